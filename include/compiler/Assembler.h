@@ -0,0 +1,117 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// x86-64 general purpose registers, numbered as in the instruction encoding
+enum Reg : uint8_t {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+// SSE registers; xmm8-xmm15 need a REX prefix like r8-r15
+enum XReg : uint8_t {
+    XMM0, XMM1, XMM2, XMM3, XMM4, XMM5, XMM6, XMM7,
+    XMM8, XMM9, XMM10, XMM11, XMM12, XMM13, XMM14, XMM15
+};
+
+// Condition codes for Jcc/SETcc (low nibble of the opcode)
+enum class Cond : uint8_t {
+    EQUAL = 0x4, NOT_EQUAL = 0x5,
+    BELOW = 0x2, ABOVE_EQUAL = 0x3, BELOW_EQUAL = 0x6, ABOVE = 0x7,
+    LESS = 0xC, GREATER_EQUAL = 0xD, LESS_EQUAL = 0xE, GREATER = 0xF,
+    PARITY = 0xA, NOT_PARITY = 0xB   // Unordered float compare sets PF
+};
+
+using Label = size_t;
+
+// Minimal x86-64 encoder for the JIT templates. Memory operands are always
+// [base + disp32]; jumps are always rel32 and patched by finalize().
+class Assembler {
+private:
+    std::vector<uint8_t> code;
+    std::vector<size_t> labels;
+    std::vector<std::pair<size_t, Label>> fixups;
+
+    void emit(uint8_t byte);
+    void emit32(uint32_t value);
+    void emit64(uint64_t value);
+    void emitRex(bool wide, int reg, int base);
+    void emitMem(int reg, Reg base, int32_t disp);
+    void emitRegReg(int reg, int rm);
+    void emitSse(uint8_t prefix, uint8_t opcode, int reg, int rm);
+    void emitSseMem(uint8_t prefix, uint8_t opcode, int reg, Reg base, int32_t disp);
+
+public:
+    // Labels
+    Label newLabel();
+    void bind(Label label);
+    bool isBound(Label label) const;
+
+    // Stack frame
+    void push(Reg reg);
+    void pop(Reg reg);
+    void ret();
+    void addImm64(Reg reg, int8_t value);
+    void subImm64(Reg reg, int8_t value);
+
+    // Moves
+    void movRegReg(Reg dst, Reg src);
+    void movImm64(Reg dst, uint64_t value);
+    void movImm32(Reg dst, uint32_t value);
+    void load64(Reg dst, Reg base, int32_t disp);
+    void load32(Reg dst, Reg base, int32_t disp);
+    void store64(Reg base, int32_t disp, Reg src);
+    void store32(Reg base, int32_t disp, Reg src);
+    void storeImm64(Reg base, int32_t disp, int32_t value);
+    void storeImm8(Reg base, int32_t disp, uint8_t value);
+    void lea(Reg dst, Reg base, int32_t disp);
+    void movsxd(Reg dst, Reg src);
+    void movzxByte(Reg dst, Reg src);
+
+    // 32-bit integer arithmetic
+    void add32(Reg dst, Reg src);
+    void sub32(Reg dst, Reg src);
+    void imul32(Reg dst, Reg src);
+    void neg32(Reg reg);
+    void cdq();
+    void idiv32(Reg divisor);
+
+    // Logic and comparisons
+    void xor32(Reg dst, Reg src);
+    void and8(Reg dst, Reg src);
+    void or8(Reg dst, Reg src);
+    void test64(Reg a, Reg b);
+    void cmp64(Reg a, Reg b);
+    void test32(Reg a, Reg b);
+    void cmp32(Reg a, Reg b);
+    void cmp32Imm(Reg reg, int32_t value);
+    void cmpMemImm64(Reg base, int32_t disp, int8_t value);
+    void cmpMemImm8(Reg base, int32_t disp, uint8_t value);
+    void setcc(Cond cond, Reg dst);
+
+    // Scalar single-precision floats (SSE)
+    void movssLoad(XReg dst, Reg base, int32_t disp);
+    void movssStore(Reg base, int32_t disp, XReg src);
+    void movdToXmm(XReg dst, Reg src);
+    void movaps(XReg dst, XReg src);
+    void addss(XReg dst, XReg src);
+    void subss(XReg dst, XReg src);
+    void mulss(XReg dst, XReg src);
+    void divss(XReg dst, XReg src);
+    void xorps(XReg dst, XReg src);
+    void ucomiss(XReg a, XReg b);
+    void cvtsi2ss(XReg dst, Reg src);
+
+    // Control flow
+    void jmp(Label label);
+    void jcc(Cond cond, Label label);
+    void call(Reg target);
+
+    size_t size() const { return code.size(); }
+    const std::vector<uint8_t>& finalize();
+};
+
+#endif
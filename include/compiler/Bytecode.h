@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <string>
 #include "../lexer/Token.h"
+#include "../parser/AST.h"
 
 enum class OpCode : uint8_t {
     // Constants
@@ -45,17 +46,46 @@ class BytecodeWriter {
 private:
     std::vector<uint8_t> code;
     std::vector<Value> constants;
+    std::vector<std::pair<size_t, int>> lines; // (first offset, source line), ascending
+    std::vector<size_t> unchecked;             // Offsets of proven-safe arithmetic, ascending
+    std::vector<std::pair<size_t, TokenType>> expected; // (offset, profiled type) of loads, ascending
+    std::vector<std::pair<size_t, unsigned>> sites;     // (offset, profile site) of operators and branches, ascending
     
 public:
     void writeByte(uint8_t byte);
     void writeOpCode(OpCode opcode);
     void writeOperand(uint32_t operand);
     
+    void patchOperand(size_t offset, uint32_t operand);
+    uint32_t readOperand(size_t offset) const;
+    
     void addConstant(const Value& value);
     size_t addConstantGetIndex(const Value& value);
     
     const std::vector<uint8_t>& getCode() const { return code; }
     const std::vector<Value>& getConstants() const { return constants; }
+    size_t slotCount() const;
+    
+    // Source line of the code emitted from here on; 0 when unknown
+    void markLine(int line);
+    int getLine(size_t offset) const;
+    
+    // Arithmetic at this offset that range analysis proved never divides by
+    // zero or overflows; faster tiers may skip the runtime check
+    void markUnchecked(size_t offset);
+    bool isUnchecked(size_t offset) const;
+    
+    // LOAD_VAR at this offset whose value had this type (INT_TYPE or
+    // BOOL_TYPE) in the profile; the JIT may speculate on it behind a guard
+    void markExpected(size_t offset, TokenType type);
+    TokenType getExpected(size_t offset) const;
+    
+    // Operator or JUMP_IF_FALSE at this offset that evaluates a profile
+    // site (Profile::number); the VM records it when profiling
+    void markSite(size_t offset, unsigned site);
+    unsigned getSite(size_t offset) const;
+    
+    static bool hasOperand(OpCode opcode);
     
     void disassemble() const;
     std::string opcodeToString(OpCode opcode) const;
@@ -0,0 +1,114 @@
+#ifndef CBACKEND_H
+#define CBACKEND_H
+
+#include "../parser/AST.h"
+#include "../core/Error.h"
+#include <string>
+#include <sstream>
+#include <vector>
+#include <unordered_map>
+
+// Static C type of a SimpleLang value
+enum class CType {
+    INT,
+    FLOAT,
+    BOOL,
+    STRING,
+    VOID
+};
+
+// Emits a self-contained C translation unit from the checked AST. Every
+// variable keeps the type of its initializer and functions use their declared
+// signatures, so typed functions become plain C functions on int/float.
+// Programs that need dynamic typing are rejected with errors. Divisions
+// check for zero at run time, and a failure stops the module; the host
+// then replays the program on the VM (NativeModule::printed()).
+class CBackend : public Visitor {
+private:
+    struct Variable {
+        std::string cName;
+        CType type;
+    };
+
+    struct Function {
+        std::string cName;
+        std::vector<CType> parameters;
+        CType returnType;
+    };
+
+    std::ostringstream globals;
+    std::ostringstream functions;
+    std::ostringstream mainBody;
+    std::ostringstream* body;
+    std::vector<std::unordered_map<std::string, Variable>> scopes;
+    std::unordered_map<std::string, Function> functionTable;
+    std::unordered_map<std::string, int> nameCounts;
+    const FunctionDeclStmt* currentFunction;
+    CType lastType;
+    int indent;
+    bool temporaries;   // The statement being emitted made temporary strings
+    bool releases;      // The function being emitted cuts temporaries back to sl_base
+    std::vector<Error> errors;
+    
+    // #line directives mapping the C back to the script
+    std::string sourceName;
+    int currentLine;
+    int emittedLine;
+
+    // Generation helpers
+    void line(const std::string& code);
+    void markLine(int sourceLine);
+    std::string lineDirective(int sourceLine) const;
+    std::string emitExpr(const ExprPtr& expr, CType& type);
+    Value result(CType type, const std::string& code);
+    std::string declareName(const std::string& name);
+    const Variable* resolveVariable(const std::string& name) const;
+    void emitPrint(const std::vector<ExprPtr>& arguments);
+    std::string emitCondition(const ExprPtr& expr);
+    void endStatement();
+    void dropStrings(size_t firstScope);
+    void emitBranch(const StmtPtr& stmt);
+    void emitFunction(const FunctionDeclStmt& stmt);
+
+    // Conversions between SimpleLang semantics and C
+    static std::string typeName(CType type);
+    static CType fromTokenType(TokenType type);
+    static std::string truthy(const std::string& code, CType type);
+    static std::string asFloat(const std::string& code, CType type);
+    static std::string asString(const std::string& code, CType type);
+    static std::string literal(const Value& value, CType& type);
+
+    void error(const Token& token, const std::string& message);
+
+public:
+    CBackend();
+
+    // Expression visitors (return the C expression as a string)
+    Value visitLiteralExpr(const LiteralExpr& expr) override;
+    Value visitVariableExpr(const VariableExpr& expr) override;
+    Value visitBinaryExpr(const BinaryExpr& expr) override;
+    Value visitUnaryExpr(const UnaryExpr& expr) override;
+    Value visitCallExpr(const CallExpr& expr) override;
+    Value visitAssignmentExpr(const AssignmentExpr& expr) override;
+
+    // Statement visitors
+    void visitPrintStmt(const PrintStmt& stmt) override;
+    void visitVariableDeclStmt(const VariableDeclStmt& stmt) override;
+    void visitExpressionStmt(const ExpressionStmt& stmt) override;
+    void visitBlockStmt(const BlockStmt& stmt) override;
+    void visitIfStmt(const IfStmt& stmt) override;
+    void visitWhileStmt(const WhileStmt& stmt) override;
+    void visitFunctionDeclStmt(const FunctionDeclStmt& stmt) override;
+    void visitReturnStmt(const ReturnStmt& stmt) override;
+
+    // Tag the generated C with the script's lines (for debuggers and perf)
+    void setSourceName(const std::string& name) { sourceName = name; }
+    
+    // Main generation method; the result exports simplelang_main()
+    std::string generate(const ProgramPtr& program);
+
+    const std::vector<Error>& getErrors() const { return errors; }
+    bool hasErrors() const { return !errors.empty(); }
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include "../parser/AST.h"
 #include <memory>
 #include <vector>
+#include <unordered_map>
 
 class CodeGenerator : public Visitor {
 private:
@@ -12,12 +13,16 @@ private:
     std::unordered_map<std::string, size_t> variableIndices;
     std::vector<std::unordered_map<std::string, size_t>> scopes;
     size_t nextVariableIndex;
+    bool executable;
     
     // Generation helpers
     void enterScope();
     void exitScope();
     size_t resolveVariable(const std::string& name);
     void declareVariable(const std::string& name);
+    size_t emitJump(OpCode opcode);
+    void patchJump(size_t operandOffset);
+    void emitOperand(const ExprPtr& operand, TokenType profiledType);
     
     // Control flow
     std::vector<size_t> breakPositions;
@@ -46,6 +51,9 @@ public:
     
     // Main generation method
     BytecodeWriter generate(const ProgramPtr& program);
+    
+    // False when the program uses constructs the VM cannot run yet (user functions)
+    bool isExecutable() const { return executable; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,113 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "Bytecode.h"
+#include "Assembler.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// Static type of a native value; also used as the runtime tag of a slot
+enum class JitType : uint8_t {
+    UNDEF,    // Slot not stored yet
+    INT,
+    BOOL,
+    NUL,
+    FLOAT,    // Raw IEEE single in the low 32 bits
+    STRING,   // Constant pool index of a string literal
+    UNKNOWN   // Conflicting types merged at a join point
+};
+
+// Point where native code hands control back to the VM
+struct JitExit {
+    size_t pc;                    // Bytecode offset the VM resumes at
+    std::vector<JitType> stack;   // Types of the operand stack at that point
+};
+
+// Anonymous mapping that is writable while code is copied in and
+// executable afterwards, never both (W^X)
+class ExecutableMemory {
+private:
+    void* memory;
+    size_t size;
+
+public:
+    ExecutableMemory();
+    ~ExecutableMemory();
+    ExecutableMemory(const ExecutableMemory&) = delete;
+    ExecutableMemory& operator=(const ExecutableMemory&) = delete;
+
+    bool allocate(const std::vector<uint8_t>& code);
+    void* data() const { return memory; }
+    size_t getSize() const { return size; }
+};
+
+class JitFunction {
+private:
+    using Entry = uint32_t (*)(int64_t* slots, uint8_t* tags, int64_t* stack);
+
+    ExecutableMemory memory;
+    std::vector<JitExit> exits;
+    std::vector<std::vector<JitType>> printTypes;
+    size_t maxStackDepth;
+
+    friend class JitCompiler;
+
+public:
+    static constexpr uint32_t COMPLETED = 0xFFFFFFFF;
+
+    JitFunction() : maxStackDepth(0) {}
+
+    // Runs the native code; returns COMPLETED or the index of the exit taken
+    uint32_t invoke(int64_t* slots, uint8_t* tags, int64_t* stack) const;
+    const JitExit& getExit(uint32_t index) const { return exits[index]; }
+    size_t getMaxStackDepth() const { return maxStackDepth; }
+    const ExecutableMemory& getMemory() const { return memory; }
+};
+
+// Baseline template JIT: every bytecode instruction whose operand types are
+// statically int/bool becomes a fixed machine-code template; everything else
+// becomes an exit back to the VM. Loads with a profiled type (markExpected)
+// speculate on it, guarded by a check of the slot's tag when the slot may
+// hold something else. x86-64 Linux only.
+class JitCompiler {
+private:
+    struct Instruction {
+        size_t pc;
+        OpCode opcode;
+        uint32_t operand;
+    };
+
+    struct State {
+        bool reachable = false;
+        std::vector<JitType> stack;
+        std::vector<JitType> slots;
+    };
+
+    const BytecodeWriter* chunk;
+    std::vector<Instruction> instructions;
+    std::vector<State> states;
+    std::vector<bool> native;
+
+    // Analysis helpers
+    void decode();
+    size_t indexOf(size_t pc) const;
+    bool analyze();
+    bool transfer(const Instruction& instr, State& state) const;
+    bool merge(State& target, const State& incoming) const;
+    bool isConstant(uint32_t index, JitType& type) const;
+    JitType expectedType(size_t pc) const;   // Profiled type of a load, UNKNOWN if none
+
+    // Code generation
+    void emitInstruction(Assembler& masm, size_t index, JitFunction& function,
+                         const std::vector<Label>& labels, Label epilogue);
+    void emitExit(Assembler& masm, size_t index, JitFunction& function, Label epilogue);
+
+public:
+    JitCompiler();
+
+    static bool isSupported();
+    std::unique_ptr<JitFunction> compile(const BytecodeWriter& chunk);
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef NATIVEMODULE_H
+#define NATIVEMODULE_H
+
+#include <string>
+
+// Builds C emitted by CBackend with the system compiler (Config "cc",
+// default "cc") and loads it into the process with dlopen. POSIX only.
+class NativeModule {
+private:
+    using EntryPoint = int (*)();
+    using ErrorMessage = const char* (*)();
+    using PrintedCount = unsigned long (*)();
+
+    void* handle;
+    std::string directory;
+    EntryPoint entry;
+    ErrorMessage errorMessage;
+    PrintedCount printedCount;
+
+    void cleanup();
+
+public:
+    NativeModule();
+    ~NativeModule();
+    NativeModule(const NativeModule&) = delete;
+    NativeModule& operator=(const NativeModule&) = delete;
+
+    static bool isSupported();
+
+    // Compiles the source into a shared object and loads it
+    bool load(const std::string& source, std::string& message);
+    // Runs the module's top-level code; false with message on a runtime error
+    bool run(std::string& message);
+    // Bytes the last run wrote to stdout, all of them before a runtime error
+    size_t printed() const;
+
+    // Links the source into a standalone executable instead
+    static bool buildExecutable(const std::string& source, const std::string& output, std::string& message);
+};
+
+#endif
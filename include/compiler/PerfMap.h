@@ -0,0 +1,29 @@
+#ifndef PERFMAP_H
+#define PERFMAP_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Native code offset where a source line starts
+struct PerfLine {
+    size_t offset;
+    int line;
+};
+
+// Tells Linux perf about generated code. With Config "perf" set, every
+// region is listed in /tmp/perf-<pid>.map (read directly by perf report)
+// and in /tmp/jit-<pid>.dump with its line table (for perf inject --jit,
+// which also gives perf annotate the SimpleLang source lines).
+class PerfMap {
+public:
+    static bool isEnabled();
+
+    // Symbol shown by perf, e.g. "simplelang:main (loops.sl:3)"
+    static std::string symbolName(const std::string& function, int line);
+
+    static void registerCode(const void* code, size_t size, const std::string& name,
+                             const std::vector<PerfLine>& lines = {});
+};
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "Jit.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// One bytecode instruction executed while a loop iteration was recorded
+struct TraceOp {
+    size_t pc;
+    OpCode opcode;
+    uint32_t operand;
+};
+
+// Records the path the VM takes through one iteration of a hot loop,
+// starting and ending at the loop header
+class TraceRecorder {
+private:
+    bool recording;
+    size_t header;
+    std::vector<TraceOp> ops;
+    std::vector<JitType> entryTypes;
+
+public:
+    static constexpr uint32_t HOT_LOOP_THRESHOLD = 10;
+    static constexpr size_t MAX_TRACE_LENGTH = 1000;
+
+    TraceRecorder();
+
+    void start(size_t header, const std::vector<JitType>& slotTypes);
+    // Returns false (and stops recording) for ops a trace cannot contain
+    bool record(size_t pc, OpCode opcode, uint32_t operand);
+    void stop();
+
+    bool isRecording() const { return recording; }
+    size_t getHeader() const { return header; }
+    const std::vector<TraceOp>& getOps() const { return ops; }
+    const std::vector<JitType>& getEntryTypes() const { return entryTypes; }
+};
+
+// Native code for one recorded loop. Entry guards check the slot types seen
+// while recording; every other guard is a side exit back to the VM.
+class Trace {
+private:
+    using Entry = uint32_t (*)(int64_t* slots, uint8_t* tags, int64_t* scratch);
+
+    ExecutableMemory memory;
+    std::vector<JitExit> exits;
+    std::vector<uint32_t> slots;   // Slots the trace reads or writes
+    size_t scratchSize;
+
+    friend class TraceCompiler;
+
+public:
+    static constexpr uint32_t ENTRY_GUARD_FAILED = 0;
+
+    Trace() : scratchSize(0) {}
+
+    // Runs the loop until a guard fails; returns the index of the exit taken
+    uint32_t invoke(int64_t* slots, uint8_t* tags, int64_t* scratch) const;
+    const JitExit& getExit(uint32_t index) const { return exits[index]; }
+    size_t getExitCount() const { return exits.size(); }
+    const std::vector<uint32_t>& getSlots() const { return slots; }
+    size_t getScratchSize() const { return scratchSize; }
+    const ExecutableMemory& getMemory() const { return memory; }
+};
+
+// Compiles a recorded iteration into a guarded straight-line loop. Int and
+// bool values live unboxed in general purpose registers, floats in xmm
+// registers; slots stay in registers for the whole loop.
+class TraceCompiler {
+private:
+    enum class Home : uint8_t { GP, XMM, MEMORY };
+
+    struct SlotInfo {
+        uint32_t index;
+        JitType entryType;
+        JitType type;
+        Home home;
+        uint8_t reg;
+    };
+
+    struct StackEntry {
+        JitType type;
+        uint32_t constant;   // Constant pool index for STRING
+    };
+
+    struct PendingExit {
+        Label label;
+        size_t pc;
+        std::vector<StackEntry> stack;
+        std::vector<JitType> slotTypes;
+    };
+
+    const BytecodeWriter* chunk;
+    std::vector<SlotInfo> slotInfo;
+    std::vector<int> slotPosition;   // Slot index -> slotInfo index, -1 if untouched
+    std::vector<StackEntry> stack;
+    std::vector<PendingExit> pendingExits;
+
+    bool assignHomes(const TraceRecorder& recorder);
+    bool emitOp(Assembler& masm, const std::vector<TraceOp>& ops, size_t index, Label loopStart);
+    Label sideExit(Assembler& masm, size_t pc);
+    void emitExits(Assembler& masm, Trace& trace, Label epilogue);
+
+    // Value movement between slot homes and stack registers
+    void loadSlot(Assembler& masm, const SlotInfo& slot, size_t depth);
+    void storeSlot(Assembler& masm, const SlotInfo& slot, size_t depth);
+    void toFloat(Assembler& masm, size_t depth);
+    bool truthy(Assembler& masm, size_t depth);
+    void spillFloatSlots(Assembler& masm, bool reload);
+
+public:
+    TraceCompiler();
+
+    std::unique_ptr<Trace> compile(const TraceRecorder& recorder, const BytecodeWriter& chunk);
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef NUMBERS_H
+#define NUMBERS_H
+
+#include <string>
+#include <string_view>
+
+// Number <-> text conversions for the whole compiler, built on
+// std::from_chars and std::to_chars: no locale, no exceptions, no streams.
+// A float is written with the fewest digits that read back as the same
+// float, plus ".0" when it would otherwise look like an int.
+namespace Numbers {
+    // Room for any int or float that write() produces
+    const size_t MAX_LENGTH = 24;
+
+    // All of `text` as a number, allowing spaces or tabs around it and a
+    // leading '+'; false if it is empty, has anything else in it or is out
+    // of range, and `value` is then unchanged
+    bool parse(std::string_view text, int& value);
+    bool parse(std::string_view text, float& value);
+
+    // Writes at `out` (MAX_LENGTH bytes) and returns the end
+    char* write(char* out, int value);
+    char* write(char* out, float value);
+
+    void append(std::string& out, int value);
+    void append(std::string& out, float value);
+    std::string toString(int value);
+    std::string toString(float value);
+}
+
+#endif
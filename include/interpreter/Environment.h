@@ -5,6 +5,7 @@
 #include <string>
 #include <memory>
 #include <variant>
+#include <vector>
 #include "../lexer/Token.h"
 
 using RuntimeValue = std::variant<int, float, bool, std::string, nullptr_t>;
@@ -14,6 +15,11 @@ struct FunctionObject {
     TokenType returnType;
     std::shared_ptr<class BlockStmt> body;
     std::shared_ptr<class Environment> closure;
+    // Set instead of closure while the function is stored in the
+    // environment it closes over, so that environment does not own itself
+    std::weak_ptr<class Environment> home;
+    bool stackFrame = false;   // Calls can run in an Environment on the C++ stack
+    unsigned site = 0;         // Profile site of the declaration
 };
 
 using Value = std::variant<int, float, bool, std::string, nullptr_t, FunctionObject>;
@@ -21,8 +27,13 @@ using Value = std::variant<int, float, bool, std::string, nullptr_t, FunctionObj
 class Environment {
 private:
     std::unordered_map<std::string, Value> values;
+    std::unordered_map<std::string, std::shared_ptr<Value>> boxes;   // Variables captured as upvalues
     std::shared_ptr<Environment> parent;
     
+    // A function value as stored here and as handed back out
+    Value stored(const Value& value) const;
+    static Value loaded(const Value& value);
+    
 public:
     Environment(std::shared_ptr<Environment> parent = nullptr);
     
@@ -31,6 +42,12 @@ public:
     Value get(const std::string& name);
     bool exists(const std::string& name) const;
     
+    // Upvalues: capture() moves a variable into a shared cell, found through
+    // the parent chain, and returns it (null if the name is undefined);
+    // bind() makes that cell visible under the name in this environment
+    std::shared_ptr<Value> capture(const std::string& name);
+    void bind(const std::string& name, std::shared_ptr<Value> cell);
+    
     std::shared_ptr<Environment> getParent() const { return parent; }
     void setParent(std::shared_ptr<Environment> parent) { this->parent = parent; }
     
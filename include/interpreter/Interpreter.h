@@ -3,6 +3,8 @@
 
 #include "Environment.h"
 #include "../parser/AST.h"
+#include "../semantic/EscapeAnalysis.h"
+#include "../optimizer/Profile.h"
 #include "../core/Error.h"
 #include <memory>
 #include <vector>
@@ -15,11 +17,15 @@ private:
     std::vector<Error> errors;
     Value returnValue;
     bool hasReturn;
+    EscapeAnalysis escapes;   // Decides closures and which frames live on the stack
+    Profile* profile;         // Records branches, operand types and call targets when set
     
     // Runtime helpers
     Value evaluate(const ExprPtr& expr);
     void execute(const StmtPtr& stmt);
     void executeBlock(const std::vector<StmtPtr>& statements, std::shared_ptr<Environment> env);
+    // Non-owning handle to an Environment that outlives every use of it
+    static std::shared_ptr<Environment> borrow(Environment& env);
     
     // Type conversion helpers
     int toInt(const Value& value);
@@ -74,6 +80,9 @@ public:
     // Main interpretation method
     void interpret(const ProgramPtr& program);
     const std::vector<Error>& getErrors() const { return errors; }
+    const EscapeAnalysis& getEscapeAnalysis() const { return escapes; }
+    // Sites must be numbered (Profile::number) before the program runs
+    void setProfile(Profile* recorder) { profile = recorder; }
     bool hasErrors() const { return !errors.empty(); }
     
     // Built-in functions
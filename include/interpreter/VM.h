@@ -0,0 +1,80 @@
+#ifndef VM_H
+#define VM_H
+
+#include "../compiler/Bytecode.h"
+#include "../compiler/Trace.h"
+#include "../core/Error.h"
+#include <vector>
+#include <string>
+#include <variant>
+#include <memory>
+#include <unordered_map>
+
+class Profile;
+
+// Stack value of the bytecode VM (same alternatives as RuntimeValue)
+using VMValue = std::variant<int, float, bool, std::string, std::nullptr_t>;
+
+class VM {
+private:
+    const BytecodeWriter* chunk;
+    std::vector<VMValue> stack;
+    std::vector<VMValue> slots;
+    std::vector<Error> errors;
+    size_t pc;
+
+    // Tracing JIT state, keyed by loop header pc
+    bool tracing;
+    TraceRecorder recorder;
+    std::unordered_map<size_t, std::unique_ptr<Trace>> traces;
+    std::unordered_map<size_t, uint32_t> loopCounters;
+
+    Profile* profile;   // Records branches and operand types when set
+
+    // Execution helpers
+    void execute();
+    bool runNative();
+    void onLoopBackEdge(size_t header);
+    void finishRecording();
+    void runTrace(size_t header, const Trace& trace);
+    void blacklist(size_t header);
+    JitType toNative(const VMValue& value, int64_t& raw) const;
+    VMValue fromNative(int64_t raw, JitType type) const;
+    uint32_t readOperand();
+    void push(const VMValue& value);
+    VMValue pop();
+    VMValue constantToValue(const Value& constant) const;
+
+    // Operations (mirror the Interpreter semantics)
+    VMValue add(const VMValue& left, const VMValue& right);
+    VMValue subtract(const VMValue& left, const VMValue& right);
+    VMValue multiply(const VMValue& left, const VMValue& right);
+    VMValue divide(const VMValue& left, const VMValue& right);
+    VMValue modulo(const VMValue& left, const VMValue& right);
+    VMValue negate(const VMValue& value);
+    bool less(const VMValue& left, const VMValue& right);
+
+    // Error reporting
+    void runtimeError(const std::string& message);
+
+public:
+    VM();
+
+    // Main execution method
+    void run(const BytecodeWriter& chunk);
+    const std::vector<Error>& getErrors() const { return errors; }
+    bool hasErrors() const { return !errors.empty(); }
+    size_t getTraceCount() const { return traces.size(); }
+    // Sites must be numbered (Profile::number) before the chunk is
+    // generated; the JIT stays off while recording
+    void setProfile(Profile* recorder) { profile = recorder; }
+
+    // Helper methods for type checking at runtime
+    static bool isTruthy(const VMValue& value);
+    static bool isEqual(const VMValue& a, const VMValue& b);
+    static bool isNumber(const VMValue& value);
+    static float toFloat(const VMValue& value);
+    static std::string valueToString(const VMValue& value);
+};
+
+#endif
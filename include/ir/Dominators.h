@@ -0,0 +1,29 @@
+#ifndef DOMINATORS_H
+#define DOMINATORS_H
+
+#include "IR.h"
+#include <unordered_map>
+#include <vector>
+
+// Dominator tree of a function's CFG (Cooper, Harvey and Kennedy's
+// iterative algorithm over reverse postorder)
+class DominatorTree {
+private:
+    std::vector<IRBlock*> order;
+    std::unordered_map<const IRBlock*, size_t> position;
+    std::unordered_map<const IRBlock*, IRBlock*> idom;
+
+    IRBlock* intersect(IRBlock* a, IRBlock* b) const;
+
+public:
+    explicit DominatorTree(const IRFunction& function);
+
+    bool isReachable(const IRBlock* block) const { return position.count(block) > 0; }
+    // Null for the entry block
+    IRBlock* immediateDominator(const IRBlock* block) const;
+    bool dominates(const IRBlock* a, const IRBlock* b) const;
+    // Reachable blocks in reverse postorder
+    const std::vector<IRBlock*>& getOrder() const { return order; }
+};
+
+#endif
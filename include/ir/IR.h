@@ -0,0 +1,113 @@
+#ifndef IR_H
+#define IR_H
+
+#include "../parser/AST.h"
+#include <string>
+#include <vector>
+#include <memory>
+
+enum class IROp {
+    // Values
+    CONST,     // constant holds the value
+    NUL,       // null, also the value of variables read before any store
+    PARAM,     // index holds the parameter number
+    PHI,       // operands[i] flows in from block->predecessors[i]
+
+    // Arithmetic and logic, same semantics as the bytecode
+    ADD, SUB, MUL, DIV, MOD, NEG,
+    EQ, NEQ, LT, GT, LTE, GTE,
+    AND, OR, NOT,
+
+    // Top-level variables that functions can see live in memory
+    LOAD_GLOBAL, STORE_GLOBAL,   // name holds the variable
+
+    // Calls
+    CALL,      // name holds the callee
+    PRINT,
+
+    // Terminators
+    JUMP,      // targets[0]
+    BRANCH,    // operands[0] ? targets[0] : targets[1]
+    RETURN     // operands[0]
+};
+
+class IRBlock;
+class IRFunction;
+
+class IRInstruction {
+public:
+    unsigned id;
+    IROp op;
+    std::vector<IRInstruction*> operands;
+    std::vector<IRBlock*> targets;
+    Value constant;
+    std::string name;
+    size_t index;
+    int line;
+    IRBlock* block;
+
+    IRInstruction(unsigned id, IROp op)
+        : id(id), op(op), constant(0), index(0), line(0), block(nullptr) {}
+
+    bool isTerminator() const { return op == IROp::JUMP || op == IROp::BRANCH || op == IROp::RETURN; }
+    // Output, stores, calls and control flow
+    bool hasSideEffects() const;
+    // May raise a runtime error (operand types, division by zero)
+    bool canTrap() const;
+    // Safe to remove, duplicate or move
+    bool isPure() const { return !hasSideEffects() && !canTrap(); }
+    bool hasResult() const { return !isTerminator() && op != IROp::STORE_GLOBAL; }
+};
+
+class IRBlock {
+public:
+    unsigned id;
+    std::vector<std::unique_ptr<IRInstruction>> instructions;
+    std::vector<IRBlock*> predecessors;
+    IRFunction* function;
+
+    IRBlock(unsigned id, IRFunction* function) : id(id), function(function) {}
+
+    IRInstruction* terminator() const;
+    std::vector<IRBlock*> successors() const;
+    size_t predecessorIndex(const IRBlock* block) const;
+};
+
+class IRFunction {
+private:
+    unsigned nextValueId;
+    unsigned nextBlockId;
+
+public:
+    std::string name;
+    size_t parameterCount;
+    std::vector<std::unique_ptr<IRBlock>> blocks;   // blocks[0] is the entry
+
+    IRFunction(const std::string& name, size_t parameterCount)
+        : nextValueId(0), nextBlockId(0), name(name), parameterCount(parameterCount) {}
+
+    IRBlock* createBlock();
+    std::unique_ptr<IRInstruction> createInstruction(IROp op);
+    IRBlock* entry() const { return blocks.empty() ? nullptr : blocks.front().get(); }
+
+    // Rewrites every use of `from` to `to`
+    void replaceAllUses(IRInstruction* from, IRInstruction* to);
+    // Drops blocks not reachable from the entry, updating phis
+    void removeUnreachableBlocks();
+    // Replaces phis whose operands are all the same value (or the phi itself)
+    size_t removeTrivialPhis();
+    // Blocks in reverse postorder from the entry
+    std::vector<IRBlock*> reversePostorder() const;
+};
+
+class IRModule {
+public:
+    std::vector<std::unique_ptr<IRFunction>> functions;   // functions[0] is the top level
+
+    IRFunction* main() const { return functions.empty() ? nullptr : functions.front().get(); }
+    IRFunction* find(const std::string& name) const;
+};
+
+const char* irOpName(IROp op);
+
+#endif
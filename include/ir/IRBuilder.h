@@ -0,0 +1,93 @@
+#ifndef IRBUILDER_H
+#define IRBUILDER_H
+
+#include "IR.h"
+#include "../parser/AST.h"
+#include "../core/Error.h"
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// Builds SSA form directly from the AST using Braun et al.'s on-the-fly
+// construction: each variable read looks up the reaching definition in
+// the current block and its predecessors, placing phis where paths merge.
+// Blocks are sealed once all their predecessors are known.
+class IRBuilder : public Visitor {
+private:
+    struct Variable {
+        int key;
+        bool global;   // Top-level variable visible to functions: lives in memory
+    };
+
+    std::unique_ptr<IRModule> module;
+    IRFunction* function;
+    IRBlock* current;
+    IRInstruction* lastValue;
+    IRInstruction* undefined;
+    int currentLine;
+    int nextKey;
+    std::vector<std::unordered_map<std::string, Variable>> scopes;
+    std::unordered_set<std::string> globalNames;
+    std::vector<Error> errors;
+
+    // SSA construction state
+    std::unordered_map<int, std::unordered_map<IRBlock*, IRInstruction*>> definitions;
+    std::unordered_map<IRBlock*, std::vector<std::pair<int, IRInstruction*>>> incompletePhis;
+    std::unordered_set<IRBlock*> sealed;
+    std::vector<std::unique_ptr<IRInstruction>> removedPhis;
+
+    void writeVariable(int key, IRBlock* block, IRInstruction* value);
+    IRInstruction* readVariable(int key, IRBlock* block);
+    IRInstruction* readVariableRecursive(int key, IRBlock* block);
+    IRInstruction* addPhiOperands(int key, IRInstruction* phi);
+    IRInstruction* tryRemoveTrivialPhi(IRInstruction* phi);
+    void sealBlock(IRBlock* block);
+
+    // Emission helpers
+    IRInstruction* emit(IROp op, std::vector<IRInstruction*> operands = {});
+    IRInstruction* emitExpr(const ExprPtr& expr);
+    IRInstruction* emitConstant(const Value& value);
+    IRInstruction* getUndefined();
+    IRInstruction* insertPhi(IRBlock* block);
+    void jump(IRBlock* target);
+    void branch(IRInstruction* condition, IRBlock* ifTrue, IRBlock* ifFalse);
+    void markLine(int line);
+
+    void enterScope();
+    void exitScope();
+    const Variable* resolveVariable(const std::string& name) const;
+    void declareVariable(const Token& name, IRInstruction* value);
+    void buildFunction(const FunctionDeclStmt& stmt);
+
+    void error(const Token& token, const std::string& message);
+
+public:
+    IRBuilder();
+
+    // Expression visitors (the value is left in lastValue)
+    Value visitLiteralExpr(const LiteralExpr& expr) override;
+    Value visitVariableExpr(const VariableExpr& expr) override;
+    Value visitBinaryExpr(const BinaryExpr& expr) override;
+    Value visitUnaryExpr(const UnaryExpr& expr) override;
+    Value visitCallExpr(const CallExpr& expr) override;
+    Value visitAssignmentExpr(const AssignmentExpr& expr) override;
+
+    // Statement visitors
+    void visitPrintStmt(const PrintStmt& stmt) override;
+    void visitVariableDeclStmt(const VariableDeclStmt& stmt) override;
+    void visitExpressionStmt(const ExpressionStmt& stmt) override;
+    void visitBlockStmt(const BlockStmt& stmt) override;
+    void visitIfStmt(const IfStmt& stmt) override;
+    void visitWhileStmt(const WhileStmt& stmt) override;
+    void visitFunctionDeclStmt(const FunctionDeclStmt& stmt) override;
+    void visitReturnStmt(const ReturnStmt& stmt) override;
+
+    // Main build method; the top-level code becomes function "main"
+    std::unique_ptr<IRModule> build(const ProgramPtr& program);
+
+    const std::vector<Error>& getErrors() const { return errors; }
+    bool hasErrors() const { return !errors.empty(); }
+};
+
+#endif
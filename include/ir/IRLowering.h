@@ -0,0 +1,45 @@
+#ifndef IRLOWERING_H
+#define IRLOWERING_H
+
+#include "IR.h"
+#include "RangeAnalysis.h"
+#include "../compiler/Bytecode.h"
+#include <unordered_map>
+#include <vector>
+#include <string>
+
+// Lowers the top-level IR function to VM bytecode. Every SSA value gets its
+// own variable slot and constants are rematerialized at each use. Phis
+// become copies on the incoming edges: all sources are pushed before any
+// phi slot is stored, so swapped values need no temporaries. Arithmetic
+// that range analysis proved safe is marked unchecked in the bytecode.
+class IRLowering {
+private:
+    BytecodeWriter writer;
+    std::unordered_map<const IRInstruction*, uint32_t> slots;
+    std::unordered_map<std::string, uint32_t> globals;
+    std::unordered_map<const IRInstruction*, size_t> useCounts;
+    std::unordered_map<const IRBlock*, size_t> blockOffsets;
+    std::vector<std::pair<size_t, const IRBlock*>> fixups;   // Null target: the final HALT
+    const RangeAnalysis* ranges;
+    uint32_t nextSlot;
+    bool executable;
+
+    void assignSlots(const IRFunction& function);
+    void load(const IRInstruction* value);
+    void storeResult(const IRInstruction& instruction);
+    void lowerInstruction(const IRInstruction& instruction, const IRBlock* next);
+    bool emitEdgeCopies(const IRBlock* from, const IRBlock* to);
+    void emitJumpTo(OpCode opcode, const IRBlock* target);
+    uint32_t globalSlot(const std::string& name);
+
+public:
+    IRLowering();
+
+    BytecodeWriter lower(const IRModule& module, const RangeAnalysis* ranges = nullptr);
+
+    // False when the module needs features the VM lacks (user functions)
+    bool isExecutable() const { return executable; }
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef IRPRINTER_H
+#define IRPRINTER_H
+
+#include "IR.h"
+#include <string>
+
+// Text form of the IR, e.g.
+//   b1:  ; preds b0, b2
+//     %3 = phi [%1, b0], [%7, b2]
+//     %4 = lt %3, %2
+//     branch %4, b2, b3
+class IRPrinter {
+public:
+    static std::string print(const IRModule& module);
+    static std::string print(const IRFunction& function);
+    static std::string print(const IRInstruction& instruction);
+    static std::string valueName(const IRInstruction* value);
+};
+
+#endif
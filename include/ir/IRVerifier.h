@@ -0,0 +1,28 @@
+#ifndef IRVERIFIER_H
+#define IRVERIFIER_H
+
+#include "IR.h"
+#include "../core/Error.h"
+#include <string>
+#include <vector>
+
+// Checks the structural invariants every pass must preserve: blocks end in
+// exactly one terminator, phis lead their block with one operand per
+// predecessor, CFG edges agree in both directions, and every definition
+// dominates its uses.
+class IRVerifier {
+private:
+    std::vector<Error> errors;
+
+    void verifyFunction(const IRFunction& function);
+    void error(const IRFunction& function, const IRInstruction* instruction, const std::string& message);
+
+public:
+    bool verify(const IRModule& module);
+    bool verify(const IRFunction& function);
+
+    const std::vector<Error>& getErrors() const { return errors; }
+    bool hasErrors() const { return !errors.empty(); }
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef RANGEANALYSIS_H
+#define RANGEANALYSIS_H
+
+#include "IR.h"
+#include "Dominators.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Interval analysis over SSA values. Every value that is an int on every
+// path gets the range of values it can hold: constants, arithmetic on
+// ranges, phis joining their incoming edges, and comparisons narrowing a
+// value in the blocks a branch on them dominates. Loops reach a fixpoint
+// by widening phis that keep growing to the int bounds, then a few
+// narrowing rounds win back the bounds the loop tests give.
+//
+// Divisions whose divisor cannot be zero and int arithmetic that cannot
+// overflow are reported per instruction, so faster tiers can emit them
+// without the runtime check.
+class RangeAnalysis {
+public:
+    struct Range {
+        enum class Kind { NONE, INT, ANY };   // NONE: not reached yet
+        Kind kind = Kind::NONE;
+        int64_t low = 0;
+        int64_t high = 0;
+
+        bool isInt() const { return kind == Kind::INT; }
+        bool contains(int64_t value) const { return isInt() && low <= value && high >= value; }
+    };
+
+    struct Stats {
+        size_t divisions = 0;
+        size_t nonZeroDivisors = 0;
+        size_t intOperations = 0;   // Int arithmetic (add, sub, mul, neg, mod)
+        size_t noOverflow = 0;
+    };
+
+private:
+    std::unordered_map<const IRInstruction*, Range> ranges;
+    std::unordered_map<const IRInstruction*, unsigned> growth;   // Times a phi widened
+    std::unordered_set<const IRInstruction*> nonZeroDivisors;
+    std::unordered_set<const IRInstruction*> noOverflow;
+    Stats stats;
+
+    Range rangeOf(const IRInstruction* value) const;
+    Range rangeAt(const IRInstruction* value, const IRBlock* block, const DominatorTree& dominators) const;
+    Range evaluate(const IRInstruction& instruction, const DominatorTree& dominators) const;
+    void recordFacts(const IRInstruction& instruction, const DominatorTree& dominators);
+    void analyzeFunction(const IRFunction& function);
+
+public:
+    void analyze(const IRModule& module);
+
+    Range getRange(const IRInstruction* value) const { return rangeOf(value); }
+    // DIV and MOD whose divisor is an int that is never zero
+    bool isDivisorNonZero(const IRInstruction* instruction) const { return nonZeroDivisors.count(instruction) > 0; }
+    // ADD, SUB, MUL, NEG and MOD on ints whose exact result always fits in an int
+    bool cannotOverflow(const IRInstruction* instruction) const { return noOverflow.count(instruction) > 0; }
+    // Needs neither a zero-divisor nor an overflow check
+    bool isUnchecked(const IRInstruction* instruction) const;
+
+    const Stats& getStats() const { return stats; }
+    std::string report() const;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef VALUENUMBERING_H
+#define VALUENUMBERING_H
+
+#include "IR.h"
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Dominator-based global value numbering. Blocks are visited in dominator
+// tree preorder with a scoped table from (op, operands, constant) to the
+// first instruction computing it; a later instruction with the same key in
+// a dominated block is replaced by that one. Operands of commutative ops
+// are ordered and `a > b` is keyed as `b < a`.
+//
+// Only values that cannot raise a runtime error are numbered, so no error
+// goes missing: arithmetic counts once its operands are known numbers.
+// Calls count when the callee is pure (no output, no globals, no error for
+// int arguments) and every argument is an int. Global loads are only
+// reused within a block, up to the next store to that name or call.
+class ValueNumbering {
+public:
+    struct Stats {
+        size_t functions = 0;
+        size_t eliminated = 0;
+        std::map<IROp, size_t> byOp;   // Eliminated instructions per opcode
+        size_t constants = 0;          // Duplicate constants merged, not counted above
+    };
+
+private:
+    // What a value holds whenever it is computed without an error
+    enum class Kind { NONE, INT, NUMBER, OTHER };   // NONE: not known yet
+
+    std::unordered_map<std::string, const IRFunction*> pureFunctions;
+    Stats stats;
+
+    std::unordered_map<const IRInstruction*, Kind> inferKinds(const IRFunction& function, bool intParameters) const;
+    Kind evaluate(const IRInstruction& instruction, const std::unordered_map<const IRInstruction*, Kind>& kinds,
+                  bool intParameters) const;
+    bool cannotTrap(const IRInstruction& instruction, const std::unordered_map<const IRInstruction*, Kind>& kinds) const;
+    void findPureFunctions(const IRModule& module);
+    std::string key(const IRInstruction& instruction) const;
+    void runFunction(IRFunction& function);
+
+public:
+    // Returns the number of redundant computations removed
+    size_t run(IRModule& module);
+
+    bool isPureFunction(const std::string& name) const { return pureFunctions.count(name) > 0; }
+    const Stats& getStats() const { return stats; }
+    std::string report() const;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef CHARCLASS_H
+#define CHARCLASS_H
+
+#include <array>
+#include <cstdint>
+
+// Class bits for every byte, built at compile time: classifying a
+// character is one load and a mask, with no locale (unlike <cctype>) and
+// nothing to set up when a Lexer is created
+class CharClass {
+public:
+    enum : uint8_t {
+        SPACE = 1,        // ' ', '\t', '\r', '\n'
+        DIGIT = 2,
+        LOWER = 4,
+        UPPER = 8,
+        UNDERSCORE = 16,
+        IDENTIFIER_START = LOWER | UPPER | UNDERSCORE,
+        IDENTIFIER = IDENTIFIER_START | DIGIT
+    };
+
+private:
+    static constexpr std::array<uint8_t, 256> build() {
+        std::array<uint8_t, 256> table{};
+        for (int c = 0; c < 256; c++) {
+            uint8_t bits = 0;
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n') bits |= SPACE;
+            if (c >= '0' && c <= '9') bits |= DIGIT;
+            if (c >= 'a' && c <= 'z') bits |= LOWER;
+            if (c >= 'A' && c <= 'Z') bits |= UPPER;
+            if (c == '_') bits |= UNDERSCORE;
+            table[c] = bits;
+        }
+        return table;
+    }
+
+public:
+    static const std::array<uint8_t, 256> TABLE;
+
+    static constexpr bool is(char c, uint8_t bits) {
+        return (TABLE[static_cast<unsigned char>(c)] & bits) != 0;
+    }
+    static constexpr bool isSpace(char c) { return is(c, SPACE); }
+    static constexpr bool isDigit(char c) { return is(c, DIGIT); }
+    static constexpr bool isIdentifierStart(char c) { return is(c, IDENTIFIER_START); }
+    static constexpr bool isIdentifier(char c) { return is(c, IDENTIFIER); }
+};
+
+// Defined after the class so build() is complete when it is evaluated
+inline constexpr std::array<uint8_t, 256> CharClass::TABLE = CharClass::build();
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef INCREMENTALLEXER_H
+#define INCREMENTALLEXER_H
+
+#include "TokenBuffer.h"
+#include <string>
+
+// Keeps the tokens of a document that is edited in place (an editor
+// buffer, a long-lived REPL). An edit relexes from the token before the
+// first one it touches and stops as soon as a new token lines up with an
+// old one after the edit; from there on the old tokens are kept, moved by
+// the edit's change in length. Lines and columns are not stored, so
+// nothing else about them changes.
+class IncrementalLexer {
+public:
+    // What an edit did to the token stream
+    struct Delta {
+        size_t first = 0;       // Index of the first token that changed
+        size_t removed = 0;     // Old tokens taken out at `first`
+        size_t inserted = 0;    // New tokens, now at [first, first + inserted)
+    };
+
+private:
+    SourceText source;
+    TokenBuffer tokens;
+
+public:
+    explicit IncrementalLexer(std::string text);
+
+    // Replaces `length` bytes at `offset` with `text`. Throws
+    // std::out_of_range if the range is not inside the document.
+    Delta edit(size_t offset, size_t length, const std::string& text);
+
+    const TokenBuffer& getTokens() const { return tokens; }
+    std::string_view getText() const { return source->view(); }
+};
+
+#endif
@@ -1,18 +1,88 @@
 #ifndef KEYWORDS_H
 #define KEYWORDS_H
 
+#include <array>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include "CharClass.h"
 #include "Token.h"
 
+// The reserved words, in a perfect hash table built at compile time: a
+// word's first and last characters and its length pick the only slot it
+// can be in, so a lookup is one hash and at most one comparison
 class Keywords {
 private:
-    static std::unordered_map<std::string, TokenType> keywordMap;
-    
+    struct Entry {
+        std::string_view word;
+        TokenType type = TokenType::IDENTIFIER;
+    };
+
+    static constexpr Entry LIST[] = {
+        {"let", TokenType::LET},
+        {"if", TokenType::IF},
+        {"else", TokenType::ELSE},
+        {"while", TokenType::WHILE},
+        {"for", TokenType::FOR},
+        {"function", TokenType::FUNCTION},
+        {"return", TokenType::RETURN},
+        {"end", TokenType::END},
+        {"then", TokenType::THEN},
+        {"do", TokenType::DO},
+        {"int", TokenType::INT_TYPE},
+        {"float", TokenType::FLOAT_TYPE},
+        {"bool", TokenType::BOOL_TYPE},
+        {"string", TokenType::STRING_TYPE},
+        {"void", TokenType::VOID_TYPE},
+        {"true", TokenType::BOOL_LITERAL},
+        {"false", TokenType::BOOL_LITERAL}
+    };
+
+    static constexpr size_t TABLE_SIZE = 32;
+    static constexpr size_t MIN_LENGTH = 2;
+    static constexpr size_t MAX_LENGTH = 8;
+
+    static constexpr size_t hash(std::string_view word) {
+        return (static_cast<unsigned char>(word.front()) * 3 + static_cast<unsigned char>(word.back()) * 2 +
+                word.size()) & (TABLE_SIZE - 1);
+    }
+
+    static constexpr std::array<Entry, TABLE_SIZE> build() {
+        std::array<Entry, TABLE_SIZE> table{};
+        for (const Entry& entry : LIST) {
+            table[hash(entry.word)] = entry;
+        }
+        return table;
+    }
+
+    static const std::array<Entry, TABLE_SIZE> TABLE;
+
 public:
-    static void initialize();
+    // Every keyword is lowercase and landed in a slot of its own
+    static constexpr bool isPerfect() {
+        for (const Entry& entry : LIST) {
+            if (TABLE[hash(entry.word)].word != entry.word || !CharClass::is(entry.word.front(), CharClass::LOWER) ||
+                entry.word.size() < MIN_LENGTH || entry.word.size() > MAX_LENGTH) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The keyword's token type, or IDENTIFIER
+    static constexpr TokenType lookup(std::string_view word) {
+        if (word.size() < MIN_LENGTH || word.size() > MAX_LENGTH || !CharClass::is(word.front(), CharClass::LOWER)) {
+            return TokenType::IDENTIFIER;
+        }
+        const Entry& entry = TABLE[hash(word)];
+        return entry.word == word ? entry.type : TokenType::IDENTIFIER;
+    }
+
     static TokenType getKeyword(const std::string& word);
     static bool isKeyword(const std::string& word);
 };
 
-#endif
\ No newline at end of file
+inline constexpr std::array<Keywords::Entry, Keywords::TABLE_SIZE> Keywords::TABLE = Keywords::build();
+
+static_assert(Keywords::isPerfect(), "Keywords::hash gives two keywords the same slot");
+
+#endif
@@ -2,20 +2,20 @@
 #define LEXER_H
 
 #include "Token.h"
+#include "TokenBuffer.h"
 #include <string>
-#include <unordered_map>
 
+// Tokens point into the lexer's source, which they keep alive. The lexer
+// tracks only byte offsets; lines and columns come from the source's line
+// table when something asks for them.
 class Lexer {
 private:
-    std::string source;
+    SourceText source;
     size_t start;
     size_t current;
-    int line;
-    int column;
+    size_t end;             // Lexing stops here rather than at the end of the source
+    std::string errorMessage;   // Of the last ERROR scanToken() returned
     
-    std::unordered_map<std::string, TokenType> keywords;
-    
-    void initKeywords();
     bool isAtEnd() const;
     char advance();
     char peek() const;
@@ -24,17 +24,23 @@ private:
     void skipWhitespace();
     void skipComment();
     Token makeToken(TokenType type) const;
-    Token makeToken(TokenType type, std::variant<int, float, bool, std::string> value) const;
-    Token errorToken(const std::string& message) const;
-    Token stringLiteral();
-    Token numberLiteral();
-    Token identifier();
+    TokenType error(const std::string& message);
+    TokenType stringLiteral();
+    TokenType numberLiteral();
+    TokenType identifier();
+    // Scans one token into [start, current) without building a Token
+    TokenType scanToken();
     
 public:
     Lexer(const std::string& source);
+    explicit Lexer(SourceText source);
+    // Lexes only [begin, end)
+    Lexer(SourceText source, size_t begin, size_t end);
     Token nextToken();
-    int getLine() const { return line; }
-    int getColumn() const { return column; }
+    // Scans one token onto the end of `tokens` and returns its type
+    TokenType scanInto(TokenBuffer& tokens);
+    // The rest of the source, scanned in one pass
+    TokenBuffer tokenize();
 };
 
 #endif
\ No newline at end of file
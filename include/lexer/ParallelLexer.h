@@ -0,0 +1,26 @@
+#ifndef PARALLELLEXER_H
+#define PARALLELLEXER_H
+
+#include "TokenBuffer.h"
+#include <vector>
+
+// Lexes a large source on several threads. The source is cut into slices
+// just after newlines that are not inside a string literal, each slice is
+// tokenized by its own Lexer, and the buffers are joined; tokens hold
+// offsets into the whole source, so nothing in them needs shifting. The
+// result is the same TokenBuffer Lexer::tokenize() gives.
+class ParallelLexer {
+public:
+    // Slices are at least this long; smaller sources are lexed on the calling thread
+    static const size_t MIN_SLICE = 1 << 20;
+
+    // `threads` 0 uses every hardware thread
+    static TokenBuffer tokenize(const SourceText& source, unsigned threads = 0, size_t minSlice = MIN_SLICE);
+
+    // Offsets of up to `slices` - 1 safe cut points, in order. A quote
+    // opens a string unless it is in a comment and '#' opens a comment
+    // unless it is in a string, so one pass over both finds every string.
+    static std::vector<size_t> splitPoints(const SourceBuffer& source, size_t slices);
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Byte-run scanners the Lexer uses to step over whitespace, comments,
+// string bodies and identifiers a block at a time, and SourceBuffer uses
+// to find line starts. Each has a scalar,
+// an SSE2 (16 bytes) and an AVX2 (32 bytes) version; the widest one the
+// CPU supports is picked on first use. All of them stop at `length` and
+// never read past it.
+class Scan {
+public:
+    // Length of the leading run of ' ', '\t', '\r' and '\n'
+    static size_t spaces(const char* text, size_t length);
+    // Offset of the first `c`, or `length` if there is none
+    static size_t find(const char* text, size_t length, char c);
+    // Length of the leading run of [A-Za-z0-9_]
+    static size_t identifier(const char* text, size_t length);
+    // Appends the offset just past each '\n' to `starts`, in order
+    static void newlines(const char* text, size_t length, std::vector<size_t>& starts);
+
+    // "avx2", "sse2" or "scalar"
+    static const char* isa();
+    // Force an implementation (tests, benchmarks); false if the CPU lacks it
+    static bool use(const std::string& isa);
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SOURCEBUFFER_H
+#define SOURCEBUFFER_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Read-only program text that the lexer scans in place and tokens point
+// into. A regular file is mapped with mmap, so opening it costs the same
+// for any size and pages are read as the lexer reaches them; pipes,
+// terminals and other inputs that cannot be mapped are read in blocks
+// into one owned buffer. The text is not NUL-terminated.
+//
+// Tokens hold only offsets into it. The line and column of an offset are
+// found by position(), from a table of line starts built on the first
+// call, so lexing does no line bookkeeping at all.
+class SourceBuffer {
+public:
+    // Both from 1; a column counts bytes
+    struct Position {
+        int line;
+        int column;
+    };
+
+private:
+    const char* bytes;
+    size_t length;
+    bool mapped;
+    std::string owned;
+    Position origin;                            // Of the first byte
+    mutable std::once_flag linesFound;
+    mutable std::vector<size_t> lineStarts;     // Offset of each line's first byte
+
+    SourceBuffer();
+
+public:
+    ~SourceBuffer();
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    // Throws std::runtime_error if the file cannot be opened or read
+    static std::shared_ptr<const SourceBuffer> open(const std::string& filename);
+    // `origin` places text that is a piece of something else (a token
+    // made by a later stage gets the position of the one it replaces)
+    static std::shared_ptr<const SourceBuffer> fromString(std::string text, Position origin = {1, 1});
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(bytes, length); }
+    bool isMapped() const { return mapped; }
+
+    // Where the byte at `offset` (at most size()) is. The first call finds
+    // every newline with Scan; each call is then a binary search. Safe to
+    // call from several threads.
+    Position position(size_t offset) const;
+};
+
+#endif
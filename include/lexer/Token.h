@@ -1,7 +1,10 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include "SourceBuffer.h"
+#include <memory>
 #include <string>
+#include <string_view>
 #include <variant>
 
 enum class TokenType {
@@ -28,18 +31,34 @@ enum class TokenType {
     END_OF_FILE, ERROR
 };
 
+// Characters a token's lexeme points into: the lexer's source for scanned
+// tokens, a buffer of its own for tokens made by later stages. Shared, so
+// copying a token never copies text.
+using SourceText = std::shared_ptr<const SourceBuffer>;
+
+using Literal = std::variant<int, float, bool, std::string>;
+
 struct Token {
     TokenType type;
-    std::string lexeme;
-    std::variant<int, float, bool, std::string> value;
-    int line;
-    int column;
+    std::string_view lexeme;   // Into `text`
+    SourceText text;
     
+    // A token with text of its own, placed at `line` and `column`
     Token(TokenType type = TokenType::ERROR, 
-          std::string lexeme = "",
-          std::variant<int, float, bool, std::string> value = 0,
+          const std::string& lexeme = "",
           int line = 1, 
           int column = 1);
+    Token(TokenType type, SourceText text, size_t offset, size_t length);
+    
+    // Where the lexeme starts, looked up in the source's line table when
+    // a diagnostic or debug info asks (SourceBuffer::position)
+    SourceBuffer::Position position() const;
+    int line() const { return position().line; }
+    int column() const { return position().column; }
+    
+    // Value of an INT, FLOAT, BOOL or STRING literal, decoded from the lexeme
+    Literal literal() const;
+    static Literal decode(TokenType type, std::string_view lexeme);
     
     std::string toString() const;
     std::string typeToString() const;
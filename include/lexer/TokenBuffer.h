@@ -0,0 +1,91 @@
+#ifndef TOKENBUFFER_H
+#define TOKENBUFFER_H
+
+#include "Token.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A whole token stream, one array per field (struct of arrays). The
+// parser tests types far more often than it reads anything else, so the
+// types are one byte each and stay in cache; a Token object is only built
+// (token()) for the ones that end up in the AST. Literals are decoded once
+// while the buffer is filled. A filled buffer ends with END_OF_FILE.
+class TokenBuffer {
+public:
+    static constexpr uint32_t NO_LITERAL = UINT32_MAX;
+
+private:
+    // Leaves the new elements of resize() unset instead of zeroing them,
+    // so joined buffers are written once, by the threads that place() them
+    template <typename T>
+    struct Uninitialized : std::allocator<T> {
+        template <typename U> struct rebind { using other = Uninitialized<U>; };
+        Uninitialized() noexcept {}
+        template <typename U> Uninitialized(const Uninitialized<U>&) noexcept {}
+
+        template <typename U> void construct(U* p) noexcept { ::new (static_cast<void*>(p)) U; }
+        template <typename U, typename... Args> void construct(U* p, Args&&... args) {
+            ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+        }
+    };
+    template <typename T> using Array = std::vector<T, Uninitialized<T>>;
+
+    SourceText source;
+    Array<uint8_t> types;
+    Array<size_t> offsets;
+    Array<uint32_t> lengths;
+    Array<uint32_t> literalIndices;         // Into `literals`, or NO_LITERAL
+    std::vector<Literal> literals;          // Literal values; the message of an ERROR token
+
+public:
+    explicit TokenBuffer(SourceText source = nullptr) : source(std::move(source)) {}
+
+    void reserve(size_t count);
+    void push(TokenType type, size_t offset, size_t length);
+    // An ERROR token over the text at [offset, offset + length)
+    void pushError(const std::string& message, size_t offset, size_t length);
+
+    // Joining buffers lexed from slices of one source (ParallelLexer):
+    // resize() makes room for all of them, then place() copies the first
+    // `count` tokens of `part` to index `at` and its literals to
+    // `literalAt`. Parts that do not overlap can be placed from different
+    // threads.
+    void resize(size_t count, size_t literalCount);
+    void place(const TokenBuffer& part, size_t count, size_t at, size_t literalAt);
+
+    // After an edit (IncrementalLexer): replaces tokens [first, first + count)
+    // with the first `replacementCount` tokens of `replacement`, moves the
+    // tokens after them by `offsetShift` bytes, and switches to the edited
+    // `text`
+    void splice(SourceText text, size_t first, size_t count, const TokenBuffer& replacement,
+                size_t replacementCount, std::ptrdiff_t offsetShift);
+
+    size_t size() const { return types.size(); }
+    size_t literalCount() const { return literals.size(); }
+    TokenType type(size_t index) const { return static_cast<TokenType>(types[index]); }
+    size_t offset(size_t index) const { return offsets[index]; }
+    size_t length(size_t index) const { return lengths[index]; }
+    std::string_view lexeme(size_t index) const;
+    // Looked up from the offset (SourceBuffer::position)
+    SourceBuffer::Position position(size_t index) const { return source->position(offsets[index]); }
+    int line(size_t index) const { return position(index).line; }
+    int column(size_t index) const { return position(index).column; }
+    // The decoded value of a literal token; nullptr for other tokens
+    const Literal* literal(size_t index) const;
+    Token token(size_t index) const {
+        if (type(index) == TokenType::ERROR) {
+            SourceBuffer::Position at = position(index);
+            return Token(TokenType::ERROR, std::string(lexeme(index)), at.line, at.column);
+        }
+        return Token(type(index), source, offsets[index], lengths[index]);
+    }
+
+    const SourceText& getSource() const { return source; }
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef CONSTANTFOLDER_H
+#define CONSTANTFOLDER_H
+
+#include "../parser/AST.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// Folds constant subtrees into literals and propagates constants through
+// variables that are declared once and never assigned. Runs after semantic
+// analysis and rewrites the program in place. Anything that would raise a
+// runtime error (division by zero, operand types) is left for the
+// interpreter to report.
+class ConstantFolder {
+public:
+    struct Stats {
+        size_t foldedExpressions = 0;
+        size_t propagatedConstants = 0;
+        size_t nodesEliminated = 0;
+    };
+
+private:
+    // Innermost scope last; an entry without a value shadows outer constants
+    std::vector<std::unordered_map<std::string, const Value*>> scopes;
+    std::unordered_set<std::string> assigned;
+    std::unordered_map<std::string, int> declarations;
+    Stats stats;
+
+    void collect(const StmtPtr& stmt);
+    void collect(const ExprPtr& expr);
+    void foldStmt(const StmtPtr& stmt);
+    void foldStatements(const std::vector<StmtPtr>& statements);
+    void foldExpr(ExprPtr& expr);
+    const Value* lookup(const std::string& name) const;
+    void replace(ExprPtr& expr, const Value& value);
+
+public:
+    // Run the pass; returns the number of AST nodes eliminated
+    size_t run(const ProgramPtr& program);
+    const Stats& getStats() const { return stats; }
+    std::string report() const;
+
+    // Interpreter semantics on constants; false when evaluation would raise
+    // a runtime error, which has to be kept
+    static bool evaluateBinary(TokenType op, const Value& left, const Value& right, Value& result);
+    static bool evaluateUnary(TokenType op, const Value& operand, Value& result);
+    static bool isTruthy(const Value& value);
+    static size_t countNodes(const ExprPtr& expr);
+};
+
+#endif
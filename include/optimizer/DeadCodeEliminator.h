@@ -0,0 +1,56 @@
+#ifndef DEADCODEELIMINATOR_H
+#define DEADCODEELIMINATOR_H
+
+#include "../parser/AST.h"
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+// Removes code that can never run or whose result is never used:
+// statements after an unconditional return in a function body, if
+// branches and while loops whose condition is a literal (run
+// ConstantFolder first), and, when enabled, stores to variables that are
+// never read. The rewrite happens
+// in place on the program.
+class DeadCodeEliminator {
+public:
+    struct Stats {
+        size_t unreachableStatements = 0;
+        size_t constantBranches = 0;
+        size_t deadStores = 0;
+        size_t nodesEliminated = 0;
+    };
+
+private:
+    bool removeDeadStores;
+    std::unordered_set<std::string> reads;
+    // Variables assigned inside a larger expression, where the store
+    // cannot be dropped on its own
+    std::unordered_set<std::string> nestedAssignments;
+    Stats stats;
+    // Function bodies being rewritten; a return only ends a function, so
+    // statements after one are cut only inside a body
+    int functionDepth;
+
+    void collect(const StmtPtr& stmt);
+    void collect(const ExprPtr& expr, bool statementLevel);
+    bool isDeadStore(const std::string& name) const;
+
+    StmtPtr eliminate(const StmtPtr& stmt);
+    StmtPtr eliminateBranch(const StmtPtr& stmt);
+    void eliminateStatements(std::vector<StmtPtr>& statements);
+
+    static bool alwaysReturns(const StmtPtr& stmt);
+
+public:
+    explicit DeadCodeEliminator(bool removeDeadStores = true) : removeDeadStores(removeDeadStores), functionDepth(0) {}
+
+    // Run the pass; returns the number of AST nodes eliminated
+    size_t run(const ProgramPtr& program);
+    const Stats& getStats() const { return stats; }
+    std::string report() const;
+
+    static size_t countNodes(const StmtPtr& stmt);
+};
+
+#endif
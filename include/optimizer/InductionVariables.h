@@ -0,0 +1,81 @@
+#ifndef INDUCTIONVARIABLES_H
+#define INDUCTIONVARIABLES_H
+
+#include "../parser/AST.h"
+#include "SideEffects.h"
+#include "ValueKinds.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+// Finds basic induction variables in while loops: int variables whose only
+// update in the loop is a top-level `i = i + c` or `i = i - c` with a
+// constant step. For each one:
+//
+// - Strength reduction: `i * k` with a constant k is replaced by a fresh
+//   `$ivN` variable, initialized to `i * k` before the loop and advanced by
+//   `c * k` right after the update of i, so the loop only adds.
+// - Exit test normalization: a condition comparing i against a
+//   loop-invariant bound is rewritten to `i < bound` / `i > bound` with i
+//   on the left. Loops that count towards their bound are recorded as
+//   counted loops for the later tiers.
+class InductionVariables {
+public:
+    struct LoopInfo {
+        int line;
+        std::vector<std::string> inductionVariables;
+        std::string counter;   // The variable of a counted loop, empty otherwise
+        int step;
+        ExprPtr bound;         // Exclusive limit of a counted loop
+        size_t reduced;
+        bool normalized;
+    };
+
+    struct Stats {
+        size_t loops = 0;
+        size_t inductionVariables = 0;
+        size_t multiplicationsReduced = 0;
+        size_t exitTestsNormalized = 0;
+        size_t countedLoops = 0;
+    };
+
+private:
+    struct Induction {
+        std::string name;
+        int step;
+        size_t update;   // Index of the update in the loop body
+        std::map<int, std::string> derived;   // Factor -> `$ivN` holding i * factor
+    };
+
+    SideEffects effects;
+    ValueKinds kinds;
+    std::vector<std::unordered_set<std::string>> scopes;
+    std::vector<LoopInfo> loops;
+    Stats stats;
+    int nextTemporary;
+
+    bool isDeclared(const std::string& name) const;
+    bool isInvariant(const ExprPtr& expr, const std::unordered_set<std::string>& defined) const;
+    std::vector<Induction> findInductions(const std::shared_ptr<WhileStmt>& loop);
+    void reduce(ExprPtr& expr, std::vector<Induction>& inductions, LoopInfo& info);
+    void reduceInStmt(const StmtPtr& stmt, std::vector<Induction>& inductions, LoopInfo& info);
+    void normalizeExitTest(const std::shared_ptr<WhileStmt>& loop, const std::vector<Induction>& inductions,
+                           const std::unordered_set<std::string>& defined, LoopInfo& info);
+
+    void process(StmtPtr& stmt);
+    void processStatements(std::vector<StmtPtr>& statements);
+    std::vector<StmtPtr> processLoop(const std::shared_ptr<WhileStmt>& loop);
+
+public:
+    InductionVariables() : nextTemporary(0) {}
+
+    // Run the pass; returns the number of multiplications reduced
+    size_t run(const ProgramPtr& program);
+    const Stats& getStats() const { return stats; }
+    const std::vector<LoopInfo>& getLoops() const { return loops; }
+    std::string report() const;
+};
+
+#endif
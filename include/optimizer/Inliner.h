@@ -0,0 +1,87 @@
+#ifndef INLINER_H
+#define INLINER_H
+
+#include "../parser/AST.h"
+#include "SideEffects.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// Replaces calls to small, non-recursive top-level functions with their
+// bodies. A function whose body is a single `return expr;` is substituted
+// directly into the expression when its arguments are literals or
+// variables. Other bodies are expanded in front of the statement holding
+// the call, with parameters and locals renamed to fresh `$inlN_` names so
+// nothing at the call site is captured; this needs the call to be the
+// first thing the statement evaluates and the only return to be the last
+// statement of the body. Calls the profile marked hot (CallExpr::hot) may
+// inline bodies up to HOT_BUDGET_FACTOR times the budget.
+class Inliner {
+public:
+    struct Decision {
+        int line;
+        std::string callee;
+        bool inlined;
+        std::string reason;   // Why not, or how
+        size_t size;
+    };
+
+    struct Stats {
+        size_t sites = 0;
+        size_t inlined = 0;
+        size_t hot = 0;   // Inlined with the larger budget of hot call sites
+    };
+
+    static constexpr size_t HOT_BUDGET_FACTOR = 4;
+
+private:
+    struct Candidate {
+        std::shared_ptr<FunctionDeclStmt> function;
+        size_t size;
+        std::string rejection;                    // Set when no call can be inlined
+        ExprPtr returnValue;                      // Value of the final return, if any
+        bool expression;                          // Body is just `return expr;` without calls or stores
+        std::unordered_set<std::string> locals;   // Parameters and declarations
+        std::unordered_set<std::string> free;     // Everything else the body names
+    };
+
+    SideEffects effects;
+    size_t budget;
+    std::unordered_map<std::string, Candidate> candidates;
+    std::unordered_set<std::string> declaredFunctions;
+    std::vector<std::unordered_set<std::string>> scopes;   // scopes[0] is the top level
+    std::vector<Decision> decisions;
+    Stats stats;
+    int nextSite;
+    ExprPtr* currentRoot;   // The call the current statement may expand
+
+    void collectCandidates(const ProgramPtr& program);
+    size_t limitFor(const CallExpr& call) const { return call.hot ? budget * HOT_BUDGET_FACTOR : budget; }
+    const Candidate* check(const CallExpr& call, bool expression, std::string& reason) const;
+    void decide(const CallExpr& call, const Candidate* candidate, bool inlined, const std::string& reason);
+
+    void expand(const StmtPtr& stmt, std::vector<StmtPtr>& out);
+    void expandStatements(std::vector<StmtPtr>& statements);
+    void expandSlot(StmtPtr& stmt);
+    void substitute(ExprPtr& expr);
+    ExprPtr* firstCall(ExprPtr& expr);
+    bool inlineAt(ExprPtr& slot, bool wholeStatement, std::vector<StmtPtr>& out);
+
+public:
+    explicit Inliner(size_t budget = 40) : budget(budget), nextSite(0), currentRoot(nullptr) {}
+
+    // Run the pass; returns the number of call sites inlined
+    size_t run(const ProgramPtr& program);
+    const Stats& getStats() const { return stats; }
+    const std::vector<Decision>& getDecisions() const { return decisions; }
+    std::string report(bool verbose = false) const;
+
+    // Deep copies; names in `renames` are replaced, variables in `values`
+    // become copies of the given expressions
+    static ExprPtr clone(const ExprPtr& expr, const std::unordered_map<std::string, std::string>& renames,
+                         const std::unordered_map<std::string, ExprPtr>& values = {});
+    static StmtPtr clone(const StmtPtr& stmt, const std::unordered_map<std::string, std::string>& renames);
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef LOOPINVARIANTMOTION_H
+#define LOOPINVARIANTMOTION_H
+
+#include "../parser/AST.h"
+#include "SideEffects.h"
+#include "ValueKinds.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// Hoists loop-invariant expressions out of while loops. Each hoisted
+// expression is computed once into a fresh variable declared right before
+// the loop (the preheader) and the loop reads that variable instead. Since
+// the bytecode is generated from the AST, both engines benefit.
+//
+// An expression is invariant when none of the variables it reads are
+// defined in the loop, directly or through calls. It is only moved when
+// evaluating it early cannot change behaviour: anywhere in the loop if it
+// cannot raise a runtime error, and from the condition (which always runs
+// before the first iteration) if it can, which covers calls to pure
+// functions.
+class LoopInvariantMotion {
+public:
+    struct LoopInfo {
+        int line;
+        std::unordered_set<std::string> defined;   // Variables the loop may assign or declare
+        bool opaque;                               // Calls something unknown
+        size_t hoisted;
+    };
+
+    struct Stats {
+        size_t loops = 0;
+        size_t expressionsHoisted = 0;
+        size_t callsHoisted = 0;
+    };
+
+private:
+    SideEffects effects;
+    ValueKinds kinds;
+    std::vector<std::unordered_set<std::string>> scopes;
+    std::vector<LoopInfo> loops;
+    Stats stats;
+    int nextTemporary;
+
+    // Per-loop hoisting state
+    struct Hoisting {
+        LoopInfo* loop;
+        std::vector<StmtPtr> preheader;
+        std::unordered_map<std::string, std::string> temporaries;   // Expression key -> variable
+    };
+
+    bool isInvariant(const ExprPtr& expr, const LoopInfo& loop) const;
+    bool isDeclared(const std::string& name) const;
+
+    void process(StmtPtr& stmt);
+    void processStatements(std::vector<StmtPtr>& statements);
+    std::vector<StmtPtr> processLoop(const std::shared_ptr<WhileStmt>& loop);
+    void hoist(ExprPtr& expr, Hoisting& state, bool alwaysEvaluated);
+    void hoistInStmt(const StmtPtr& stmt, Hoisting& state);
+
+public:
+    LoopInvariantMotion() : nextTemporary(0) {}
+
+    // Run the pass; returns the number of expressions hoisted
+    size_t run(const ProgramPtr& program);
+    const Stats& getStats() const { return stats; }
+    const std::vector<LoopInfo>& getLoops() const { return loops; }
+    std::string report() const;
+
+    // Structural key; equal keys mean the same computation
+    static std::string key(const ExprPtr& expr);
+};
+
+#endif
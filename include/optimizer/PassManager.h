@@ -0,0 +1,70 @@
+#ifndef PASSMANAGER_H
+#define PASSMANAGER_H
+
+#include "../parser/AST.h"
+#include "../ir/IR.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// Runs registered AST or IR passes in registration order. Each pass has
+// the lowest optimization level it runs at (Config "optimize", -O0 to
+// -O3); passes above the current level are skipped. Every pass that runs
+// is timed and returns how many changes it made, and the form it produced
+// can be dumped after it with Config "print_after" (`--print-after=`).
+class PassManager {
+public:
+    static constexpr int MAX_LEVEL = 3;
+
+    using AstPass = std::function<size_t(const ProgramPtr&)>;
+    using IrPass = std::function<size_t(IRModule&)>;
+    using Report = std::function<std::string()>;
+
+    struct PassStats {
+        std::string name;
+        double milliseconds;
+        size_t changes;
+    };
+
+private:
+    struct Pass {
+        std::string name;
+        int level;
+        AstPass runAst;
+        IrPass runIr;
+        Report report;
+    };
+
+    int level;
+    std::string printAfter;   // Pass name, "all", or empty
+    std::vector<Pass> passes;
+    std::vector<PassStats> stats;
+
+    bool shouldPrint(const std::string& name) const;
+    void record(const Pass& pass, double milliseconds, size_t changes);
+
+public:
+    explicit PassManager(int level);
+
+    void add(const std::string& name, int level, AstPass pass, Report report = nullptr);
+    void add(const std::string& name, int level, IrPass pass, Report report = nullptr);
+    void setPrintAfter(const std::string& name) { printAfter = name; }
+
+    // Runs the passes of that kind enabled at the current level
+    void run(const ProgramPtr& program);
+    void run(IRModule& module);
+
+    int getLevel() const { return level; }
+    bool isRegistered(const std::string& name) const;
+    const std::vector<PassStats>& getStats() const { return stats; }
+    // Each pass's own report, then time and changes per pass
+    std::string report() const;
+
+    // Level from Config "optimize": 0 to 3, "true" means -O2 and "false" -O0
+    static int configuredLevel();
+    // Inliner budget in AST nodes: Config "inline_budget" if set, else 40
+    // (120 at -O3)
+    static size_t inlineBudget(int level);
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "../parser/AST.h"
+#include <cstdint>
+#include <map>
+#include <string>
+
+// Execution profile of one program: how often each `if` and `while`
+// condition held, the operand types every binary operator saw, and which
+// function each call reached. The VM records it (`--record-profile=`;
+// the interpreter for programs with calls) and a later compile reads it back
+// (`--use-profile=`). Sites are numbered by number() in source order, so a
+// profile only applies to the program text it was recorded from.
+class Profile {
+public:
+    struct Branch {
+        uint64_t taken = 0;      // Condition true: then branch, or another iteration
+        uint64_t notTaken = 0;
+    };
+
+    struct Call {
+        uint64_t count = 0;
+        std::map<unsigned, uint64_t> targets;   // Site of the called declaration -> calls
+    };
+
+private:
+    size_t sites = 0;
+    std::map<unsigned, Branch> branches;
+    std::map<unsigned, std::map<std::string, uint64_t>> operands;   // "int int" -> evaluations
+    std::map<unsigned, Call> calls;
+
+public:
+    // Gives every IfStmt, WhileStmt, BinaryExpr, CallExpr and
+    // FunctionDeclStmt a site from 1 in source order; returns the count
+    static size_t number(const ProgramPtr& program);
+
+    void setSites(size_t count) { sites = count; }
+    size_t getSites() const { return sites; }
+    bool empty() const { return branches.empty() && operands.empty() && calls.empty(); }
+
+    void recordBranch(unsigned site, bool taken);
+    void recordOperands(unsigned site, const std::string& left, const std::string& right);
+    void recordCall(unsigned site, unsigned target);
+
+    const Branch* getBranch(unsigned site) const;
+    const Call* getCall(unsigned site) const;
+    // The operand types ("int int") of at least `share` of the evaluations, or ""
+    std::string dominantOperands(unsigned site, double share) const;
+    uint64_t hottestCall() const;
+
+    // Text format, one site per line; load() replaces the current contents
+    bool save(const std::string& filename) const;
+    bool load(const std::string& filename);
+};
+
+#endif
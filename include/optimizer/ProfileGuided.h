@@ -0,0 +1,53 @@
+#ifndef PROFILEGUIDED_H
+#define PROFILEGUIDED_H
+
+#include "../parser/AST.h"
+#include "Profile.h"
+#include <string>
+#include <unordered_map>
+
+// Applies a recorded Profile to the AST (`--use-profile=`):
+//
+// - Layout: an `if` whose else branch ran more often than its then branch
+//   is inverted (`if !c then else-branch else then-branch`), so the hot
+//   path falls through in the bytecode and comes first in the IR.
+// - Types: a binary operator whose operands had one type on nearly every
+//   evaluation gets BinaryExpr::profiledType; the bytecode generator
+//   turns int and bool into guarded speculation for the baseline JIT.
+// - Calls: a busy call site that nearly always reached the top-level
+//   function of its name is marked CallExpr::hot for the Inliner.
+class ProfileGuided {
+public:
+    static constexpr uint64_t MIN_SAMPLES = 16;     // Fewer executions say nothing
+    static constexpr double TYPE_SHARE = 0.99;
+    static constexpr double TARGET_SHARE = 0.9;
+    static constexpr double HOT_CALL_SHARE = 0.1;   // Of the busiest call site's count
+
+    struct Stats {
+        size_t branchesInverted = 0;
+        size_t operationsTyped = 0;
+        size_t hotCalls = 0;
+    };
+
+private:
+    const Profile& profile;
+    std::unordered_map<std::string, unsigned> functions;   // Top-level function -> declaration site
+    uint64_t hottest;
+    Stats stats;
+
+    void visit(const StmtPtr& stmt);
+    void visit(const ExprPtr& expr);
+    void layout(IfStmt& ifStmt);
+    void specialize(BinaryExpr& binary);
+    void markHot(CallExpr& call);
+
+public:
+    explicit ProfileGuided(const Profile& profile) : profile(profile), hottest(0) {}
+
+    // Run the pass; returns the number of nodes changed
+    size_t run(const ProgramPtr& program);
+    const Stats& getStats() const { return stats; }
+    std::string report() const;
+};
+
+#endif
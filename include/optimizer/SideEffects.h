@@ -0,0 +1,45 @@
+#ifndef SIDEEFFECTS_H
+#define SIDEEFFECTS_H
+
+#include "../parser/AST.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Per-function summary of what a call can observe or change, including
+// everything its callees do. Variables are tracked by name; parameters
+// and names declared in the body count as locals.
+class SideEffects {
+public:
+    struct Summary {
+        std::unordered_set<std::string> reads;    // Non-local variables read
+        std::unordered_set<std::string> writes;   // Non-local variables assigned
+        bool io = false;                          // print/input
+        bool unknownCalls = false;                // Calls something that is not a known function
+        bool recursive = false;
+    };
+
+private:
+    std::unordered_map<std::string, Summary> functions;
+    std::unordered_map<std::string, std::unordered_set<std::string>> callGraph;
+
+    void summarize(const FunctionDeclStmt& function);
+
+public:
+    void analyze(const ProgramPtr& program);
+
+    const Summary* find(const std::string& function) const;
+    // No output and no stores outside the callee; the result depends only
+    // on the arguments and summary->reads
+    bool isPure(const std::string& function) const;
+    // Names that evaluating the statement or expression can assign, calls
+    // included; false when it calls something unknown
+    bool collectWrites(const StmtPtr& stmt, std::unordered_set<std::string>& writes) const;
+    bool collectWrites(const ExprPtr& expr, std::unordered_set<std::string>& writes) const;
+
+    // Library functions without side effects (StandardLibrary)
+    static bool isPureNative(const std::string& name);
+    static bool isIONative(const std::string& name);
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef VALUEKINDS_H
+#define VALUEKINDS_H
+
+#include "../parser/AST.h"
+#include <string>
+#include <unordered_map>
+
+// What each variable is known to hold, by name across the program. A
+// variable gets a kind once every definition of it agrees; parameters and
+// variables declared without a value are UNKNOWN.
+class ValueKinds {
+public:
+    enum class Kind { NONE, INT, FLOAT, NUMBER, STRING, BOOL, UNKNOWN };
+
+private:
+    std::unordered_map<std::string, Kind> kinds;
+
+public:
+    void infer(const ProgramPtr& program);
+    void set(const std::string& name, Kind kind) { kinds[name] = kind; }
+
+    // UNKNOWN when the expression can fail at runtime
+    Kind kindOf(const ExprPtr& expr) const;
+    bool cannotTrap(const ExprPtr& expr) const;
+
+    static bool isNumeric(Kind kind);
+};
+
+#endif
@@ -43,6 +43,10 @@ enum class StmtType {
 // Base Expression class
 class Expr {
 public:
+    // Set by the TypeChecker: INT_TYPE, FLOAT_TYPE, BOOL_TYPE or STRING_TYPE
+    // when every evaluation produces that type, ERROR when only known at runtime
+    TokenType staticType = TokenType::ERROR;
+    
     virtual ~Expr() = default;
     virtual ExprType getType() const = 0;
     virtual Value accept(class Visitor& visitor) const = 0;
@@ -82,6 +86,8 @@ public:
     ExprPtr left;
     Token op;
     ExprPtr right;
+    unsigned site = 0;                           // Profile site, see Profile::number
+    TokenType profiledType = TokenType::ERROR;   // Type of both operands in the profile, if dominant
     
     BinaryExpr(ExprPtr left, const Token& op, ExprPtr right)
         : left(left), op(op), right(right) {}
@@ -106,6 +112,8 @@ class CallExpr : public Expr {
 public:
     Token callee;
     std::vector<ExprPtr> arguments;
+    unsigned site = 0;    // Profile site, see Profile::number
+    bool hot = false;     // The profile saw many calls, nearly all to this name's top-level function
     
     CallExpr(const Token& callee, std::vector<ExprPtr> arguments)
         : callee(callee), arguments(arguments) {}
@@ -140,6 +148,7 @@ class VariableDeclStmt : public Stmt {
 public:
     Token name;
     ExprPtr initializer;
+    TokenType staticType = TokenType::ERROR;   // Type of every value the binding holds
     
     VariableDeclStmt(const Token& name, ExprPtr initializer)
         : name(name), initializer(initializer) {}
@@ -173,6 +182,7 @@ public:
     ExprPtr condition;
     StmtPtr thenBranch;
     StmtPtr elseBranch;
+    unsigned site = 0;   // Profile site, see Profile::number
     
     IfStmt(ExprPtr condition, StmtPtr thenBranch, StmtPtr elseBranch = nullptr)
         : condition(condition), thenBranch(thenBranch), elseBranch(elseBranch) {}
@@ -185,6 +195,7 @@ class WhileStmt : public Stmt {
 public:
     ExprPtr condition;
     StmtPtr body;
+    unsigned site = 0;   // Profile site, see Profile::number
     
     WhileStmt(ExprPtr condition, StmtPtr body)
         : condition(condition), body(body) {}
@@ -199,6 +210,7 @@ public:
     std::vector<std::pair<Token, TokenType>> parameters;
     TokenType returnType;
     StmtPtr body;
+    unsigned site = 0;   // Profile site, see Profile::number
     
     FunctionDeclStmt(const Token& name, 
                     std::vector<std::pair<Token, TokenType>> parameters,
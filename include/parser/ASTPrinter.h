@@ -0,0 +1,25 @@
+#ifndef ASTPRINTER_H
+#define ASTPRINTER_H
+
+#include "AST.h"
+#include <string>
+
+// Source form of the AST, one statement per line, e.g.
+//   let i = 0;
+//   while (i < 10) do {
+//     i = (i + 1);
+//   } end;
+// Binary and unary expressions are fully parenthesized so rewrites made by
+// the optimizer show their structure.
+class ASTPrinter {
+private:
+    static void printStatement(const StmtPtr& stmt, int depth, std::string& out);
+    static void printBranch(const StmtPtr& stmt, int depth, std::string& out);
+
+public:
+    static std::string print(const ProgramPtr& program);
+    static std::string print(const StmtPtr& stmt);
+    static std::string print(const ExprPtr& expr);
+};
+
+#endif
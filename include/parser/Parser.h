@@ -7,18 +7,24 @@
 #include <vector>
 #include <memory>
 
+// Parses a TokenBuffer by index; Tokens are built only for AST nodes and errors
 class Parser {
 private:
-    Lexer& lexer;
-    Token current;
-    Token previous;
+    TokenBuffer tokens;
+    size_t position;        // Index of the current token
+    size_t previousIndex;
     std::vector<Error> errors;
     
+    Token current() const { return tokens.token(position); }
+    Token previous() const { return tokens.token(previousIndex); }
+    TokenType peekNext() const;
     void advance();
     bool check(TokenType type) const;
     bool match(TokenType type);
     bool consume(TokenType type, const std::string& message);
     Token consume(TokenType type);
+    // Skips past a statement that failed to parse, which started at `start`
+    void synchronize(size_t start);
     
     // Parsing methods
     ProgramPtr parseProgram();
@@ -46,6 +52,7 @@ private:
     
 public:
     Parser(Lexer& lexer);
+    explicit Parser(TokenBuffer tokens);
     ProgramPtr parse();
     const std::vector<Error>& getErrors() const { return errors; }
     bool hasErrors() const { return !errors.empty(); }
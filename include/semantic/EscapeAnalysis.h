@@ -0,0 +1,98 @@
+#ifndef ESCAPEANALYSIS_H
+#define ESCAPEANALYSIS_H
+
+#include "../parser/AST.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// Decides which functions and variables outlive the scope that created
+// them, so the interpreter does not have to keep every environment chain
+// alive on the heap.
+//
+// A function escapes when its value is read (stored, passed or returned)
+// rather than only called, or when a nested function calls it through an
+// upvalue. A function that does not escape can only run
+// while its defining frame is alive, so it refers to that frame without
+// owning it. An escaping function gets its own small environment holding
+// its upvalues: the enclosing locals it uses, each boxed in a shared cell
+// so both sides see assignments. Frames no escaping function pins can
+// then live on the C++ stack.
+//
+// An escaping function that uses an enclosing local declared after it
+// (only visible once that declaration runs) still captures its defining
+// frame whole; that frame and every frame around it stay on the heap.
+class EscapeAnalysis {
+public:
+    struct FunctionInfo {
+        std::vector<std::string> upvalues;   // Enclosing locals it or a nested function uses
+        bool escapes = false;
+        bool capturesFrame = false;          // Needs names that are not declared yet where it is defined
+        bool pinned = false;                 // Keeps its defining frame chain: owns it, frames on the heap
+    };
+
+    struct Stats {
+        size_t functions = 0;
+        size_t escaping = 0;
+        size_t pinned = 0;
+        size_t boxedVariables = 0;
+        size_t stackFrames = 0;
+        size_t heapFrames = 0;
+    };
+
+private:
+    struct Scope {
+        const void* owner;   // BlockStmt, FunctionDeclStmt for a call frame, null for globals
+        std::unordered_map<std::string, const FunctionDeclStmt*> declared;   // So far; null for variables
+        std::unordered_set<std::string> names;   // Everything the frame declares
+    };
+
+    struct Active {
+        const FunctionDeclStmt* function;
+        size_t frame;   // Index of its call frame in scopes
+    };
+
+    struct Chain {
+        std::vector<const void*> frames;                   // Non-global frames around the declaration
+        std::vector<const FunctionDeclStmt*> enclosing;
+    };
+
+    struct Capture {
+        const FunctionDeclStmt* function;
+        const void* owner;
+        std::string name;
+    };
+
+    std::vector<Scope> scopes;
+    std::vector<Active> active;
+    std::unordered_map<const FunctionDeclStmt*, FunctionInfo> functions;
+    std::unordered_map<const FunctionDeclStmt*, Chain> chains;
+    std::unordered_map<std::string, std::vector<const FunctionDeclStmt*>> byName;
+    std::vector<Capture> captures;
+    std::unordered_set<const void*> frames;
+    std::unordered_set<const void*> heapFrames;
+    Stats stats;
+
+    void pushScope(const void* owner, const std::vector<StmtPtr>& statements);
+    int resolve(const std::string& name) const;
+    void use(const std::string& name, bool asValue);
+    void walk(const StmtPtr& stmt);
+    void walk(const ExprPtr& expr);
+
+public:
+    void analyze(const ProgramPtr& program);
+
+    // Null for functions the analysis has not seen
+    const FunctionInfo* find(const FunctionDeclStmt* function) const;
+    // Whether a block's frame, or a function's call frame, can live on the
+    // stack; false for frames the analysis has not seen
+    bool isStackFrame(const void* owner) const {
+        return frames.count(owner) > 0 && heapFrames.count(owner) == 0;
+    }
+
+    const Stats& getStats() const { return stats; }
+    std::string report() const;
+};
+
+#endif
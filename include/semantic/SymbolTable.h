@@ -20,6 +20,7 @@ struct Symbol {
     int scopeLevel;
     bool isInitialized;
     bool isConstant;
+    const Token* declaration = nullptr;   // Name token of the declaring node, if known
     
     Symbol(const std::string& name, SymbolType symType, TokenType dataType, 
            int scopeLevel, bool initialized = false, bool constant = false)
@@ -5,30 +5,68 @@
 #include "../parser/AST.h"
 #include "../core/Error.h"
 #include <memory>
+#include <string>
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 
+// Local type inference. Every expression is annotated with its static type
+// (Expr::staticType) and every `let` with the type of all values it holds
+// (VariableDeclStmt::staticType); DYNAMIC marks anything only known at
+// runtime. A binding starts with the type of its initializer and becomes
+// DYNAMIC once it is assigned something else, so checking repeats until no
+// binding changes. Parameters keep their declared type while every call
+// passes exactly that type, and a call has its function's return type when
+// every path returns a value of that type.
+//
+// Operations that would always fail at runtime (`"a" - 1`, `-true`, an
+// argument of the wrong type) are reported as errors.
 class TypeChecker : public Visitor {
+public:
+    static constexpr TokenType DYNAMIC = TokenType::ERROR;
+
 private:
+    struct FunctionInfo {
+        const FunctionDeclStmt* declaration;
+        bool returnsDeclared;   // Every path returns a value of the declared type
+    };
+
     std::shared_ptr<SymbolTable> currentScope;
     std::vector<Error> errors;
     TokenType currentReturnType;
     bool inFunction;
-    
+    const FunctionDeclStmt* currentFunction;
+    int functionScopeLevel;
+    TokenType currentType;   // Type of the expression just visited
+
+    // Inference state kept across rounds
+    std::unordered_map<const Token*, TokenType> bindings;   // Declaration -> type
+    std::unordered_map<std::string, FunctionInfo> functions;
+    std::unordered_map<std::string, int> declarationCounts;
+    std::unordered_set<std::string> dynamicNames;   // Assigned where no declaration is visible
+    bool changed;
+
     // Type checking helpers
     TokenType getExpressionType(const ExprPtr& expr);
-    bool checkType(TokenType expected, TokenType actual, const Token& token);
     bool isNumericType(TokenType type);
-    bool isBooleanType(TokenType type);
-    bool isStringType(TokenType type);
     bool typesCompatible(TokenType t1, TokenType t2);
-    TokenType getBinaryResultType(TokenType left, TokenType right, TokenType op);
-    
+    bool getBinaryResultType(TokenType left, TokenType right, TokenType op, TokenType& result);
+
+    // Inference helpers
+    void collectDeclarations(const StmtPtr& stmt);
+    void checkStatement(const StmtPtr& stmt);
+    void declare(const Token& name, SymbolType kind, TokenType type);
+    void refine(const Token* declaration, TokenType type);
+    void markDynamic(const std::string& name);
+    void markReturnsDynamic(const std::string& function);
+    std::shared_ptr<Symbol> resolve(const std::string& name);
+
     // Error reporting
     void reportError(const Token& token, const std::string& message);
-    
+
 public:
     TypeChecker();
-    
+
     // Expression visitors
     Value visitLiteralExpr(const LiteralExpr& expr) override;
     Value visitVariableExpr(const VariableExpr& expr) override;
@@ -36,7 +74,7 @@ public:
     Value visitUnaryExpr(const UnaryExpr& expr) override;
     Value visitCallExpr(const CallExpr& expr) override;
     Value visitAssignmentExpr(const AssignmentExpr& expr) override;
-    
+
     // Statement visitors
     void visitPrintStmt(const PrintStmt& stmt) override;
     void visitVariableDeclStmt(const VariableDeclStmt& stmt) override;
@@ -46,11 +84,16 @@ public:
     void visitWhileStmt(const WhileStmt& stmt) override;
     void visitFunctionDeclStmt(const FunctionDeclStmt& stmt) override;
     void visitReturnStmt(const ReturnStmt& stmt) override;
-    
+
     // Main type checking method
     void check(const ProgramPtr& program);
     const std::vector<Error>& getErrors() const { return errors; }
     bool hasErrors() const { return !errors.empty(); }
+
+    // Declared and inferred return type of a function; DYNAMIC when a call
+    // can produce anything else
+    TokenType getReturnType(const std::string& function) const;
+    static std::string typeName(TokenType type);
 };
 
-#endif
\ No newline at end of file
+#endif
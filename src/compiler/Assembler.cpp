@@ -0,0 +1,364 @@
+#include "Assembler.h"
+
+void Assembler::emit(uint8_t byte) {
+    code.push_back(byte);
+}
+
+void Assembler::emit32(uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        emit(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void Assembler::emit64(uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        emit(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void Assembler::emitRex(bool wide, int reg, int base) {
+    uint8_t rex = 0x40;
+    if (wide) rex |= 0x08;
+    if (reg & 8) rex |= 0x04;
+    if (base & 8) rex |= 0x01;
+    if (rex != 0x40) {
+        emit(rex);
+    }
+}
+
+void Assembler::emitMem(int reg, Reg base, int32_t disp) {
+    // mod=10: [base + disp32]; rsp/r12 as base need a SIB byte
+    emit(static_cast<uint8_t>(0x80 | ((reg & 7) << 3) | (base & 7)));
+    if ((base & 7) == RSP) {
+        emit(0x24);
+    }
+    emit32(static_cast<uint32_t>(disp));
+}
+
+void Assembler::emitRegReg(int reg, int rm) {
+    emit(static_cast<uint8_t>(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+void Assembler::emitSse(uint8_t prefix, uint8_t opcode, int reg, int rm) {
+    // Mandatory prefix goes before REX
+    if (prefix) emit(prefix);
+    emitRex(false, reg, rm);
+    emit(0x0F);
+    emit(opcode);
+    emitRegReg(reg, rm);
+}
+
+void Assembler::emitSseMem(uint8_t prefix, uint8_t opcode, int reg, Reg base, int32_t disp) {
+    if (prefix) emit(prefix);
+    emitRex(false, reg, base);
+    emit(0x0F);
+    emit(opcode);
+    emitMem(reg, base, disp);
+}
+
+// Labels
+Label Assembler::newLabel() {
+    labels.push_back(static_cast<size_t>(-1));
+    return labels.size() - 1;
+}
+
+void Assembler::bind(Label label) {
+    labels[label] = code.size();
+}
+
+bool Assembler::isBound(Label label) const {
+    return labels[label] != static_cast<size_t>(-1);
+}
+
+// Stack frame
+void Assembler::push(Reg reg) {
+    emitRex(false, 0, reg);
+    emit(static_cast<uint8_t>(0x50 + (reg & 7)));
+}
+
+void Assembler::pop(Reg reg) {
+    emitRex(false, 0, reg);
+    emit(static_cast<uint8_t>(0x58 + (reg & 7)));
+}
+
+void Assembler::ret() {
+    emit(0xC3);
+}
+
+void Assembler::addImm64(Reg reg, int8_t value) {
+    emitRex(true, 0, reg);
+    emit(0x83);
+    emitRegReg(0, reg);
+    emit(static_cast<uint8_t>(value));
+}
+
+void Assembler::subImm64(Reg reg, int8_t value) {
+    emitRex(true, 0, reg);
+    emit(0x83);
+    emitRegReg(5, reg);
+    emit(static_cast<uint8_t>(value));
+}
+
+// Moves
+void Assembler::movRegReg(Reg dst, Reg src) {
+    emitRex(true, src, dst);
+    emit(0x89);
+    emitRegReg(src, dst);
+}
+
+void Assembler::movImm64(Reg dst, uint64_t value) {
+    emitRex(true, 0, dst);
+    emit(static_cast<uint8_t>(0xB8 + (dst & 7)));
+    emit64(value);
+}
+
+void Assembler::movImm32(Reg dst, uint32_t value) {
+    emitRex(false, 0, dst);
+    emit(static_cast<uint8_t>(0xB8 + (dst & 7)));
+    emit32(value);
+}
+
+void Assembler::load64(Reg dst, Reg base, int32_t disp) {
+    emitRex(true, dst, base);
+    emit(0x8B);
+    emitMem(dst, base, disp);
+}
+
+void Assembler::load32(Reg dst, Reg base, int32_t disp) {
+    emitRex(false, dst, base);
+    emit(0x8B);
+    emitMem(dst, base, disp);
+}
+
+void Assembler::store64(Reg base, int32_t disp, Reg src) {
+    emitRex(true, src, base);
+    emit(0x89);
+    emitMem(src, base, disp);
+}
+
+void Assembler::store32(Reg base, int32_t disp, Reg src) {
+    emitRex(false, src, base);
+    emit(0x89);
+    emitMem(src, base, disp);
+}
+
+void Assembler::storeImm64(Reg base, int32_t disp, int32_t value) {
+    emitRex(true, 0, base);
+    emit(0xC7);
+    emitMem(0, base, disp);
+    emit32(static_cast<uint32_t>(value));
+}
+
+void Assembler::storeImm8(Reg base, int32_t disp, uint8_t value) {
+    emitRex(false, 0, base);
+    emit(0xC6);
+    emitMem(0, base, disp);
+    emit(value);
+}
+
+void Assembler::lea(Reg dst, Reg base, int32_t disp) {
+    emitRex(true, dst, base);
+    emit(0x8D);
+    emitMem(dst, base, disp);
+}
+
+void Assembler::movsxd(Reg dst, Reg src) {
+    emitRex(true, dst, src);
+    emit(0x63);
+    emitRegReg(dst, src);
+}
+
+void Assembler::movzxByte(Reg dst, Reg src) {
+    // spl/bpl/sil/dil are only addressable with a REX prefix
+    if ((dst & 8) || (src & 8) || (src >= RSP && src <= RDI)) {
+        emit(static_cast<uint8_t>(0x40 | ((dst & 8) ? 0x04 : 0) | ((src & 8) ? 0x01 : 0)));
+    }
+    emit(0x0F);
+    emit(0xB6);
+    emitRegReg(dst, src);
+}
+
+// 32-bit integer arithmetic
+void Assembler::add32(Reg dst, Reg src) {
+    emitRex(false, src, dst);
+    emit(0x01);
+    emitRegReg(src, dst);
+}
+
+void Assembler::sub32(Reg dst, Reg src) {
+    emitRex(false, src, dst);
+    emit(0x29);
+    emitRegReg(src, dst);
+}
+
+void Assembler::imul32(Reg dst, Reg src) {
+    emitRex(false, dst, src);
+    emit(0x0F);
+    emit(0xAF);
+    emitRegReg(dst, src);
+}
+
+void Assembler::neg32(Reg reg) {
+    emitRex(false, 0, reg);
+    emit(0xF7);
+    emitRegReg(3, reg);
+}
+
+void Assembler::cdq() {
+    emit(0x99);
+}
+
+void Assembler::idiv32(Reg divisor) {
+    emitRex(false, 0, divisor);
+    emit(0xF7);
+    emitRegReg(7, divisor);
+}
+
+// Logic and comparisons
+void Assembler::xor32(Reg dst, Reg src) {
+    emitRex(false, src, dst);
+    emit(0x31);
+    emitRegReg(src, dst);
+}
+
+void Assembler::and8(Reg dst, Reg src) {
+    emitRex(false, src, dst);
+    emit(0x20);
+    emitRegReg(src, dst);
+}
+
+void Assembler::or8(Reg dst, Reg src) {
+    emitRex(false, src, dst);
+    emit(0x08);
+    emitRegReg(src, dst);
+}
+
+void Assembler::test64(Reg a, Reg b) {
+    emitRex(true, b, a);
+    emit(0x85);
+    emitRegReg(b, a);
+}
+
+void Assembler::cmp64(Reg a, Reg b) {
+    emitRex(true, b, a);
+    emit(0x39);
+    emitRegReg(b, a);
+}
+
+void Assembler::test32(Reg a, Reg b) {
+    emitRex(false, b, a);
+    emit(0x85);
+    emitRegReg(b, a);
+}
+
+void Assembler::cmp32(Reg a, Reg b) {
+    emitRex(false, b, a);
+    emit(0x39);
+    emitRegReg(b, a);
+}
+
+void Assembler::cmp32Imm(Reg reg, int32_t value) {
+    emitRex(false, 0, reg);
+    emit(0x81);
+    emitRegReg(7, reg);
+    emit32(static_cast<uint32_t>(value));
+}
+
+void Assembler::cmpMemImm64(Reg base, int32_t disp, int8_t value) {
+    emitRex(true, 0, base);
+    emit(0x83);
+    emitMem(7, base, disp);
+    emit(static_cast<uint8_t>(value));
+}
+
+void Assembler::cmpMemImm8(Reg base, int32_t disp, uint8_t value) {
+    emitRex(false, 0, base);
+    emit(0x80);
+    emitMem(7, base, disp);
+    emit(value);
+}
+
+void Assembler::setcc(Cond cond, Reg dst) {
+    if ((dst & 8) || (dst >= RSP && dst <= RDI)) {
+        emit(static_cast<uint8_t>(0x40 | ((dst & 8) ? 0x01 : 0)));
+    }
+    emit(0x0F);
+    emit(static_cast<uint8_t>(0x90 | static_cast<uint8_t>(cond)));
+    emitRegReg(0, dst);
+}
+
+// Scalar single-precision floats
+void Assembler::movssLoad(XReg dst, Reg base, int32_t disp) {
+    emitSseMem(0xF3, 0x10, dst, base, disp);
+}
+
+void Assembler::movssStore(Reg base, int32_t disp, XReg src) {
+    emitSseMem(0xF3, 0x11, src, base, disp);
+}
+
+void Assembler::movdToXmm(XReg dst, Reg src) {
+    emitSse(0x66, 0x6E, dst, src);
+}
+
+void Assembler::movaps(XReg dst, XReg src) {
+    emitSse(0, 0x28, dst, src);
+}
+
+void Assembler::addss(XReg dst, XReg src) {
+    emitSse(0xF3, 0x58, dst, src);
+}
+
+void Assembler::subss(XReg dst, XReg src) {
+    emitSse(0xF3, 0x5C, dst, src);
+}
+
+void Assembler::mulss(XReg dst, XReg src) {
+    emitSse(0xF3, 0x59, dst, src);
+}
+
+void Assembler::divss(XReg dst, XReg src) {
+    emitSse(0xF3, 0x5E, dst, src);
+}
+
+void Assembler::xorps(XReg dst, XReg src) {
+    emitSse(0, 0x57, dst, src);
+}
+
+void Assembler::ucomiss(XReg a, XReg b) {
+    emitSse(0, 0x2E, a, b);
+}
+
+void Assembler::cvtsi2ss(XReg dst, Reg src) {
+    emitSse(0xF3, 0x2A, dst, src);
+}
+
+// Control flow
+void Assembler::jmp(Label label) {
+    emit(0xE9);
+    fixups.emplace_back(code.size(), label);
+    emit32(0);
+}
+
+void Assembler::jcc(Cond cond, Label label) {
+    emit(0x0F);
+    emit(static_cast<uint8_t>(0x80 | static_cast<uint8_t>(cond)));
+    fixups.emplace_back(code.size(), label);
+    emit32(0);
+}
+
+void Assembler::call(Reg target) {
+    emitRex(false, 0, target);
+    emit(0xFF);
+    emitRegReg(2, target);
+}
+
+const std::vector<uint8_t>& Assembler::finalize() {
+    for (const auto& [position, label] : fixups) {
+        int32_t relative = static_cast<int32_t>(labels[label]) - static_cast<int32_t>(position + 4);
+        for (int i = 0; i < 4; i++) {
+            code[position + i] = static_cast<uint8_t>(static_cast<uint32_t>(relative) >> (8 * i));
+        }
+    }
+    fixups.clear();
+    return code;
+}
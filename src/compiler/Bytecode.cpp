@@ -1,6 +1,7 @@
 #include "Bytecode.h"
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 
 void BytecodeWriter::writeByte(uint8_t byte) {
     code.push_back(byte);
@@ -18,6 +19,73 @@ void BytecodeWriter::writeOperand(uint32_t operand) {
     writeByte(operand & 0xFF);
 }
 
+void BytecodeWriter::patchOperand(size_t offset, uint32_t operand) {
+    // Rewrite a previously emitted operand in place (used for forward jumps)
+    code[offset] = (operand >> 24) & 0xFF;
+    code[offset + 1] = (operand >> 16) & 0xFF;
+    code[offset + 2] = (operand >> 8) & 0xFF;
+    code[offset + 3] = operand & 0xFF;
+}
+
+uint32_t BytecodeWriter::readOperand(size_t offset) const {
+    return (static_cast<uint32_t>(code[offset]) << 24) |
+           (static_cast<uint32_t>(code[offset + 1]) << 16) |
+           (static_cast<uint32_t>(code[offset + 2]) << 8) |
+           static_cast<uint32_t>(code[offset + 3]);
+}
+
+size_t BytecodeWriter::slotCount() const {
+    size_t count = 0;
+    size_t offset = 0;
+    while (offset < code.size()) {
+        OpCode opcode = static_cast<OpCode>(code[offset++]);
+        if (!hasOperand(opcode)) continue;
+        
+        if (opcode == OpCode::LOAD_VAR || opcode == OpCode::STORE_VAR ||
+            opcode == OpCode::DECLARE_VAR) {
+            count = std::max(count, static_cast<size_t>(readOperand(offset)) + 1);
+        }
+        offset += 4;
+    }
+    return count;
+}
+
+void BytecodeWriter::markLine(int line) {
+    if (line <= 0 || (!lines.empty() && lines.back().second == line)) {
+        return;
+    }
+    if (!lines.empty() && lines.back().first == code.size()) {
+        lines.back().second = line; // Nothing emitted for the previous line yet
+    } else {
+        lines.push_back({code.size(), line});
+    }
+}
+
+int BytecodeWriter::getLine(size_t offset) const {
+    auto it = std::upper_bound(lines.begin(), lines.end(), offset,
+                               [](size_t value, const std::pair<size_t, int>& entry) {
+                                   return value < entry.first;
+                               });
+    return it == lines.begin() ? 0 : std::prev(it)->second;
+}
+
+bool BytecodeWriter::hasOperand(OpCode opcode) {
+    switch (opcode) {
+        case OpCode::LOAD_CONST:
+        case OpCode::LOAD_VAR:
+        case OpCode::STORE_VAR:
+        case OpCode::DECLARE_VAR:
+        case OpCode::JUMP:
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::JUMP_IF_TRUE:
+        case OpCode::CALL:
+        case OpCode::PRINT:
+            return true;
+        default:
+            return false;
+    }
+}
+
 void BytecodeWriter::addConstant(const Value& value) {
     constants.push_back(value);
 }
@@ -35,6 +103,40 @@ size_t BytecodeWriter::addConstantGetIndex(const Value& value) {
     return constants.size() - 1;
 }
 
+void BytecodeWriter::markUnchecked(size_t offset) {
+    if (unchecked.empty() || unchecked.back() < offset) {
+        unchecked.push_back(offset);
+    }
+}
+
+bool BytecodeWriter::isUnchecked(size_t offset) const {
+    return std::binary_search(unchecked.begin(), unchecked.end(), offset);
+}
+
+void BytecodeWriter::markExpected(size_t offset, TokenType type) {
+    if (expected.empty() || expected.back().first < offset) {
+        expected.emplace_back(offset, type);
+    }
+}
+
+TokenType BytecodeWriter::getExpected(size_t offset) const {
+    auto it = std::lower_bound(expected.begin(), expected.end(), offset,
+        [](const std::pair<size_t, TokenType>& entry, size_t value) { return entry.first < value; });
+    return it != expected.end() && it->first == offset ? it->second : TokenType::ERROR;
+}
+
+void BytecodeWriter::markSite(size_t offset, unsigned site) {
+    if (site && (sites.empty() || sites.back().first < offset)) {
+        sites.emplace_back(offset, site);
+    }
+}
+
+unsigned BytecodeWriter::getSite(size_t offset) const {
+    auto it = std::lower_bound(sites.begin(), sites.end(), offset,
+        [](const std::pair<size_t, unsigned>& entry, size_t value) { return entry.first < value; });
+    return it != sites.end() && it->first == offset ? it->second : 0;
+}
+
 void BytecodeWriter::disassemble() const {
     std::cout << "Bytecode (" << code.size() << " bytes):\n";
     std::cout << "========================\n";
@@ -45,31 +147,19 @@ void BytecodeWriter::disassemble() const {
         
         OpCode opcode = static_cast<OpCode>(code[offset]);
         std::cout << opcodeToString(opcode);
+        if (isUnchecked(offset)) {
+            std::cout << " (unchecked)";
+        }
+        TokenType expectedType = getExpected(offset);
+        if (expectedType != TokenType::ERROR) {
+            std::cout << (expectedType == TokenType::INT_TYPE ? " (expect int)" : " (expect bool)");
+        }
         offset++;
         
         // Handle operands based on opcode
-        switch (opcode) {
-            case OpCode::LOAD_CONST:
-            case OpCode::LOAD_VAR:
-            case OpCode::STORE_VAR:
-            case OpCode::DECLARE_VAR:
-            case OpCode::JUMP:
-            case OpCode::JUMP_IF_FALSE:
-            case OpCode::JUMP_IF_TRUE:
-            case OpCode::CALL:
-                if (offset + 4 <= code.size()) {
-                    uint32_t operand = (code[offset] << 24) | 
-                                      (code[offset + 1] << 16) | 
-                                      (code[offset + 2] << 8) | 
-                                      code[offset + 3];
-                    std::cout << " " << operand;
-                    offset += 4;
-                }
-                break;
-                
-            default:
-                // No operands
-                break;
+        if (hasOperand(opcode) && offset + 4 <= code.size()) {
+            std::cout << " " << readOperand(offset);
+            offset += 4;
         }
         
         std::cout << "\n";
@@ -0,0 +1,879 @@
+#include "CBackend.h"
+#include "../core/Numbers.h"
+#include <cstdio>
+
+namespace {
+    // Runtime support emitted at the top of every module. Runtime errors
+    // unwind to simplelang_main(), which reports them to the host together
+    // with how much the module printed, so the host can replay the program
+    // on the VM from the start and go on past the error.
+    const char* PRELUDE = R"(#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+
+static jmp_buf sl_abort;
+static char sl_message[256];
+static unsigned long sl_printed;
+
+static void sl_fail(const char* message) {
+    snprintf(sl_message, sizeof sl_message, "%s", message);
+    longjmp(sl_abort, 1);
+}
+
+/* The VM's checks, made at run time */
+static float sl_div(float a, float b) {
+    if (b == 0.0f) sl_fail("Division by zero");
+    return a / b;
+}
+
+static int sl_mod(int a, int b) {
+    if (b == 0) sl_fail("Modulo by zero");
+    return b == -1 ? 0 : a % b;
+}
+
+/* Both operands are always evaluated, as in the interpreter */
+static int sl_and(int a, int b) { return a && b; }
+static int sl_or(int a, int b) { return a || b; }
+
+static void sl_wrote(int count) {
+    if (count > 0) sl_printed += (unsigned long)count;
+}
+
+/* Strings are immutable. Concatenations and conversions are temporaries on
+   a stack that every statement cuts back to where it started (sl_release).
+   A variable owns a copy of its string (sl_keep) until its scope ends
+   (sl_drop); what is left is freed when simplelang_main returns. */
+struct sl_string {
+    struct sl_string* prev;
+    struct sl_string* next;
+    char text[];
+};
+
+static struct sl_string* sl_temps;
+static struct sl_string* sl_owned;
+
+static struct sl_string* sl_alloc(size_t size) {
+    struct sl_string* s = malloc(sizeof *s + size);
+    if (!s) sl_fail("Out of memory");
+    return s;
+}
+
+static const char* sl_concat(const char* a, const char* b) {
+    size_t left = strlen(a), right = strlen(b);
+    struct sl_string* s = sl_alloc(left + right + 1);
+    s->prev = NULL;
+    s->next = sl_temps;
+    sl_temps = s;
+    memcpy(s->text, a, left);
+    memcpy(s->text + left, b, right + 1);
+    return s->text;
+}
+
+static void sl_release(struct sl_string* mark) {
+    while (sl_temps != mark) {
+        struct sl_string* next = sl_temps->next;
+        free(sl_temps);
+        sl_temps = next;
+    }
+}
+
+/* A condition's temporaries are released once it has been tested */
+static int sl_test(int value, struct sl_string* mark) {
+    sl_release(mark);
+    return value;
+}
+
+static const char* sl_keep(const char* text) {
+    size_t size = strlen(text) + 1;
+    struct sl_string* s = sl_alloc(size);
+    s->prev = NULL;
+    s->next = sl_owned;
+    if (sl_owned) sl_owned->prev = s;
+    sl_owned = s;
+    memcpy(s->text, text, size);
+    return s->text;
+}
+
+static void sl_drop(const char* text) {
+    struct sl_string* s;
+    if (!text) return;
+    s = (struct sl_string*)(text - offsetof(struct sl_string, text));
+    if (s->prev) s->prev->next = s->next;
+    else sl_owned = s->next;
+    if (s->next) s->next->prev = s->prev;
+    free(s);
+}
+
+static const char* sl_store(const char** variable, const char* text) {
+    const char* copy = sl_keep(text);
+    sl_drop(*variable);
+    *variable = copy;
+    return copy;
+}
+
+static void sl_release_all(void) {
+    sl_release(NULL);
+    while (sl_owned) {
+        struct sl_string* next = sl_owned->next;
+        free(sl_owned);
+        sl_owned = next;
+    }
+}
+
+static const char* sl_int_str(int v) {
+    char buf[16];
+    snprintf(buf, sizeof buf, "%d", v);
+    return sl_concat(buf, "");
+}
+
+/* The interpreter's float format (Numbers::write): the fewest digits that
+   read back as v, in fixed or exponent form, whichever is shorter (fixed on
+   a tie), with ".0" on whole numbers. `out` holds 32 bytes. */
+static char* sl_float_text(char* out, float v) {
+    char text[32], digits[16];
+    int precision, count = 0, exponent, fixed, i;
+    const char* c = text;
+    char* p = out;
+    int negative;
+
+    if (isnan(v) || isinf(v)) {
+        snprintf(out, 32, "%s%s", signbit(v) ? "-" : "", isnan(v) ? "nan" : "inf");
+        return out;
+    }
+    for (precision = 0; precision < 8; precision++) {
+        snprintf(text, sizeof text, "%.*e", precision, (double)v);
+        if (strtof(text, NULL) == v) break;
+    }
+    snprintf(text, sizeof text, "%.*e", precision, (double)v);
+
+    negative = *c == '-';
+    if (negative) c++;
+    for (; *c != 'e'; c++) {
+        if (*c != '.') digits[count++] = *c;
+    }
+    exponent = atoi(c + 1);
+
+    /* Fixed is "dddddd", "dd.ddd" or "0.000ddd" */
+    fixed = exponent >= count - 1 ? exponent + 1 : exponent >= 0 ? count + 1 : count + 1 - exponent;
+    if (fixed > (int)strlen(text) - negative) {
+        strcpy(out, text);
+        return out;
+    }
+    if (exponent >= count - 1) {
+        /* Whole numbers are written exactly, like to_chars does */
+        snprintf(out, 32, "%.0f.0", (double)v);
+        return out;
+    }
+    if (negative) *p++ = '-';
+    if (exponent >= 0) {
+        memcpy(p, digits, exponent + 1);
+        p += exponent + 1;
+        *p++ = '.';
+        memcpy(p, digits + exponent + 1, count - exponent - 1);
+        p[count - exponent - 1] = '\0';
+    } else {
+        *p++ = '0';
+        *p++ = '.';
+        for (i = 0; i < -exponent - 1; i++) *p++ = '0';
+        memcpy(p, digits, count);
+        p[count] = '\0';
+    }
+    return out;
+}
+
+static const char* sl_float_str(float v) {
+    char buf[32];
+    return sl_concat(sl_float_text(buf, v), "");
+}
+
+static const char* sl_bool_str(int v) { return v ? "true" : "false"; }
+
+)";
+
+    // Placeholder for the #line that hands line numbering back to the C file
+    const char* RESUME_GENERATED = "#line resume";
+
+    std::string resumeGeneratedLines(const std::string& code) {
+        std::istringstream in(code);
+        std::ostringstream out;
+        std::string text;
+        for (int number = 1; std::getline(in, text); number++) {
+            if (text == RESUME_GENERATED) {
+                text = "#line " + std::to_string(number + 1) + " \"<generated>\"";
+            }
+            out << text << "\n";
+        }
+        return out.str();
+    }
+}
+
+CBackend::CBackend()
+    : body(&mainBody), currentFunction(nullptr), lastType(CType::VOID), indent(1),
+      temporaries(false), releases(false), currentLine(0), emittedLine(0) {
+    // Start with global scope
+    scopes.push_back(std::unordered_map<std::string, Variable>());
+}
+
+void CBackend::error(const Token& token, const std::string& message) {
+    errors.push_back(Error(ErrorType::SEMANTIC, message, token.line(), token.column(), "CBackend"));
+}
+
+void CBackend::line(const std::string& code) {
+    if (!sourceName.empty() && currentLine > 0 && currentLine != emittedLine) {
+        *body << lineDirective(currentLine) << "\n";
+        emittedLine = currentLine;
+    }
+    *body << std::string(indent * 4, ' ') << code << "\n";
+}
+
+void CBackend::markLine(int sourceLine) {
+    if (sourceLine > 0) {
+        currentLine = sourceLine;
+    }
+}
+
+std::string CBackend::lineDirective(int sourceLine) const {
+    CType type;
+    return "#line " + std::to_string(sourceLine) + " " + literal(Value(sourceName), type);
+}
+
+std::string CBackend::emitExpr(const ExprPtr& expr, CType& type) {
+    Value code = expr->accept(*this);
+    type = lastType;
+    return std::get<std::string>(code);
+}
+
+Value CBackend::result(CType type, const std::string& code) {
+    lastType = type;
+    return code;
+}
+
+std::string CBackend::declareName(const std::string& name) {
+    // Every declaration gets its own C name, so `let x = x + 1` in an inner
+    // scope still reads the outer x
+    int count = nameCounts[name]++;
+    return count == 0 ? "v_" + name : "v_" + name + "_" + std::to_string(count);
+}
+
+const CBackend::Variable* CBackend::resolveVariable(const std::string& name) const {
+    // Search from innermost to outermost scope
+    for (int i = static_cast<int>(scopes.size()) - 1; i >= 0; i--) {
+        auto it = scopes[i].find(name);
+        if (it != scopes[i].end()) {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+// Conversions
+std::string CBackend::typeName(CType type) {
+    switch (type) {
+        case CType::INT: return "int";
+        case CType::FLOAT: return "float";
+        case CType::BOOL: return "int";
+        case CType::STRING: return "const char*";
+        default: return "void";
+    }
+}
+
+CType CBackend::fromTokenType(TokenType type) {
+    switch (type) {
+        case TokenType::INT_TYPE: return CType::INT;
+        case TokenType::FLOAT_TYPE: return CType::FLOAT;
+        case TokenType::BOOL_TYPE: return CType::BOOL;
+        case TokenType::STRING_TYPE: return CType::STRING;
+        default: return CType::VOID;
+    }
+}
+
+std::string CBackend::truthy(const std::string& code, CType type) {
+    switch (type) {
+        case CType::INT: return "(" + code + " != 0)";
+        case CType::FLOAT: return "(" + code + " != 0.0f)";
+        case CType::STRING: return "(" + code + "[0] != '\\0')";
+        default: return code;
+    }
+}
+
+std::string CBackend::asFloat(const std::string& code, CType type) {
+    return type == CType::FLOAT ? code : "(float)" + code;
+}
+
+std::string CBackend::asString(const std::string& code, CType type) {
+    switch (type) {
+        case CType::INT: return "sl_int_str(" + code + ")";
+        case CType::FLOAT: return "sl_float_str(" + code + ")";
+        case CType::BOOL: return "sl_bool_str(" + code + ")";
+        default: return code;
+    }
+}
+
+std::string CBackend::literal(const Value& value, CType& type) {
+    if (std::holds_alternative<int>(value)) {
+        type = CType::INT;
+        return std::to_string(std::get<int>(value));
+    }
+    if (std::holds_alternative<float>(value)) {
+        type = CType::FLOAT;
+        return Numbers::toString(std::get<float>(value)) + "f";
+    }
+    if (std::holds_alternative<bool>(value)) {
+        type = CType::BOOL;
+        return std::get<bool>(value) ? "1" : "0";
+    }
+
+    type = CType::STRING;
+    std::string text = "\"";
+    for (unsigned char c : std::get<std::string>(value)) {
+        switch (c) {
+            case '"': text += "\\\""; break;
+            case '\\': text += "\\\\"; break;
+            case '\n': text += "\\n"; break;
+            case '\t': text += "\\t"; break;
+            default:
+                if (c < 0x20 || c >= 0x7F) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof escaped, "\\%03o", c);
+                    text += escaped;
+                } else {
+                    text += static_cast<char>(c);
+                }
+                break;
+        }
+    }
+    return text + "\"";
+}
+
+// Expression visitors
+Value CBackend::visitLiteralExpr(const LiteralExpr& expr) {
+    CType type;
+    std::string code = literal(expr.value, type);
+    return result(type, code);
+}
+
+Value CBackend::visitVariableExpr(const VariableExpr& expr) {
+    markLine(expr.name.line());
+    const Variable* variable = resolveVariable(std::string(expr.name.lexeme));
+    if (!variable) {
+        error(expr.name, "Undefined variable '" + std::string(expr.name.lexeme) + "'");
+        return result(CType::INT, "0");
+    }
+    return result(variable->type, variable->cName);
+}
+
+Value CBackend::visitBinaryExpr(const BinaryExpr& expr) {
+    markLine(expr.op.line());
+    CType leftType, rightType;
+    std::string left = emitExpr(expr.left, leftType);
+    std::string right = emitExpr(expr.right, rightType);
+
+    bool numeric = (leftType == CType::INT || leftType == CType::FLOAT) &&
+                   (rightType == CType::INT || rightType == CType::FLOAT);
+    bool integers = leftType == CType::INT && rightType == CType::INT;
+
+    switch (expr.op.type) {
+        case TokenType::PLUS:
+            if (leftType == CType::STRING || rightType == CType::STRING) {
+                if (leftType == CType::VOID || rightType == CType::VOID) break;
+                temporaries = true;
+                return result(CType::STRING, "sl_concat(" + asString(left, leftType) + ", " +
+                                             asString(right, rightType) + ")");
+            }
+            [[fallthrough]];
+        case TokenType::MINUS:
+        case TokenType::MULTIPLY: {
+            if (!numeric) break;
+            std::string op = expr.op.type == TokenType::PLUS ? " + " :
+                             expr.op.type == TokenType::MINUS ? " - " : " * ";
+            if (integers) {
+                return result(CType::INT, "(" + left + op + right + ")");
+            }
+            return result(CType::FLOAT, "(" + asFloat(left, leftType) + op + asFloat(right, rightType) + ")");
+        }
+
+        case TokenType::DIVIDE:
+            // Division always produces a float, as in the interpreter
+            if (!numeric) break;
+            return result(CType::FLOAT, "sl_div(" + asFloat(left, leftType) + ", " + asFloat(right, rightType) + ")");
+
+        case TokenType::MODULO:
+            if (!integers) break;
+            return result(CType::INT, "sl_mod(" + left + ", " + right + ")");
+
+        case TokenType::LESS:
+        case TokenType::GREATER:
+        case TokenType::LESS_EQUAL:
+        case TokenType::GREATER_EQUAL: {
+            std::string op = expr.op.type == TokenType::LESS ? " < " :
+                             expr.op.type == TokenType::GREATER ? " > " :
+                             expr.op.type == TokenType::LESS_EQUAL ? " <= " : " >= ";
+            if (integers) {
+                return result(CType::BOOL, "(" + left + op + right + ")");
+            }
+            if (numeric) {
+                return result(CType::BOOL, "(" + asFloat(left, leftType) + op + asFloat(right, rightType) + ")");
+            }
+            if (leftType == CType::STRING && rightType == CType::STRING) {
+                return result(CType::BOOL, "(strcmp(" + left + ", " + right + ")" + op + "0)");
+            }
+            break;
+        }
+
+        case TokenType::EQUAL:
+        case TokenType::NOT_EQUAL: {
+            if (leftType == CType::VOID || rightType == CType::VOID) break;
+            std::string op = expr.op.type == TokenType::EQUAL ? " == " : " != ";
+            if (numeric && !integers) {
+                return result(CType::BOOL, "(" + asFloat(left, leftType) + op + asFloat(right, rightType) + ")");
+            }
+            if (leftType == rightType) {
+                if (leftType == CType::STRING) {
+                    return result(CType::BOOL, "(strcmp(" + left + ", " + right + ")" + op + "0)");
+                }
+                return result(CType::BOOL, "(" + left + op + right + ")");
+            }
+            // Values of different types are never equal
+            std::string constant = expr.op.type == TokenType::EQUAL ? "0" : "1";
+            return result(CType::BOOL, "((void)" + left + ", (void)" + right + ", " + constant + ")");
+        }
+
+        case TokenType::AND:
+        case TokenType::OR:
+            if (leftType == CType::VOID || rightType == CType::VOID) break;
+            return result(CType::BOOL, std::string(expr.op.type == TokenType::AND ? "sl_and(" : "sl_or(") +
+                                       truthy(left, leftType) + ", " + truthy(right, rightType) + ")");
+
+        default:
+            break;
+    }
+
+    error(expr.op, "Operands of '" + std::string(expr.op.lexeme) + "' have no static C type");
+    return result(CType::INT, "0");
+}
+
+Value CBackend::visitUnaryExpr(const UnaryExpr& expr) {
+    markLine(expr.op.line());
+    CType type;
+    std::string operand = emitExpr(expr.right, type);
+
+    if (expr.op.type == TokenType::MINUS && (type == CType::INT || type == CType::FLOAT)) {
+        return result(type, "(-" + operand + ")");
+    }
+    if (expr.op.type == TokenType::NOT && type != CType::VOID) {
+        return result(CType::BOOL, "(!" + truthy(operand, type) + ")");
+    }
+
+    error(expr.op, "Operand of '" + std::string(expr.op.lexeme) + "' has no static C type");
+    return result(CType::INT, "0");
+}
+
+Value CBackend::visitCallExpr(const CallExpr& expr) {
+    markLine(expr.callee.line());
+    if (expr.callee.lexeme == "print") {
+        error(expr.callee, "print() has no value in compiled code");
+        return result(CType::VOID, "0");
+    }
+
+    auto it = functionTable.find(std::string(expr.callee.lexeme));
+    if (it == functionTable.end()) {
+        error(expr.callee, "Undefined function '" + std::string(expr.callee.lexeme) + "'");
+        return result(CType::INT, "0");
+    }
+
+    const Function& function = it->second;
+    if (expr.arguments.size() != function.parameters.size()) {
+        error(expr.callee, "Expected " + std::to_string(function.parameters.size()) +
+              " arguments but got " + std::to_string(expr.arguments.size()));
+        return result(function.returnType, "0");
+    }
+
+    std::string code = function.cName + "(";
+    for (size_t i = 0; i < expr.arguments.size(); i++) {
+        CType type;
+        std::string argument = emitExpr(expr.arguments[i], type);
+        if (type != function.parameters[i]) {
+            error(expr.callee, "Argument " + std::to_string(i + 1) + " of '" + std::string(expr.callee.lexeme) +
+                  "' does not match the parameter type");
+        }
+        code += (i > 0 ? ", " : "") + argument;
+    }
+    if (function.returnType == CType::STRING) {
+        temporaries = true;   // Functions return strings as temporaries
+    }
+    return result(function.returnType, code + ")");
+}
+
+Value CBackend::visitAssignmentExpr(const AssignmentExpr& expr) {
+    markLine(expr.name.line());
+    CType type;
+    std::string value = emitExpr(expr.value, type);
+
+    const Variable* variable = resolveVariable(std::string(expr.name.lexeme));
+    if (!variable) {
+        error(expr.name, "Undefined variable '" + std::string(expr.name.lexeme) + "'");
+        return result(CType::INT, "0");
+    }
+    if (variable->type != type) {
+        error(expr.name, "Assignment changes the type of '" + std::string(expr.name.lexeme) + "'");
+    }
+    if (variable->type == CType::STRING) {
+        return result(variable->type, "sl_store(&" + variable->cName + ", " + value + ")");
+    }
+    return result(variable->type, "(" + variable->cName + " = " + value + ")");
+}
+
+// Statement visitors
+void CBackend::emitPrint(const std::vector<ExprPtr>& arguments) {
+    std::string format;
+    std::string values;
+    for (size_t i = 0; i < arguments.size(); i++) {
+        CType type;
+        std::string value = emitExpr(arguments[i], type);
+        if (i > 0) format += " ";
+
+        switch (type) {
+            case CType::INT: format += "%d"; break;
+            case CType::FLOAT: format += "%s"; value = "sl_float_text((char[32]){0}, " + value + ")"; break;
+            case CType::BOOL: format += "%s"; value = "sl_bool_str(" + value + ")"; break;
+            case CType::STRING: format += "%s"; break;
+            default:
+                error(Token(), "Cannot print a value without a type");
+                break;
+        }
+        values += ", " + value;
+    }
+    line("sl_wrote(printf(\"" + format + "\\n\"" + values + "));");
+    endStatement();
+}
+
+// A condition as a C int; its temporaries are released once it is tested
+std::string CBackend::emitCondition(const ExprPtr& expr) {
+    CType type;
+    std::string condition = truthy(emitExpr(expr, type), type);
+    if (!temporaries) {
+        return condition;
+    }
+    temporaries = false;
+    releases = true;
+    return "sl_test(" + condition + ", sl_base)";
+}
+
+void CBackend::endStatement() {
+    if (temporaries) {
+        line("sl_release(sl_base);");
+        releases = true;
+    }
+    temporaries = false;
+}
+
+// Frees the strings owned by variables of scopes[firstScope] and inner scopes
+void CBackend::dropStrings(size_t firstScope) {
+    for (size_t i = firstScope; i < scopes.size(); i++) {
+        for (const auto& [name, variable] : scopes[i]) {
+            if (variable.type == CType::STRING) {
+                line("sl_drop(" + variable.cName + ");");
+            }
+        }
+    }
+}
+
+void CBackend::visitPrintStmt(const PrintStmt& stmt) {
+    emitPrint(stmt.expressions);
+}
+
+void CBackend::visitVariableDeclStmt(const VariableDeclStmt& stmt) {
+    markLine(stmt.name.line());
+    if (!stmt.initializer) {
+        error(stmt.name, "Variable '" + std::string(stmt.name.lexeme) + "' needs an initializer to have a C type");
+        return;
+    }
+
+    CType type;
+    std::string value = emitExpr(stmt.initializer, type);
+    if (type == CType::VOID) {
+        error(stmt.name, "Variable '" + std::string(stmt.name.lexeme) + "' is initialized without a value");
+        return;
+    }
+
+    // Redeclaring in the same scope overwrites the variable, like Environment::define
+    auto& scope = scopes.back();
+    auto existing = scope.find(std::string(stmt.name.lexeme));
+    if (existing != scope.end()) {
+        if (existing->second.type != type) {
+            error(stmt.name, "Redeclaration changes the type of '" + std::string(stmt.name.lexeme) + "'");
+        }
+        if (type == CType::STRING) {
+            line("sl_store(&" + existing->second.cName + ", " + value + ");");
+        } else {
+            line(existing->second.cName + " = " + value + ";");
+        }
+        endStatement();
+        return;
+    }
+
+    // A string variable owns a copy, so the statement's temporaries can go
+    if (type == CType::STRING) {
+        value = "sl_keep(" + value + ")";
+    }
+    Variable variable{declareName(std::string(stmt.name.lexeme)), type};
+    if (scopes.size() == 1 && !currentFunction) {
+        // Top-level variables are visible to functions, so they live at file scope
+        globals << "static " << typeName(type) << " " << variable.cName << ";\n";
+        line(variable.cName + " = " + value + ";");
+    } else {
+        line(typeName(type) + " " + variable.cName + " = " + value + ";");
+    }
+    scope[std::string(stmt.name.lexeme)] = variable;
+    endStatement();
+}
+
+void CBackend::visitExpressionStmt(const ExpressionStmt& stmt) {
+    if (stmt.expression->getType() == ExprType::CALL) {
+        auto call = std::static_pointer_cast<CallExpr>(stmt.expression);
+        if (call->callee.lexeme == "print") {
+            emitPrint(call->arguments);
+            return;
+        }
+    }
+
+    CType type;
+    line(emitExpr(stmt.expression, type) + ";");
+    endStatement();
+}
+
+void CBackend::visitBlockStmt(const BlockStmt& stmt) {
+    line("{");
+    indent++;
+    scopes.push_back(std::unordered_map<std::string, Variable>());
+
+    for (const auto& statement : stmt.statements) {
+        statement->accept(*this);
+    }
+
+    dropStrings(scopes.size() - 1);
+    scopes.pop_back();
+    indent--;
+    line("}");
+}
+
+void CBackend::emitBranch(const StmtPtr& stmt) {
+    // C braces end the scope of a declaration used as a whole branch
+    indent++;
+    scopes.push_back(std::unordered_map<std::string, Variable>());
+    stmt->accept(*this);
+    dropStrings(scopes.size() - 1);
+    scopes.pop_back();
+    indent--;
+}
+
+void CBackend::visitIfStmt(const IfStmt& stmt) {
+    line("if (" + emitCondition(stmt.condition) + ") {");
+    emitBranch(stmt.thenBranch);
+
+    if (stmt.elseBranch) {
+        line("} else {");
+        emitBranch(stmt.elseBranch);
+    }
+    line("}");
+}
+
+void CBackend::visitWhileStmt(const WhileStmt& stmt) {
+    line("while (" + emitCondition(stmt.condition) + ") {");
+    emitBranch(stmt.body);
+    line("}");
+}
+
+void CBackend::visitFunctionDeclStmt(const FunctionDeclStmt& stmt) {
+    // Top-level functions are emitted by generate(); closures have no C equivalent
+    error(stmt.name, "Nested function '" + std::string(stmt.name.lexeme) + "' is not supported by the C backend");
+}
+
+void CBackend::visitReturnStmt(const ReturnStmt& stmt) {
+    markLine(stmt.keyword.line());
+    if (!currentFunction) {
+        error(stmt.keyword, "Cannot return from top-level code");
+        return;
+    }
+
+    // The function's string variables are freed on the way out; scopes[1]
+    // holds its parameters
+    bool owned = false;
+    for (size_t i = 1; i < scopes.size(); i++) {
+        for (const auto& [name, variable] : scopes[i]) {
+            owned = owned || variable.type == CType::STRING;
+        }
+    }
+
+    CType expected = fromTokenType(currentFunction->returnType);
+    if (!stmt.value) {
+        if (expected != CType::VOID) {
+            error(stmt.keyword, "Missing return value");
+        }
+        if (owned) {
+            line("{");
+            indent++;
+            dropStrings(1);
+            line("return;");
+            indent--;
+            line("}");
+        } else {
+            line("return;");
+        }
+        return;
+    }
+
+    CType type;
+    std::string value = emitExpr(stmt.value, type);
+    if (type != expected) {
+        error(stmt.keyword, "Return value does not match the declared return type");
+    }
+    // A string is returned as a temporary; the caller's statement releases it
+    if (type == CType::STRING) {
+        value = "sl_concat(" + value + ", \"\")";
+    }
+    temporaries = false;
+    if (!owned) {
+        line("return " + value + ";");
+        return;
+    }
+    line("{");
+    indent++;
+    line(typeName(type) + " sl_result = " + value + ";");
+    dropStrings(1);
+    line("return sl_result;");
+    indent--;
+    line("}");
+}
+
+void CBackend::emitFunction(const FunctionDeclStmt& stmt) {
+    const Function& function = functionTable[std::string(stmt.name.lexeme)];
+
+    std::ostringstream code;
+    body = &code;
+    currentFunction = &stmt;
+    indent = 1;
+    markLine(stmt.name.line());
+    emittedLine = currentLine;
+
+    scopes.push_back(std::unordered_map<std::string, Variable>());
+    std::string signature = typeName(function.returnType) + " " + function.cName + "(";
+    for (size_t i = 0; i < stmt.parameters.size(); i++) {
+        Variable parameter{declareName(std::string(stmt.parameters[i].first.lexeme)), function.parameters[i]};
+        scopes.back()[std::string(stmt.parameters[i].first.lexeme)] = parameter;
+        signature += (i > 0 ? ", " : "") + typeName(parameter.type) + " " + parameter.cName;
+    }
+    signature += stmt.parameters.empty() ? "void)" : ")";
+
+    // String arguments are copied, so assigning a parameter frees only the copy
+    for (const auto& [name, parameter] : scopes.back()) {
+        if (parameter.type == CType::STRING) {
+            line(parameter.cName + " = sl_keep(" + parameter.cName + ");");
+        }
+    }
+
+    releases = false;
+    auto block = std::dynamic_pointer_cast<BlockStmt>(stmt.body);
+    if (block) {
+        for (const auto& statement : block->statements) {
+            statement->accept(*this);
+        }
+    }
+    dropStrings(1);
+    if (function.returnType != CType::VOID) {
+        // Falling off the end would return null in the interpreter
+        line("sl_fail(\"Missing return value\");");
+        line("return 0;");
+    }
+    scopes.pop_back();
+
+    if (!sourceName.empty()) {
+        functions << lineDirective(stmt.name.line()) << "\n";
+    }
+    functions << "static " << signature << " {\n"
+              << (releases ? "    struct sl_string* sl_base = sl_temps;\n" : "")
+              << code.str() << "}\n";
+    if (!sourceName.empty()) {
+        functions << RESUME_GENERATED << "\n";
+    }
+    functions << "\n";
+    body = &mainBody;
+    emittedLine = 0;
+    releases = false;
+    currentFunction = nullptr;
+}
+
+std::string CBackend::generate(const ProgramPtr& program) {
+    // Signatures first so calls may precede declarations
+    std::vector<const FunctionDeclStmt*> declarations;
+    std::ostringstream prototypes;
+    for (const auto& stmt : program->statements) {
+        if (stmt->getType() != StmtType::FUNCTION_DECL) continue;
+        auto decl = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+
+        if (std::string(decl->name.lexeme) == "print" || functionTable.count(std::string(decl->name.lexeme))) {
+            error(decl->name, "Function '" + std::string(decl->name.lexeme) + "' is already defined");
+            continue;
+        }
+
+        Function function{"f_" + std::string(decl->name.lexeme), {}, fromTokenType(decl->returnType)};
+        std::string parameters;
+        for (const auto& parameter : decl->parameters) {
+            function.parameters.push_back(fromTokenType(parameter.second));
+            parameters += (parameters.empty() ? "" : ", ") + typeName(function.parameters.back());
+        }
+        prototypes << "static " << typeName(function.returnType) << " " << function.cName << "("
+                   << (parameters.empty() ? "void" : parameters) << ");\n";
+        functionTable[std::string(decl->name.lexeme)] = function;
+        declarations.push_back(decl.get());
+    }
+
+    for (const auto& stmt : program->statements) {
+        if (stmt->getType() != StmtType::FUNCTION_DECL) {
+            stmt->accept(*this);
+        }
+    }
+    bool mainReleases = releases;
+
+    // Function bodies see every top-level variable, wherever it was declared
+    for (const FunctionDeclStmt* decl : declarations) {
+        emitFunction(*decl);
+    }
+
+    std::ostringstream out;
+    out << "/* Generated by SimpleLang */\n" << PRELUDE
+        << prototypes.str() << "\n"
+        << globals.str() << "\n"
+        << functions.str()
+        << "const char* simplelang_error(void) {\n"
+        << "    return sl_message;\n"
+        << "}\n\n"
+        << "unsigned long simplelang_printed(void) {\n"
+        << "    return sl_printed;\n"
+        << "}\n\n"
+        << "int simplelang_main(void) {\n"
+        << (mainReleases ? "    struct sl_string* sl_base = sl_temps;\n" : "")
+        << "    sl_printed = 0;\n"
+        << "    if (setjmp(sl_abort)) {\n"
+        << "        sl_release_all();\n"
+        << "        fflush(stdout);\n"
+        << "        return 1;\n"
+        << "    }\n"
+        << mainBody.str()
+        << (sourceName.empty() ? "" : std::string(RESUME_GENERATED) + "\n")
+        << "    sl_release_all();\n"
+        << "    fflush(stdout);\n"
+        << "    return 0;\n"
+        << "}\n\n"
+        << "#ifdef SIMPLELANG_STANDALONE\n"
+        << "int main(void) {\n"
+        << "    int status = simplelang_main();\n"
+        << "    if (status) fprintf(stderr, \"Runtime error: %s\\n\", sl_message);\n"
+        << "    return status;\n"
+        << "}\n"
+        << "#endif\n";
+    return sourceName.empty() ? out.str() : resumeGeneratedLines(out.str());
+}
@@ -1,7 +1,7 @@
 #include "CodeGenerator.h"
 #include <iostream>
 
-CodeGenerator::CodeGenerator() : nextVariableIndex(0) {
+CodeGenerator::CodeGenerator() : nextVariableIndex(0), executable(true) {
     // Start with global scope
     scopes.push_back(std::unordered_map<std::string, size_t>());
 }
@@ -31,35 +31,69 @@ size_t CodeGenerator::resolveVariable(const std::string& name) {
 
 void CodeGenerator::declareVariable(const std::string& name) {
     if (!scopes.empty()) {
+        // Redeclaring in the same scope overwrites the variable, like Environment::define
+        if (scopes.back().find(name) != scopes.back().end()) {
+            return;
+        }
         scopes.back()[name] = nextVariableIndex++;
     }
 }
 
+size_t CodeGenerator::emitJump(OpCode opcode) {
+    writer.writeOpCode(opcode);
+    size_t operandOffset = writer.getCode().size();
+    writer.writeOperand(0); // Placeholder - patched once the target is known
+    return operandOffset;
+}
+
+void CodeGenerator::patchJump(size_t operandOffset) {
+    writer.patchOperand(operandOffset, static_cast<uint32_t>(writer.getCode().size()));
+}
+
+// Operand of a binary operator; a variable load carries the type the
+// profile saw so the JIT can speculate on it
+void CodeGenerator::emitOperand(const ExprPtr& operand, TokenType profiledType) {
+    size_t offset = writer.getCode().size();
+    operand->accept(*this);
+    
+    bool speculable = profiledType == TokenType::INT_TYPE || profiledType == TokenType::BOOL_TYPE;
+    if (speculable && operand->getType() == ExprType::VARIABLE && writer.getCode().size() > offset &&
+        static_cast<OpCode>(writer.getCode()[offset]) == OpCode::LOAD_VAR) {
+        writer.markExpected(offset, profiledType);
+    }
+}
+
 // Expression visitors
 Value CodeGenerator::visitLiteralExpr(const LiteralExpr& expr) {
     size_t constIndex = writer.addConstantGetIndex(expr.value);
     writer.writeOpCode(OpCode::LOAD_CONST);
     writer.writeOperand(static_cast<uint32_t>(constIndex));
-    return nullptr;
+    return Value();
 }
 
 Value CodeGenerator::visitVariableExpr(const VariableExpr& expr) {
-    size_t varIndex = resolveVariable(expr.name.lexeme);
+    writer.markLine(expr.name.line());
+    size_t varIndex = resolveVariable(std::string(expr.name.lexeme));
     if (varIndex != static_cast<size_t>(-1)) {
         writer.writeOpCode(OpCode::LOAD_VAR);
         writer.writeOperand(static_cast<uint32_t>(varIndex));
+    } else {
+        executable = false;
     }
-    return nullptr;
+    return Value();
 }
 
 Value CodeGenerator::visitBinaryExpr(const BinaryExpr& expr) {
+    writer.markLine(expr.op.line());
+    
     // Generate code for left operand
-    expr.left->accept(*this);
+    emitOperand(expr.left, expr.profiledType);
     
     // Generate code for right operand
-    expr.right->accept(*this);
+    emitOperand(expr.right, expr.profiledType);
     
     // Generate operation code
+    writer.markSite(writer.getCode().size(), expr.site);
     switch (expr.op.type) {
         case TokenType::PLUS:
             writer.writeOpCode(OpCode::ADD);
@@ -105,10 +139,12 @@ Value CodeGenerator::visitBinaryExpr(const BinaryExpr& expr) {
             break;
     }
     
-    return nullptr;
+    return Value();
 }
 
 Value CodeGenerator::visitUnaryExpr(const UnaryExpr& expr) {
+    writer.markLine(expr.op.line());
+    
     // Generate code for operand
     expr.right->accept(*this);
     
@@ -125,10 +161,12 @@ Value CodeGenerator::visitUnaryExpr(const UnaryExpr& expr) {
             break;
     }
     
-    return nullptr;
+    return Value();
 }
 
 Value CodeGenerator::visitCallExpr(const CallExpr& expr) {
+    writer.markLine(expr.callee.line());
+    
     // Generate code for each argument
     for (auto& arg : expr.arguments) {
         arg->accept(*this);
@@ -137,34 +175,39 @@ Value CodeGenerator::visitCallExpr(const CallExpr& expr) {
     // Generate call instruction
     // For now, we'll assume it's a built-in function
     if (expr.callee.lexeme == "print") {
+        // PRINT pops its arguments and pushes null as the call result
         writer.writeOpCode(OpCode::PRINT);
+        writer.writeOperand(static_cast<uint32_t>(expr.arguments.size()));
     } else {
         writer.writeOpCode(OpCode::CALL);
         // Would need function index
+        executable = false;
     }
     
-    return nullptr;
+    return Value();
 }
 
 Value CodeGenerator::visitAssignmentExpr(const AssignmentExpr& expr) {
+    writer.markLine(expr.name.line());
+    
     // Generate code for value
     expr.value->accept(*this);
     
     // Generate store instruction
-    size_t varIndex = resolveVariable(expr.name.lexeme);
+    size_t varIndex = resolveVariable(std::string(expr.name.lexeme));
     if (varIndex != static_cast<size_t>(-1)) {
         writer.writeOpCode(OpCode::STORE_VAR);
         writer.writeOperand(static_cast<uint32_t>(varIndex));
     }
     
     // Leave value on stack
-    varIndex = resolveVariable(expr.name.lexeme);
+    varIndex = resolveVariable(std::string(expr.name.lexeme));
     if (varIndex != static_cast<size_t>(-1)) {
         writer.writeOpCode(OpCode::LOAD_VAR);
         writer.writeOperand(static_cast<uint32_t>(varIndex));
     }
     
-    return nullptr;
+    return Value();
 }
 
 // Statement visitors
@@ -173,28 +216,27 @@ void CodeGenerator::visitPrintStmt(const PrintStmt& stmt) {
         expr->accept(*this);
     }
     writer.writeOpCode(OpCode::PRINT);
+    writer.writeOperand(static_cast<uint32_t>(stmt.expressions.size()));
+    writer.writeOpCode(OpCode::POP);
 }
 
 void CodeGenerator::visitVariableDeclStmt(const VariableDeclStmt& stmt) {
-    // Declare variable
-    declareVariable(stmt.name.lexeme);
+    writer.markLine(stmt.name.line());
     
     if (stmt.initializer) {
         // Generate code for initializer
         stmt.initializer->accept(*this);
-        
-        // Store initial value
-        size_t varIndex = resolveVariable(stmt.name.lexeme);
-        writer.writeOpCode(OpCode::STORE_VAR);
-        writer.writeOperand(static_cast<uint32_t>(varIndex));
     } else {
         // Initialize with null
         writer.writeOpCode(OpCode::LOAD_NULL);
-        
-        size_t varIndex = resolveVariable(stmt.name.lexeme);
-        writer.writeOpCode(OpCode::STORE_VAR);
-        writer.writeOperand(static_cast<uint32_t>(varIndex));
     }
+    
+    // Declare after the initializer so it still sees any outer variable of the same name
+    declareVariable(std::string(stmt.name.lexeme));
+    
+    size_t varIndex = resolveVariable(std::string(stmt.name.lexeme));
+    writer.writeOpCode(OpCode::STORE_VAR);
+    writer.writeOperand(static_cast<uint32_t>(varIndex));
 }
 
 void CodeGenerator::visitExpressionStmt(const ExpressionStmt& stmt) {
@@ -220,28 +262,23 @@ void CodeGenerator::visitIfStmt(const IfStmt& stmt) {
     stmt.condition->accept(*this);
     
     // Remember position for jump
-    size_t jumpIfFalsePos = writer.getCode().size();
-    writer.writeOpCode(OpCode::JUMP_IF_FALSE);
-    writer.writeOperand(0); // Placeholder - will be patched
+    writer.markSite(writer.getCode().size(), stmt.site);
+    size_t jumpIfFalsePos = emitJump(OpCode::JUMP_IF_FALSE);
     
     // Generate code for then branch
     stmt.thenBranch->accept(*this);
     
-    size_t jumpPos = writer.getCode().size();
-    writer.writeOpCode(OpCode::JUMP);
-    writer.writeOperand(0); // Placeholder
+    size_t jumpPos = emitJump(OpCode::JUMP);
     
-    // Patch jump_if_false
-    // This would require modifying the bytecode after generation
-    // For simplicity, we'll leave it as is for now
+    // The else branch (or the end of the statement) starts here
+    patchJump(jumpIfFalsePos);
     
     if (stmt.elseBranch) {
         // Generate code for else branch
         stmt.elseBranch->accept(*this);
     }
     
-    // Patch jumps
-    // Implementation would go here
+    patchJump(jumpPos);
 }
 
 void CodeGenerator::visitWhileStmt(const WhileStmt& stmt) {
@@ -250,9 +287,8 @@ void CodeGenerator::visitWhileStmt(const WhileStmt& stmt) {
     // Generate code for condition
     stmt.condition->accept(*this);
     
-    size_t jumpIfFalsePos = writer.getCode().size();
-    writer.writeOpCode(OpCode::JUMP_IF_FALSE);
-    writer.writeOperand(0); // Placeholder
+    writer.markSite(writer.getCode().size(), stmt.site);
+    size_t jumpIfFalsePos = emitJump(OpCode::JUMP_IF_FALSE);
     
     // Generate code for body
     stmt.body->accept(*this);
@@ -261,23 +297,26 @@ void CodeGenerator::visitWhileStmt(const WhileStmt& stmt) {
     writer.writeOpCode(OpCode::JUMP);
     writer.writeOperand(static_cast<uint32_t>(loopStart));
     
-    // Patch jump_if_false
-    // Implementation would go here
+    patchJump(jumpIfFalsePos);
 }
 
 void CodeGenerator::visitFunctionDeclStmt(const FunctionDeclStmt& stmt) {
     // Function declaration would generate a function object
     // For now, we'll skip code generation for functions
     // In a real compiler, this would create a new code segment
+    executable = false;
 }
 
 void CodeGenerator::visitReturnStmt(const ReturnStmt& stmt) {
+    writer.markLine(stmt.keyword.line());
+    
     if (stmt.value) {
         stmt.value->accept(*this);
     } else {
         writer.writeOpCode(OpCode::LOAD_NULL);
     }
     writer.writeOpCode(OpCode::RETURN);
+    executable = false;
 }
 
 BytecodeWriter CodeGenerator::generate(const ProgramPtr& program) {
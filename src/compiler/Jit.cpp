@@ -0,0 +1,583 @@
+#include "Jit.h"
+#include "PerfMap.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define SIMPLELANG_JIT_AVAILABLE 1
+#endif
+
+namespace {
+    // Called from native code for PRINT; formats like Environment::valueToString
+    void jitPrint(const int64_t* values, const JitType* types, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            switch (types[i]) {
+                case JitType::INT: std::cout << static_cast<int>(values[i]); break;
+                case JitType::BOOL: std::cout << (values[i] ? "true" : "false"); break;
+                default: std::cout << "null"; break;
+            }
+            if (i + 1 < count) {
+                std::cout << " ";
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    bool isScalar(JitType type) {
+        return type == JitType::INT || type == JitType::BOOL;
+    }
+
+    int32_t stackOffset(size_t depth) {
+        return static_cast<int32_t>(depth * sizeof(int64_t));
+    }
+}
+
+// ExecutableMemory
+ExecutableMemory::ExecutableMemory() : memory(nullptr), size(0) {}
+
+ExecutableMemory::~ExecutableMemory() {
+#ifdef SIMPLELANG_JIT_AVAILABLE
+    if (memory) {
+        munmap(memory, size);
+    }
+#endif
+}
+
+bool ExecutableMemory::allocate(const std::vector<uint8_t>& code) {
+#ifdef SIMPLELANG_JIT_AVAILABLE
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t length = ((code.size() + pageSize - 1) / pageSize) * pageSize;
+
+    void* pages = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED) {
+        return false;
+    }
+
+    std::memcpy(pages, code.data(), code.size());
+
+    // Flip to executable only after the code is in place
+    if (mprotect(pages, length, PROT_READ | PROT_EXEC) != 0) {
+        munmap(pages, length);
+        return false;
+    }
+
+    memory = pages;
+    size = length;
+    return true;
+#else
+    (void)code;
+    return false;
+#endif
+}
+
+// JitFunction
+uint32_t JitFunction::invoke(int64_t* slots, uint8_t* tags, int64_t* stack) const {
+    Entry entry = reinterpret_cast<Entry>(memory.data());
+    return entry(slots, tags, stack);
+}
+
+// JitCompiler
+JitCompiler::JitCompiler() : chunk(nullptr) {}
+
+bool JitCompiler::isSupported() {
+#ifdef SIMPLELANG_JIT_AVAILABLE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void JitCompiler::decode() {
+    const std::vector<uint8_t>& code = chunk->getCode();
+    instructions.clear();
+
+    size_t pc = 0;
+    while (pc < code.size()) {
+        Instruction instr{pc, static_cast<OpCode>(code[pc]), 0};
+        pc++;
+        if (BytecodeWriter::hasOperand(instr.opcode)) {
+            instr.operand = chunk->readOperand(pc);
+            pc += 4;
+        }
+        instructions.push_back(instr);
+    }
+}
+
+size_t JitCompiler::indexOf(size_t pc) const {
+    auto it = std::lower_bound(instructions.begin(), instructions.end(), pc,
+        [](const Instruction& instr, size_t value) { return instr.pc < value; });
+    return static_cast<size_t>(it - instructions.begin());
+}
+
+bool JitCompiler::isConstant(uint32_t index, JitType& type) const {
+    const Value& constant = chunk->getConstants()[index];
+    if (std::holds_alternative<int>(constant)) {
+        type = JitType::INT;
+        return true;
+    }
+    if (std::holds_alternative<bool>(constant)) {
+        type = JitType::BOOL;
+        return true;
+    }
+    return false;
+}
+
+JitType JitCompiler::expectedType(size_t pc) const {
+    switch (chunk->getExpected(pc)) {
+        case TokenType::INT_TYPE: return JitType::INT;
+        case TokenType::BOOL_TYPE: return JitType::BOOL;
+        default: return JitType::UNKNOWN;
+    }
+}
+
+bool JitCompiler::transfer(const Instruction& instr, State& state) const {
+    std::vector<JitType>& stack = state.stack;
+
+    switch (instr.opcode) {
+        case OpCode::LOAD_CONST: {
+            JitType type;
+            if (!isConstant(instr.operand, type)) return false;
+            stack.push_back(type);
+            return true;
+        }
+        case OpCode::LOAD_NULL:
+            stack.push_back(JitType::NUL);
+            return true;
+        case OpCode::LOAD_TRUE:
+        case OpCode::LOAD_FALSE:
+            stack.push_back(JitType::BOOL);
+            return true;
+
+        case OpCode::LOAD_VAR: {
+            if (instr.operand >= state.slots.size()) return false;
+            // A profiled load always has its profiled type, guarded on the
+            // slot's tag unless the slot is known to have it; the pushed type
+            // then stays the same while the slot's type widens
+            JitType type = expectedType(instr.pc);
+            if (type == JitType::UNKNOWN) {
+                type = state.slots[instr.operand];
+            }
+            if (!isScalar(type)) return false;
+            stack.push_back(type);
+            return true;
+        }
+        case OpCode::STORE_VAR:
+            if (stack.empty() || instr.operand >= state.slots.size()) return false;
+            state.slots[instr.operand] = stack.back();
+            stack.pop_back();
+            return true;
+
+        case OpCode::ADD:
+        case OpCode::SUB:
+        case OpCode::MUL:
+        case OpCode::MOD:
+        case OpCode::LT:
+        case OpCode::GT:
+        case OpCode::LTE:
+        case OpCode::GTE: {
+            if (stack.size() < 2) return false;
+            if (stack[stack.size() - 2] != JitType::INT || stack.back() != JitType::INT) return false;
+            bool comparison = instr.opcode >= OpCode::LT && instr.opcode <= OpCode::GTE;
+            stack.pop_back();
+            stack.back() = comparison ? JitType::BOOL : JitType::INT;
+            return true;
+        }
+        case OpCode::EQ:
+        case OpCode::NEQ:
+        case OpCode::AND:
+        case OpCode::OR:
+            if (stack.size() < 2) return false;
+            if (!isScalar(stack[stack.size() - 2]) || !isScalar(stack.back())) return false;
+            stack.pop_back();
+            stack.back() = JitType::BOOL;
+            return true;
+
+        case OpCode::NEG:
+            if (stack.empty() || stack.back() != JitType::INT) return false;
+            return true;
+        case OpCode::NOT:
+            if (stack.empty() || !isScalar(stack.back())) return false;
+            stack.back() = JitType::BOOL;
+            return true;
+
+        case OpCode::JUMP:
+            return true;
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::JUMP_IF_TRUE:
+            if (stack.empty() || !isScalar(stack.back())) return false;
+            stack.pop_back();
+            return true;
+
+        case OpCode::POP:
+            if (stack.empty()) return false;
+            stack.pop_back();
+            return true;
+        case OpCode::PRINT:
+            if (stack.size() < instr.operand) return false;
+            for (size_t i = stack.size() - instr.operand; i < stack.size(); i++) {
+                if (!isScalar(stack[i]) && stack[i] != JitType::NUL) return false;
+            }
+            stack.resize(stack.size() - instr.operand);
+            stack.push_back(JitType::NUL);
+            return true;
+
+        case OpCode::HALT:
+            return true;
+
+        default:
+            // CALL, RETURN, INPUT, DIV (float result), ... stay in the VM
+            return false;
+    }
+}
+
+bool JitCompiler::merge(State& target, const State& incoming) const {
+    if (!target.reachable) {
+        target = incoming;
+        target.reachable = true;
+        return true;
+    }
+
+    bool changed = false;
+    auto join = [&changed](JitType& into, JitType from) {
+        if (into == from || from == JitType::UNDEF) return;
+        // A slot that is not stored yet on one path takes the type of the other
+        JitType joined = into == JitType::UNDEF ? from : JitType::UNKNOWN;
+        if (joined != into) {
+            into = joined;
+            changed = true;
+        }
+    };
+
+    for (size_t i = 0; i < target.stack.size(); i++) join(target.stack[i], incoming.stack[i]);
+    for (size_t i = 0; i < target.slots.size(); i++) join(target.slots[i], incoming.slots[i]);
+    return changed;
+}
+
+bool JitCompiler::analyze() {
+    size_t count = instructions.size();
+    states.assign(count, State());
+    native.assign(count, false);
+    if (count == 0) return false;
+
+    State entry;
+    entry.reachable = true;
+    entry.slots.assign(chunk->slotCount(), JitType::UNDEF);
+    states[0] = entry;
+
+    std::vector<size_t> worklist = {0};
+    while (!worklist.empty()) {
+        size_t index = worklist.back();
+        worklist.pop_back();
+
+        const Instruction& instr = instructions[index];
+        State out = states[index];
+        if (!transfer(instr, out)) {
+            continue; // Becomes an exit to the VM; no native successors
+        }
+
+        std::vector<size_t> successors;
+        switch (instr.opcode) {
+            case OpCode::HALT:
+                break;
+            case OpCode::JUMP:
+                successors.push_back(indexOf(instr.operand));
+                break;
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::JUMP_IF_TRUE:
+                successors.push_back(index + 1);
+                successors.push_back(indexOf(instr.operand));
+                break;
+            default:
+                successors.push_back(index + 1);
+                break;
+        }
+
+        for (size_t successor : successors) {
+            if (successor >= count) continue; // Falls off the end of the program
+            State& target = states[successor];
+            if (target.reachable && target.stack.size() != out.stack.size()) {
+                return false; // Unbalanced stack across a join; leave it all to the VM
+            }
+            if (merge(target, out)) {
+                // Stack values are untagged; a mixed-type stack entry could not be boxed at an exit
+                if (std::find(target.stack.begin(), target.stack.end(), JitType::UNKNOWN) != target.stack.end()) {
+                    return false;
+                }
+                worklist.push_back(successor);
+            }
+        }
+    }
+
+    // Decide native vs. exit on the final (widest) states
+    for (size_t i = 0; i < count; i++) {
+        if (states[i].reachable) {
+            State scratch = states[i];
+            native[i] = transfer(instructions[i], scratch);
+        }
+    }
+    return native[0];
+}
+
+void JitCompiler::emitExit(Assembler& masm, size_t index, JitFunction& function, Label epilogue) {
+    function.exits.push_back({instructions[index].pc, states[index].stack});
+    masm.movImm32(RAX, static_cast<uint32_t>(function.exits.size() - 1));
+    masm.jmp(epilogue);
+}
+
+void JitCompiler::emitInstruction(Assembler& masm, size_t index, JitFunction& function,
+                                  const std::vector<Label>& labels, Label epilogue) {
+    // Register conventions: rbx = slots, rbp = slot tags, r12 = operand stack
+    const Instruction& instr = instructions[index];
+    const std::vector<JitType>& stack = states[index].stack;
+    size_t depth = stack.size();
+    int32_t top = depth > 0 ? stackOffset(depth - 1) : 0;
+    int32_t second = depth > 1 ? stackOffset(depth - 2) : 0;
+
+    switch (instr.opcode) {
+        case OpCode::LOAD_CONST: {
+            const Value& constant = chunk->getConstants()[instr.operand];
+            int32_t value = std::holds_alternative<int>(constant) ? std::get<int>(constant)
+                                                                  : (std::get<bool>(constant) ? 1 : 0);
+            masm.storeImm64(R12, stackOffset(depth), value);
+            break;
+        }
+        case OpCode::LOAD_NULL:
+        case OpCode::LOAD_FALSE:
+            masm.storeImm64(R12, stackOffset(depth), 0);
+            break;
+        case OpCode::LOAD_TRUE:
+            masm.storeImm64(R12, stackOffset(depth), 1);
+            break;
+
+        case OpCode::LOAD_VAR: {
+            JitType expected = expectedType(instr.pc);
+            if (expected != JitType::UNKNOWN && states[index].slots[instr.operand] != expected) {
+                // Speculating on the profiled type; anything else resumes the VM at this load
+                Label matches = masm.newLabel();
+                masm.cmpMemImm8(RBP, static_cast<int32_t>(instr.operand), static_cast<uint8_t>(expected));
+                masm.jcc(Cond::EQUAL, matches);
+                emitExit(masm, index, function, epilogue);
+                masm.bind(matches);
+            }
+            masm.load64(RAX, RBX, stackOffset(instr.operand));
+            masm.store64(R12, stackOffset(depth), RAX);
+            break;
+        }
+        case OpCode::STORE_VAR:
+            masm.load64(RAX, R12, top);
+            masm.store64(RBX, stackOffset(instr.operand), RAX);
+            masm.storeImm8(RBP, static_cast<int32_t>(instr.operand), static_cast<uint8_t>(stack.back()));
+            break;
+
+        case OpCode::ADD:
+        case OpCode::SUB:
+        case OpCode::MUL:
+            masm.load32(RAX, R12, second);
+            masm.load32(RCX, R12, top);
+            if (instr.opcode == OpCode::ADD) masm.add32(RAX, RCX);
+            else if (instr.opcode == OpCode::SUB) masm.sub32(RAX, RCX);
+            else masm.imul32(RAX, RCX);
+            masm.movsxd(RAX, RAX);
+            masm.store64(R12, second, RAX);
+            break;
+
+        case OpCode::MOD: {
+            if (chunk->isUnchecked(instr.pc)) {
+                // Range analysis ruled out zero and INT_MIN % -1
+                masm.load32(RAX, R12, second);
+                masm.load32(RCX, R12, top);
+                masm.cdq();
+                masm.idiv32(RCX);
+                masm.movsxd(RAX, RDX);
+                masm.store64(R12, second, RAX);
+                break;
+            }
+            
+            // Zero divisors go back to the VM, which reports "Modulo by zero"
+            Label byZero = masm.newLabel();
+            Label general = masm.newLabel();
+            Label done = masm.newLabel();
+            masm.load32(RCX, R12, top);
+            masm.cmp32Imm(RCX, 0);
+            masm.jcc(Cond::EQUAL, byZero);
+            // x % -1 is 0; idiv would fault on INT_MIN
+            masm.cmp32Imm(RCX, -1);
+            masm.jcc(Cond::NOT_EQUAL, general);
+            masm.xor32(RDX, RDX);
+            masm.jmp(done);
+            masm.bind(general);
+            masm.load32(RAX, R12, second);
+            masm.cdq();
+            masm.idiv32(RCX);
+            masm.bind(done);
+            masm.movsxd(RAX, RDX);
+            masm.store64(R12, second, RAX);
+
+            Label next = masm.newLabel();
+            masm.jmp(next);
+            masm.bind(byZero);
+            emitExit(masm, index, function, epilogue);
+            masm.bind(next);
+            break;
+        }
+
+        case OpCode::NEG:
+            masm.load32(RAX, R12, top);
+            masm.neg32(RAX);
+            masm.movsxd(RAX, RAX);
+            masm.store64(R12, top, RAX);
+            break;
+
+        case OpCode::EQ:
+        case OpCode::NEQ:
+        case OpCode::LT:
+        case OpCode::GT:
+        case OpCode::LTE:
+        case OpCode::GTE: {
+            if (stack[depth - 2] != stack[depth - 1]) {
+                // int == bool is always false (Environment::isEqual)
+                masm.storeImm64(R12, second, instr.opcode == OpCode::NEQ ? 1 : 0);
+                break;
+            }
+            Cond cond = Cond::EQUAL;
+            switch (instr.opcode) {
+                case OpCode::NEQ: cond = Cond::NOT_EQUAL; break;
+                case OpCode::LT: cond = Cond::LESS; break;
+                case OpCode::GT: cond = Cond::GREATER; break;
+                case OpCode::LTE: cond = Cond::LESS_EQUAL; break;
+                case OpCode::GTE: cond = Cond::GREATER_EQUAL; break;
+                default: break;
+            }
+            masm.load64(RAX, R12, second);
+            masm.load64(RCX, R12, top);
+            masm.cmp64(RAX, RCX);
+            masm.setcc(cond, RAX);
+            masm.movzxByte(RAX, RAX);
+            masm.store64(R12, second, RAX);
+            break;
+        }
+
+        case OpCode::AND:
+        case OpCode::OR:
+            masm.load64(RAX, R12, second);
+            masm.test64(RAX, RAX);
+            masm.setcc(Cond::NOT_EQUAL, RAX);
+            masm.load64(RCX, R12, top);
+            masm.test64(RCX, RCX);
+            masm.setcc(Cond::NOT_EQUAL, RCX);
+            if (instr.opcode == OpCode::AND) masm.and8(RAX, RCX);
+            else masm.or8(RAX, RCX);
+            masm.movzxByte(RAX, RAX);
+            masm.store64(R12, second, RAX);
+            break;
+
+        case OpCode::NOT:
+            masm.cmpMemImm64(R12, top, 0);
+            masm.setcc(Cond::EQUAL, RAX);
+            masm.movzxByte(RAX, RAX);
+            masm.store64(R12, top, RAX);
+            break;
+
+        case OpCode::JUMP:
+            masm.jmp(labels[std::min(indexOf(instr.operand), instructions.size())]);
+            break;
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::JUMP_IF_TRUE:
+            masm.cmpMemImm64(R12, top, 0);
+            masm.jcc(instr.opcode == OpCode::JUMP_IF_FALSE ? Cond::EQUAL : Cond::NOT_EQUAL,
+                     labels[std::min(indexOf(instr.operand), instructions.size())]);
+            break;
+
+        case OpCode::POP:
+            break;
+
+        case OpCode::PRINT: {
+            size_t first = depth - instr.operand;
+            function.printTypes.emplace_back(stack.begin() + first, stack.end());
+            masm.lea(RDI, R12, stackOffset(first));
+            masm.movImm64(RSI, reinterpret_cast<uint64_t>(function.printTypes.back().data()));
+            masm.movImm32(RDX, instr.operand);
+            masm.movImm64(RAX, reinterpret_cast<uint64_t>(&jitPrint));
+            masm.call(RAX);
+            masm.storeImm64(R12, stackOffset(first), 0);
+            break;
+        }
+
+        case OpCode::HALT:
+            masm.movImm32(RAX, JitFunction::COMPLETED);
+            masm.jmp(epilogue);
+            break;
+
+        default:
+            break;
+    }
+}
+
+std::unique_ptr<JitFunction> JitCompiler::compile(const BytecodeWriter& chunk) {
+    if (!isSupported()) {
+        return nullptr;
+    }
+
+    this->chunk = &chunk;
+    decode();
+    if (!analyze()) {
+        return nullptr;
+    }
+
+    auto function = std::make_unique<JitFunction>();
+    for (const auto& state : states) {
+        function->maxStackDepth = std::max(function->maxStackDepth, state.stack.size() + 1);
+    }
+
+    Assembler masm;
+    std::vector<Label> labels;
+    for (size_t i = 0; i <= instructions.size(); i++) {
+        labels.push_back(masm.newLabel());
+    }
+    Label epilogue = masm.newLabel();
+
+    // Prologue: keep the three base pointers in callee-saved registers.
+    // Three pushes also leave rsp 16-byte aligned for helper calls.
+    masm.push(RBX);
+    masm.push(RBP);
+    masm.push(R12);
+    masm.movRegReg(RBX, RDI);
+    masm.movRegReg(RBP, RSI);
+    masm.movRegReg(R12, RDX);
+
+    std::vector<PerfLine> lines;
+    for (size_t i = 0; i < instructions.size(); i++) {
+        if (!states[i].reachable) continue;
+        masm.bind(labels[i]);
+        int line = chunk.getLine(instructions[i].pc);
+        if (line > 0 && (lines.empty() || lines.back().line != line)) {
+            lines.push_back({masm.size(), line});
+        }
+        if (native[i]) {
+            emitInstruction(masm, i, *function, labels, epilogue);
+        } else {
+            emitExit(masm, i, *function, epilogue);
+        }
+    }
+
+    // Running off the end of the bytecode completes the program
+    masm.bind(labels[instructions.size()]);
+    masm.movImm32(RAX, JitFunction::COMPLETED);
+
+    masm.bind(epilogue);
+    masm.pop(R12);
+    masm.pop(RBP);
+    masm.pop(RBX);
+    masm.ret();
+
+    const std::vector<uint8_t>& code = masm.finalize();
+    if (!function->memory.allocate(code)) {
+        return nullptr;
+    }
+    PerfMap::registerCode(function->memory.data(), code.size(),
+                          PerfMap::symbolName("main", chunk.getLine(0)), lines);
+    return function;
+}
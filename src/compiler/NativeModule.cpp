@@ -0,0 +1,171 @@
+#include "NativeModule.h"
+#include "PerfMap.h"
+#include "../core/Config.h"
+#include "../core/Utils.h"
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dlfcn.h>
+#include <unistd.h>
+#define SIMPLELANG_NATIVE_AVAILABLE 1
+#endif
+
+namespace {
+    std::string shellQuote(const std::string& text) {
+        std::string quoted = "'";
+        for (char c : text) {
+            if (c == '\'') quoted += "'\\''";
+            else quoted += c;
+        }
+        return quoted + "'";
+    }
+
+    std::string makeTempDirectory() {
+#ifdef SIMPLELANG_NATIVE_AVAILABLE
+        char pattern[] = "/tmp/simplelang-XXXXXX";
+        char* path = mkdtemp(pattern);
+        return path ? path : "";
+#else
+        return "";
+#endif
+    }
+
+    // Runs the configured C compiler; on failure message holds its diagnostics
+    bool runCompiler(const std::string& arguments, const std::string& logFile, std::string& message) {
+        // Debug info lets perf annotate module code with the script's lines
+        std::string flags = PerfMap::isEnabled() ? " -O2 -g -fno-omit-frame-pointer -fwrapv " : " -O2 -fwrapv ";
+        std::string command = Config::get("cc", "cc") + flags + arguments +
+                              " 2> " + shellQuote(logFile);
+        if (std::system(command.c_str()) == 0) {
+            return true;
+        }
+
+        message = "C compiler failed";
+        try {
+            message += ":\n" + Utils::readFile(logFile);
+        } catch (const std::runtime_error&) {
+            // No diagnostics captured
+        }
+        return false;
+    }
+}
+
+NativeModule::NativeModule() : handle(nullptr), entry(nullptr), errorMessage(nullptr), printedCount(nullptr) {}
+
+NativeModule::~NativeModule() {
+    cleanup();
+}
+
+void NativeModule::cleanup() {
+#ifdef SIMPLELANG_NATIVE_AVAILABLE
+    if (handle) {
+        dlclose(handle);
+        handle = nullptr;
+    }
+    // perf resolves symbols from the module file after the run, so keep it
+    if (!directory.empty() && !PerfMap::isEnabled()) {
+        std::remove((directory + "/module.c").c_str());
+        std::remove((directory + "/module.so").c_str());
+        std::remove((directory + "/cc.log").c_str());
+        rmdir(directory.c_str());
+    }
+    directory.clear();
+#endif
+    entry = nullptr;
+    errorMessage = nullptr;
+    printedCount = nullptr;
+}
+
+bool NativeModule::isSupported() {
+#ifdef SIMPLELANG_NATIVE_AVAILABLE
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool NativeModule::load(const std::string& source, std::string& message) {
+#ifdef SIMPLELANG_NATIVE_AVAILABLE
+    cleanup();
+
+    directory = makeTempDirectory();
+    if (directory.empty()) {
+        message = "Could not create a build directory";
+        return false;
+    }
+
+    std::string sourceFile = directory + "/module.c";
+    std::string library = directory + "/module.so";
+    if (!Utils::writeFile(sourceFile, source)) {
+        message = "Could not write " + sourceFile;
+        return false;
+    }
+    if (!runCompiler("-shared -fPIC -o " + shellQuote(library) + " " + shellQuote(sourceFile),
+                     directory + "/cc.log", message)) {
+        return false;
+    }
+
+    handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        message = dlerror();
+        return false;
+    }
+
+    entry = reinterpret_cast<EntryPoint>(dlsym(handle, "simplelang_main"));
+    errorMessage = reinterpret_cast<ErrorMessage>(dlsym(handle, "simplelang_error"));
+    printedCount = reinterpret_cast<PrintedCount>(dlsym(handle, "simplelang_printed"));
+    if (!entry || !errorMessage || !printedCount) {
+        message = "Module does not export simplelang_main";
+        return false;
+    }
+    return true;
+#else
+    (void)source;
+    message = "Native modules are not supported on this platform";
+    return false;
+#endif
+}
+
+bool NativeModule::run(std::string& message) {
+    if (!entry) {
+        message = "No module loaded";
+        return false;
+    }
+
+    if (entry() != 0) {
+        message = errorMessage();
+        return false;
+    }
+    return true;
+}
+
+size_t NativeModule::printed() const {
+    return printedCount ? static_cast<size_t>(printedCount()) : 0;
+}
+
+bool NativeModule::buildExecutable(const std::string& source, const std::string& output, std::string& message) {
+    std::string directory = makeTempDirectory();
+    if (directory.empty()) {
+        message = "Could not create a build directory";
+        return false;
+    }
+
+    std::string sourceFile = directory + "/main.c";
+    std::string logFile = directory + "/cc.log";
+    bool built = false;
+    if (!Utils::writeFile(sourceFile, source)) {
+        message = "Could not write " + sourceFile;
+    } else {
+        built = runCompiler("-DSIMPLELANG_STANDALONE -o " + shellQuote(output) + " " + shellQuote(sourceFile),
+                            logFile, message);
+    }
+
+    std::remove(sourceFile.c_str());
+    std::remove(logFile.c_str());
+#ifdef SIMPLELANG_NATIVE_AVAILABLE
+    rmdir(directory.c_str());
+#endif
+    return built;
+}
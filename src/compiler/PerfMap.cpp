@@ -0,0 +1,179 @@
+#include "PerfMap.h"
+#include "../core/Config.h"
+#include <cstdio>
+#include <cstdint>
+#include <ctime>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define SIMPLELANG_PERF_AVAILABLE 1
+#endif
+
+namespace {
+    // jitdump format, see tools/perf/Documentation/jitdump-specification.txt
+    constexpr uint32_t JITDUMP_MAGIC = 0x4A695444;
+    constexpr uint32_t JITDUMP_VERSION = 1;
+    constexpr uint32_t JIT_CODE_LOAD = 0;
+    constexpr uint32_t JIT_CODE_DEBUG_INFO = 2;
+    constexpr uint32_t EM_X86_64 = 62;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t totalSize;
+        uint32_t elfMach;
+        uint32_t pad;
+        uint32_t pid;
+        uint64_t timestamp;
+        uint64_t flags;
+    };
+
+    struct RecordHeader {
+        uint32_t id;
+        uint32_t totalSize;
+        uint64_t timestamp;
+    };
+
+    struct CodeLoad {
+        RecordHeader header;
+        uint32_t pid;
+        uint32_t tid;
+        uint64_t vma;
+        uint64_t codeAddress;
+        uint64_t codeSize;
+        uint64_t codeIndex;
+    };
+
+    struct DebugInfo {
+        RecordHeader header;
+        uint64_t codeAddress;
+        uint64_t entryCount;
+    };
+
+    struct DebugEntry {
+        uint64_t address;
+        int32_t line;
+        int32_t discriminator;
+    };
+
+    FILE* mapFile = nullptr;
+    FILE* dumpFile = nullptr;
+    bool opened = false;
+    uint64_t codeIndex = 0;
+
+#ifdef SIMPLELANG_PERF_AVAILABLE
+    // perf record -k mono matches samples against this clock
+    uint64_t timestamp() {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+    }
+
+    void openFiles() {
+        opened = true;
+        std::string pid = std::to_string(getpid());
+
+        mapFile = std::fopen(("/tmp/perf-" + pid + ".map").c_str(), "w");
+
+        std::string dumpPath = "/tmp/jit-" + pid + ".dump";
+        int fd = open(dumpPath.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0666);
+        if (fd < 0) {
+            return;
+        }
+        // perf record only notices the dump through an executable mapping of it
+        long pageSize = sysconf(_SC_PAGESIZE);
+        if (mmap(nullptr, static_cast<size_t>(pageSize), PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0) == MAP_FAILED) {
+            close(fd);
+            return;
+        }
+        dumpFile = fdopen(fd, "wb");
+        if (!dumpFile) {
+            close(fd);
+            return;
+        }
+
+        FileHeader header = {JITDUMP_MAGIC, JITDUMP_VERSION, sizeof(FileHeader), EM_X86_64, 0,
+                             static_cast<uint32_t>(getpid()), timestamp(), 0};
+        std::fwrite(&header, sizeof header, 1, dumpFile);
+    }
+
+    void writeDebugInfo(uint64_t address, const std::vector<PerfLine>& lines, const std::string& file) {
+        DebugInfo info;
+        info.header.id = JIT_CODE_DEBUG_INFO;
+        info.header.totalSize = static_cast<uint32_t>(
+            sizeof(DebugInfo) + lines.size() * (sizeof(DebugEntry) + file.size() + 1));
+        info.header.timestamp = timestamp();
+        info.codeAddress = address;
+        info.entryCount = lines.size();
+        std::fwrite(&info, sizeof info, 1, dumpFile);
+
+        for (const PerfLine& line : lines) {
+            DebugEntry entry = {address + line.offset, line.line, 0};
+            std::fwrite(&entry, sizeof entry, 1, dumpFile);
+            std::fwrite(file.c_str(), 1, file.size() + 1, dumpFile);
+        }
+    }
+
+    void writeCodeLoad(uint64_t address, size_t size, const std::string& name) {
+        CodeLoad load;
+        load.header.id = JIT_CODE_LOAD;
+        load.header.totalSize = static_cast<uint32_t>(sizeof(CodeLoad) + name.size() + 1 + size);
+        load.header.timestamp = timestamp();
+        load.pid = static_cast<uint32_t>(getpid());
+        load.tid = static_cast<uint32_t>(syscall(SYS_gettid));
+        load.vma = address;
+        load.codeAddress = address;
+        load.codeSize = size;
+        load.codeIndex = codeIndex++;
+        std::fwrite(&load, sizeof load, 1, dumpFile);
+        std::fwrite(name.c_str(), 1, name.size() + 1, dumpFile);
+        std::fwrite(reinterpret_cast<const void*>(address), 1, size, dumpFile);
+    }
+#endif
+}
+
+bool PerfMap::isEnabled() {
+    return Config::getBool("perf");
+}
+
+std::string PerfMap::symbolName(const std::string& function, int line) {
+    std::string name = "simplelang:" + function + " (" + Config::get("script", "<stdin>");
+    if (line > 0) {
+        name += ":" + std::to_string(line);
+    }
+    return name + ")";
+}
+
+void PerfMap::registerCode(const void* code, size_t size, const std::string& name,
+                           const std::vector<PerfLine>& lines) {
+#ifdef SIMPLELANG_PERF_AVAILABLE
+    if (!isEnabled() || !code || size == 0) {
+        return;
+    }
+    if (!opened) {
+        openFiles();
+    }
+
+    uint64_t address = reinterpret_cast<uint64_t>(code);
+    if (mapFile) {
+        std::fprintf(mapFile, "%llx %zx %s\n", static_cast<unsigned long long>(address), size, name.c_str());
+        std::fflush(mapFile);
+    }
+    if (dumpFile) {
+        // Line info has to precede the load record it describes
+        if (!lines.empty()) {
+            writeDebugInfo(address, lines, Config::get("script", "<stdin>"));
+        }
+        writeCodeLoad(address, size, name);
+        std::fflush(dumpFile);
+    }
+#else
+    (void)code;
+    (void)size;
+    (void)name;
+    (void)lines;
+#endif
+}
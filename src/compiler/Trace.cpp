@@ -0,0 +1,706 @@
+#include "Trace.h"
+#include "PerfMap.h"
+#include "../core/Numbers.h"
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+    // Operand stack entry d lives in STACK_GP[d] (int/bool) or xmm d (float);
+    // xmm7, rax and rdx are scratch
+    const Reg STACK_GP[] = {RSI, RDI, R8, R9, R10, R11, RCX};
+    const size_t MAX_DEPTH = sizeof(STACK_GP) / sizeof(STACK_GP[0]);
+    const XReg XMM_SCRATCH = XMM7;
+
+    // Slot homes; callee-saved so they survive the print helper
+    const Reg GP_HOMES[] = {R12, R13, R14, R15};
+    const XReg XMM_HOMES[] = {XMM8, XMM9, XMM10, XMM11, XMM12, XMM13, XMM14, XMM15};
+
+    // Scratch buffer layout (byte offsets): exit stack / print arguments,
+    // saved tags pointer, float homes spilled around calls, print types
+    const int32_t TAGS_POINTER = static_cast<int32_t>(MAX_DEPTH * 8);
+    const int32_t FLOAT_SPILL = TAGS_POINTER + 8;
+    const int32_t PRINT_TYPES = FLOAT_SPILL + 8 * 8;
+    const size_t SCRATCH_WORDS = MAX_DEPTH + 1 + 8 + 1;
+
+    bool isGp(JitType type) {
+        return type == JitType::INT || type == JitType::BOOL;
+    }
+
+    bool isNumeric(JitType type) {
+        return type == JitType::INT || type == JitType::FLOAT;
+    }
+
+    XReg stackXmm(size_t depth) {
+        return static_cast<XReg>(depth);
+    }
+
+    int32_t slotOffset(uint32_t index) {
+        return static_cast<int32_t>(index * sizeof(int64_t));
+    }
+
+    float floatFromRaw(int64_t raw) {
+        uint32_t bits = static_cast<uint32_t>(raw);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // Called from trace code for PRINT; formats like VM::valueToString
+    void tracePrint(const int64_t* values, const uint8_t* types, uint32_t count, const BytecodeWriter* chunk) {
+        for (uint32_t i = 0; i < count; i++) {
+            switch (static_cast<JitType>(types[i])) {
+                case JitType::INT: std::cout << static_cast<int>(values[i]); break;
+                case JitType::FLOAT: std::cout << Numbers::toString(floatFromRaw(values[i])); break;
+                case JitType::BOOL: std::cout << (values[i] ? "true" : "false"); break;
+                case JitType::STRING: std::cout << std::get<std::string>(chunk->getConstants()[values[i]]); break;
+                default: std::cout << "null"; break;
+            }
+            if (i + 1 < count) {
+                std::cout << " ";
+            }
+        }
+        std::cout << std::endl;
+    }
+}
+
+// TraceRecorder
+TraceRecorder::TraceRecorder() : recording(false), header(0) {}
+
+void TraceRecorder::start(size_t header, const std::vector<JitType>& slotTypes) {
+    recording = true;
+    this->header = header;
+    ops.clear();
+    entryTypes = slotTypes;
+}
+
+bool TraceRecorder::record(size_t pc, OpCode opcode, uint32_t operand) {
+    switch (opcode) {
+        case OpCode::LOAD_CONST:
+        case OpCode::LOAD_NULL:
+        case OpCode::LOAD_TRUE:
+        case OpCode::LOAD_FALSE:
+        case OpCode::LOAD_VAR:
+        case OpCode::STORE_VAR:
+        case OpCode::DECLARE_VAR:
+        case OpCode::ADD:
+        case OpCode::SUB:
+        case OpCode::MUL:
+        case OpCode::DIV:
+        case OpCode::MOD:
+        case OpCode::NEG:
+        case OpCode::NOT:
+        case OpCode::EQ:
+        case OpCode::NEQ:
+        case OpCode::LT:
+        case OpCode::GT:
+        case OpCode::LTE:
+        case OpCode::GTE:
+        case OpCode::AND:
+        case OpCode::OR:
+        case OpCode::JUMP:
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::JUMP_IF_TRUE:
+        case OpCode::POP:
+        case OpCode::PRINT:
+            break;
+        default:
+            // Calls, input and leaving the program end the recording
+            stop();
+            return false;
+    }
+
+    if (ops.size() >= MAX_TRACE_LENGTH) {
+        stop();
+        return false;
+    }
+
+    ops.push_back({pc, opcode, operand});
+    return true;
+}
+
+void TraceRecorder::stop() {
+    recording = false;
+}
+
+// Trace
+uint32_t Trace::invoke(int64_t* slots, uint8_t* tags, int64_t* scratch) const {
+    Entry entry = reinterpret_cast<Entry>(memory.data());
+    return entry(slots, tags, scratch);
+}
+
+// TraceCompiler
+TraceCompiler::TraceCompiler() : chunk(nullptr) {}
+
+bool TraceCompiler::assignHomes(const TraceRecorder& recorder) {
+    const std::vector<JitType>& entryTypes = recorder.getEntryTypes();
+    slotInfo.clear();
+    slotPosition.assign(entryTypes.size(), -1);
+
+    size_t gpUsed = 0;
+    size_t xmmUsed = 0;
+    for (const TraceOp& op : recorder.getOps()) {
+        if (op.opcode != OpCode::LOAD_VAR && op.opcode != OpCode::STORE_VAR &&
+            op.opcode != OpCode::DECLARE_VAR) {
+            continue;
+        }
+        if (op.operand >= entryTypes.size()) return false;
+        if (slotPosition[op.operand] != -1) continue;
+
+        // Slots written before they are read are guarded as well: an exit
+        // ahead of the store must hand back the previous iteration's value
+        JitType type = entryTypes[op.operand];
+        SlotInfo info{op.operand, type, type, Home::MEMORY, 0};
+        if (isGp(type)) {
+            if (gpUsed < sizeof(GP_HOMES) / sizeof(GP_HOMES[0])) {
+                info.home = Home::GP;
+                info.reg = GP_HOMES[gpUsed++];
+            }
+        } else if (type == JitType::FLOAT) {
+            if (xmmUsed < sizeof(XMM_HOMES) / sizeof(XMM_HOMES[0])) {
+                info.home = Home::XMM;
+                info.reg = XMM_HOMES[xmmUsed++];
+            }
+        } else {
+            return false;
+        }
+
+        slotPosition[op.operand] = static_cast<int>(slotInfo.size());
+        slotInfo.push_back(info);
+    }
+    return true;
+}
+
+void TraceCompiler::loadSlot(Assembler& masm, const SlotInfo& slot, size_t depth) {
+    switch (slot.home) {
+        case Home::GP: masm.movRegReg(STACK_GP[depth], static_cast<Reg>(slot.reg)); break;
+        case Home::XMM: masm.movaps(stackXmm(depth), static_cast<XReg>(slot.reg)); break;
+        case Home::MEMORY:
+            if (isGp(slot.type)) masm.load32(STACK_GP[depth], RBX, slotOffset(slot.index));
+            else masm.movssLoad(stackXmm(depth), RBX, slotOffset(slot.index));
+            break;
+    }
+}
+
+void TraceCompiler::storeSlot(Assembler& masm, const SlotInfo& slot, size_t depth) {
+    switch (slot.home) {
+        case Home::GP: masm.movRegReg(static_cast<Reg>(slot.reg), STACK_GP[depth]); break;
+        case Home::XMM: masm.movaps(static_cast<XReg>(slot.reg), stackXmm(depth)); break;
+        case Home::MEMORY:
+            if (isGp(slot.type)) masm.store64(RBX, slotOffset(slot.index), STACK_GP[depth]);
+            else masm.movssStore(RBX, slotOffset(slot.index), stackXmm(depth));
+            break;
+    }
+}
+
+void TraceCompiler::toFloat(Assembler& masm, size_t depth) {
+    if (stack[depth].type == JitType::INT) {
+        masm.cvtsi2ss(stackXmm(depth), STACK_GP[depth]);
+        stack[depth].type = JitType::FLOAT;
+    }
+}
+
+bool TraceCompiler::truthy(Assembler& masm, size_t depth) {
+    // Leaves 0/1 in the entry's GP register, as VM::isTruthy would decide
+    Reg reg = STACK_GP[depth];
+    switch (stack[depth].type) {
+        case JitType::BOOL:
+            break;
+        case JitType::INT:
+            masm.test32(reg, reg);
+            masm.setcc(Cond::NOT_EQUAL, reg);
+            masm.movzxByte(reg, reg);
+            break;
+        case JitType::FLOAT:
+            // NaN is truthy: unordered sets ZF and PF
+            masm.xorps(XMM_SCRATCH, XMM_SCRATCH);
+            masm.ucomiss(stackXmm(depth), XMM_SCRATCH);
+            masm.setcc(Cond::NOT_EQUAL, RAX);
+            masm.setcc(Cond::PARITY, RDX);
+            masm.or8(RAX, RDX);
+            masm.movzxByte(reg, RAX);
+            break;
+        case JitType::NUL:
+            masm.movImm32(reg, 0);
+            break;
+        case JitType::STRING: {
+            const Value& constant = chunk->getConstants()[stack[depth].constant];
+            masm.movImm32(reg, std::get<std::string>(constant).empty() ? 0 : 1);
+            break;
+        }
+        default:
+            return false;
+    }
+    stack[depth].type = JitType::BOOL;
+    return true;
+}
+
+void TraceCompiler::spillFloatSlots(Assembler& masm, bool reload) {
+    int32_t offset = FLOAT_SPILL;
+    for (const SlotInfo& slot : slotInfo) {
+        if (slot.home != Home::XMM) continue;
+        if (reload) masm.movssLoad(static_cast<XReg>(slot.reg), RBP, offset);
+        else masm.movssStore(RBP, offset, static_cast<XReg>(slot.reg));
+        offset += 8;
+    }
+}
+
+Label TraceCompiler::sideExit(Assembler& masm, size_t pc) {
+    PendingExit exit{masm.newLabel(), pc, stack, {}};
+    for (const SlotInfo& slot : slotInfo) {
+        exit.slotTypes.push_back(slot.type);
+    }
+    pendingExits.push_back(exit);
+    return exit.label;
+}
+
+void TraceCompiler::emitExits(Assembler& masm, Trace& trace, Label epilogue) {
+    for (const PendingExit& exit : pendingExits) {
+        masm.bind(exit.label);
+
+        // Write the register-resident slots back and retag every touched slot
+        masm.load64(RAX, RBP, TAGS_POINTER);
+        for (size_t i = 0; i < slotInfo.size(); i++) {
+            const SlotInfo& slot = slotInfo[i];
+            int32_t offset = slotOffset(slot.index);
+            if (slot.home == Home::GP) masm.store64(RBX, offset, static_cast<Reg>(slot.reg));
+            else if (slot.home == Home::XMM) masm.movssStore(RBX, offset, static_cast<XReg>(slot.reg));
+            masm.storeImm8(RAX, static_cast<int32_t>(slot.index), static_cast<uint8_t>(exit.slotTypes[i]));
+        }
+
+        // The operand stack goes to the scratch buffer for the VM to rebox
+        std::vector<JitType> types;
+        for (size_t depth = 0; depth < exit.stack.size(); depth++) {
+            const StackEntry& entry = exit.stack[depth];
+            int32_t offset = static_cast<int32_t>(depth * 8);
+            switch (entry.type) {
+                case JitType::INT:
+                case JitType::BOOL: masm.store64(RBP, offset, STACK_GP[depth]); break;
+                case JitType::FLOAT: masm.movssStore(RBP, offset, stackXmm(depth)); break;
+                case JitType::STRING: masm.storeImm64(RBP, offset, static_cast<int32_t>(entry.constant)); break;
+                default: break;
+            }
+            types.push_back(entry.type);
+        }
+
+        trace.exits.push_back({exit.pc, types});
+        masm.movImm32(RAX, static_cast<uint32_t>(trace.exits.size() - 1));
+        masm.jmp(epilogue);
+    }
+}
+
+bool TraceCompiler::emitOp(Assembler& masm, const std::vector<TraceOp>& ops, size_t index, Label loopStart) {
+    const TraceOp& op = ops[index];
+    size_t depth = stack.size();
+    size_t top = depth - 1;
+    size_t second = depth - 2;
+
+    switch (op.opcode) {
+        case OpCode::LOAD_CONST:
+        case OpCode::LOAD_NULL:
+        case OpCode::LOAD_TRUE:
+        case OpCode::LOAD_FALSE:
+        case OpCode::LOAD_VAR:
+            if (depth >= MAX_DEPTH) return false;
+            break;
+        case OpCode::NEG:
+        case OpCode::NOT:
+        case OpCode::STORE_VAR:
+        case OpCode::DECLARE_VAR:
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::JUMP_IF_TRUE:
+        case OpCode::POP:
+            if (depth < 1) return false;
+            break;
+        case OpCode::JUMP:
+        case OpCode::PRINT:
+            break;
+        default:
+            if (depth < 2) return false;
+            break;
+    }
+
+    switch (op.opcode) {
+        case OpCode::LOAD_CONST: {
+            const Value& constant = chunk->getConstants()[op.operand];
+            if (std::holds_alternative<int>(constant)) {
+                masm.movImm32(STACK_GP[depth], static_cast<uint32_t>(std::get<int>(constant)));
+                stack.push_back({JitType::INT, 0});
+            } else if (std::holds_alternative<bool>(constant)) {
+                masm.movImm32(STACK_GP[depth], std::get<bool>(constant) ? 1 : 0);
+                stack.push_back({JitType::BOOL, 0});
+            } else if (std::holds_alternative<float>(constant)) {
+                float value = std::get<float>(constant);
+                uint32_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                masm.movImm32(RAX, bits);
+                masm.movdToXmm(stackXmm(depth), RAX);
+                stack.push_back({JitType::FLOAT, 0});
+            } else {
+                // Strings stay constants; only PRINT and POP may consume them
+                stack.push_back({JitType::STRING, op.operand});
+            }
+            return true;
+        }
+        case OpCode::LOAD_NULL:
+            stack.push_back({JitType::NUL, 0});
+            return true;
+        case OpCode::LOAD_TRUE:
+        case OpCode::LOAD_FALSE:
+            masm.movImm32(STACK_GP[depth], op.opcode == OpCode::LOAD_TRUE ? 1 : 0);
+            stack.push_back({JitType::BOOL, 0});
+            return true;
+
+        case OpCode::LOAD_VAR: {
+            const SlotInfo& slot = slotInfo[slotPosition[op.operand]];
+            loadSlot(masm, slot, depth);
+            stack.push_back({slot.type, 0});
+            return true;
+        }
+        case OpCode::STORE_VAR:
+        case OpCode::DECLARE_VAR: {
+            SlotInfo& slot = slotInfo[slotPosition[op.operand]];
+            JitType type = stack[top].type;
+            // A slot keeps its register class for the whole trace
+            bool fits = isGp(slot.entryType) ? isGp(type) : type == JitType::FLOAT;
+            if (!fits) return false;
+            slot.type = type;
+            storeSlot(masm, slot, top);
+            stack.pop_back();
+            return true;
+        }
+
+        case OpCode::ADD:
+        case OpCode::SUB:
+        case OpCode::MUL: {
+            JitType left = stack[second].type;
+            JitType right = stack[top].type;
+            if (!isNumeric(left) || !isNumeric(right)) return false;
+
+            if (left == JitType::INT && right == JitType::INT) {
+                Reg dst = STACK_GP[second];
+                Reg src = STACK_GP[top];
+                if (op.opcode == OpCode::ADD) masm.add32(dst, src);
+                else if (op.opcode == OpCode::SUB) masm.sub32(dst, src);
+                else masm.imul32(dst, src);
+            } else {
+                toFloat(masm, second);
+                toFloat(masm, top);
+                XReg dst = stackXmm(second);
+                XReg src = stackXmm(top);
+                if (op.opcode == OpCode::ADD) masm.addss(dst, src);
+                else if (op.opcode == OpCode::SUB) masm.subss(dst, src);
+                else masm.mulss(dst, src);
+            }
+            stack.pop_back();
+            return true;
+        }
+
+        case OpCode::DIV: {
+            if (!isNumeric(stack[second].type) || !isNumeric(stack[top].type)) return false;
+
+            // Zero divisors leave the trace; the VM re-executes DIV and reports the error.
+            // Int divisors that range analysis proved non-zero need no guard.
+            if (stack[top].type != JitType::INT || !chunk->isUnchecked(op.pc)) {
+                Label exit = sideExit(masm, op.pc);
+                if (stack[top].type == JitType::INT) {
+                    masm.test32(STACK_GP[top], STACK_GP[top]);
+                    masm.jcc(Cond::EQUAL, exit);
+                } else {
+                    Label nonZero = masm.newLabel();
+                    masm.xorps(XMM_SCRATCH, XMM_SCRATCH);
+                    masm.ucomiss(stackXmm(top), XMM_SCRATCH);
+                    masm.jcc(Cond::PARITY, nonZero);
+                    masm.jcc(Cond::EQUAL, exit);
+                    masm.bind(nonZero);
+                }
+            }
+
+            toFloat(masm, second);
+            toFloat(masm, top);
+            masm.divss(stackXmm(second), stackXmm(top));
+            stack.pop_back();
+            return true;
+        }
+
+        case OpCode::MOD: {
+            if (stack[second].type != JitType::INT || stack[top].type != JitType::INT) return false;
+            Reg dividend = STACK_GP[second];
+            Reg divisor = STACK_GP[top];
+
+            if (chunk->isUnchecked(op.pc)) {
+                // Range analysis ruled out zero and INT_MIN % -1
+                masm.movRegReg(RAX, dividend);
+                masm.cdq();
+                masm.idiv32(divisor);
+                masm.movRegReg(dividend, RDX);
+                stack.pop_back();
+                return true;
+            }
+
+            masm.test32(divisor, divisor);
+            masm.jcc(Cond::EQUAL, sideExit(masm, op.pc));
+
+            // x % -1 is 0; idiv would fault on INT_MIN
+            Label general = masm.newLabel();
+            Label done = masm.newLabel();
+            masm.cmp32Imm(divisor, -1);
+            masm.jcc(Cond::NOT_EQUAL, general);
+            masm.xor32(dividend, dividend);
+            masm.jmp(done);
+            masm.bind(general);
+            masm.movRegReg(RAX, dividend);
+            masm.cdq();
+            masm.idiv32(divisor);
+            masm.movRegReg(dividend, RDX);
+            masm.bind(done);
+            stack.pop_back();
+            return true;
+        }
+
+        case OpCode::NEG:
+            if (stack[top].type == JitType::INT) {
+                masm.neg32(STACK_GP[top]);
+            } else if (stack[top].type == JitType::FLOAT) {
+                masm.movImm32(RAX, 0x80000000u);
+                masm.movdToXmm(XMM_SCRATCH, RAX);
+                masm.xorps(stackXmm(top), XMM_SCRATCH);
+            } else {
+                return false;
+            }
+            return true;
+
+        case OpCode::NOT:
+            if (!truthy(masm, top)) return false;
+            masm.cmp32Imm(STACK_GP[top], 0);
+            masm.setcc(Cond::EQUAL, STACK_GP[top]);
+            masm.movzxByte(STACK_GP[top], STACK_GP[top]);
+            return true;
+
+        case OpCode::AND:
+        case OpCode::OR:
+            if (!truthy(masm, second) || !truthy(masm, top)) return false;
+            if (op.opcode == OpCode::AND) masm.and8(STACK_GP[second], STACK_GP[top]);
+            else masm.or8(STACK_GP[second], STACK_GP[top]);
+            stack.pop_back();
+            return true;
+
+        case OpCode::LT:
+        case OpCode::GT:
+        case OpCode::LTE:
+        case OpCode::GTE: {
+            JitType left = stack[second].type;
+            JitType right = stack[top].type;
+            if (!isNumeric(left) || !isNumeric(right)) return false;
+
+            if (left == JitType::INT && right == JitType::INT) {
+                Cond cond = op.opcode == OpCode::LT ? Cond::LESS :
+                            op.opcode == OpCode::GT ? Cond::GREATER :
+                            op.opcode == OpCode::LTE ? Cond::LESS_EQUAL : Cond::GREATER_EQUAL;
+                masm.cmp32(STACK_GP[second], STACK_GP[top]);
+                masm.setcc(cond, RAX);
+            } else {
+                // "above" conditions are false when unordered, matching C++ on NaN
+                toFloat(masm, second);
+                toFloat(masm, top);
+                bool swap = op.opcode == OpCode::LT || op.opcode == OpCode::LTE;
+                bool strict = op.opcode == OpCode::LT || op.opcode == OpCode::GT;
+                masm.ucomiss(stackXmm(swap ? top : second), stackXmm(swap ? second : top));
+                masm.setcc(strict ? Cond::ABOVE : Cond::ABOVE_EQUAL, RAX);
+            }
+            masm.movzxByte(STACK_GP[second], RAX);
+            stack.pop_back();
+            stack[second].type = JitType::BOOL;
+            return true;
+        }
+
+        case OpCode::EQ:
+        case OpCode::NEQ: {
+            JitType left = stack[second].type;
+            JitType right = stack[top].type;
+            bool equal = op.opcode == OpCode::EQ;
+
+            if (isNumeric(left) && isNumeric(right) && (left == JitType::FLOAT || right == JitType::FLOAT)) {
+                toFloat(masm, second);
+                toFloat(masm, top);
+                masm.ucomiss(stackXmm(second), stackXmm(top));
+                masm.setcc(equal ? Cond::EQUAL : Cond::NOT_EQUAL, RAX);
+                masm.setcc(equal ? Cond::NOT_PARITY : Cond::PARITY, RDX);
+                if (equal) masm.and8(RAX, RDX);
+                else masm.or8(RAX, RDX);
+                masm.movzxByte(STACK_GP[second], RAX);
+            } else if (left == right && isGp(left)) {
+                masm.cmp32(STACK_GP[second], STACK_GP[top]);
+                masm.setcc(equal ? Cond::EQUAL : Cond::NOT_EQUAL, RAX);
+                masm.movzxByte(STACK_GP[second], RAX);
+            } else if (left == JitType::STRING && right == JitType::STRING) {
+                const auto& constants = chunk->getConstants();
+                bool same = constants[stack[second].constant] == constants[stack[top].constant];
+                masm.movImm32(STACK_GP[second], same == equal ? 1 : 0);
+            } else {
+                // Different types are never equal, except null == null
+                bool same = left == JitType::NUL && right == JitType::NUL;
+                masm.movImm32(STACK_GP[second], same == equal ? 1 : 0);
+            }
+            stack.pop_back();
+            stack[second].type = JitType::BOOL;
+            return true;
+        }
+
+        case OpCode::JUMP:
+            if (index + 1 < ops.size()) {
+                return true; // Forward jump inside the iteration; already followed
+            }
+            // Closing the loop: types must match what the entry guards checked
+            for (const SlotInfo& slot : slotInfo) {
+                if (slot.type != slot.entryType) return false;
+            }
+            if (!stack.empty()) return false;
+            masm.jmp(loopStart);
+            return true;
+
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::JUMP_IF_TRUE: {
+            if (!truthy(masm, top)) return false;
+            stack.pop_back();
+
+            size_t fallthrough = op.pc + 5;
+            if (op.operand == fallthrough || index + 1 >= ops.size()) return true;
+
+            // Guard that the branch goes the way it went while recording
+            bool taken = ops[index + 1].pc == op.operand;
+            bool recordedTruthy = (op.opcode == OpCode::JUMP_IF_TRUE) == taken;
+            Label exit = sideExit(masm, taken ? fallthrough : op.operand);
+            masm.test32(STACK_GP[top], STACK_GP[top]);
+            masm.jcc(recordedTruthy ? Cond::EQUAL : Cond::NOT_EQUAL, exit);
+            return true;
+        }
+
+        case OpCode::POP:
+            stack.pop_back();
+            return true;
+
+        case OpCode::PRINT: {
+            // Only a print statement on its own; nothing may sit below its arguments
+            if (depth != op.operand) return false;
+            for (size_t i = 0; i < depth; i++) {
+                int32_t offset = static_cast<int32_t>(i * 8);
+                switch (stack[i].type) {
+                    case JitType::INT:
+                    case JitType::BOOL: masm.store64(RBP, offset, STACK_GP[i]); break;
+                    case JitType::FLOAT: masm.movssStore(RBP, offset, stackXmm(i)); break;
+                    case JitType::STRING: masm.storeImm64(RBP, offset, static_cast<int32_t>(stack[i].constant)); break;
+                    default: break;
+                }
+                masm.storeImm8(RBP, PRINT_TYPES + static_cast<int32_t>(i), static_cast<uint8_t>(stack[i].type));
+            }
+
+            // xmm registers are caller-saved in the SysV ABI
+            spillFloatSlots(masm, false);
+            masm.lea(RDI, RBP, 0);
+            masm.lea(RSI, RBP, PRINT_TYPES);
+            masm.movImm32(RDX, op.operand);
+            masm.movImm64(RCX, reinterpret_cast<uint64_t>(chunk));
+            masm.movImm64(RAX, reinterpret_cast<uint64_t>(&tracePrint));
+            masm.call(RAX);
+            spillFloatSlots(masm, true);
+
+            stack.clear();
+            stack.push_back({JitType::NUL, 0});
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+std::unique_ptr<Trace> TraceCompiler::compile(const TraceRecorder& recorder, const BytecodeWriter& chunk) {
+    const std::vector<TraceOp>& ops = recorder.getOps();
+    if (!JitCompiler::isSupported() || ops.empty()) {
+        return nullptr;
+    }
+    // A complete recording ends with the jump back to its header
+    if (ops.back().opcode != OpCode::JUMP || ops.back().operand != recorder.getHeader()) {
+        return nullptr;
+    }
+
+    this->chunk = &chunk;
+    stack.clear();
+    pendingExits.clear();
+    if (!assignHomes(recorder)) {
+        return nullptr;
+    }
+
+    auto trace = std::make_unique<Trace>();
+    trace->scratchSize = SCRATCH_WORDS;
+    trace->exits.push_back({recorder.getHeader(), {}}); // ENTRY_GUARD_FAILED
+    for (const SlotInfo& slot : slotInfo) {
+        trace->slots.push_back(slot.index);
+    }
+
+    Assembler masm;
+    Label loopStart = masm.newLabel();
+    Label entryFailed = masm.newLabel();
+    Label epilogue = masm.newLabel();
+
+    // Prologue: six pushes plus the return address need 8 more bytes to
+    // keep rsp 16-byte aligned for the print helper
+    masm.push(RBX);
+    masm.push(RBP);
+    masm.push(R12);
+    masm.push(R13);
+    masm.push(R14);
+    masm.push(R15);
+    masm.subImm64(RSP, 8);
+    masm.movRegReg(RBX, RDI);
+    masm.movRegReg(RBP, RDX);
+    masm.store64(RBP, TAGS_POINTER, RSI);
+
+    // Entry guards: the code below is only valid for the recorded slot types
+    for (const SlotInfo& slot : slotInfo) {
+        masm.cmpMemImm8(RSI, static_cast<int32_t>(slot.index), static_cast<uint8_t>(slot.entryType));
+        masm.jcc(Cond::NOT_EQUAL, entryFailed);
+    }
+
+    // Unbox slots into their registers once, before the loop
+    for (const SlotInfo& slot : slotInfo) {
+        if (slot.home == Home::GP) masm.load32(static_cast<Reg>(slot.reg), RBX, slotOffset(slot.index));
+        else if (slot.home == Home::XMM) masm.movssLoad(static_cast<XReg>(slot.reg), RBX, slotOffset(slot.index));
+    }
+
+    masm.bind(loopStart);
+    std::vector<PerfLine> lines;
+    for (size_t i = 0; i < ops.size(); i++) {
+        int line = chunk.getLine(ops[i].pc);
+        if (line > 0 && (lines.empty() || lines.back().line != line)) {
+            lines.push_back({masm.size(), line});
+        }
+        if (!emitOp(masm, ops, i, loopStart)) {
+            return nullptr;
+        }
+    }
+
+    emitExits(masm, *trace, epilogue);
+
+    masm.bind(entryFailed);
+    masm.movImm32(RAX, Trace::ENTRY_GUARD_FAILED);
+
+    masm.bind(epilogue);
+    masm.addImm64(RSP, 8);
+    masm.pop(R15);
+    masm.pop(R14);
+    masm.pop(R13);
+    masm.pop(R12);
+    masm.pop(RBP);
+    masm.pop(RBX);
+    masm.ret();
+
+    const std::vector<uint8_t>& code = masm.finalize();
+    if (!trace->memory.allocate(code)) {
+        return nullptr;
+    }
+    PerfMap::registerCode(trace->memory.data(), code.size(),
+                          PerfMap::symbolName("loop", chunk.getLine(recorder.getHeader())), lines);
+    return trace;
+}
@@ -1,11 +1,19 @@
 #include "Config.h"
+#include "Numbers.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 
 std::unordered_map<std::string, std::string> Config::settings = {
     {"debug", "false"},
     {"optimize", "true"},
+    {"print_after", ""},
+    {"record_profile", ""},
+    {"use_profile", ""},
+    {"jit", "false"},
+    {"ir", "false"},
+    {"perf", "false"},
     {"warnings", "true"},
     {"max_errors", "10"},
     {"indent_size", "4"},
@@ -43,22 +51,18 @@ int Config::getInt(const std::string& key, int defaultValue) {
     std::string value = get(key, "");
     if (value.empty()) return defaultValue;
     
-    try {
-        return std::stoi(value);
-    } catch (...) {
-        return defaultValue;
-    }
+    int result = defaultValue;
+    Numbers::parse(value, result);
+    return result;
 }
 
 float Config::getFloat(const std::string& key, float defaultValue) {
     std::string value = get(key, "");
     if (value.empty()) return defaultValue;
     
-    try {
-        return std::stof(value);
-    } catch (...) {
-        return defaultValue;
-    }
+    float result = defaultValue;
+    Numbers::parse(value, result);
+    return result;
 }
 
 void Config::loadFromFile(const std::string& filename) {
@@ -1,5 +1,6 @@
 #include "Error.h"
 #include <sstream>
+#include <iostream>
 
 std::string Error::toString() const {
     std::stringstream ss;
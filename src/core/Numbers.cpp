@@ -0,0 +1,72 @@
+#include "Numbers.h"
+#include <charconv>
+
+namespace Numbers {
+    namespace {
+        template<typename T>
+        bool parseWhole(std::string_view text, T& value) {
+            size_t first = text.find_first_not_of(" \t");
+            if (first == std::string_view::npos) {
+                return false;
+            }
+            text = text.substr(first, text.find_last_not_of(" \t") - first + 1);
+            // from_chars takes a '-' but not a '+'
+            if (text.size() > 1 && text[0] == '+' && text[1] != '-') {
+                text.remove_prefix(1);
+            }
+            T result;
+            const char* end = text.data() + text.size();
+            auto [last, error] = std::from_chars(text.data(), end, result);
+            if (error != std::errc() || last != end) {
+                return false;
+            }
+            value = result;
+            return true;
+        }
+    }
+
+    bool parse(std::string_view text, int& value) {
+        return parseWhole(text, value);
+    }
+
+    bool parse(std::string_view text, float& value) {
+        return parseWhole(text, value);
+    }
+
+    char* write(char* out, int value) {
+        return std::to_chars(out, out + MAX_LENGTH, value).ptr;
+    }
+
+    char* write(char* out, float value) {
+        char* end = std::to_chars(out, out + MAX_LENGTH, value).ptr;
+        // Digits alone ("3", "-0") would read back as an int; inf and nan have letters
+        for (char* c = out; c != end; c++) {
+            if (*c != '-' && (*c < '0' || *c > '9')) {
+                return end;
+            }
+        }
+        *end++ = '.';
+        *end++ = '0';
+        return end;
+    }
+
+    void append(std::string& out, int value) {
+        char buffer[MAX_LENGTH];
+        out.append(buffer, write(buffer, value));
+    }
+
+    void append(std::string& out, float value) {
+        char buffer[MAX_LENGTH];
+        out.append(buffer, write(buffer, value));
+    }
+
+    std::string toString(int value) {
+        char buffer[MAX_LENGTH];
+        return std::string(buffer, write(buffer, value));
+    }
+
+    std::string toString(float value) {
+        char buffer[MAX_LENGTH];
+        return std::string(buffer, write(buffer, value));
+    }
+}
@@ -1,5 +1,6 @@
 #include "Utils.h"
 #include <fstream>
+#include <iostream>
 #include <algorithm>
 #include <cctype>
 
@@ -1,16 +1,52 @@
 #include "Environment.h"
+#include "../core/Numbers.h"
 #include <iostream>
 #include <stdexcept>
 
 Environment::Environment(std::shared_ptr<Environment> parent) : parent(parent) {}
 
+// A recursive function defined in a heap frame closes over the frame that
+// holds it; a strong reference there would keep both alive forever.
+// Captured cells keep strong references, so a function another escaping
+// closure captures still keeps its frame
+Value Environment::stored(const Value& value) const {
+    const FunctionObject* func = std::get_if<FunctionObject>(&value);
+    if (!func || func->closure.get() != this || func->closure.use_count() == 0) {
+        return value;
+    }
+    FunctionObject weak = *func;
+    weak.home = weak.closure;
+    weak.closure.reset();
+    return weak;
+}
+
+Value Environment::loaded(const Value& value) {
+    const FunctionObject* func = std::get_if<FunctionObject>(&value);
+    if (!func || func->closure || func->home.expired()) {
+        return value;
+    }
+    FunctionObject strong = *func;
+    strong.closure = strong.home.lock();
+    strong.home.reset();
+    return strong;
+}
+
 void Environment::define(const std::string& name, const Value& value) {
-    values[name] = value;
+    // Redefining a captured variable updates the cell functions share
+    auto box = boxes.find(name);
+    if (box != boxes.end()) {
+        *box->second = value;
+        return;
+    }
+    values[name] = stored(value);
 }
 
 void Environment::assign(const std::string& name, const Value& value) {
-    if (values.find(name) != values.end()) {
-        values[name] = value;
+    auto box = boxes.find(name);
+    if (box != boxes.end()) {
+        *box->second = value;
+    } else if (values.find(name) != values.end()) {
+        values[name] = stored(value);
     } else if (parent) {
         parent->assign(name, value);
     } else {
@@ -21,7 +57,12 @@ void Environment::assign(const std::string& name, const Value& value) {
 Value Environment::get(const std::string& name) {
     auto it = values.find(name);
     if (it != values.end()) {
-        return it->second;
+        return loaded(it->second);
+    }
+    
+    auto box = boxes.find(name);
+    if (box != boxes.end()) {
+        return *box->second;
     }
     
     if (parent) {
@@ -32,7 +73,7 @@ Value Environment::get(const std::string& name) {
 }
 
 bool Environment::exists(const std::string& name) const {
-    if (values.find(name) != values.end()) {
+    if (values.find(name) != values.end() || boxes.find(name) != boxes.end()) {
         return true;
     }
     
@@ -43,6 +84,28 @@ bool Environment::exists(const std::string& name) const {
     return false;
 }
 
+std::shared_ptr<Value> Environment::capture(const std::string& name) {
+    auto box = boxes.find(name);
+    if (box != boxes.end()) {
+        return box->second;
+    }
+    
+    auto it = values.find(name);
+    if (it != values.end()) {
+        auto cell = std::make_shared<Value>(loaded(it->second));
+        values.erase(it);
+        boxes[name] = cell;
+        return cell;
+    }
+    
+    return parent ? parent->capture(name) : nullptr;
+}
+
+void Environment::bind(const std::string& name, std::shared_ptr<Value> cell) {
+    values.erase(name);
+    boxes[name] = std::move(cell);
+}
+
 bool Environment::isTruthy(const Value& value) {
     if (std::holds_alternative<nullptr_t>(value)) return false;
     if (std::holds_alternative<bool>(value)) return std::get<bool>(value);
@@ -76,8 +139,8 @@ bool Environment::isEqual(const Value& a, const Value& b) {
 
 std::string Environment::valueToString(const Value& value) {
     if (std::holds_alternative<nullptr_t>(value)) return "null";
-    if (std::holds_alternative<int>(value)) return std::to_string(std::get<int>(value));
-    if (std::holds_alternative<float>(value)) return std::to_string(std::get<float>(value));
+    if (std::holds_alternative<int>(value)) return Numbers::toString(std::get<int>(value));
+    if (std::holds_alternative<float>(value)) return Numbers::toString(std::get<float>(value));
     if (std::holds_alternative<bool>(value)) return std::get<bool>(value) ? "true" : "false";
     if (std::holds_alternative<std::string>(value)) return std::get<std::string>(value);
     return "unknown";
@@ -88,6 +151,9 @@ void Environment::print() const {
     for (const auto& [name, value] : values) {
         std::cout << "  " << name << " = " << valueToString(value) << std::endl;
     }
+    for (const auto& [name, cell] : boxes) {
+        std::cout << "  " << name << " = " << valueToString(*cell) << " (captured)" << std::endl;
+    }
     
     if (parent) {
         std::cout << "Parent environment:" << std::endl;
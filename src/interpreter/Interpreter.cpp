@@ -3,8 +3,23 @@
 #include <iostream>
 #include <sstream>
 #include <limits>
+#include <optional>
+
+namespace {
+    // Type names of the recorded profile
+    const char* profileType(const Value& value) {
+        switch (value.index()) {
+            case 0: return "int";
+            case 1: return "float";
+            case 2: return "bool";
+            case 3: return "string";
+            case 4: return "null";
+            default: return "function";
+        }
+    }
+}
 
-Interpreter::Interpreter() : hasReturn(false) {
+Interpreter::Interpreter() : hasReturn(false), profile(nullptr) {
     globalEnv = std::make_shared<Environment>();
     currentEnv = globalEnv;
     defineNativeFunctions();
@@ -37,6 +52,10 @@ void Interpreter::executeBlock(const std::vector<StmtPtr>& statements, std::shar
     currentEnv = previousEnv;
 }
 
+std::shared_ptr<Environment> Interpreter::borrow(Environment& env) {
+    return std::shared_ptr<Environment>(std::shared_ptr<Environment>(), &env);
+}
+
 int Interpreter::toInt(const Value& value) {
     if (std::holds_alternative<int>(value)) return std::get<int>(value);
     if (std::holds_alternative<float>(value)) return static_cast<int>(std::get<float>(value));
@@ -165,7 +184,7 @@ Value Interpreter::logicalNot(const Value& value) {
 }
 
 void Interpreter::runtimeError(const Token& token, const std::string& message) {
-    errors.push_back(Error(ErrorType::RUNTIME, message, token.line, token.column, "Interpreter"));
+    errors.push_back(Error(ErrorType::RUNTIME, message, token.line(), token.column(), "Interpreter"));
 }
 
 // Expression visitors
@@ -175,7 +194,7 @@ Value Interpreter::visitLiteralExpr(const LiteralExpr& expr) {
 
 Value Interpreter::visitVariableExpr(const VariableExpr& expr) {
     try {
-        return currentEnv->get(expr.name.lexeme);
+        return currentEnv->get(std::string(expr.name.lexeme));
     } catch (const std::runtime_error& e) {
         runtimeError(expr.name, e.what());
         return nullptr;
@@ -185,6 +204,9 @@ Value Interpreter::visitVariableExpr(const VariableExpr& expr) {
 Value Interpreter::visitBinaryExpr(const BinaryExpr& expr) {
     Value left = evaluate(expr.left);
     Value right = evaluate(expr.right);
+    if (profile && expr.site) {
+        profile->recordOperands(expr.site, profileType(left), profileType(right));
+    }
     
     try {
         switch (expr.op.type) {
@@ -239,7 +261,7 @@ Value Interpreter::visitUnaryExpr(const UnaryExpr& expr) {
 Value Interpreter::visitCallExpr(const CallExpr& expr) {
     Value callee;
     try {
-        callee = currentEnv->get(expr.callee.lexeme);
+        callee = currentEnv->get(std::string(expr.callee.lexeme));
     } catch (const std::runtime_error& e) {
         runtimeError(expr.callee, e.what());
         return nullptr;
@@ -252,6 +274,9 @@ Value Interpreter::visitCallExpr(const CallExpr& expr) {
     
     if (std::holds_alternative<FunctionObject>(callee)) {
         auto& func = std::get<FunctionObject>(callee);
+        if (profile && expr.site) {
+            profile->recordCall(expr.site, func.site);
+        }
         
         if (arguments.size() != func.parameters.size()) {
             runtimeError(expr.callee, "Expected " + std::to_string(func.parameters.size()) + 
@@ -259,7 +284,15 @@ Value Interpreter::visitCallExpr(const CallExpr& expr) {
             return nullptr;
         }
         
-        auto env = std::make_shared<Environment>(func.closure);
+        // Nothing can keep a stack frame's environment alive past the call
+        std::optional<Environment> frame;
+        std::shared_ptr<Environment> env;
+        if (func.stackFrame) {
+            frame.emplace(func.closure);
+            env = borrow(*frame);
+        } else {
+            env = std::make_shared<Environment>(func.closure);
+        }
         
         for (size_t i = 0; i < arguments.size(); i++) {
             env->define(func.parameters[i].first, arguments[i]);
@@ -281,7 +314,9 @@ Value Interpreter::visitCallExpr(const CallExpr& expr) {
         
         currentEnv = previousEnv;
         
+        // The return ends this call only, not the caller's block
         if (hasReturn) {
+            hasReturn = false;
             return returnValue;
         }
         
@@ -295,7 +330,7 @@ Value Interpreter::visitCallExpr(const CallExpr& expr) {
 Value Interpreter::visitAssignmentExpr(const AssignmentExpr& expr) {
     Value value = evaluate(expr.value);
     try {
-        currentEnv->assign(expr.name.lexeme, value);
+        currentEnv->assign(std::string(expr.name.lexeme), value);
     } catch (const std::runtime_error& e) {
         runtimeError(expr.name, e.what());
     }
@@ -319,7 +354,7 @@ void Interpreter::visitVariableDeclStmt(const VariableDeclStmt& stmt) {
     if (stmt.initializer) {
         value = evaluate(stmt.initializer);
     }
-    currentEnv->define(stmt.name.lexeme, value);
+    currentEnv->define(std::string(stmt.name.lexeme), value);
 }
 
 void Interpreter::visitExpressionStmt(const ExpressionStmt& stmt) {
@@ -327,12 +362,21 @@ void Interpreter::visitExpressionStmt(const ExpressionStmt& stmt) {
 }
 
 void Interpreter::visitBlockStmt(const BlockStmt& stmt) {
+    if (escapes.isStackFrame(&stmt)) {
+        Environment frame(currentEnv);
+        executeBlock(stmt.statements, borrow(frame));
+        return;
+    }
     auto env = std::make_shared<Environment>(currentEnv);
     executeBlock(stmt.statements, env);
 }
 
 void Interpreter::visitIfStmt(const IfStmt& stmt) {
-    if (toBool(evaluate(stmt.condition))) {
+    bool taken = toBool(evaluate(stmt.condition));
+    if (profile && stmt.site) {
+        profile->recordBranch(stmt.site, taken);
+    }
+    if (taken) {
         execute(stmt.thenBranch);
     } else if (stmt.elseBranch) {
         execute(stmt.elseBranch);
@@ -340,7 +384,12 @@ void Interpreter::visitIfStmt(const IfStmt& stmt) {
 }
 
 void Interpreter::visitWhileStmt(const WhileStmt& stmt) {
-    while (toBool(evaluate(stmt.condition))) {
+    while (true) {
+        bool taken = toBool(evaluate(stmt.condition));
+        if (profile && stmt.site) {
+            profile->recordBranch(stmt.site, taken);
+        }
+        if (!taken) break;
         execute(stmt.body);
     }
 }
@@ -350,9 +399,27 @@ void Interpreter::visitFunctionDeclStmt(const FunctionDeclStmt& stmt) {
     func.parameters = stmt.parameters;
     func.returnType = stmt.returnType;
     func.body = stmt.body;
-    func.closure = currentEnv;
+    func.stackFrame = escapes.isStackFrame(&stmt);
+    func.site = stmt.site;
+    
+    const EscapeAnalysis::FunctionInfo* info = escapes.find(&stmt);
+    if (!info || info->pinned) {
+        func.closure = currentEnv;
+    } else if (!info->escapes) {
+        // Only callable while this frame is alive
+        func.closure = borrow(*currentEnv);
+    } else {
+        // Keeps just its upvalues, shared with the frame that defines them
+        func.closure = std::make_shared<Environment>(globalEnv);
+        for (const auto& name : info->upvalues) {
+            auto cell = currentEnv->capture(name);
+            if (cell) {
+                func.closure->bind(name, cell);
+            }
+        }
+    }
     
-    currentEnv->define(stmt.name.lexeme, func);
+    currentEnv->define(std::string(stmt.name.lexeme), func);
 }
 
 void Interpreter::visitReturnStmt(const ReturnStmt& stmt) {
@@ -365,6 +432,7 @@ void Interpreter::visitReturnStmt(const ReturnStmt& stmt) {
 }
 
 void Interpreter::interpret(const ProgramPtr& program) {
+    escapes.analyze(program);
     try {
         for (auto& stmt : program->statements) {
             execute(stmt);
@@ -0,0 +1,477 @@
+#include "VM.h"
+#include "../compiler/Jit.h"
+#include "../core/Config.h"
+#include "../core/Numbers.h"
+#include "../optimizer/Profile.h"
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+
+namespace {
+    // Loop counter value for headers that will not be traced again
+    const uint32_t BLACKLISTED = 0xFFFFFFFF;
+
+    // Int arithmetic wraps, as in the JIT;
+    // done unsigned because signed overflow is undefined in C++
+    int wrap(uint32_t value) {
+        return static_cast<int>(value);
+    }
+
+    // Type names of the recorded profile
+    const char* profileType(const VMValue& value) {
+        switch (value.index()) {
+            case 0: return "int";
+            case 1: return "float";
+            case 2: return "bool";
+            case 3: return "string";
+            default: return "null";
+        }
+    }
+}
+
+VM::VM() : chunk(nullptr), pc(0), tracing(false), profile(nullptr) {}
+
+uint32_t VM::readOperand() {
+    uint32_t operand = chunk->readOperand(pc);
+    pc += 4;
+    return operand;
+}
+
+void VM::push(const VMValue& value) {
+    stack.push_back(value);
+}
+
+VMValue VM::pop() {
+    if (stack.empty()) {
+        throw std::runtime_error("Stack underflow");
+    }
+    VMValue value = stack.back();
+    stack.pop_back();
+    return value;
+}
+
+VMValue VM::constantToValue(const Value& constant) const {
+    if (std::holds_alternative<int>(constant)) return std::get<int>(constant);
+    if (std::holds_alternative<float>(constant)) return std::get<float>(constant);
+    if (std::holds_alternative<bool>(constant)) return std::get<bool>(constant);
+    return std::get<std::string>(constant);
+}
+
+bool VM::isNumber(const VMValue& value) {
+    return std::holds_alternative<int>(value) || std::holds_alternative<float>(value);
+}
+
+float VM::toFloat(const VMValue& value) {
+    if (std::holds_alternative<float>(value)) return std::get<float>(value);
+    if (std::holds_alternative<int>(value)) return static_cast<float>(std::get<int>(value));
+    if (std::holds_alternative<bool>(value)) return std::get<bool>(value) ? 1.0f : 0.0f;
+    throw std::runtime_error("Cannot convert to float");
+}
+
+VMValue VM::add(const VMValue& left, const VMValue& right) {
+    if (std::holds_alternative<int>(left) && std::holds_alternative<int>(right)) {
+        return wrap(static_cast<uint32_t>(std::get<int>(left)) + static_cast<uint32_t>(std::get<int>(right)));
+    }
+    if (isNumber(left) && isNumber(right)) {
+        return toFloat(left) + toFloat(right);
+    }
+    if (std::holds_alternative<std::string>(left) || std::holds_alternative<std::string>(right)) {
+        return valueToString(left) + valueToString(right);
+    }
+    throw std::runtime_error("Invalid operands for addition");
+}
+
+VMValue VM::subtract(const VMValue& left, const VMValue& right) {
+    if (std::holds_alternative<int>(left) && std::holds_alternative<int>(right)) {
+        return wrap(static_cast<uint32_t>(std::get<int>(left)) - static_cast<uint32_t>(std::get<int>(right)));
+    }
+    if (isNumber(left) && isNumber(right)) {
+        return toFloat(left) - toFloat(right);
+    }
+    throw std::runtime_error("Invalid operands for subtraction");
+}
+
+VMValue VM::multiply(const VMValue& left, const VMValue& right) {
+    if (std::holds_alternative<int>(left) && std::holds_alternative<int>(right)) {
+        return wrap(static_cast<uint32_t>(std::get<int>(left)) * static_cast<uint32_t>(std::get<int>(right)));
+    }
+    if (isNumber(left) && isNumber(right)) {
+        return toFloat(left) * toFloat(right);
+    }
+    throw std::runtime_error("Invalid operands for multiplication");
+}
+
+VMValue VM::divide(const VMValue& left, const VMValue& right) {
+    if (isNumber(left) && isNumber(right)) {
+        float divisor = toFloat(right);
+        if (divisor == 0.0f) {
+            throw std::runtime_error("Division by zero");
+        }
+        return toFloat(left) / divisor;
+    }
+    throw std::runtime_error("Invalid operands for division");
+}
+
+VMValue VM::modulo(const VMValue& left, const VMValue& right) {
+    if (std::holds_alternative<int>(left) && std::holds_alternative<int>(right)) {
+        int divisor = std::get<int>(right);
+        if (divisor == 0) {
+            throw std::runtime_error("Modulo by zero");
+        }
+        // INT_MIN % -1 overflows in C++; the result is 0
+        return divisor == -1 ? 0 : std::get<int>(left) % divisor;
+    }
+    throw std::runtime_error("Invalid operands for modulo");
+}
+
+VMValue VM::negate(const VMValue& value) {
+    if (std::holds_alternative<int>(value)) return wrap(0u - static_cast<uint32_t>(std::get<int>(value)));
+    if (std::holds_alternative<float>(value)) return -std::get<float>(value);
+    throw std::runtime_error("Invalid operand for negation");
+}
+
+bool VM::less(const VMValue& left, const VMValue& right) {
+    if (std::holds_alternative<int>(left) && std::holds_alternative<int>(right)) {
+        return std::get<int>(left) < std::get<int>(right);
+    }
+    if (isNumber(left) && isNumber(right)) {
+        return toFloat(left) < toFloat(right);
+    }
+    if (std::holds_alternative<std::string>(left) && std::holds_alternative<std::string>(right)) {
+        return std::get<std::string>(left) < std::get<std::string>(right);
+    }
+    throw std::runtime_error("Invalid operands for comparison");
+}
+
+bool VM::isTruthy(const VMValue& value) {
+    if (std::holds_alternative<std::nullptr_t>(value)) return false;
+    if (std::holds_alternative<bool>(value)) return std::get<bool>(value);
+    if (std::holds_alternative<int>(value)) return std::get<int>(value) != 0;
+    if (std::holds_alternative<float>(value)) return std::get<float>(value) != 0.0f;
+    return !std::get<std::string>(value).empty();
+}
+
+bool VM::isEqual(const VMValue& a, const VMValue& b) {
+    if (std::holds_alternative<std::nullptr_t>(a) && std::holds_alternative<std::nullptr_t>(b)) return true;
+    if (std::holds_alternative<std::nullptr_t>(a) || std::holds_alternative<std::nullptr_t>(b)) return false;
+
+    if (a.index() == b.index()) return a == b;
+
+    // Cross-type comparisons
+    if (std::holds_alternative<int>(a) && std::holds_alternative<float>(b))
+        return static_cast<float>(std::get<int>(a)) == std::get<float>(b);
+    if (std::holds_alternative<float>(a) && std::holds_alternative<int>(b))
+        return std::get<float>(a) == static_cast<float>(std::get<int>(b));
+
+    return false;
+}
+
+std::string VM::valueToString(const VMValue& value) {
+    if (std::holds_alternative<std::nullptr_t>(value)) return "null";
+    if (std::holds_alternative<int>(value)) return Numbers::toString(std::get<int>(value));
+    if (std::holds_alternative<float>(value)) return Numbers::toString(std::get<float>(value));
+    if (std::holds_alternative<bool>(value)) return std::get<bool>(value) ? "true" : "false";
+    return std::get<std::string>(value);
+}
+
+void VM::runtimeError(const std::string& message) {
+    errors.push_back(Error(ErrorType::RUNTIME, message, -1, -1, "VM"));
+}
+
+JitType VM::toNative(const VMValue& value, int64_t& raw) const {
+    raw = 0;
+    if (std::holds_alternative<int>(value)) {
+        raw = std::get<int>(value);
+        return JitType::INT;
+    }
+    if (std::holds_alternative<float>(value)) {
+        float number = std::get<float>(value);
+        uint32_t bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        raw = bits;
+        return JitType::FLOAT;
+    }
+    if (std::holds_alternative<bool>(value)) {
+        raw = std::get<bool>(value) ? 1 : 0;
+        return JitType::BOOL;
+    }
+    if (std::holds_alternative<std::nullptr_t>(value)) {
+        return JitType::NUL;
+    }
+    return JitType::UNKNOWN;
+}
+
+VMValue VM::fromNative(int64_t raw, JitType type) const {
+    // Box a value left behind by native code according to its static type
+    switch (type) {
+        case JitType::INT: return static_cast<int>(raw);
+        case JitType::BOOL: return raw != 0;
+        case JitType::FLOAT: {
+            uint32_t bits = static_cast<uint32_t>(raw);
+            float number;
+            std::memcpy(&number, &bits, sizeof(number));
+            return number;
+        }
+        case JitType::STRING: return constantToValue(chunk->getConstants()[raw]);
+        default: return nullptr;
+    }
+}
+
+bool VM::runNative() {
+    JitCompiler compiler;
+    std::unique_ptr<JitFunction> function = compiler.compile(*chunk);
+    if (!function) {
+        return false;
+    }
+
+    std::vector<int64_t> nativeSlots(slots.size(), 0);
+    std::vector<uint8_t> tags(slots.size(), static_cast<uint8_t>(JitType::UNDEF));
+    std::vector<int64_t> nativeStack(function->getMaxStackDepth() + 1, 0);
+
+    uint32_t exitIndex = function->invoke(nativeSlots.data(), tags.data(), nativeStack.data());
+
+    // Hand the machine state back to the VM, boxing every value again
+    for (size_t i = 0; i < slots.size(); i++) {
+        slots[i] = fromNative(nativeSlots[i], static_cast<JitType>(tags[i]));
+    }
+
+    if (exitIndex == JitFunction::COMPLETED) {
+        pc = chunk->getCode().size();
+        return true;
+    }
+
+    const JitExit& exit = function->getExit(exitIndex);
+    for (size_t i = 0; i < exit.stack.size(); i++) {
+        push(fromNative(nativeStack[i], exit.stack[i]));
+    }
+    pc = exit.pc;
+    return true;
+}
+
+void VM::blacklist(size_t header) {
+    loopCounters[header] = BLACKLISTED;
+}
+
+void VM::onLoopBackEdge(size_t header) {
+    if (recorder.isRecording()) {
+        if (recorder.getHeader() == header) {
+            finishRecording();
+        } else {
+            // Nested loop inside the recording: leave the outer loop to the VM
+            recorder.stop();
+            blacklist(recorder.getHeader());
+        }
+    }
+
+    auto it = traces.find(header);
+    if (it != traces.end()) {
+        runTrace(header, *it->second);
+        return;
+    }
+
+    uint32_t& count = loopCounters[header];
+    if (count == BLACKLISTED) {
+        return;
+    }
+    if (++count >= TraceRecorder::HOT_LOOP_THRESHOLD) {
+        std::vector<JitType> types;
+        for (const VMValue& slot : slots) {
+            int64_t raw;
+            types.push_back(toNative(slot, raw));
+        }
+        recorder.start(header, types);
+    }
+}
+
+void VM::finishRecording() {
+    recorder.stop();
+
+    TraceCompiler compiler;
+    std::unique_ptr<Trace> trace = compiler.compile(recorder, *chunk);
+    if (trace) {
+        traces[recorder.getHeader()] = std::move(trace);
+    } else {
+        blacklist(recorder.getHeader());
+    }
+}
+
+void VM::runTrace(size_t header, const Trace& trace) {
+    std::vector<int64_t> nativeSlots(slots.size(), 0);
+    std::vector<uint8_t> tags(slots.size(), static_cast<uint8_t>(JitType::UNKNOWN));
+    for (uint32_t index : trace.getSlots()) {
+        tags[index] = static_cast<uint8_t>(toNative(slots[index], nativeSlots[index]));
+    }
+    std::vector<int64_t> scratch(trace.getScratchSize(), 0);
+
+    uint32_t exitIndex = trace.invoke(nativeSlots.data(), tags.data(), scratch.data());
+
+    if (exitIndex == Trace::ENTRY_GUARD_FAILED) {
+        // Slot types differ from the recording; keep this loop in the VM
+        traces.erase(header);
+        blacklist(header);
+        return;
+    }
+
+    for (uint32_t index : trace.getSlots()) {
+        slots[index] = fromNative(nativeSlots[index], static_cast<JitType>(tags[index]));
+    }
+
+    const JitExit& exit = trace.getExit(exitIndex);
+    for (size_t i = 0; i < exit.stack.size(); i++) {
+        push(fromNative(scratch[i], exit.stack[i]));
+    }
+    pc = exit.pc;
+}
+
+void VM::execute() {
+    const std::vector<uint8_t>& code = chunk->getCode();
+    const std::vector<Value>& constants = chunk->getConstants();
+
+    while (pc < code.size()) {
+        size_t start = pc;
+        OpCode opcode = static_cast<OpCode>(code[pc++]);
+
+        if (recorder.isRecording()) {
+            uint32_t operand = BytecodeWriter::hasOperand(opcode) ? chunk->readOperand(pc) : 0;
+            if (!recorder.record(start, opcode, operand)) {
+                blacklist(recorder.getHeader());
+            }
+        }
+
+        try {
+            switch (opcode) {
+                case OpCode::LOAD_CONST: push(constantToValue(constants[readOperand()])); break;
+                case OpCode::LOAD_NULL: push(nullptr); break;
+                case OpCode::LOAD_TRUE: push(true); break;
+                case OpCode::LOAD_FALSE: push(false); break;
+
+                case OpCode::LOAD_VAR: push(slots[readOperand()]); break;
+                case OpCode::STORE_VAR:
+                case OpCode::DECLARE_VAR: {
+                    uint32_t index = readOperand();
+                    slots[index] = pop();
+                    break;
+                }
+
+                case OpCode::NEG: push(negate(pop())); break;
+                case OpCode::NOT: push(!isTruthy(pop())); break;
+
+                case OpCode::ADD:
+                case OpCode::SUB:
+                case OpCode::MUL:
+                case OpCode::DIV:
+                case OpCode::MOD:
+                case OpCode::EQ:
+                case OpCode::NEQ:
+                case OpCode::LT:
+                case OpCode::GT:
+                case OpCode::LTE:
+                case OpCode::GTE:
+                case OpCode::AND:
+                case OpCode::OR: {
+                    VMValue right = pop();
+                    VMValue left = pop();
+                    if (profile) {
+                        if (unsigned site = chunk->getSite(start)) {
+                            profile->recordOperands(site, profileType(left), profileType(right));
+                        }
+                    }
+                    switch (opcode) {
+                        case OpCode::ADD: push(add(left, right)); break;
+                        case OpCode::SUB: push(subtract(left, right)); break;
+                        case OpCode::MUL: push(multiply(left, right)); break;
+                        case OpCode::DIV: push(divide(left, right)); break;
+                        case OpCode::MOD: push(modulo(left, right)); break;
+                        case OpCode::EQ: push(isEqual(left, right)); break;
+                        case OpCode::NEQ: push(!isEqual(left, right)); break;
+                        case OpCode::LT: push(less(left, right)); break;
+                        case OpCode::GT: push(less(right, left)); break;
+                        case OpCode::LTE: push(less(left, right) || isEqual(left, right)); break;
+                        case OpCode::GTE: push(less(right, left) || isEqual(left, right)); break;
+                        case OpCode::AND: push(isTruthy(left) && isTruthy(right)); break;
+                        default: push(isTruthy(left) || isTruthy(right)); break;
+                    }
+                    break;
+                }
+
+                case OpCode::JUMP:
+                    pc = readOperand();
+                    if (tracing && pc < start) {
+                        onLoopBackEdge(pc);
+                    }
+                    break;
+                case OpCode::JUMP_IF_FALSE:
+                case OpCode::JUMP_IF_TRUE: {
+                    uint32_t target = readOperand();
+                    bool condition = isTruthy(pop());
+                    if (profile) {
+                        if (unsigned site = chunk->getSite(start)) {
+                            profile->recordBranch(site, condition);
+                        }
+                    }
+                    if (condition == (opcode == OpCode::JUMP_IF_TRUE)) {
+                        pc = target;
+                    }
+                    break;
+                }
+
+                case OpCode::POP: pop(); break;
+
+                case OpCode::PRINT: {
+                    uint32_t count = readOperand();
+                    size_t first = stack.size() - count;
+                    for (size_t i = first; i < stack.size(); i++) {
+                        std::cout << valueToString(stack[i]);
+                        if (i < stack.size() - 1) {
+                            std::cout << " ";
+                        }
+                    }
+                    std::cout << std::endl;
+                    stack.resize(first);
+                    push(nullptr);
+                    break;
+                }
+
+                case OpCode::INPUT: {
+                    std::string line;
+                    std::getline(std::cin, line);
+                    push(line);
+                    break;
+                }
+
+                case OpCode::HALT:
+                    return;
+
+                default:
+                    runtimeError("Unsupported instruction: " + chunk->opcodeToString(opcode));
+                    return;
+            }
+        } catch (const std::runtime_error& e) {
+            // Same recovery as the Interpreter: record the error, continue with null
+            if (recorder.isRecording()) {
+                recorder.stop();
+                blacklist(recorder.getHeader());
+            }
+            runtimeError(e.what());
+            push(nullptr);
+        }
+    }
+}
+
+void VM::run(const BytecodeWriter& chunk) {
+    this->chunk = &chunk;
+    pc = 0;
+    stack.clear();
+    slots.assign(chunk.slotCount(), nullptr);
+    recorder.stop();
+    traces.clear();
+    loopCounters.clear();
+    // Native code would skip the profiled sites
+    tracing = !profile && Config::getBool("jit") && JitCompiler::isSupported();
+
+    if (tracing) {
+        runNative();
+    }
+
+    execute();
+}
@@ -0,0 +1,58 @@
+#include "Dominators.h"
+
+DominatorTree::DominatorTree(const IRFunction& function) : order(function.reversePostorder()) {
+    for (size_t i = 0; i < order.size(); i++) {
+        position[order[i]] = i;
+    }
+    if (order.empty()) {
+        return;
+    }
+
+    idom[order[0]] = order[0];
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < order.size(); i++) {
+            IRBlock* block = order[i];
+            IRBlock* dominator = nullptr;
+            for (IRBlock* predecessor : block->predecessors) {
+                if (!idom.count(predecessor)) continue; // Not processed yet or unreachable
+                dominator = dominator ? intersect(predecessor, dominator) : predecessor;
+            }
+            if (dominator && idom[block] != dominator) {
+                idom[block] = dominator;
+                changed = true;
+            }
+        }
+    }
+}
+
+IRBlock* DominatorTree::intersect(IRBlock* a, IRBlock* b) const {
+    while (a != b) {
+        while (position.at(a) > position.at(b)) a = idom.at(a);
+        while (position.at(b) > position.at(a)) b = idom.at(b);
+    }
+    return a;
+}
+
+IRBlock* DominatorTree::immediateDominator(const IRBlock* block) const {
+    auto it = idom.find(block);
+    if (it == idom.end() || it->second == block) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+bool DominatorTree::dominates(const IRBlock* a, const IRBlock* b) const {
+    if (!isReachable(a) || !isReachable(b)) {
+        return false;
+    }
+    // Walk up from b; dominators always come earlier in reverse postorder
+    const IRBlock* current = b;
+    while (current) {
+        if (current == a) return true;
+        if (position.at(current) < position.at(a)) return false;
+        current = immediateDominator(current);
+    }
+    return false;
+}
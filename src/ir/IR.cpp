@@ -0,0 +1,223 @@
+#include "IR.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace {
+    bool isNumberConstant(const IRInstruction* value) {
+        return value->op == IROp::CONST &&
+               (std::holds_alternative<int>(value->constant) || std::holds_alternative<float>(value->constant));
+    }
+
+    bool isZeroConstant(const IRInstruction* value) {
+        return (std::holds_alternative<int>(value->constant) && std::get<int>(value->constant) == 0) ||
+               (std::holds_alternative<float>(value->constant) && std::get<float>(value->constant) == 0.0f);
+    }
+}
+
+bool IRInstruction::hasSideEffects() const {
+    switch (op) {
+        case IROp::STORE_GLOBAL:
+        case IROp::CALL:
+        case IROp::PRINT:
+        case IROp::JUMP:
+        case IROp::BRANCH:
+        case IROp::RETURN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool IRInstruction::canTrap() const {
+    switch (op) {
+        case IROp::ADD:
+            // Anything concatenates with a string
+            for (const IRInstruction* operand : operands) {
+                if (operand->op == IROp::CONST && std::holds_alternative<std::string>(operand->constant)) {
+                    return false;
+                }
+            }
+            return !isNumberConstant(operands[0]) || !isNumberConstant(operands[1]);
+        case IROp::SUB:
+        case IROp::MUL:
+        case IROp::LT:
+        case IROp::GT:
+        case IROp::LTE:
+        case IROp::GTE:
+            return !isNumberConstant(operands[0]) || !isNumberConstant(operands[1]);
+        case IROp::DIV:
+            return !isNumberConstant(operands[0]) || !isNumberConstant(operands[1]) ||
+                   isZeroConstant(operands[1]);
+        case IROp::MOD:
+            return operands[0]->op != IROp::CONST || !std::holds_alternative<int>(operands[0]->constant) ||
+                   operands[1]->op != IROp::CONST || !std::holds_alternative<int>(operands[1]->constant) ||
+                   isZeroConstant(operands[1]);
+        case IROp::NEG:
+            return !isNumberConstant(operands[0]);
+        case IROp::CALL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+IRInstruction* IRBlock::terminator() const {
+    if (instructions.empty() || !instructions.back()->isTerminator()) {
+        return nullptr;
+    }
+    return instructions.back().get();
+}
+
+std::vector<IRBlock*> IRBlock::successors() const {
+    IRInstruction* term = terminator();
+    return term ? term->targets : std::vector<IRBlock*>();
+}
+
+size_t IRBlock::predecessorIndex(const IRBlock* block) const {
+    auto it = std::find(predecessors.begin(), predecessors.end(), block);
+    return static_cast<size_t>(it - predecessors.begin());
+}
+
+IRBlock* IRFunction::createBlock() {
+    blocks.push_back(std::make_unique<IRBlock>(nextBlockId++, this));
+    return blocks.back().get();
+}
+
+std::unique_ptr<IRInstruction> IRFunction::createInstruction(IROp op) {
+    return std::make_unique<IRInstruction>(nextValueId++, op);
+}
+
+void IRFunction::replaceAllUses(IRInstruction* from, IRInstruction* to) {
+    for (auto& block : blocks) {
+        for (auto& instruction : block->instructions) {
+            for (auto& operand : instruction->operands) {
+                if (operand == from) operand = to;
+            }
+        }
+    }
+}
+
+std::vector<IRBlock*> IRFunction::reversePostorder() const {
+    std::vector<IRBlock*> order;
+    if (blocks.empty()) {
+        return order;
+    }
+
+    // Iterative DFS; a block is emitted once all its successors are done.
+    // Successors are visited last to first so the first one (the taken
+    // side of a branch) ends up right after its block.
+    std::unordered_set<IRBlock*> visited;
+    std::vector<std::pair<IRBlock*, size_t>> stack;
+    stack.push_back({entry(), 0});
+    visited.insert(entry());
+    while (!stack.empty()) {
+        IRBlock* block = stack.back().first;
+        std::vector<IRBlock*> successors = block->successors();
+        if (stack.back().second < successors.size()) {
+            IRBlock* next = successors[successors.size() - 1 - stack.back().second++];
+            if (visited.insert(next).second) {
+                stack.push_back({next, 0});
+            }
+        } else {
+            order.push_back(block);
+            stack.pop_back();
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+void IRFunction::removeUnreachableBlocks() {
+    std::vector<IRBlock*> order = reversePostorder();
+    std::unordered_set<IRBlock*> reachable(order.begin(), order.end());
+
+    for (IRBlock* block : order) {
+        // Drop incoming edges (and matching phi operands) from dead blocks
+        for (size_t i = block->predecessors.size(); i-- > 0;) {
+            if (reachable.count(block->predecessors[i])) continue;
+            block->predecessors.erase(block->predecessors.begin() + static_cast<long>(i));
+            for (auto& instruction : block->instructions) {
+                if (instruction->op == IROp::PHI) {
+                    instruction->operands.erase(instruction->operands.begin() + static_cast<long>(i));
+                }
+            }
+        }
+    }
+
+    blocks.erase(std::remove_if(blocks.begin(), blocks.end(),
+                                [&](const std::unique_ptr<IRBlock>& block) {
+                                    return !reachable.count(block.get());
+                                }),
+                 blocks.end());
+}
+
+size_t IRFunction::removeTrivialPhis() {
+    size_t removed = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& block : blocks) {
+            auto& instructions = block->instructions;
+            for (size_t i = 0; i < instructions.size() && instructions[i]->op == IROp::PHI; i++) {
+                IRInstruction* phi = instructions[i].get();
+                IRInstruction* same = nullptr;
+                bool trivial = true;
+                for (IRInstruction* operand : phi->operands) {
+                    if (operand == phi || operand == same) continue;
+                    if (same) {
+                        trivial = false;
+                        break;
+                    }
+                    same = operand;
+                }
+                // An operandless phi only appears in dead code, which is gone by now
+                if (!trivial || !same) continue;
+
+                replaceAllUses(phi, same);
+                instructions.erase(instructions.begin() + static_cast<long>(i--));
+                removed++;
+                changed = true;
+            }
+        }
+    }
+    return removed;
+}
+
+IRFunction* IRModule::find(const std::string& name) const {
+    for (const auto& function : functions) {
+        if (function->name == name) return function.get();
+    }
+    return nullptr;
+}
+
+const char* irOpName(IROp op) {
+    switch (op) {
+        case IROp::CONST: return "const";
+        case IROp::NUL: return "null";
+        case IROp::PARAM: return "param";
+        case IROp::PHI: return "phi";
+        case IROp::ADD: return "add";
+        case IROp::SUB: return "sub";
+        case IROp::MUL: return "mul";
+        case IROp::DIV: return "div";
+        case IROp::MOD: return "mod";
+        case IROp::NEG: return "neg";
+        case IROp::EQ: return "eq";
+        case IROp::NEQ: return "neq";
+        case IROp::LT: return "lt";
+        case IROp::GT: return "gt";
+        case IROp::LTE: return "lte";
+        case IROp::GTE: return "gte";
+        case IROp::AND: return "and";
+        case IROp::OR: return "or";
+        case IROp::NOT: return "not";
+        case IROp::LOAD_GLOBAL: return "load_global";
+        case IROp::STORE_GLOBAL: return "store_global";
+        case IROp::CALL: return "call";
+        case IROp::PRINT: return "print";
+        case IROp::JUMP: return "jump";
+        case IROp::BRANCH: return "branch";
+        case IROp::RETURN: return "return";
+    }
+    return "unknown";
+}
@@ -0,0 +1,548 @@
+#include "IRBuilder.h"
+#include <algorithm>
+
+namespace {
+    // Collects every variable name a function body reads or writes
+    class NameCollector : public Visitor {
+    public:
+        std::unordered_set<std::string>& names;
+
+        explicit NameCollector(std::unordered_set<std::string>& names) : names(names) {}
+
+        Value visitLiteralExpr(const LiteralExpr&) override { return Value(); }
+        Value visitVariableExpr(const VariableExpr& expr) override {
+            names.insert(std::string(expr.name.lexeme));
+            return Value();
+        }
+        Value visitBinaryExpr(const BinaryExpr& expr) override {
+            expr.left->accept(*this);
+            expr.right->accept(*this);
+            return Value();
+        }
+        Value visitUnaryExpr(const UnaryExpr& expr) override {
+            expr.right->accept(*this);
+            return Value();
+        }
+        Value visitCallExpr(const CallExpr& expr) override {
+            for (const auto& argument : expr.arguments) argument->accept(*this);
+            return Value();
+        }
+        Value visitAssignmentExpr(const AssignmentExpr& expr) override {
+            names.insert(std::string(expr.name.lexeme));
+            expr.value->accept(*this);
+            return Value();
+        }
+
+        void visitPrintStmt(const PrintStmt& stmt) override {
+            for (const auto& expr : stmt.expressions) expr->accept(*this);
+        }
+        void visitVariableDeclStmt(const VariableDeclStmt& stmt) override {
+            if (stmt.initializer) stmt.initializer->accept(*this);
+        }
+        void visitExpressionStmt(const ExpressionStmt& stmt) override {
+            stmt.expression->accept(*this);
+        }
+        void visitBlockStmt(const BlockStmt& stmt) override {
+            for (const auto& statement : stmt.statements) statement->accept(*this);
+        }
+        void visitIfStmt(const IfStmt& stmt) override {
+            stmt.condition->accept(*this);
+            stmt.thenBranch->accept(*this);
+            if (stmt.elseBranch) stmt.elseBranch->accept(*this);
+        }
+        void visitWhileStmt(const WhileStmt& stmt) override {
+            stmt.condition->accept(*this);
+            stmt.body->accept(*this);
+        }
+        void visitFunctionDeclStmt(const FunctionDeclStmt& stmt) override {
+            stmt.body->accept(*this);
+        }
+        void visitReturnStmt(const ReturnStmt& stmt) override {
+            if (stmt.value) stmt.value->accept(*this);
+        }
+    };
+}
+
+IRBuilder::IRBuilder()
+    : function(nullptr), current(nullptr), lastValue(nullptr), undefined(nullptr),
+      currentLine(0), nextKey(0) {}
+
+void IRBuilder::error(const Token& token, const std::string& message) {
+    errors.push_back(Error(ErrorType::SEMANTIC, message, token.line(), token.column(), "IRBuilder"));
+}
+
+void IRBuilder::markLine(int line) {
+    if (line > 0) {
+        currentLine = line;
+    }
+}
+
+// SSA construction
+void IRBuilder::writeVariable(int key, IRBlock* block, IRInstruction* value) {
+    definitions[key][block] = value;
+}
+
+IRInstruction* IRBuilder::readVariable(int key, IRBlock* block) {
+    auto& blockDefinitions = definitions[key];
+    auto it = blockDefinitions.find(block);
+    if (it != blockDefinitions.end()) {
+        return it->second;
+    }
+    return readVariableRecursive(key, block);
+}
+
+IRInstruction* IRBuilder::readVariableRecursive(int key, IRBlock* block) {
+    IRInstruction* value;
+    if (!sealed.count(block)) {
+        // More predecessors may still appear; complete the phi when sealing
+        value = insertPhi(block);
+        incompletePhis[block].push_back({key, value});
+    } else if (block->predecessors.empty()) {
+        value = getUndefined();
+    } else if (block->predecessors.size() == 1) {
+        value = readVariable(key, block->predecessors[0]);
+    } else {
+        // Break cycles through loops with an operandless phi first
+        IRInstruction* phi = insertPhi(block);
+        writeVariable(key, block, phi);
+        value = addPhiOperands(key, phi);
+    }
+    writeVariable(key, block, value);
+    return value;
+}
+
+IRInstruction* IRBuilder::addPhiOperands(int key, IRInstruction* phi) {
+    for (IRBlock* predecessor : phi->block->predecessors) {
+        phi->operands.push_back(readVariable(key, predecessor));
+    }
+    return tryRemoveTrivialPhi(phi);
+}
+
+IRInstruction* IRBuilder::tryRemoveTrivialPhi(IRInstruction* phi) {
+    IRInstruction* same = nullptr;
+    for (IRInstruction* operand : phi->operands) {
+        if (operand == same || operand == phi) continue;
+        if (same) {
+            return phi; // Merges at least two values
+        }
+        same = operand;
+    }
+    if (!same) {
+        same = getUndefined();
+    }
+
+    // Reroute every use, remembering phis that might become trivial in turn
+    std::vector<IRInstruction*> users;
+    for (auto& block : function->blocks) {
+        for (auto& instruction : block->instructions) {
+            if (instruction.get() != phi && instruction->op == IROp::PHI &&
+                std::find(instruction->operands.begin(), instruction->operands.end(), phi) !=
+                    instruction->operands.end()) {
+                users.push_back(instruction.get());
+            }
+        }
+    }
+    function->replaceAllUses(phi, same);
+    for (auto& variable : definitions) {
+        for (auto& definition : variable.second) {
+            if (definition.second == phi) definition.second = same;
+        }
+    }
+
+    // Keep the phi alive until the build ends: a user removed further down
+    // the cascade may still be in `users`
+    auto& instructions = phi->block->instructions;
+    auto position = std::find_if(instructions.begin(), instructions.end(),
+                                 [phi](const std::unique_ptr<IRInstruction>& instruction) {
+                                     return instruction.get() == phi;
+                                 });
+    removedPhis.push_back(std::move(*position));
+    instructions.erase(position);
+    phi->block = nullptr;
+
+    for (IRInstruction* user : users) {
+        if (user->block) tryRemoveTrivialPhi(user);
+    }
+    return same;
+}
+
+void IRBuilder::sealBlock(IRBlock* block) {
+    sealed.insert(block);
+    std::vector<std::pair<int, IRInstruction*>> pending;
+    pending.swap(incompletePhis[block]);
+    for (const auto& [key, phi] : pending) {
+        addPhiOperands(key, phi);
+    }
+    incompletePhis.erase(block);
+}
+
+// Emission helpers
+IRInstruction* IRBuilder::emit(IROp op, std::vector<IRInstruction*> operands) {
+    std::unique_ptr<IRInstruction> instruction = function->createInstruction(op);
+    instruction->operands = std::move(operands);
+    instruction->line = currentLine;
+    instruction->block = current;
+    current->instructions.push_back(std::move(instruction));
+    return current->instructions.back().get();
+}
+
+IRInstruction* IRBuilder::emitExpr(const ExprPtr& expr) {
+    expr->accept(*this);
+    return lastValue;
+}
+
+IRInstruction* IRBuilder::emitConstant(const Value& value) {
+    IRInstruction* instruction = emit(IROp::CONST);
+    instruction->constant = value;
+    return instruction;
+}
+
+IRInstruction* IRBuilder::getUndefined() {
+    if (!undefined) {
+        // One null at the top of the entry block serves every undefined read
+        IRBlock* entry = function->entry();
+        std::unique_ptr<IRInstruction> instruction = function->createInstruction(IROp::NUL);
+        instruction->block = entry;
+        entry->instructions.insert(entry->instructions.begin(), std::move(instruction));
+        undefined = entry->instructions.front().get();
+    }
+    return undefined;
+}
+
+IRInstruction* IRBuilder::insertPhi(IRBlock* block) {
+    std::unique_ptr<IRInstruction> phi = function->createInstruction(IROp::PHI);
+    phi->block = block;
+    phi->line = currentLine;
+
+    // Phis stay grouped at the top of their block
+    auto position = std::find_if(block->instructions.begin(), block->instructions.end(),
+                                 [](const std::unique_ptr<IRInstruction>& instruction) {
+                                     return instruction->op != IROp::PHI;
+                                 });
+    return block->instructions.insert(position, std::move(phi))->get();
+}
+
+void IRBuilder::jump(IRBlock* target) {
+    IRInstruction* instruction = emit(IROp::JUMP);
+    instruction->targets = {target};
+    target->predecessors.push_back(current);
+}
+
+void IRBuilder::branch(IRInstruction* condition, IRBlock* ifTrue, IRBlock* ifFalse) {
+    IRInstruction* instruction = emit(IROp::BRANCH, {condition});
+    instruction->targets = {ifTrue, ifFalse};
+    ifTrue->predecessors.push_back(current);
+    ifFalse->predecessors.push_back(current);
+}
+
+void IRBuilder::enterScope() {
+    scopes.push_back(std::unordered_map<std::string, Variable>());
+}
+
+void IRBuilder::exitScope() {
+    if (!scopes.empty()) {
+        scopes.pop_back();
+    }
+}
+
+const IRBuilder::Variable* IRBuilder::resolveVariable(const std::string& name) const {
+    // Search from innermost to outermost scope
+    for (int i = static_cast<int>(scopes.size()) - 1; i >= 0; i--) {
+        auto it = scopes[i].find(name);
+        if (it != scopes[i].end()) {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+void IRBuilder::declareVariable(const Token& name, IRInstruction* value) {
+    auto& scope = scopes.back();
+    auto it = scope.find(std::string(name.lexeme));
+    if (it == scope.end()) {
+        // Redeclaring in the same scope overwrites the variable, like Environment::define
+        bool global = function == module->main() && scopes.size() == 1 && globalNames.count(std::string(name.lexeme));
+        it = scope.emplace(name.lexeme, Variable{nextKey++, global}).first;
+    }
+
+    if (it->second.global) {
+        IRInstruction* store = emit(IROp::STORE_GLOBAL, {value});
+        store->name = name.lexeme;
+    } else {
+        writeVariable(it->second.key, current, value);
+    }
+}
+
+// Expression visitors
+Value IRBuilder::visitLiteralExpr(const LiteralExpr& expr) {
+    lastValue = emitConstant(expr.value);
+    return Value();
+}
+
+Value IRBuilder::visitVariableExpr(const VariableExpr& expr) {
+    markLine(expr.name.line());
+    const Variable* variable = resolveVariable(std::string(expr.name.lexeme));
+    if (variable && !variable->global) {
+        lastValue = readVariable(variable->key, current);
+    } else if (variable || function != module->main()) {
+        // Top-level variables are read from memory inside functions
+        lastValue = emit(IROp::LOAD_GLOBAL);
+        lastValue->name = expr.name.lexeme;
+    } else {
+        error(expr.name, "Undefined variable '" + std::string(expr.name.lexeme) + "'");
+        lastValue = getUndefined();
+    }
+    return Value();
+}
+
+Value IRBuilder::visitBinaryExpr(const BinaryExpr& expr) {
+    markLine(expr.op.line());
+    IRInstruction* left = emitExpr(expr.left);
+    IRInstruction* right = emitExpr(expr.right);
+    markLine(expr.op.line());
+
+    IROp op;
+    switch (expr.op.type) {
+        case TokenType::PLUS: op = IROp::ADD; break;
+        case TokenType::MINUS: op = IROp::SUB; break;
+        case TokenType::MULTIPLY: op = IROp::MUL; break;
+        case TokenType::DIVIDE: op = IROp::DIV; break;
+        case TokenType::MODULO: op = IROp::MOD; break;
+        case TokenType::EQUAL: op = IROp::EQ; break;
+        case TokenType::NOT_EQUAL: op = IROp::NEQ; break;
+        case TokenType::LESS: op = IROp::LT; break;
+        case TokenType::GREATER: op = IROp::GT; break;
+        case TokenType::LESS_EQUAL: op = IROp::LTE; break;
+        case TokenType::GREATER_EQUAL: op = IROp::GTE; break;
+        case TokenType::AND: op = IROp::AND; break;
+        case TokenType::OR: op = IROp::OR; break;
+        default:
+            error(expr.op, "Unknown binary operator '" + std::string(expr.op.lexeme) + "'");
+            lastValue = getUndefined();
+            return Value();
+    }
+    lastValue = emit(op, {left, right});
+    return Value();
+}
+
+Value IRBuilder::visitUnaryExpr(const UnaryExpr& expr) {
+    markLine(expr.op.line());
+    IRInstruction* operand = emitExpr(expr.right);
+    markLine(expr.op.line());
+
+    if (expr.op.type == TokenType::MINUS) {
+        lastValue = emit(IROp::NEG, {operand});
+    } else if (expr.op.type == TokenType::NOT) {
+        lastValue = emit(IROp::NOT, {operand});
+    } else {
+        error(expr.op, "Unknown unary operator '" + std::string(expr.op.lexeme) + "'");
+        lastValue = getUndefined();
+    }
+    return Value();
+}
+
+Value IRBuilder::visitCallExpr(const CallExpr& expr) {
+    markLine(expr.callee.line());
+    std::vector<IRInstruction*> arguments;
+    for (const auto& argument : expr.arguments) {
+        arguments.push_back(emitExpr(argument));
+    }
+    markLine(expr.callee.line());
+
+    if (expr.callee.lexeme == "print") {
+        lastValue = emit(IROp::PRINT, arguments);
+    } else {
+        lastValue = emit(IROp::CALL, arguments);
+        lastValue->name = expr.callee.lexeme;
+    }
+    return Value();
+}
+
+Value IRBuilder::visitAssignmentExpr(const AssignmentExpr& expr) {
+    markLine(expr.name.line());
+    IRInstruction* value = emitExpr(expr.value);
+    markLine(expr.name.line());
+
+    const Variable* variable = resolveVariable(std::string(expr.name.lexeme));
+    if (variable && !variable->global) {
+        writeVariable(variable->key, current, value);
+    } else if (variable || function != module->main()) {
+        IRInstruction* store = emit(IROp::STORE_GLOBAL, {value});
+        store->name = expr.name.lexeme;
+    } else {
+        error(expr.name, "Undefined variable '" + std::string(expr.name.lexeme) + "'");
+    }
+    lastValue = value;
+    return Value();
+}
+
+// Statement visitors
+void IRBuilder::visitPrintStmt(const PrintStmt& stmt) {
+    std::vector<IRInstruction*> arguments;
+    for (const auto& expr : stmt.expressions) {
+        arguments.push_back(emitExpr(expr));
+    }
+    emit(IROp::PRINT, arguments);
+}
+
+void IRBuilder::visitVariableDeclStmt(const VariableDeclStmt& stmt) {
+    markLine(stmt.name.line());
+    IRInstruction* value = stmt.initializer ? emitExpr(stmt.initializer) : getUndefined();
+    markLine(stmt.name.line());
+
+    // Declare after the initializer so it still sees any outer variable of the same name
+    declareVariable(stmt.name, value);
+}
+
+void IRBuilder::visitExpressionStmt(const ExpressionStmt& stmt) {
+    emitExpr(stmt.expression);
+}
+
+void IRBuilder::visitBlockStmt(const BlockStmt& stmt) {
+    enterScope();
+    for (const auto& statement : stmt.statements) {
+        statement->accept(*this);
+    }
+    exitScope();
+}
+
+void IRBuilder::visitIfStmt(const IfStmt& stmt) {
+    IRInstruction* condition = emitExpr(stmt.condition);
+
+    IRBlock* thenBlock = function->createBlock();
+    IRBlock* elseBlock = function->createBlock();
+    IRBlock* merge = function->createBlock();
+    branch(condition, thenBlock, elseBlock);
+    sealBlock(thenBlock);
+    sealBlock(elseBlock);
+
+    current = thenBlock;
+    stmt.thenBranch->accept(*this);
+    jump(merge);
+
+    current = elseBlock;
+    if (stmt.elseBranch) {
+        stmt.elseBranch->accept(*this);
+    }
+    jump(merge);
+
+    sealBlock(merge);
+    current = merge;
+}
+
+void IRBuilder::visitWhileStmt(const WhileStmt& stmt) {
+    // The header stays unsealed until the back edge from the body exists
+    IRBlock* header = function->createBlock();
+    jump(header);
+    current = header;
+    IRInstruction* condition = emitExpr(stmt.condition);
+
+    IRBlock* body = function->createBlock();
+    IRBlock* exit = function->createBlock();
+    branch(condition, body, exit);
+    sealBlock(body);
+
+    current = body;
+    stmt.body->accept(*this);
+    jump(header);
+
+    sealBlock(header);
+    sealBlock(exit);
+    current = exit;
+}
+
+void IRBuilder::visitFunctionDeclStmt(const FunctionDeclStmt& stmt) {
+    // Top-level functions are built by build(); closures need environments
+    error(stmt.name, "Nested function '" + std::string(stmt.name.lexeme) + "' is not supported by the IR");
+}
+
+void IRBuilder::visitReturnStmt(const ReturnStmt& stmt) {
+    markLine(stmt.keyword.line());
+    if (function == module->main()) {
+        error(stmt.keyword, "Cannot return from top-level code");
+        return;
+    }
+
+    IRInstruction* value = stmt.value ? emitExpr(stmt.value) : getUndefined();
+    markLine(stmt.keyword.line());
+    emit(IROp::RETURN, {value});
+
+    // Anything after the return lands in a block with no predecessors
+    current = function->createBlock();
+    sealBlock(current);
+}
+
+void IRBuilder::buildFunction(const FunctionDeclStmt& stmt) {
+    module->functions.push_back(std::make_unique<IRFunction>(std::string(stmt.name.lexeme), stmt.parameters.size()));
+    function = module->functions.back().get();
+    undefined = nullptr;
+    current = function->createBlock();
+    sealBlock(current);
+    markLine(stmt.name.line());
+
+    // Parameters shadow top-level variables of the same name
+    std::vector<std::unordered_map<std::string, Variable>> outer;
+    outer.swap(scopes);
+    enterScope();
+    for (size_t i = 0; i < stmt.parameters.size(); i++) {
+        IRInstruction* parameter = emit(IROp::PARAM);
+        parameter->index = i;
+        scopes.back()[std::string(stmt.parameters[i].first.lexeme)] = Variable{nextKey, false};
+        writeVariable(nextKey++, current, parameter);
+    }
+
+    auto block = std::dynamic_pointer_cast<BlockStmt>(stmt.body);
+    if (block) {
+        for (const auto& statement : block->statements) {
+            statement->accept(*this);
+        }
+    } else {
+        stmt.body->accept(*this);
+    }
+    emit(IROp::RETURN, {getUndefined()});
+
+    exitScope();
+    scopes.swap(outer);
+    function->removeUnreachableBlocks();
+    function->removeTrivialPhis();
+}
+
+std::unique_ptr<IRModule> IRBuilder::build(const ProgramPtr& program) {
+    module = std::make_unique<IRModule>();
+    module->functions.push_back(std::make_unique<IRFunction>("<main>", 0));
+
+    // Top-level variables a function might touch cannot be SSA values
+    std::vector<const FunctionDeclStmt*> declarations;
+    for (const auto& stmt : program->statements) {
+        if (stmt->getType() != StmtType::FUNCTION_DECL) continue;
+        auto decl = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+        declarations.push_back(decl.get());
+        NameCollector collector(globalNames);
+        decl->accept(collector);
+    }
+
+    function = module->main();
+    current = function->createBlock();
+    sealBlock(current);
+    enterScope();
+    for (const auto& stmt : program->statements) {
+        if (stmt->getType() != StmtType::FUNCTION_DECL) {
+            stmt->accept(*this);
+        }
+    }
+    emit(IROp::RETURN, {getUndefined()});
+    function->removeUnreachableBlocks();
+    function->removeTrivialPhis();
+
+    // Function bodies see top-level variables through memory
+    for (const FunctionDeclStmt* decl : declarations) {
+        buildFunction(*decl);
+    }
+    scopes.clear();
+    definitions.clear();
+    incompletePhis.clear();
+    sealed.clear();
+    removedPhis.clear();
+
+    return std::move(module);
+}
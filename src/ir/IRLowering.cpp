@@ -0,0 +1,216 @@
+#include "IRLowering.h"
+
+IRLowering::IRLowering() : ranges(nullptr), nextSlot(0), executable(true) {}
+
+uint32_t IRLowering::globalSlot(const std::string& name) {
+    auto it = globals.find(name);
+    if (it == globals.end()) {
+        it = globals.emplace(name, nextSlot++).first;
+    }
+    return it->second;
+}
+
+void IRLowering::assignSlots(const IRFunction& function) {
+    for (const auto& block : function.blocks) {
+        for (const auto& instruction : block->instructions) {
+            for (const IRInstruction* operand : instruction->operands) {
+                useCounts[operand]++;
+            }
+            if (instruction->hasResult() && instruction->op != IROp::CONST && instruction->op != IROp::NUL) {
+                slots[instruction.get()] = nextSlot++;
+            }
+        }
+    }
+}
+
+void IRLowering::load(const IRInstruction* value) {
+    if (value->op == IROp::CONST) {
+        size_t index = writer.addConstantGetIndex(value->constant);
+        writer.writeOpCode(OpCode::LOAD_CONST);
+        writer.writeOperand(static_cast<uint32_t>(index));
+    } else if (value->op == IROp::NUL) {
+        writer.writeOpCode(OpCode::LOAD_NULL);
+    } else {
+        writer.writeOpCode(OpCode::LOAD_VAR);
+        writer.writeOperand(slots[value]);
+    }
+}
+
+void IRLowering::storeResult(const IRInstruction& instruction) {
+    if (useCounts[&instruction] == 0) {
+        writer.writeOpCode(OpCode::POP);
+    } else {
+        writer.writeOpCode(OpCode::STORE_VAR);
+        writer.writeOperand(slots[&instruction]);
+    }
+}
+
+void IRLowering::emitJumpTo(OpCode opcode, const IRBlock* target) {
+    writer.writeOpCode(opcode);
+    fixups.push_back({writer.getCode().size(), target});
+    writer.writeOperand(0); // Patched once every block has an offset
+}
+
+bool IRLowering::emitEdgeCopies(const IRBlock* from, const IRBlock* to) {
+    size_t index = to->predecessorIndex(from);
+    std::vector<const IRInstruction*> phis;
+    for (const auto& instruction : to->instructions) {
+        if (instruction->op != IROp::PHI) break;
+        phis.push_back(instruction.get());
+    }
+
+    // Push every source first so phis that read each other see old values
+    for (const IRInstruction* phi : phis) {
+        load(phi->operands[index]);
+    }
+    for (size_t i = phis.size(); i-- > 0;) {
+        writer.writeOpCode(OpCode::STORE_VAR);
+        writer.writeOperand(slots[phis[i]]);
+    }
+    return !phis.empty();
+}
+
+void IRLowering::lowerInstruction(const IRInstruction& instruction, const IRBlock* next) {
+    writer.markLine(instruction.line);
+
+    switch (instruction.op) {
+        case IROp::CONST:
+        case IROp::NUL:
+        case IROp::PHI:
+            break; // Rematerialized at uses / written on incoming edges
+
+        case IROp::PARAM:
+        case IROp::CALL:
+            // The VM has no user functions yet
+            executable = false;
+            writer.writeOpCode(OpCode::LOAD_NULL);
+            storeResult(instruction);
+            break;
+
+        case IROp::LOAD_GLOBAL:
+            writer.writeOpCode(OpCode::LOAD_VAR);
+            writer.writeOperand(globalSlot(instruction.name));
+            storeResult(instruction);
+            break;
+
+        case IROp::STORE_GLOBAL:
+            load(instruction.operands[0]);
+            writer.writeOpCode(OpCode::STORE_VAR);
+            writer.writeOperand(globalSlot(instruction.name));
+            break;
+
+        case IROp::PRINT:
+            for (const IRInstruction* operand : instruction.operands) {
+                load(operand);
+            }
+            writer.writeOpCode(OpCode::PRINT);
+            writer.writeOperand(static_cast<uint32_t>(instruction.operands.size()));
+            storeResult(instruction);
+            break;
+
+        case IROp::JUMP:
+            emitEdgeCopies(instruction.block, instruction.targets[0]);
+            if (instruction.targets[0] != next) {
+                emitJumpTo(OpCode::JUMP, instruction.targets[0]);
+            }
+            break;
+
+        case IROp::BRANCH: {
+            const IRBlock* ifTrue = instruction.targets[0];
+            const IRBlock* ifFalse = instruction.targets[1];
+            bool falseCopies = ifFalse->instructions.front()->op == IROp::PHI;
+
+            load(instruction.operands[0]);
+            if (!falseCopies) {
+                emitJumpTo(OpCode::JUMP_IF_FALSE, ifFalse);
+                emitEdgeCopies(instruction.block, ifTrue);
+                if (ifTrue != next) {
+                    emitJumpTo(OpCode::JUMP, ifTrue);
+                }
+                break;
+            }
+
+            // The false edge needs its own copies: route it through a stub
+            writer.writeOpCode(OpCode::JUMP_IF_FALSE);
+            size_t stub = writer.getCode().size();
+            writer.writeOperand(0);
+            emitEdgeCopies(instruction.block, ifTrue);
+            emitJumpTo(OpCode::JUMP, ifTrue);
+            writer.patchOperand(stub, static_cast<uint32_t>(writer.getCode().size()));
+            emitEdgeCopies(instruction.block, ifFalse);
+            if (ifFalse != next) {
+                emitJumpTo(OpCode::JUMP, ifFalse);
+            }
+            break;
+        }
+
+        case IROp::RETURN:
+            // Only the top level is lowered, where return means the end
+            if (next) {
+                emitJumpTo(OpCode::JUMP, nullptr);
+            }
+            break;
+
+        default: {
+            for (const IRInstruction* operand : instruction.operands) {
+                load(operand);
+            }
+            OpCode opcode;
+            switch (instruction.op) {
+                case IROp::ADD: opcode = OpCode::ADD; break;
+                case IROp::SUB: opcode = OpCode::SUB; break;
+                case IROp::MUL: opcode = OpCode::MUL; break;
+                case IROp::DIV: opcode = OpCode::DIV; break;
+                case IROp::MOD: opcode = OpCode::MOD; break;
+                case IROp::NEG: opcode = OpCode::NEG; break;
+                case IROp::EQ: opcode = OpCode::EQ; break;
+                case IROp::NEQ: opcode = OpCode::NEQ; break;
+                case IROp::LT: opcode = OpCode::LT; break;
+                case IROp::GT: opcode = OpCode::GT; break;
+                case IROp::LTE: opcode = OpCode::LTE; break;
+                case IROp::GTE: opcode = OpCode::GTE; break;
+                case IROp::AND: opcode = OpCode::AND; break;
+                case IROp::OR: opcode = OpCode::OR; break;
+                default: opcode = OpCode::NOT; break;
+            }
+            if (ranges && ranges->isUnchecked(&instruction)) {
+                writer.markUnchecked(writer.getCode().size());
+            }
+            writer.writeOpCode(opcode);
+            storeResult(instruction);
+            break;
+        }
+    }
+}
+
+BytecodeWriter IRLowering::lower(const IRModule& module, const RangeAnalysis* ranges) {
+    this->ranges = ranges;
+    const IRFunction* function = module.main();
+    if (!function) {
+        writer.writeOpCode(OpCode::HALT);
+        return writer;
+    }
+    if (module.functions.size() > 1) {
+        executable = false;
+    }
+
+    assignSlots(*function);
+
+    // Reverse postorder puts loop headers before their bodies, so every
+    // back edge is a backward JUMP (which is what the tracing JIT watches)
+    std::vector<IRBlock*> order = function->reversePostorder();
+    for (size_t i = 0; i < order.size(); i++) {
+        blockOffsets[order[i]] = writer.getCode().size();
+        const IRBlock* next = i + 1 < order.size() ? order[i + 1] : nullptr;
+        for (const auto& instruction : order[i]->instructions) {
+            lowerInstruction(*instruction, next);
+        }
+    }
+
+    size_t halt = writer.getCode().size();
+    writer.writeOpCode(OpCode::HALT);
+    for (const auto& [offset, target] : fixups) {
+        writer.patchOperand(offset, static_cast<uint32_t>(target ? blockOffsets[target] : halt));
+    }
+    return writer;
+}
@@ -0,0 +1,94 @@
+#include "IRPrinter.h"
+#include "../core/Numbers.h"
+#include <sstream>
+
+namespace {
+    std::string constantText(const Value& value) {
+        if (std::holds_alternative<int>(value)) return Numbers::toString(std::get<int>(value));
+        if (std::holds_alternative<float>(value)) return Numbers::toString(std::get<float>(value));
+        if (std::holds_alternative<bool>(value)) return std::get<bool>(value) ? "true" : "false";
+        return "\"" + std::get<std::string>(value) + "\"";
+    }
+}
+
+std::string IRPrinter::valueName(const IRInstruction* value) {
+    return value ? "%" + std::to_string(value->id) : "%?";
+}
+
+std::string IRPrinter::print(const IRInstruction& instruction) {
+    std::ostringstream out;
+    if (instruction.hasResult()) {
+        out << valueName(&instruction) << " = ";
+    }
+    out << irOpName(instruction.op);
+
+    switch (instruction.op) {
+        case IROp::CONST:
+            out << " " << constantText(instruction.constant);
+            break;
+        case IROp::PARAM:
+            out << " " << instruction.index;
+            break;
+        case IROp::PHI:
+            for (size_t i = 0; i < instruction.operands.size(); i++) {
+                const IRBlock* from = i < instruction.block->predecessors.size()
+                                          ? instruction.block->predecessors[i] : nullptr;
+                out << (i > 0 ? ", [" : " [") << valueName(instruction.operands[i]) << ", "
+                    << (from ? "b" + std::to_string(from->id) : "?") << "]";
+            }
+            break;
+        case IROp::LOAD_GLOBAL:
+        case IROp::STORE_GLOBAL:
+        case IROp::CALL:
+            out << " " << instruction.name;
+            for (const IRInstruction* operand : instruction.operands) {
+                out << ", " << valueName(operand);
+            }
+            break;
+        default: {
+            const char* separator = " ";
+            for (const IRInstruction* operand : instruction.operands) {
+                out << separator << valueName(operand);
+                separator = ", ";
+            }
+            for (const IRBlock* target : instruction.targets) {
+                out << separator << "b" << target->id;
+                separator = ", ";
+            }
+            break;
+        }
+    }
+    return out.str();
+}
+
+std::string IRPrinter::print(const IRFunction& function) {
+    std::ostringstream out;
+    out << "function " << function.name << "(" << function.parameterCount << ") {\n";
+    for (const auto& block : function.blocks) {
+        out << "b" << block->id << ":";
+        if (!block->predecessors.empty()) {
+            out << "  ; preds";
+            for (size_t i = 0; i < block->predecessors.size(); i++) {
+                out << (i > 0 ? ", b" : " b") << block->predecessors[i]->id;
+            }
+        }
+        out << "\n";
+        for (const auto& instruction : block->instructions) {
+            out << "  " << print(*instruction);
+            if (instruction->line > 0) {
+                out << "  ; line " << instruction->line;
+            }
+            out << "\n";
+        }
+    }
+    out << "}\n";
+    return out.str();
+}
+
+std::string IRPrinter::print(const IRModule& module) {
+    std::string text;
+    for (const auto& function : module.functions) {
+        text += (text.empty() ? "" : "\n") + print(*function);
+    }
+    return text;
+}
@@ -0,0 +1,175 @@
+#include "IRVerifier.h"
+#include "IRPrinter.h"
+#include "Dominators.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+    // Operand count each opcode requires; -1 when variable
+    int expectedOperands(IROp op) {
+        switch (op) {
+            case IROp::CONST:
+            case IROp::NUL:
+            case IROp::PARAM:
+            case IROp::LOAD_GLOBAL:
+            case IROp::JUMP:
+                return 0;
+            case IROp::NEG:
+            case IROp::NOT:
+            case IROp::STORE_GLOBAL:
+            case IROp::BRANCH:
+            case IROp::RETURN:
+                return 1;
+            case IROp::PHI:
+            case IROp::CALL:
+            case IROp::PRINT:
+                return -1;
+            default:
+                return 2;
+        }
+    }
+
+    size_t expectedTargets(IROp op) {
+        if (op == IROp::JUMP) return 1;
+        if (op == IROp::BRANCH) return 2;
+        return 0;
+    }
+}
+
+void IRVerifier::error(const IRFunction& function, const IRInstruction* instruction, const std::string& message) {
+    std::string where = function.name;
+    int line = -1;
+    if (instruction) {
+        where += ": " + IRPrinter::print(*instruction);
+        line = instruction->line > 0 ? instruction->line : -1;
+    }
+    errors.push_back(Error(ErrorType::SEMANTIC, message + " (" + where + ")", line, -1, "IRVerifier"));
+}
+
+bool IRVerifier::verify(const IRModule& module) {
+    errors.clear();
+    for (const auto& function : module.functions) {
+        verifyFunction(*function);
+    }
+    return errors.empty();
+}
+
+bool IRVerifier::verify(const IRFunction& function) {
+    errors.clear();
+    verifyFunction(function);
+    return errors.empty();
+}
+
+void IRVerifier::verifyFunction(const IRFunction& function) {
+    if (!function.entry()) {
+        error(function, nullptr, "Function has no blocks");
+        return;
+    }
+    if (!function.entry()->predecessors.empty()) {
+        error(function, nullptr, "Entry block has predecessors");
+    }
+
+    // Where each value is defined
+    std::unordered_map<const IRBlock*, bool> blocks;
+    std::unordered_map<const IRInstruction*, std::pair<const IRBlock*, size_t>> definitions;
+    for (const auto& block : function.blocks) {
+        blocks[block.get()] = true;
+        for (size_t i = 0; i < block->instructions.size(); i++) {
+            definitions[block->instructions[i].get()] = {block.get(), i};
+        }
+    }
+
+    for (const auto& block : function.blocks) {
+        if (!block->terminator()) {
+            error(function, nullptr, "Block b" + std::to_string(block->id) + " does not end in a terminator");
+        }
+
+        // Edges must be recorded on both ends, once per branch target
+        for (IRBlock* successor : block->successors()) {
+            if (!blocks.count(successor)) {
+                error(function, block->terminator(), "Branch to a block outside the function");
+                continue;
+            }
+            std::vector<IRBlock*> targets = block->successors();
+            auto expected = std::count(targets.begin(), targets.end(), successor);
+            auto recorded = std::count(successor->predecessors.begin(), successor->predecessors.end(), block.get());
+            if (expected != recorded) {
+                error(function, block->terminator(),
+                      "b" + std::to_string(successor->id) + " does not list b" + std::to_string(block->id) +
+                      " as a predecessor");
+            }
+        }
+        for (IRBlock* predecessor : block->predecessors) {
+            std::vector<IRBlock*> targets = predecessor->successors();
+            if (!blocks.count(predecessor) || std::find(targets.begin(), targets.end(), block.get()) == targets.end()) {
+                error(function, nullptr, "b" + std::to_string(block->id) + " lists a predecessor that does not branch to it");
+            }
+        }
+
+        bool pastPhis = false;
+        for (size_t i = 0; i < block->instructions.size(); i++) {
+            const IRInstruction* instruction = block->instructions[i].get();
+            if (instruction->block != block.get()) {
+                error(function, instruction, "Instruction does not point back to its block");
+            }
+            if (instruction->isTerminator() && i + 1 != block->instructions.size()) {
+                error(function, instruction, "Terminator in the middle of a block");
+            }
+            if (instruction->op == IROp::PHI) {
+                if (pastPhis) {
+                    error(function, instruction, "Phi after a non-phi instruction");
+                }
+                if (instruction->operands.size() != block->predecessors.size()) {
+                    error(function, instruction, "Phi operand count does not match the predecessors");
+                }
+            } else {
+                pastPhis = true;
+            }
+
+            int operands = expectedOperands(instruction->op);
+            if (operands >= 0 && instruction->operands.size() != static_cast<size_t>(operands)) {
+                error(function, instruction, "Wrong number of operands");
+            }
+            if (instruction->targets.size() != expectedTargets(instruction->op)) {
+                error(function, instruction, "Wrong number of branch targets");
+            }
+            for (const IRInstruction* operand : instruction->operands) {
+                if (!operand || !definitions.count(operand)) {
+                    error(function, instruction, "Operand is not defined in this function");
+                } else if (!operand->hasResult()) {
+                    error(function, instruction, "Operand does not produce a value");
+                }
+            }
+        }
+    }
+    if (!errors.empty()) {
+        return; // Dominance is meaningless on a broken CFG
+    }
+
+    // Every use must be dominated by its definition
+    DominatorTree dominators(function);
+    for (const auto& block : function.blocks) {
+        if (!dominators.isReachable(block.get())) continue;
+        for (size_t i = 0; i < block->instructions.size(); i++) {
+            const IRInstruction* instruction = block->instructions[i].get();
+            for (size_t k = 0; k < instruction->operands.size(); k++) {
+                auto [defBlock, defIndex] = definitions[instruction->operands[k]];
+                bool dominated;
+                if (instruction->op == IROp::PHI) {
+                    // A phi operand is used at the end of its predecessor
+                    const IRBlock* predecessor = block->predecessors[k];
+                    dominated = !dominators.isReachable(predecessor) ||
+                                dominators.dominates(defBlock, predecessor);
+                } else if (defBlock == block.get()) {
+                    dominated = defIndex < i;
+                } else {
+                    dominated = dominators.dominates(defBlock, block.get());
+                }
+                if (!dominated) {
+                    error(function, instruction,
+                          "Use of " + IRPrinter::valueName(instruction->operands[k]) + " is not dominated by its definition");
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,343 @@
+#include "RangeAnalysis.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+
+namespace {
+    using Range = RangeAnalysis::Range;
+
+    constexpr int64_t INT_LOW = std::numeric_limits<int>::min();
+    constexpr int64_t INT_HIGH = std::numeric_limits<int>::max();
+
+    // Rounds a phi may grow before its bounds jump to the int limits
+    constexpr unsigned WIDEN_AFTER = 2;
+    constexpr int NARROWING_ROUNDS = 2;
+
+    Range intRange(int64_t low, int64_t high) {
+        Range range;
+        range.kind = Range::Kind::INT;
+        range.low = low;
+        range.high = high;
+        return range;
+    }
+
+    Range anyRange() {
+        Range range;
+        range.kind = Range::Kind::ANY;
+        return range;
+    }
+
+    bool fits(int64_t low, int64_t high) {
+        return low >= INT_LOW && high <= INT_HIGH;
+    }
+
+    // Result of int arithmetic whose exact bounds may not fit: the VM wraps
+    Range wrapped(int64_t low, int64_t high) {
+        return fits(low, high) ? intRange(low, high) : intRange(INT_LOW, INT_HIGH);
+    }
+
+    Range join(const Range& a, const Range& b) {
+        if (a.kind == Range::Kind::NONE) return b;
+        if (b.kind == Range::Kind::NONE) return a;
+        if (!a.isInt() || !b.isInt()) return anyRange();
+        return intRange(std::min(a.low, b.low), std::max(a.high, b.high));
+    }
+
+    bool sameRange(const Range& a, const Range& b) {
+        return a.kind == b.kind && (!a.isInt() || (a.low == b.low && a.high == b.high));
+    }
+
+    // Comparison `value op other` with the operands swapped
+    IROp swapped(IROp op) {
+        switch (op) {
+            case IROp::LT: return IROp::GT;
+            case IROp::GT: return IROp::LT;
+            case IROp::LTE: return IROp::GTE;
+            case IROp::GTE: return IROp::LTE;
+            default: return op;
+        }
+    }
+
+    // Comparison that holds when `op` does not
+    IROp negated(IROp op) {
+        switch (op) {
+            case IROp::LT: return IROp::GTE;
+            case IROp::GT: return IROp::LTE;
+            case IROp::LTE: return IROp::GT;
+            case IROp::GTE: return IROp::LT;
+            case IROp::EQ: return IROp::NEQ;
+            default: return IROp::EQ;
+        }
+    }
+
+    bool isComparison(IROp op) {
+        return op == IROp::EQ || op == IROp::NEQ || op == IROp::LT ||
+               op == IROp::GT || op == IROp::LTE || op == IROp::GTE;
+    }
+
+    // Narrows `range` to the values for which `range op other` holds
+    Range narrow(Range range, IROp op, const Range& other) {
+        switch (op) {
+            case IROp::LT: range.high = std::min(range.high, other.high - 1); break;
+            case IROp::LTE: range.high = std::min(range.high, other.high); break;
+            case IROp::GT: range.low = std::max(range.low, other.low + 1); break;
+            case IROp::GTE: range.low = std::max(range.low, other.low); break;
+            case IROp::EQ:
+                range.low = std::max(range.low, other.low);
+                range.high = std::min(range.high, other.high);
+                break;
+            case IROp::NEQ:
+                if (other.low == other.high) {
+                    if (range.low == other.low) range.low++;
+                    if (range.high == other.high) range.high--;
+                }
+                break;
+            default:
+                break;
+        }
+        // No value passes: the block is unreachable
+        if (range.low > range.high) return Range();
+        return range;
+    }
+}
+
+Range RangeAnalysis::rangeOf(const IRInstruction* value) const {
+    auto it = ranges.find(value);
+    return it == ranges.end() ? Range() : it->second;
+}
+
+// Range of a value where `block` runs: every branch that had to be taken
+// to get there narrows it
+Range RangeAnalysis::rangeAt(const IRInstruction* value, const IRBlock* block,
+                             const DominatorTree& dominators) const {
+    Range range = rangeOf(value);
+    for (const IRBlock* current = block; current && range.isInt();
+         current = dominators.immediateDominator(current)) {
+        if (current->predecessors.size() != 1) continue;
+        const IRInstruction* branch = current->predecessors[0]->terminator();
+        if (!branch || branch->op != IROp::BRANCH || branch->targets[0] == branch->targets[1]) continue;
+
+        const IRInstruction* condition = branch->operands[0];
+        if (!isComparison(condition->op)) continue;
+        IROp op = condition->op;
+        const IRInstruction* other;
+        if (condition->operands[0] == value) {
+            other = condition->operands[1];
+        } else if (condition->operands[1] == value) {
+            other = condition->operands[0];
+            op = swapped(op);
+        } else {
+            continue;
+        }
+
+        Range bound = rangeOf(other);
+        if (!bound.isInt()) continue;
+        if (branch->targets[1] == current) op = negated(op);
+        range = narrow(range, op, bound);
+    }
+    return range;
+}
+
+Range RangeAnalysis::evaluate(const IRInstruction& instruction, const DominatorTree& dominators) const {
+    const IRBlock* block = instruction.block;
+    switch (instruction.op) {
+        case IROp::CONST:
+            if (std::holds_alternative<int>(instruction.constant)) {
+                int value = std::get<int>(instruction.constant);
+                return intRange(value, value);
+            }
+            return anyRange();
+
+        case IROp::PHI: {
+            // Edges not reached yet do not count
+            Range range;
+            for (size_t i = 0; i < instruction.operands.size(); i++) {
+                range = join(range, rangeAt(instruction.operands[i], block->predecessors[i], dominators));
+            }
+            return range;
+        }
+
+        case IROp::ADD:
+        case IROp::SUB:
+        case IROp::MUL:
+        case IROp::MOD: {
+            Range left = rangeAt(instruction.operands[0], block, dominators);
+            Range right = rangeAt(instruction.operands[1], block, dominators);
+            if (left.kind == Range::Kind::NONE || right.kind == Range::Kind::NONE) return Range();
+            if (!left.isInt() || !right.isInt()) return anyRange();
+
+            if (instruction.op == IROp::ADD) return wrapped(left.low + right.low, left.high + right.high);
+            if (instruction.op == IROp::SUB) return wrapped(left.low - right.high, left.high - right.low);
+            if (instruction.op == IROp::MUL) {
+                // Products of int32 bounds fit in int64
+                int64_t corners[] = {left.low * right.low, left.low * right.high,
+                                     left.high * right.low, left.high * right.high};
+                return wrapped(*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4));
+            }
+
+            // The remainder is smaller than the divisor and takes the dividend's sign
+            if (right.contains(0)) return anyRange();
+            int64_t magnitude = std::max(std::abs(right.low), std::abs(right.high)) - 1;
+            return intRange(left.low >= 0 ? 0 : std::max(left.low, -magnitude),
+                            left.high <= 0 ? 0 : std::min(left.high, magnitude));
+        }
+
+        case IROp::NEG: {
+            Range operand = rangeAt(instruction.operands[0], block, dominators);
+            if (!operand.isInt()) return operand.kind == Range::Kind::NONE ? Range() : anyRange();
+            return wrapped(-operand.high, -operand.low);
+        }
+
+        default:
+            // Loads, parameters, calls, DIV (always a float) and booleans
+            return anyRange();
+    }
+}
+
+void RangeAnalysis::recordFacts(const IRInstruction& instruction, const DominatorTree& dominators) {
+    const IRBlock* block = instruction.block;
+    switch (instruction.op) {
+        case IROp::DIV:
+        case IROp::MOD: {
+            stats.divisions++;
+            Range divisor = rangeAt(instruction.operands[1], block, dominators);
+            if (divisor.isInt() && !divisor.contains(0)) {
+                nonZeroDivisors.insert(&instruction);
+                stats.nonZeroDivisors++;
+            }
+            if (instruction.op == IROp::DIV) break;
+
+            Range dividend = rangeAt(instruction.operands[0], block, dominators);
+            if (!dividend.isInt() || !divisor.isInt()) break;
+            stats.intOperations++;
+            // INT_MIN % -1 is the one remainder the hardware cannot produce
+            if (!dividend.contains(INT_LOW) || !divisor.contains(-1)) {
+                noOverflow.insert(&instruction);
+                stats.noOverflow++;
+            }
+            break;
+        }
+
+        case IROp::ADD:
+        case IROp::SUB:
+        case IROp::MUL:
+        case IROp::NEG: {
+            bool allInts = true;
+            for (const IRInstruction* operand : instruction.operands) {
+                allInts = allInts && rangeAt(operand, block, dominators).isInt();
+            }
+            if (!allInts) break;
+            stats.intOperations++;
+
+            // The evaluated range only keeps exact bounds when they fit
+            Range result = rangeOf(&instruction);
+            bool exact;
+            if (instruction.op == IROp::NEG) {
+                exact = !rangeAt(instruction.operands[0], block, dominators).contains(INT_LOW);
+            } else {
+                Range left = rangeAt(instruction.operands[0], block, dominators);
+                Range right = rangeAt(instruction.operands[1], block, dominators);
+                if (instruction.op == IROp::ADD) {
+                    exact = fits(left.low + right.low, left.high + right.high);
+                } else if (instruction.op == IROp::SUB) {
+                    exact = fits(left.low - right.high, left.high - right.low);
+                } else {
+                    int64_t corners[] = {left.low * right.low, left.low * right.high,
+                                         left.high * right.low, left.high * right.high};
+                    exact = fits(*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4));
+                }
+            }
+            if (exact && result.isInt()) {
+                noOverflow.insert(&instruction);
+                stats.noOverflow++;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void RangeAnalysis::analyzeFunction(const IRFunction& function) {
+    DominatorTree dominators(function);
+    const std::vector<IRBlock*>& order = dominators.getOrder();
+
+    // Ascending: ranges only grow, phis that keep growing are widened
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (IRBlock* block : order) {
+            for (const auto& instruction : block->instructions) {
+                Range old = rangeOf(instruction.get());
+                Range range = join(old, evaluate(*instruction, dominators));
+                if (sameRange(range, old)) continue;
+
+                if (instruction->op == IROp::PHI && old.isInt() && range.isInt() &&
+                    growth[instruction.get()]++ >= WIDEN_AFTER) {
+                    if (range.low < old.low) range.low = INT_LOW;
+                    if (range.high > old.high) range.high = INT_HIGH;
+                }
+                ranges[instruction.get()] = range;
+                changed = true;
+            }
+        }
+    }
+
+    // Descending: re-evaluating from a sound state stays sound and
+    // recovers bounds that widening gave up
+    for (int round = 0; round < NARROWING_ROUNDS; round++) {
+        for (IRBlock* block : order) {
+            for (const auto& instruction : block->instructions) {
+                Range old = rangeOf(instruction.get());
+                Range range = evaluate(*instruction, dominators);
+                if (old.isInt() && range.isInt()) {
+                    ranges[instruction.get()] = intRange(std::max(old.low, range.low), std::min(old.high, range.high));
+                }
+            }
+        }
+    }
+
+    for (IRBlock* block : order) {
+        for (const auto& instruction : block->instructions) {
+            recordFacts(*instruction, dominators);
+        }
+    }
+}
+
+void RangeAnalysis::analyze(const IRModule& module) {
+    ranges.clear();
+    growth.clear();
+    nonZeroDivisors.clear();
+    noOverflow.clear();
+    stats = Stats();
+
+    for (const auto& function : module.functions) {
+        analyzeFunction(*function);
+    }
+}
+
+bool RangeAnalysis::isUnchecked(const IRInstruction* instruction) const {
+    switch (instruction->op) {
+        case IROp::DIV:
+            return isDivisorNonZero(instruction);
+        case IROp::MOD:
+            return isDivisorNonZero(instruction) && cannotOverflow(instruction);
+        case IROp::ADD:
+        case IROp::SUB:
+        case IROp::MUL:
+        case IROp::NEG:
+            return cannotOverflow(instruction);
+        default:
+            return false;
+    }
+}
+
+std::string RangeAnalysis::report() const {
+    std::ostringstream out;
+    out << "Range analysis: " << stats.nonZeroDivisors << " of " << stats.divisions
+        << " divisors proven non-zero, " << stats.noOverflow << " of " << stats.intOperations
+        << " int operations proven not to overflow";
+    return out.str();
+}
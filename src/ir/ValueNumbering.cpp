@@ -0,0 +1,354 @@
+#include "ValueNumbering.h"
+#include "Dominators.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+namespace {
+    bool isCommutative(IROp op) {
+        return op == IROp::MUL || op == IROp::EQ || op == IROp::NEQ || op == IROp::AND || op == IROp::OR;
+    }
+
+    bool isNonZeroConstant(const IRInstruction* value, bool intOnly) {
+        if (value->op != IROp::CONST) return false;
+        if (std::holds_alternative<int>(value->constant)) return std::get<int>(value->constant) != 0;
+        return !intOnly && std::holds_alternative<float>(value->constant) && std::get<float>(value->constant) != 0.0f;
+    }
+}
+
+ValueNumbering::Kind ValueNumbering::evaluate(const IRInstruction& instruction,
+                                              const std::unordered_map<const IRInstruction*, Kind>& kinds,
+                                              bool intParameters) const {
+    auto kindOf = [&kinds](const IRInstruction* value) {
+        auto it = kinds.find(value);
+        return it == kinds.end() ? Kind::NONE : it->second;
+    };
+    auto numeric = [](Kind kind) { return kind == Kind::INT || kind == Kind::NUMBER; };
+
+    switch (instruction.op) {
+        case IROp::CONST:
+            if (std::holds_alternative<int>(instruction.constant)) return Kind::INT;
+            if (std::holds_alternative<float>(instruction.constant)) return Kind::NUMBER;
+            return Kind::OTHER;
+        case IROp::PARAM:
+            return intParameters ? Kind::INT : Kind::OTHER;
+        case IROp::PHI: {
+            // Operands not known yet (back edges) do not count
+            Kind result = Kind::NONE;
+            for (const IRInstruction* operand : instruction.operands) {
+                Kind kind = kindOf(operand);
+                if (kind == Kind::NONE || kind == result) continue;
+                result = result == Kind::NONE ? kind
+                         : numeric(result) && numeric(kind) ? Kind::NUMBER : Kind::OTHER;
+            }
+            return result;
+        }
+        case IROp::ADD:
+        case IROp::SUB:
+        case IROp::MUL:
+        case IROp::NEG: {
+            bool ints = true;
+            for (const IRInstruction* operand : instruction.operands) {
+                Kind kind = kindOf(operand);
+                if (!numeric(kind)) return Kind::OTHER;
+                ints = ints && kind == Kind::INT;
+            }
+            return ints ? Kind::INT : Kind::NUMBER;
+        }
+        case IROp::DIV:
+            return cannotTrap(instruction, kinds) ? Kind::NUMBER : Kind::OTHER;
+        case IROp::MOD:
+            return cannotTrap(instruction, kinds) ? Kind::INT : Kind::OTHER;
+        default:
+            return Kind::OTHER;
+    }
+}
+
+std::unordered_map<const IRInstruction*, ValueNumbering::Kind>
+ValueNumbering::inferKinds(const IRFunction& function, bool intParameters) const {
+    // Kinds only move from NONE towards OTHER, so this settles
+    std::unordered_map<const IRInstruction*, Kind> kinds;
+    std::vector<IRBlock*> order = function.reversePostorder();
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (IRBlock* block : order) {
+            for (const auto& instruction : block->instructions) {
+                Kind kind = evaluate(*instruction, kinds, intParameters);
+                Kind& current = kinds[instruction.get()];
+                if (current != kind) {
+                    current = kind;
+                    changed = true;
+                }
+            }
+        }
+    }
+    return kinds;
+}
+
+bool ValueNumbering::cannotTrap(const IRInstruction& instruction,
+                                const std::unordered_map<const IRInstruction*, Kind>& kinds) const {
+    auto kindOf = [&kinds](const IRInstruction* value) {
+        auto it = kinds.find(value);
+        return it == kinds.end() ? Kind::NONE : it->second;
+    };
+    auto numeric = [&kindOf](const IRInstruction* value) {
+        Kind kind = kindOf(value);
+        return kind == Kind::INT || kind == Kind::NUMBER;
+    };
+
+    switch (instruction.op) {
+        case IROp::ADD:
+        case IROp::SUB:
+        case IROp::MUL:
+        case IROp::LT:
+        case IROp::GT:
+        case IROp::LTE:
+        case IROp::GTE:
+            return !instruction.canTrap() || (numeric(instruction.operands[0]) && numeric(instruction.operands[1]));
+        case IROp::NEG:
+            return numeric(instruction.operands[0]);
+        case IROp::DIV:
+            return numeric(instruction.operands[0]) && isNonZeroConstant(instruction.operands[1], false);
+        case IROp::MOD:
+            return kindOf(instruction.operands[0]) == Kind::INT && isNonZeroConstant(instruction.operands[1], true);
+        case IROp::CALL: {
+            auto it = pureFunctions.find(instruction.name);
+            if (it == pureFunctions.end() || it->second->parameterCount != instruction.operands.size()) {
+                return false;
+            }
+            for (const IRInstruction* argument : instruction.operands) {
+                if (kindOf(argument) != Kind::INT) return false;
+            }
+            return true;
+        }
+        default:
+            return !instruction.canTrap();
+    }
+}
+
+void ValueNumbering::findPureFunctions(const IRModule& module) {
+    // Start from every function without output or global state, then drop
+    // those that can fail or call one that is dropped until nothing changes
+    pureFunctions.clear();
+    for (size_t i = 1; i < module.functions.size(); i++) {
+        const IRFunction& function = *module.functions[i];
+        bool candidate = true;
+        for (const auto& block : function.blocks) {
+            for (const auto& instruction : block->instructions) {
+                IROp op = instruction->op;
+                if (op == IROp::PRINT || op == IROp::LOAD_GLOBAL || op == IROp::STORE_GLOBAL) {
+                    candidate = false;
+                }
+            }
+        }
+        if (candidate) {
+            pureFunctions[function.name] = &function;
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = pureFunctions.begin(); it != pureFunctions.end();) {
+            auto kinds = inferKinds(*it->second, true);
+            bool pure = true;
+            for (const auto& block : it->second->blocks) {
+                for (const auto& instruction : block->instructions) {
+                    pure = pure && cannotTrap(*instruction, kinds);
+                }
+            }
+            if (pure) {
+                ++it;
+            } else {
+                it = pureFunctions.erase(it);
+                changed = true;
+            }
+        }
+    }
+}
+
+std::string ValueNumbering::key(const IRInstruction& instruction) const {
+    IROp op = instruction.op;
+    std::vector<const IRInstruction*> operands(instruction.operands.begin(), instruction.operands.end());
+    if (op == IROp::GT || op == IROp::GTE) {
+        op = op == IROp::GT ? IROp::LT : IROp::LTE;
+        std::swap(operands[0], operands[1]);
+    } else if (isCommutative(op) && operands[1]->id < operands[0]->id) {
+        std::swap(operands[0], operands[1]);
+    }
+
+    std::ostringstream out;
+    out << irOpName(op);
+    if (op == IROp::PHI) {
+        // Phis only match within their own block
+        out << " b" << instruction.block->id;
+    } else if (op == IROp::CALL) {
+        out << " " << instruction.name;
+    } else if (op == IROp::CONST) {
+        const Value& value = instruction.constant;
+        out << " " << value.index() << ":";
+        if (std::holds_alternative<int>(value)) {
+            out << std::get<int>(value);
+        } else if (std::holds_alternative<float>(value)) {
+            // Bit pattern, so 0.0 and -0.0 stay apart
+            float number = std::get<float>(value);
+            uint32_t bits;
+            std::memcpy(&bits, &number, sizeof(bits));
+            out << bits;
+        } else if (std::holds_alternative<bool>(value)) {
+            out << std::get<bool>(value);
+        } else {
+            out << std::get<std::string>(value);
+        }
+    }
+    for (const IRInstruction* operand : operands) {
+        out << " %" << operand->id;
+    }
+    return out.str();
+}
+
+void ValueNumbering::runFunction(IRFunction& function) {
+    DominatorTree dominators(function);
+    const std::vector<IRBlock*>& order = dominators.getOrder();
+    if (order.empty()) {
+        return;
+    }
+    std::unordered_map<const IRBlock*, std::vector<IRBlock*>> children;
+    for (size_t i = 1; i < order.size(); i++) {
+        children[dominators.immediateDominator(order[i])].push_back(order[i]);
+    }
+
+    auto kinds = inferKinds(function, false);
+    std::unordered_map<std::string, IRInstruction*> table;
+    std::vector<std::string> scoped;   // Keys added, undone when leaving a subtree
+    std::unordered_map<IRInstruction*, IRInstruction*> replacements;
+    auto resolve = [&replacements](IRInstruction*& operand) {
+        auto it = replacements.find(operand);
+        if (it != replacements.end()) operand = it->second;
+    };
+
+    struct Frame {
+        IRBlock* block;
+        size_t child;
+        size_t scopeMark;
+    };
+    std::vector<Frame> stack;
+    stack.push_back({order[0], 0, 0});
+    bool entering = true;
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (entering) {
+            frame.scopeMark = scoped.size();
+            std::unordered_map<std::string, IRInstruction*> loads;   // Global name -> load
+            for (auto& instruction : frame.block->instructions) {
+                for (auto& operand : instruction->operands) {
+                    resolve(operand);
+                }
+
+                IROp op = instruction->op;
+                if (op == IROp::STORE_GLOBAL) {
+                    loads.erase(instruction->name);
+                    continue;
+                }
+                if (op == IROp::LOAD_GLOBAL) {
+                    auto it = loads.find(instruction->name);
+                    if (it != loads.end()) {
+                        replacements[instruction.get()] = it->second;
+                        stats.byOp[op]++;
+                        stats.eliminated++;
+                    } else {
+                        loads[instruction->name] = instruction.get();
+                    }
+                    continue;
+                }
+
+                bool callable = op == IROp::CALL && cannotTrap(*instruction, kinds);
+                if (op == IROp::CALL && !callable) {
+                    loads.clear();
+                }
+                if ((instruction->hasSideEffects() && !callable) || !instruction->hasResult() ||
+                    op == IROp::PARAM || !cannotTrap(*instruction, kinds)) {
+                    continue;
+                }
+
+                std::string k = key(*instruction);
+                auto it = table.find(k);
+                if (it != table.end()) {
+                    replacements[instruction.get()] = it->second;
+                    if (op == IROp::CONST || op == IROp::NUL) {
+                        stats.constants++;
+                    } else {
+                        stats.byOp[op]++;
+                        stats.eliminated++;
+                    }
+                } else {
+                    table[k] = instruction.get();
+                    scoped.push_back(k);
+                }
+            }
+        }
+
+        auto& next = children[frame.block];
+        if (frame.child < next.size()) {
+            IRBlock* child = next[frame.child++];
+            stack.push_back({child, 0, 0});
+            entering = true;
+            continue;
+        }
+        while (scoped.size() > frame.scopeMark) {
+            table.erase(scoped.back());
+            scoped.pop_back();
+        }
+        stack.pop_back();
+        entering = false;
+    }
+
+    if (replacements.empty()) {
+        return;
+    }
+    // Phis read values from back edges that were numbered after them
+    for (auto& block : function.blocks) {
+        for (auto& instruction : block->instructions) {
+            for (auto& operand : instruction->operands) {
+                resolve(operand);
+            }
+        }
+        auto& instructions = block->instructions;
+        instructions.erase(std::remove_if(instructions.begin(), instructions.end(),
+                                          [&replacements](const std::unique_ptr<IRInstruction>& instruction) {
+                                              return replacements.count(instruction.get()) > 0;
+                                          }),
+                           instructions.end());
+    }
+    function.removeTrivialPhis();
+}
+
+size_t ValueNumbering::run(IRModule& module) {
+    stats = Stats();
+    findPureFunctions(module);
+    for (auto& function : module.functions) {
+        runFunction(*function);
+        stats.functions++;
+    }
+    return stats.eliminated;
+}
+
+std::string ValueNumbering::report() const {
+    std::ostringstream out;
+    out << "Value numbering: " << stats.eliminated << " redundant values removed in " << stats.functions
+        << " functions";
+    if (!stats.byOp.empty()) {
+        out << " (";
+        bool first = true;
+        for (const auto& [op, count] : stats.byOp) {
+            out << (first ? "" : ", ") << irOpName(op) << " " << count;
+            first = false;
+        }
+        out << ")";
+    }
+    out << ", " << stats.constants << " duplicate constants merged";
+    return out.str();
+}
@@ -0,0 +1,77 @@
+#include "IncrementalLexer.h"
+#include "Lexer.h"
+#include <stdexcept>
+
+IncrementalLexer::IncrementalLexer(std::string text)
+    : source(SourceBuffer::fromString(std::move(text))) {
+    Lexer lexer(source);
+    tokens = lexer.tokenize();
+}
+
+IncrementalLexer::Delta IncrementalLexer::edit(size_t offset, size_t length, const std::string& text) {
+    std::string_view old = source->view();
+    if (offset > old.size() || length > old.size() - offset) {
+        throw std::out_of_range("Edit is outside the document");
+    }
+    size_t editEnd = offset + length;
+
+    std::string updated;
+    updated.reserve(old.size() - length + text.size());
+    updated.append(old.substr(0, offset));
+    updated.append(text);
+    updated.append(old.substr(editEnd));
+    SourceText next = SourceBuffer::fromString(std::move(updated));
+
+    std::ptrdiff_t offsetShift = static_cast<std::ptrdiff_t>(text.size()) - static_cast<std::ptrdiff_t>(length);
+
+    // The first token that reaches the edit, then one more back: a token
+    // that ends where the edit starts can run on into the new text ("=" + "=")
+    size_t low = 0, high = tokens.size() - 1;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (tokens.offset(middle) + tokens.length(middle) < offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    size_t first = low > 0 ? low - 1 : 0;
+    size_t restart = first > 0 ? tokens.offset(first) : 0;
+
+    // Old tokens from `reuse` on are candidates to line up with. From an
+    // old token's start past the edit the text is unchanged, so the rest
+    // lexes the same.
+    Lexer lexer(next, restart, next->size());
+    TokenBuffer fresh(next);
+    size_t reuse = first;
+    bool synchronized = false;
+    while (true) {
+        TokenType type = lexer.scanInto(fresh);
+        if (type == TokenType::END_OF_FILE) {
+            break;
+        }
+
+        size_t at = fresh.offset(fresh.size() - 1);
+        if (at < offset + text.size()) {
+            continue;
+        }
+        size_t oldAt = at - text.size() + length;
+        while (reuse < tokens.size() && tokens.offset(reuse) < oldAt) {
+            reuse++;
+        }
+        if (reuse < tokens.size() && tokens.offset(reuse) == oldAt && tokens.type(reuse) == type &&
+            tokens.length(reuse) == fresh.length(fresh.size() - 1)) {
+            synchronized = true;
+            break;
+        }
+    }
+
+    // Without a match everything from `first` on, END_OF_FILE included, is new
+    Delta delta;
+    delta.first = first;
+    delta.removed = (synchronized ? reuse : tokens.size()) - first;
+    delta.inserted = synchronized ? fresh.size() - 1 : fresh.size();
+    tokens.splice(next, first, delta.removed, fresh, delta.inserted, offsetShift);
+    source = std::move(next);
+    return delta;
+}
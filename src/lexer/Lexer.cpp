@@ -1,77 +1,54 @@
 #include "Lexer.h"
-#include <cctype>
+#include "CharClass.h"
+#include "Keywords.h"
+#include "Scan.h"
+#include "../core/Numbers.h"
 #include <sstream>
 #include <algorithm>
 
 Lexer::Lexer(const std::string& source) 
-    : source(source), start(0), current(0), line(1), column(1) {
-    initKeywords();
-}
-
-void Lexer::initKeywords() {
-    keywords = {
-        {"let", TokenType::LET},
-        {"if", TokenType::IF},
-        {"else", TokenType::ELSE},
-        {"while", TokenType::WHILE},
-        {"for", TokenType::FOR},
-        {"function", TokenType::FUNCTION},
-        {"return", TokenType::RETURN},
-        {"end", TokenType::END},
-        {"then", TokenType::THEN},
-        {"do", TokenType::DO},
-        {"int", TokenType::INT_TYPE},
-        {"float", TokenType::FLOAT_TYPE},
-        {"bool", TokenType::BOOL_TYPE},
-        {"string", TokenType::STRING_TYPE},
-        {"void", TokenType::VOID_TYPE},
-        {"true", TokenType::BOOL_LITERAL},
-        {"false", TokenType::BOOL_LITERAL}
-    };
-}
+    : Lexer(SourceBuffer::fromString(source)) {}
+
+Lexer::Lexer(SourceText source)
+    : source(std::move(source)), start(0), current(0), end(this->source->size()) {}
+
+Lexer::Lexer(SourceText source, size_t begin, size_t end)
+    : source(std::move(source)), start(begin), current(begin), end(end) {}
 
 bool Lexer::isAtEnd() const {
-    return current >= source.length();
+    return current >= end;
 }
 
 char Lexer::advance() {
     if (isAtEnd()) return '\0';
-    char c = source[current++];
-    if (c == '\n') {
-        line++;
-        column = 1;
-    } else {
-        column++;
-    }
-    return c;
+    return source->data()[current++];
 }
 
 char Lexer::peek() const {
     if (isAtEnd()) return '\0';
-    return source[current];
+    return source->data()[current];
 }
 
 char Lexer::peekNext() const {
-    if (current + 1 >= source.length()) return '\0';
-    return source[current + 1];
+    if (current + 1 >= end) return '\0';
+    return source->data()[current + 1];
 }
 
 bool Lexer::match(char expected) {
-    if (isAtEnd() || source[current] != expected) return false;
+    if (isAtEnd() || source->data()[current] != expected) return false;
     current++;
-    column++;
     return true;
 }
 
 void Lexer::skipWhitespace() {
+    // Most gaps between tokens are one space; longer runs go to the scanner
+    if (peek() == ' ' && !CharClass::isSpace(peekNext()) && peekNext() != '#') {
+        current++;
+    }
     while (!isAtEnd()) {
         char c = peek();
-        if (c == ' ' || c == '\t' || c == '\r') {
-            advance();
-        } else if (c == '\n') {
-            line++;
-            column = 1;
-            advance();
+        if (CharClass::isSpace(c)) {
+            current += Scan::spaces(source->data() + current, end - current);
         } else if (c == '#') {
             skipComment();
         } else {
@@ -81,151 +58,169 @@ void Lexer::skipWhitespace() {
 }
 
 void Lexer::skipComment() {
-    while (!isAtEnd() && peek() != '\n') {
-        advance();
-    }
+    // Runs to the newline
+    current += Scan::find(source->data() + current, end - current, '\n');
 }
 
+// Literal values are decoded from the lexeme when the parser asks (Token::literal)
 Token Lexer::makeToken(TokenType type) const {
-    std::string text = source.substr(start, current - start);
-    return Token(type, text, 0, line, column - text.length());
+    return Token(type, source, start, current - start);
 }
 
-Token Lexer::makeToken(TokenType type, std::variant<int, float, bool, std::string> value) const {
-    std::string text = source.substr(start, current - start);
-    return Token(type, text, value, line, column - text.length());
+TokenType Lexer::error(const std::string& message) {
+    errorMessage = message;
+    return TokenType::ERROR;
 }
 
-Token Lexer::errorToken(const std::string& message) const {
-    return Token(TokenType::ERROR, message, 0, line, column);
-}
-
-Token Lexer::stringLiteral() {
-    while (peek() != '"' && !isAtEnd()) {
-        if (peek() == '\n') {
-            line++;
-            column = 1;
-        }
-        advance();
-    }
+TokenType Lexer::stringLiteral() {
+    current += Scan::find(source->data() + current, end - current, '"');
     
     if (isAtEnd()) {
-        return errorToken("Unterminated string");
+        return error("Unterminated string");
     }
     
     // Skip the closing quote
     advance();
     
-    std::string value = source.substr(start + 1, current - start - 2);
-    return makeToken(TokenType::STRING_LITERAL, value);
+    return TokenType::STRING_LITERAL;
 }
 
-Token Lexer::numberLiteral() {
+TokenType Lexer::numberLiteral() {
     bool isFloat = false;
     
-    while (std::isdigit(peek())) {
+    while (CharClass::isDigit(peek())) {
         advance();
     }
     
-    if (peek() == '.' && std::isdigit(peekNext())) {
+    if (peek() == '.' && CharClass::isDigit(peekNext())) {
         isFloat = true;
         advance(); // Consume the dot
         
-        while (std::isdigit(peek())) {
+        while (CharClass::isDigit(peek())) {
             advance();
         }
     }
     
-    std::string text = source.substr(start, current - start);
+    TokenType type = isFloat ? TokenType::FLOAT_LITERAL : TokenType::INT_LITERAL;
     
-    if (isFloat) {
-        float value = std::stof(text);
-        return makeToken(TokenType::FLOAT_LITERAL, value);
-    } else {
-        int value = std::stoi(text);
-        return makeToken(TokenType::INT_LITERAL, value);
+    // Anything shorter than INT_MAX fits; longer literals are decoded once
+    // here so Token::literal() never sees one out of range
+    if (current - start >= 10) {
+        std::string_view lexeme = source->view().substr(start, current - start);
+        int intValue;
+        float floatValue;
+        if (isFloat ? !Numbers::parse(lexeme, floatValue) : !Numbers::parse(lexeme, intValue)) {
+            return error("Number literal out of range");
+        }
     }
+    return type;
 }
 
-Token Lexer::identifier() {
-    while (std::isalnum(peek()) || peek() == '_') {
-        advance();
-    }
+TokenType Lexer::identifier() {
+    current += Scan::identifier(source->data() + current, end - current);
     
-    std::string text = source.substr(start, current - start);
-    
-    auto it = keywords.find(text);
-    if (it != keywords.end()) {
-        if (text == "true") {
-            return makeToken(it->second, true);
-        } else if (text == "false") {
-            return makeToken(it->second, false);
-        }
-        return makeToken(it->second);
-    }
-    
-    return makeToken(TokenType::IDENTIFIER);
+    return Keywords::lookup(source->view().substr(start, current - start));
 }
 
-Token Lexer::nextToken() {
+TokenType Lexer::scanToken() {
     skipWhitespace();
     start = current;
     
     if (isAtEnd()) {
-        return makeToken(TokenType::END_OF_FILE);
+        return TokenType::END_OF_FILE;
     }
     
     char c = advance();
     
-    if (std::isalpha(c) || c == '_') {
+    if (CharClass::isIdentifierStart(c)) {
         return identifier();
     }
     
-    if (std::isdigit(c)) {
+    if (CharClass::isDigit(c)) {
         return numberLiteral();
     }
     
     switch (c) {
-        case '(': return makeToken(TokenType::LEFT_PAREN);
-        case ')': return makeToken(TokenType::RIGHT_PAREN);
-        case '{': return makeToken(TokenType::LEFT_BRACE);
-        case '}': return makeToken(TokenType::RIGHT_BRACE);
-        case ',': return makeToken(TokenType::COMMA);
-        case ':': return makeToken(TokenType::COLON);
-        case ';': return makeToken(TokenType::SEMICOLON);
+        case '(': return TokenType::LEFT_PAREN;
+        case ')': return TokenType::RIGHT_PAREN;
+        case '{': return TokenType::LEFT_BRACE;
+        case '}': return TokenType::RIGHT_BRACE;
+        case ',': return TokenType::COMMA;
+        case ':': return TokenType::COLON;
+        case ';': return TokenType::SEMICOLON;
         
-        case '+': return makeToken(TokenType::PLUS);
-        case '-': return makeToken(TokenType::MINUS);
-        case '*': return makeToken(TokenType::MULTIPLY);
-        case '/': return makeToken(TokenType::DIVIDE);
-        case '%': return makeToken(TokenType::MODULO);
+        case '+': return TokenType::PLUS;
+        case '-': return TokenType::MINUS;
+        case '*': return TokenType::MULTIPLY;
+        case '/': return TokenType::DIVIDE;
+        case '%': return TokenType::MODULO;
         
         case '=':
-            if (match('=')) return makeToken(TokenType::EQUAL);
-            return makeToken(TokenType::ASSIGN);
+            if (match('=')) return TokenType::EQUAL;
+            return TokenType::ASSIGN;
         
         case '!':
-            if (match('=')) return makeToken(TokenType::NOT_EQUAL);
-            return makeToken(TokenType::NOT);
+            if (match('=')) return TokenType::NOT_EQUAL;
+            return TokenType::NOT;
         
         case '<':
-            if (match('=')) return makeToken(TokenType::LESS_EQUAL);
-            return makeToken(TokenType::LESS);
+            if (match('=')) return TokenType::LESS_EQUAL;
+            return TokenType::LESS;
         
         case '>':
-            if (match('=')) return makeToken(TokenType::GREATER_EQUAL);
-            return makeToken(TokenType::GREATER);
+            if (match('=')) return TokenType::GREATER_EQUAL;
+            return TokenType::GREATER;
         
         case '&':
-            if (match('&')) return makeToken(TokenType::AND);
+            if (match('&')) return TokenType::AND;
             break;
         
         case '|':
-            if (match('|')) return makeToken(TokenType::OR);
+            if (match('|')) return TokenType::OR;
             break;
         
         case '"': return stringLiteral();
     }
     
-    return errorToken("Unexpected character: '" + std::string(1, c) + "'");
-}
\ No newline at end of file
+    return error("Unexpected character: '" + std::string(1, c) + "'");
+}
+
+Token Lexer::nextToken() {
+    TokenType type = scanToken();
+    if (type == TokenType::ERROR) {
+        // Errors are rare enough to pay for the line table
+        SourceBuffer::Position at = source->position(start);
+        return Token(TokenType::ERROR, errorMessage, at.line, at.column);
+    }
+    return makeToken(type);
+}
+
+TokenBuffer Lexer::tokenize() {
+    TokenBuffer tokens(source);
+    // Dense code averages about one token per four bytes
+    tokens.reserve((end - current) / 4 + 1);
+    // scanInto() inlined; the call costs about 7% here
+    while (true) {
+        TokenType type = scanToken();
+        size_t length = current - start;
+        if (type == TokenType::ERROR) {
+            tokens.pushError(errorMessage, start, length);
+            continue;
+        }
+        tokens.push(type, start, length);
+        if (type == TokenType::END_OF_FILE) {
+            return tokens;
+        }
+    }
+}
+
+TokenType Lexer::scanInto(TokenBuffer& tokens) {
+    TokenType type = scanToken();
+    size_t length = current - start;
+    if (type == TokenType::ERROR) {
+        tokens.pushError(errorMessage, start, length);
+    } else {
+        tokens.push(type, start, length);
+    }
+    return type;
+}
@@ -0,0 +1,119 @@
+#include "ParallelLexer.h"
+#include "Lexer.h"
+#include "Scan.h"
+#include <algorithm>
+#include <thread>
+
+std::vector<size_t> ParallelLexer::splitPoints(const SourceBuffer& source, size_t slices) {
+    const char* text = source.data();
+    size_t length = source.size();
+    auto findFrom = [text, length](size_t from, char c) {
+        return from + Scan::find(text + from, length - from, c);
+    };
+
+    std::vector<size_t> points;
+    size_t position = 0;    // Everything before this has been classified
+    size_t quote = findFrom(0, '"');
+    size_t comment = findFrom(0, '#');
+
+    for (size_t k = 1; k < slices; k++) {
+        size_t target = std::max(length / slices * k, position);
+        size_t cut = length;
+
+        while (position < length) {
+            if (quote < position) quote = findFrom(position, '"');
+            if (comment < position) comment = findFrom(position, '#');
+
+            // [position, opening) is plain code, where any newline is a safe cut
+            size_t opening = std::min(quote, comment);
+            size_t from = std::max(position, target);
+            if (from < opening) {
+                size_t newline = from + Scan::find(text + from, opening - from, '\n');
+                if (newline < opening) {
+                    cut = newline + 1;
+                    break;
+                }
+            }
+            if (opening >= length) {
+                position = length;
+                break;
+            }
+
+            if (opening == quote) {
+                // An unterminated string runs to the end, and so does its slice
+                position = std::min(findFrom(opening + 1, '"') + 1, length);
+            } else {
+                // The comment's newline is plain code again
+                position = findFrom(opening, '\n');
+            }
+        }
+
+        if (cut >= length) {
+            break;
+        }
+        points.push_back(cut);
+        position = cut;
+    }
+
+    return points;
+}
+
+TokenBuffer ParallelLexer::tokenize(const SourceText& source, unsigned threads, size_t minSlice) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t slices = std::min<size_t>(threads, source->size() / std::max<size_t>(minSlice, 1));
+    std::vector<size_t> points;
+    if (slices > 1) {
+        points = splitPoints(*source, slices);
+    }
+    if (points.empty()) {
+        Lexer lexer(source);
+        return lexer.tokenize();
+    }
+
+    std::vector<size_t> bounds;
+    bounds.push_back(0);
+    bounds.insert(bounds.end(), points.begin(), points.end());
+    bounds.push_back(source->size());
+    size_t count = bounds.size() - 1;
+
+    std::vector<TokenBuffer> parts(count);
+    std::vector<std::thread> workers;
+    for (size_t k = 0; k < count; k++) {
+        workers.emplace_back([&, k] {
+            Lexer lexer(source, bounds[k], bounds[k + 1]);
+            parts[k] = lexer.tokenize();
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // Every part but the last ends in an END_OF_FILE that is dropped;
+    // offsets are into the whole source already
+    std::vector<size_t> tokenAt(count), literalAt(count);
+    size_t tokenCount = 0, literalCount = 0;
+    for (size_t k = 0; k < count; k++) {
+        tokenAt[k] = tokenCount;
+        literalAt[k] = literalCount;
+        tokenCount += parts[k].size() - (k + 1 < count ? 1 : 0);
+        literalCount += parts[k].literalCount();
+    }
+
+    TokenBuffer tokens(source);
+    tokens.resize(tokenCount, literalCount);
+    workers.clear();
+    for (size_t k = 0; k < count; k++) {
+        workers.emplace_back([&, k] {
+            size_t placed = parts[k].size() - (k + 1 < count ? 1 : 0);
+            tokens.place(parts[k], placed, tokenAt[k], literalAt[k]);
+            parts[k] = TokenBuffer();
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    return tokens;
+}
@@ -0,0 +1,234 @@
+#include "Scan.h"
+#include "CharClass.h"
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SIMPLELANG_SIMD_AVAILABLE 1
+#endif
+
+namespace {
+    struct Implementation {
+        const char* name;
+        size_t (*spaces)(const char*, size_t);
+        size_t (*find)(const char*, size_t, char);
+        size_t (*identifier)(const char*, size_t);
+        void (*newlines)(const char*, size_t, size_t, std::vector<size_t>&);
+    };
+
+    size_t spacesScalar(const char* text, size_t length) {
+        size_t i = 0;
+        while (i < length && CharClass::isSpace(text[i])) i++;
+        return i;
+    }
+
+    size_t findScalar(const char* text, size_t length, char c) {
+        const void* found = std::memchr(text, c, length);
+        return found ? static_cast<const char*>(found) - text : length;
+    }
+
+    size_t identifierScalar(const char* text, size_t length) {
+        size_t i = 0;
+        while (i < length && CharClass::isIdentifier(text[i])) i++;
+        return i;
+    }
+
+    // `base` is added to every offset, so the vector versions can hand their tail on
+    void newlinesScalar(const char* text, size_t length, size_t base, std::vector<size_t>& starts) {
+        for (size_t i = 0; i < length; i++) {
+            if (text[i] == '\n') starts.push_back(base + i + 1);
+        }
+    }
+
+    const Implementation SCALAR = {"scalar", spacesScalar, findScalar, identifierScalar, newlinesScalar};
+
+#ifdef SIMPLELANG_SIMD_AVAILABLE
+    // Each block is classified into a bit mask, one bit per byte; the
+    // first clear bit ends a run, and set bits are taken off one at a time.
+    // Ranges use unsigned saturation: lo <= x <= hi iff (x - lo) -sat (hi - lo) == 0.
+
+    // SSE2, 16 bytes
+    __m128i inRange(__m128i x, char lo, char hi) {
+        __m128i shifted = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+        return _mm_cmpeq_epi8(_mm_subs_epu8(shifted, _mm_set1_epi8(static_cast<char>(hi - lo))),
+                              _mm_setzero_si128());
+    }
+
+    unsigned spaceMask(__m128i x) {
+        __m128i space = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(x, _mm_set1_epi8('\t')));
+        __m128i line = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(x, _mm_set1_epi8('\n')));
+        return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(space, line)));
+    }
+
+    unsigned identifierMask(__m128i x) {
+        __m128i letter = inRange(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z');
+        __m128i digit = inRange(x, '0', '9');
+        __m128i underscore = _mm_cmpeq_epi8(x, _mm_set1_epi8('_'));
+        return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), underscore)));
+    }
+
+    __m128i load16(const char* text) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+    }
+
+    size_t spacesSse2(const char* text, size_t length) {
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16) {
+            unsigned stop = ~spaceMask(load16(text + i)) & 0xFFFF;
+            if (stop) return i + __builtin_ctz(stop);
+        }
+        return i + spacesScalar(text + i, length - i);
+    }
+
+    size_t findSse2(const char* text, size_t length, char c) {
+        __m128i target = _mm_set1_epi8(c);
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16) {
+            unsigned found = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(load16(text + i), target)));
+            if (found) return i + __builtin_ctz(found);
+        }
+        return i + findScalar(text + i, length - i, c);
+    }
+
+    size_t identifierSse2(const char* text, size_t length) {
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16) {
+            unsigned stop = ~identifierMask(load16(text + i)) & 0xFFFF;
+            if (stop) return i + __builtin_ctz(stop);
+        }
+        return i + identifierScalar(text + i, length - i);
+    }
+
+    void newlinesSse2(const char* text, size_t length, size_t base, std::vector<size_t>& starts) {
+        __m128i newline = _mm_set1_epi8('\n');
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16) {
+            unsigned found = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(load16(text + i), newline)));
+            for (; found; found &= found - 1) {
+                starts.push_back(base + i + __builtin_ctz(found) + 1);
+            }
+        }
+        newlinesScalar(text + i, length - i, base + i, starts);
+    }
+
+    const Implementation SSE2 = {"sse2", spacesSse2, findSse2, identifierSse2, newlinesSse2};
+
+    // AVX2, 32 bytes
+#define SIMPLELANG_AVX2 __attribute__((target("avx2")))
+
+    SIMPLELANG_AVX2 __m256i inRange256(__m256i x, char lo, char hi) {
+        __m256i shifted = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+        return _mm256_cmpeq_epi8(_mm256_subs_epu8(shifted, _mm256_set1_epi8(static_cast<char>(hi - lo))),
+                                 _mm256_setzero_si256());
+    }
+
+    SIMPLELANG_AVX2 unsigned spaceMask256(__m256i x) {
+        __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')),
+                                        _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t')));
+        __m256i line = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\r')),
+                                       _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n')));
+        return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(space, line)));
+    }
+
+    SIMPLELANG_AVX2 unsigned identifierMask256(__m256i x) {
+        __m256i letter = inRange256(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z');
+        __m256i digit = inRange256(x, '0', '9');
+        __m256i underscore = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_'));
+        return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(letter, digit), underscore)));
+    }
+
+    SIMPLELANG_AVX2 __m256i load32(const char* text) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text));
+    }
+
+    SIMPLELANG_AVX2 size_t spacesAvx2(const char* text, size_t length) {
+        size_t i = 0;
+        for (; i + 32 <= length; i += 32) {
+            unsigned stop = ~spaceMask256(load32(text + i));
+            if (stop) return i + __builtin_ctz(stop);
+        }
+        return i + spacesSse2(text + i, length - i);
+    }
+
+    SIMPLELANG_AVX2 size_t findAvx2(const char* text, size_t length, char c) {
+        __m256i target = _mm256_set1_epi8(c);
+        size_t i = 0;
+        for (; i + 32 <= length; i += 32) {
+            unsigned found = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(load32(text + i), target)));
+            if (found) return i + __builtin_ctz(found);
+        }
+        return i + findSse2(text + i, length - i, c);
+    }
+
+    SIMPLELANG_AVX2 size_t identifierAvx2(const char* text, size_t length) {
+        size_t i = 0;
+        for (; i + 32 <= length; i += 32) {
+            unsigned stop = ~identifierMask256(load32(text + i));
+            if (stop) return i + __builtin_ctz(stop);
+        }
+        return i + identifierSse2(text + i, length - i);
+    }
+
+    SIMPLELANG_AVX2 void newlinesAvx2(const char* text, size_t length, size_t base, std::vector<size_t>& starts) {
+        __m256i newline = _mm256_set1_epi8('\n');
+        size_t i = 0;
+        for (; i + 32 <= length; i += 32) {
+            unsigned found = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(load32(text + i), newline)));
+            for (; found; found &= found - 1) {
+                starts.push_back(base + i + __builtin_ctz(found) + 1);
+            }
+        }
+        newlinesSse2(text + i, length - i, base + i, starts);
+    }
+
+#undef SIMPLELANG_AVX2
+
+    const Implementation AVX2 = {"avx2", spacesAvx2, findAvx2, identifierAvx2, newlinesAvx2};
+#endif
+
+    const Implementation* named(const std::string& isa) {
+#ifdef SIMPLELANG_SIMD_AVAILABLE
+        __builtin_cpu_init();
+        if (isa == "avx2") return __builtin_cpu_supports("avx2") ? &AVX2 : nullptr;
+        if (isa == "sse2") return &SSE2;
+#endif
+        return isa == "scalar" ? &SCALAR : nullptr;
+    }
+
+    const Implementation*& active() {
+        static const Implementation* implementation = [] {
+            for (const char* isa : {"avx2", "sse2"}) {
+                if (const Implementation* supported = named(isa)) return supported;
+            }
+            return &SCALAR;
+        }();
+        return implementation;
+    }
+}
+
+size_t Scan::spaces(const char* text, size_t length) {
+    return active()->spaces(text, length);
+}
+
+size_t Scan::find(const char* text, size_t length, char c) {
+    return active()->find(text, length, c);
+}
+
+size_t Scan::identifier(const char* text, size_t length) {
+    return active()->identifier(text, length);
+}
+
+void Scan::newlines(const char* text, size_t length, std::vector<size_t>& starts) {
+    active()->newlines(text, length, 0, starts);
+}
+
+const char* Scan::isa() {
+    return active()->name;
+}
+
+bool Scan::use(const std::string& isa) {
+    const Implementation* implementation = named(isa);
+    if (!implementation) return false;
+    active() = implementation;
+    return true;
+}
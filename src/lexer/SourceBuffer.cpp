@@ -0,0 +1,103 @@
+#include "SourceBuffer.h"
+#include "Scan.h"
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SIMPLELANG_MMAP_AVAILABLE 1
+#endif
+
+namespace {
+    const size_t READ_BLOCK = 1 << 16;
+}
+
+SourceBuffer::SourceBuffer() : bytes(""), length(0), mapped(false), origin{1, 1} {}
+
+SourceBuffer::~SourceBuffer() {
+#ifdef SIMPLELANG_MMAP_AVAILABLE
+    if (mapped) {
+        munmap(const_cast<char*>(bytes), length);
+    }
+#endif
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::open(const std::string& filename) {
+    std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+
+#ifdef SIMPLELANG_MMAP_AVAILABLE
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        size_t size = static_cast<size_t>(info.st_size);
+        void* pages = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (pages != MAP_FAILED) {
+            madvise(pages, size, MADV_SEQUENTIAL);
+            close(fd);
+            buffer->bytes = static_cast<const char*>(pages);
+            buffer->length = size;
+            buffer->mapped = true;
+            return buffer;
+        }
+    }
+
+    // Pipes, terminals, empty files: read to the end of input
+    char block[READ_BLOCK];
+    ssize_t count;
+    while ((count = read(fd, block, sizeof(block))) != 0) {
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            close(fd);
+            throw std::runtime_error("Could not read file: " + filename);
+        }
+        buffer->owned.append(block, static_cast<size_t>(count));
+    }
+    close(fd);
+#else
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+    char block[READ_BLOCK];
+    while (file.read(block, sizeof(block)) || file.gcount() > 0) {
+        buffer->owned.append(block, static_cast<size_t>(file.gcount()));
+    }
+#endif
+
+    buffer->bytes = buffer->owned.data();
+    buffer->length = buffer->owned.size();
+    return buffer;
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::fromString(std::string text, Position origin) {
+    std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+    buffer->owned = std::move(text);
+    buffer->bytes = buffer->owned.data();
+    buffer->length = buffer->owned.size();
+    buffer->origin = origin;
+    return buffer;
+}
+
+SourceBuffer::Position SourceBuffer::position(size_t offset) const {
+    std::call_once(linesFound, [this] {
+        lineStarts.push_back(0);
+        Scan::newlines(bytes, length, lineStarts);
+    });
+
+    // The last line that starts at or before `offset`
+    size_t line = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin() - 1;
+    int column = static_cast<int>(offset - lineStarts[line]) + 1;
+    if (line == 0) {
+        column += origin.column - 1;
+    }
+    return {origin.line + static_cast<int>(line), column};
+}
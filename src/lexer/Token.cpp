@@ -1,27 +1,65 @@
 #include "Token.h"
+#include "../core/Numbers.h"
 #include <sstream>
+#include <stdexcept>
 
-Token::Token(TokenType type, std::string lexeme, 
-             std::variant<int, float, bool, std::string> value,
-             int line, int column)
-    : type(type), lexeme(lexeme), value(value), line(line), column(column) {}
+Token::Token(TokenType type, const std::string& lexeme, int line, int column)
+    : type(type) {
+    // Tokens without text at 1:1 (Token()) allocate nothing
+    if (!lexeme.empty() || line != 1 || column != 1) {
+        text = SourceBuffer::fromString(lexeme, {line, column});
+        this->lexeme = text->view();
+    }
+}
+
+Token::Token(TokenType type, SourceText text, size_t offset, size_t length)
+    : type(type), lexeme(text->view().substr(offset, length)), text(std::move(text)) {}
+
+SourceBuffer::Position Token::position() const {
+    if (!text) {
+        return {1, 1};
+    }
+    return text->position(static_cast<size_t>(lexeme.data() - text->data()));
+}
+
+Literal Token::literal() const {
+    return decode(type, lexeme);
+}
+
+Literal Token::decode(TokenType type, std::string_view lexeme) {
+    switch (type) {
+        case TokenType::INT_LITERAL: {
+            int value;
+            if (!Numbers::parse(lexeme, value)) throw std::out_of_range("int literal");
+            return value;
+        }
+        case TokenType::FLOAT_LITERAL: {
+            float value;
+            if (!Numbers::parse(lexeme, value)) throw std::out_of_range("float literal");
+            return value;
+        }
+        case TokenType::BOOL_LITERAL: return lexeme == "true";
+        case TokenType::STRING_LITERAL:
+            // Without the quotes
+            return std::string(lexeme.size() >= 2 ? lexeme.substr(1, lexeme.size() - 2) : lexeme);
+        default: return 0;
+    }
+}
 
 std::string Token::toString() const {
     std::stringstream ss;
     ss << typeToString() << " '" << lexeme << "'";
     
-    // Add value if present
-    if (std::holds_alternative<int>(value)) {
-        ss << " (value: " << std::get<int>(value) << ")";
-    } else if (std::holds_alternative<float>(value)) {
-        ss << " (value: " << std::get<float>(value) << ")";
-    } else if (std::holds_alternative<bool>(value)) {
-        ss << " (value: " << (std::get<bool>(value) ? "true" : "false") << ")";
-    } else if (std::holds_alternative<std::string>(value)) {
-        ss << " (value: \"" << std::get<std::string>(value) << "\")";
+    // Add value if present; numbers and booleans are their own lexeme
+    if (type == TokenType::STRING_LITERAL) {
+        ss << " (value: \"" << std::get<std::string>(literal()) << "\")";
+    } else if (type == TokenType::INT_LITERAL || type == TokenType::FLOAT_LITERAL ||
+               type == TokenType::BOOL_LITERAL) {
+        ss << " (value: " << lexeme << ")";
     }
     
-    ss << " at " << line << ":" << column;
+    SourceBuffer::Position at = position();
+    ss << " at " << at.line << ":" << at.column;
     return ss.str();
 }
 
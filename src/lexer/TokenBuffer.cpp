@@ -0,0 +1,123 @@
+#include "TokenBuffer.h"
+#include <algorithm>
+#include <stdexcept>
+
+void TokenBuffer::reserve(size_t count) {
+    types.reserve(count);
+    offsets.reserve(count);
+    lengths.reserve(count);
+    literalIndices.reserve(count);
+    literals.reserve(count / 4);
+}
+
+void TokenBuffer::push(TokenType type, size_t offset, size_t length) {
+    uint32_t literal = NO_LITERAL;
+    if (type == TokenType::INT_LITERAL || type == TokenType::FLOAT_LITERAL ||
+        type == TokenType::BOOL_LITERAL || type == TokenType::STRING_LITERAL) {
+        try {
+            literals.push_back(Token::decode(type, source->view().substr(offset, length)));
+        } catch (const std::out_of_range&) {
+            pushError("Number literal out of range", offset, length);
+            return;
+        }
+        literal = static_cast<uint32_t>(literals.size() - 1);
+    }
+
+    types.push_back(static_cast<uint8_t>(type));
+    offsets.push_back(offset);
+    lengths.push_back(static_cast<uint32_t>(length));
+    literalIndices.push_back(literal);
+}
+
+void TokenBuffer::pushError(const std::string& message, size_t offset, size_t length) {
+    literals.push_back(message);
+    types.push_back(static_cast<uint8_t>(TokenType::ERROR));
+    offsets.push_back(offset);
+    lengths.push_back(static_cast<uint32_t>(length));
+    literalIndices.push_back(static_cast<uint32_t>(literals.size() - 1));
+}
+
+void TokenBuffer::resize(size_t count, size_t literalCount) {
+    types.resize(count);
+    offsets.resize(count);
+    lengths.resize(count);
+    literalIndices.resize(count);
+    literals.resize(literalCount);
+}
+
+void TokenBuffer::place(const TokenBuffer& part, size_t count, size_t at, size_t literalAt) {
+    std::copy(part.types.begin(), part.types.begin() + count, types.begin() + at);
+    std::copy(part.offsets.begin(), part.offsets.begin() + count, offsets.begin() + at);
+    std::copy(part.lengths.begin(), part.lengths.begin() + count, lengths.begin() + at);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t literal = part.literalIndices[i];
+        literalIndices[at + i] = literal == NO_LITERAL ? NO_LITERAL : literal + static_cast<uint32_t>(literalAt);
+    }
+    std::copy(part.literals.begin(), part.literals.end(), literals.begin() + literalAt);
+}
+
+namespace {
+    template <typename Array>
+    void replace(Array& array, size_t first, size_t count, const Array& replacement, size_t replacementCount) {
+        auto at = array.erase(array.begin() + first, array.begin() + first + count);
+        array.insert(at, replacement.begin(), replacement.begin() + replacementCount);
+    }
+}
+
+void TokenBuffer::splice(SourceText text, size_t first, size_t count, const TokenBuffer& replacement,
+                         size_t replacementCount, std::ptrdiff_t offsetShift) {
+    // Literals are stored in token order, so the removed tokens' literals are one run
+    size_t literalFirst = literals.size();
+    for (size_t i = first; i < size(); i++) {
+        if (literalIndices[i] != NO_LITERAL) {
+            literalFirst = literalIndices[i];
+            break;
+        }
+    }
+    size_t literalRemoved = 0;
+    for (size_t i = first; i < first + count; i++) {
+        literalRemoved += literalIndices[i] != NO_LITERAL;
+    }
+    size_t literalAdded = 0;
+    for (size_t i = 0; i < replacementCount; i++) {
+        literalAdded += replacement.literalIndices[i] != NO_LITERAL;
+    }
+
+    literals.erase(literals.begin() + literalFirst, literals.begin() + literalFirst + literalRemoved);
+    literals.insert(literals.begin() + literalFirst, replacement.literals.begin(),
+                    replacement.literals.begin() + literalAdded);
+
+    replace(types, first, count, replacement.types, replacementCount);
+    replace(offsets, first, count, replacement.offsets, replacementCount);
+    replace(lengths, first, count, replacement.lengths, replacementCount);
+    replace(literalIndices, first, count, replacement.literalIndices, replacementCount);
+
+    for (size_t i = first; i < first + replacementCount; i++) {
+        if (literalIndices[i] != NO_LITERAL) {
+            literalIndices[i] += static_cast<uint32_t>(literalFirst);
+        }
+    }
+    uint32_t literalShift = static_cast<uint32_t>(literalAdded - literalRemoved);
+    for (size_t i = first + replacementCount; i < size(); i++) {
+        offsets[i] += offsetShift;
+        if (literalIndices[i] != NO_LITERAL) {
+            literalIndices[i] += literalShift;
+        }
+    }
+
+    source = std::move(text);
+}
+
+std::string_view TokenBuffer::lexeme(size_t index) const {
+    if (type(index) == TokenType::ERROR) {
+        return std::get<std::string>(literals[literalIndices[index]]);
+    }
+    return source->view().substr(offsets[index], lengths[index]);
+}
+
+const Literal* TokenBuffer::literal(size_t index) const {
+    if (literalIndices[index] == NO_LITERAL || type(index) == TokenType::ERROR) {
+        return nullptr;
+    }
+    return &literals[literalIndices[index]];
+}
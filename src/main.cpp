@@ -2,15 +2,271 @@
 #include <fstream>
 #include <string>
 #include "lexer/Lexer.h"
+#include "lexer/ParallelLexer.h"
 #include "parser/Parser.h"
 #include "semantic/SemanticAnalyzer.h"
 #include "interpreter/Interpreter.h"
+#include "interpreter/VM.h"
+#include "compiler/CodeGenerator.h"
+#include "compiler/CBackend.h"
+#include "compiler/NativeModule.h"
+#include "ir/IRBuilder.h"
+#include "ir/IRVerifier.h"
+#include "ir/IRPrinter.h"
+#include "ir/IRLowering.h"
+#include "ir/RangeAnalysis.h"
+#include "ir/ValueNumbering.h"
+#include "optimizer/ConstantFolder.h"
+#include "optimizer/DeadCodeEliminator.h"
+#include "optimizer/Inliner.h"
+#include "optimizer/InductionVariables.h"
+#include "optimizer/LoopInvariantMotion.h"
+#include "optimizer/PassManager.h"
+#include "optimizer/Profile.h"
+#include "optimizer/ProfileGuided.h"
+#include "core/Config.h"
 #include "core/Utils.h"
 #include "core/Error.h"
 
-void run(const std::string& source) {
-    Lexer lexer(source);
-    Parser parser(lexer);
+// Drops the first `count` characters written to a stream while it is alive
+class SkipOutput : public std::streambuf {
+private:
+    std::ostream& stream;
+    std::streambuf* target;
+    size_t remaining;
+    
+protected:
+    int overflow(int c) override {
+        if (c == traits_type::eof()) return traits_type::not_eof(c);
+        if (remaining > 0) {
+            remaining--;
+            return c;
+        }
+        return target->sputc(traits_type::to_char_type(c));
+    }
+    
+    int sync() override {
+        return target->pubsync();
+    }
+    
+public:
+    SkipOutput(std::ostream& stream, size_t count) : stream(stream), target(stream.rdbuf()), remaining(count) {
+        if (count > 0) stream.rdbuf(this);
+    }
+    
+    ~SkipOutput() {
+        if (stream.rdbuf() == this) stream.rdbuf(target);
+    }
+};
+
+// Compiles the program to C; returns false when it should run on the interpreter instead.
+// After a runtime error `printed` is what the module wrote before it
+bool runCompiled(const ProgramPtr& program, size_t& printed) {
+    std::string emitPath = Config::get("emit_c");
+    std::string outputPath = Config::get("output");
+    bool required = !emitPath.empty() || !outputPath.empty();
+    
+    CBackend backend;
+    if (Config::getBool("perf")) {
+        backend.setSourceName(Config::get("script", "<stdin>"));
+    }
+    std::string source = backend.generate(program);
+    
+    if (backend.hasErrors()) {
+        if (!required) {
+            return false; // Dynamically typed code stays on the interpreter
+        }
+        std::cout << "C backend errors:" << std::endl;
+        Utils::printErrors(backend.getErrors());
+        return true;
+    }
+    
+    std::string message;
+    if (!emitPath.empty() && !Utils::writeFile(emitPath, source)) {
+        std::cerr << "Error: Could not write " << emitPath << std::endl;
+    }
+    if (!outputPath.empty() && !NativeModule::buildExecutable(source, outputPath, message)) {
+        std::cerr << "Error: " << message << std::endl;
+    }
+    if (required) {
+        return true;
+    }
+    
+    NativeModule module;
+    if (!module.load(source, message)) {
+        std::cerr << "Error: " << message << std::endl;
+        return false;
+    }
+    
+    std::cout.flush();
+    if (!module.run(message)) {
+        // The VM records a runtime error and goes on with null, which
+        // compiled code cannot do; the program runs again from the start
+        // there, without printing the same output twice
+        printed = module.printed();
+        return false;
+    }
+    return true;
+}
+
+bool wantsReport() {
+    return Config::getBool("opt_report") || Config::getBool("verbose");
+}
+
+// -O1 folds constants and removes unreachable code, -O2 also inlines small
+// functions, removes dead stores, hoists loop invariants and strength-reduces
+// induction variables, -O3 inlines larger functions and folds and cleans up
+// again after the loop passes. A profile (--use-profile) is applied first.
+void optimize(const ProgramPtr& program, const Profile* profile) {
+    PassManager passes(PassManager::configuredLevel());
+    passes.setPrintAfter(Config::get("print_after"));
+    int level = passes.getLevel();
+    bool verbose = Config::getBool("verbose");
+    
+    // Inline first so folding sees through the substituted bodies
+    Inliner inliner(PassManager::inlineBudget(level));
+    ConstantFolder folder;
+    DeadCodeEliminator eliminator(level >= 2);
+    LoopInvariantMotion licm;
+    InductionVariables inductions;
+    ConstantFolder lateFolder;
+    DeadCodeEliminator lateEliminator(true);
+    
+    if (profile) {
+        auto guided = std::make_shared<ProfileGuided>(*profile);
+        passes.add("pgo", 1, [guided](const ProgramPtr& p) { return guided->run(p); },
+                   [guided] { return guided->report(); });
+    }
+    passes.add("inline", 2, [&inliner](const ProgramPtr& p) { return inliner.run(p); },
+               [&inliner, verbose] { return inliner.report(verbose); });
+    passes.add("fold", 1, [&folder](const ProgramPtr& p) { return folder.run(p); },
+               [&folder] { return folder.report(); });
+    passes.add("dce", 1, [&eliminator](const ProgramPtr& p) { return eliminator.run(p); },
+               [&eliminator] { return eliminator.report(); });
+    passes.add("licm", 2, [&licm](const ProgramPtr& p) { return licm.run(p); },
+               [&licm] { return licm.report(); });
+    passes.add("indvars", 2, [&inductions](const ProgramPtr& p) { return inductions.run(p); },
+               [&inductions] { return inductions.report(); });
+    passes.add("late-fold", 3, [&lateFolder](const ProgramPtr& p) { return lateFolder.run(p); },
+               [&lateFolder] { return lateFolder.report(); });
+    passes.add("late-dce", 3, [&lateEliminator](const ProgramPtr& p) { return lateEliminator.run(p); },
+               [&lateEliminator] { return lateEliminator.report(); });
+    
+    passes.run(program);
+    if (wantsReport() && level >= 1) {
+        std::cout << passes.report();
+    }
+}
+
+// Compiles to bytecode, through the SSA IR with --ir; false when the VM cannot run the program
+bool compileBytecode(const ProgramPtr& program, BytecodeWriter& chunk) {
+    if (!Config::getBool("ir")) {
+        CodeGenerator generator;
+        chunk = generator.generate(program);
+        return generator.isExecutable();
+    }
+    
+    IRBuilder builder;
+    auto module = builder.build(program);
+    if (builder.hasErrors()) {
+        return false;
+    }
+    
+    // Value numbering at -O2; ranges at -O1 prove divisions and int
+    // arithmetic safe so the JITs can drop their checks
+    PassManager passes(PassManager::configuredLevel());
+    passes.setPrintAfter(Config::get("print_after"));
+    ValueNumbering numbering;
+    RangeAnalysis ranges;
+    passes.add("gvn", 2, [&numbering](IRModule& m) { return numbering.run(m); },
+               [&numbering] { return numbering.report(); });
+    passes.add("range", 1, [&ranges](IRModule& m) {
+                   ranges.analyze(m);
+                   return ranges.getStats().nonZeroDivisors + ranges.getStats().noOverflow;
+               },
+               [&ranges] { return ranges.report(); });
+    passes.run(*module);
+    if (wantsReport() && passes.getLevel() >= 1) {
+        std::cout << passes.report();
+    }
+    
+    IRVerifier verifier;
+    if (!verifier.verify(*module)) {
+        std::cout << "IR verifier errors:" << std::endl;
+        Utils::printErrors(verifier.getErrors());
+        return false;
+    }
+    if (Config::getBool("dump_ir")) {
+        std::cout << IRPrinter::print(*module);
+    }
+    
+    IRLowering lowering;
+    chunk = lowering.lower(*module, &ranges);
+    return lowering.isExecutable();
+}
+
+// `skipped` characters of output were already printed by compiled code
+void interpret(const ProgramPtr& program, Profile* profile, size_t skipped = 0) {
+    Interpreter interpreter;
+    interpreter.setProfile(profile);
+    {
+        SkipOutput skip(std::cout, skipped);
+        interpreter.interpret(program);
+    }
+    
+    if (interpreter.hasErrors()) {
+        std::cout << "Runtime errors:" << std::endl;
+        Utils::printErrors(interpreter.getErrors());
+    }
+}
+
+// Runs the program as written for --record-profile: on the VM when the
+// bytecode can express it, else on the tree walker, the only tier that
+// runs user functions (and so the only one that records call targets)
+void record(const ProgramPtr& program, Profile& profile) {
+    CodeGenerator generator;
+    BytecodeWriter chunk = generator.generate(program);
+    if (!generator.isExecutable()) {
+        interpret(program, &profile);
+        return;
+    }
+    
+    VM vm;
+    vm.setProfile(&profile);
+    vm.run(chunk);
+    if (vm.hasErrors()) {
+        std::cout << "Runtime errors:" << std::endl;
+        Utils::printErrors(vm.getErrors());
+    }
+}
+
+// Numbers the program's profile sites and reads --use-profile; the profile
+// stays empty when it cannot be read or was recorded from other source
+Profile loadProfile(const ProgramPtr& program) {
+    Profile profile;
+    std::string recordPath = Config::get("record_profile");
+    std::string usePath = Config::get("use_profile");
+    if (recordPath.empty() && usePath.empty()) {
+        return profile;
+    }
+    
+    size_t sites = Profile::number(program);
+    if (!usePath.empty()) {
+        if (!profile.load(usePath)) {
+            std::cerr << "Warning: Could not load profile: " << usePath << std::endl;
+            profile = Profile();
+        } else if (profile.getSites() != sites) {
+            std::cerr << "Warning: Profile " << usePath << " was recorded from a different program" << std::endl;
+            profile = Profile();
+        }
+    }
+    profile.setSites(sites);
+    return profile;
+}
+
+void run(const SourceText& source) {
+    // Scripts of a few megabytes and up are lexed on every core
+    Parser parser(ParallelLexer::tokenize(source));
     
     auto program = parser.parse();
     
@@ -29,19 +285,51 @@ void run(const std::string& source) {
         return;
     }
     
-    Interpreter interpreter;
-    interpreter.interpret(program);
+    Profile profile = loadProfile(program);
+    std::string recordPath = Config::get("record_profile");
+    if (!recordPath.empty()) {
+        record(program, profile);
+        if (!profile.save(recordPath)) {
+            std::cerr << "Warning: Could not write profile: " << recordPath << std::endl;
+        }
+        return;
+    }
     
-    if (interpreter.hasErrors()) {
-        std::cout << "Runtime errors:" << std::endl;
-        Utils::printErrors(interpreter.getErrors());
+    optimize(program, profile.empty() ? nullptr : &profile);
+    
+    bool compile = Config::getBool("native") || !Config::get("emit_c").empty() ||
+                   !Config::get("output").empty();
+    size_t printed = 0;
+    if (compile && runCompiled(program, printed)) {
+        return;
+    }
+    
+    if (Config::getBool("jit") || Config::getBool("ir")) {
+        BytecodeWriter chunk;
+        
+        // Programs the bytecode cannot express yet stay on the tree walker
+        if (compileBytecode(program, chunk)) {
+            VM vm;
+            {
+                SkipOutput skip(std::cout, printed);
+                vm.run(chunk);
+            }
+            
+            if (vm.hasErrors()) {
+                std::cout << "Runtime errors:" << std::endl;
+                Utils::printErrors(vm.getErrors());
+            }
+            return;
+        }
     }
+    
+    interpret(program, nullptr, printed);
 }
 
 void runFile(const std::string& filename) {
     try {
-        std::string source = Utils::readFile(filename);
-        run(source);
+        // Mapped, not copied: the lexer and tokens read the file in place
+        run(SourceBuffer::open(filename));
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
     }
@@ -61,18 +349,53 @@ void runPrompt() {
             break;
         }
         
-        run(line);
+        run(SourceBuffer::fromString(line));
     }
 }
 
 int main(int argc, char* argv[]) {
-    if (argc > 2) {
-        std::cout << "Usage: simplelang [script]" << std::endl;
-        return 1;
+    std::string script;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--jit") {
+            Config::set("jit", "true");
+        } else if (arg == "--ir") {
+            Config::set("ir", "true");
+        } else if (arg == "--dump-ir") {
+            Config::set("ir", "true");
+            Config::set("dump_ir", "true");
+        } else if (arg == "-O0" || arg == "-O1" || arg == "-O2" || arg == "-O3") {
+            Config::set("optimize", arg.substr(2));
+        } else if (arg.rfind("--print-after=", 0) == 0) {
+            Config::set("print_after", arg.substr(14));
+        } else if (arg == "--verbose") {
+            Config::set("verbose", "true");
+        } else if (arg == "--opt-report") {
+            Config::set("opt_report", "true");
+        } else if (arg.rfind("--record-profile=", 0) == 0) {
+            Config::set("record_profile", arg.substr(17));
+        } else if (arg.rfind("--use-profile=", 0) == 0) {
+            Config::set("use_profile", arg.substr(14));
+        } else if (arg == "--perf") {
+            Config::set("perf", "true");
+        } else if (arg == "--native") {
+            Config::set("native", "true");
+        } else if (arg.rfind("--emit-c=", 0) == 0) {
+            Config::set("emit_c", arg.substr(9));
+        } else if (arg.rfind("--output=", 0) == 0) {
+            Config::set("output", arg.substr(9));
+        } else if (script.empty() && arg.rfind("--", 0) != 0) {
+            script = arg;
+            Config::set("script", arg);
+        } else {
+            std::cout << "Usage: simplelang [--jit] [--ir] [--dump-ir] [-O0|-O1|-O2|-O3] [--print-after=pass|all] [--opt-report] [--verbose] [--record-profile=file] [--use-profile=file] [--native] [--perf] [--emit-c=file.c] [--output=exe] [script]" << std::endl;
+            return 1;
+        }
     }
     
-    if (argc == 2) {
-        runFile(argv[1]);
+    if (!script.empty()) {
+        runFile(script);
     } else {
         runPrompt();
     }
@@ -0,0 +1,405 @@
+#include "ConstantFolder.h"
+#include "../core/Numbers.h"
+#include <sstream>
+
+namespace {
+    bool isNumber(const Value& value) {
+        return std::holds_alternative<int>(value) || std::holds_alternative<float>(value);
+    }
+
+    float toFloat(const Value& value) {
+        if (std::holds_alternative<int>(value)) return static_cast<float>(std::get<int>(value));
+        return std::get<float>(value);
+    }
+
+    std::string toString(const Value& value) {
+        if (std::holds_alternative<int>(value)) return Numbers::toString(std::get<int>(value));
+        if (std::holds_alternative<float>(value)) return Numbers::toString(std::get<float>(value));
+        if (std::holds_alternative<bool>(value)) return std::get<bool>(value) ? "true" : "false";
+        return std::get<std::string>(value);
+    }
+
+    // Same rules as Environment::isEqual
+    bool isEqual(const Value& a, const Value& b) {
+        if (a.index() == b.index()) return a == b;
+        if (isNumber(a) && isNumber(b)) return toFloat(a) == toFloat(b);
+        return false;
+    }
+
+    // Interpreter::less; false when the operands cannot be compared
+    bool less(const Value& a, const Value& b, bool& result) {
+        if (std::holds_alternative<int>(a) && std::holds_alternative<int>(b)) {
+            result = std::get<int>(a) < std::get<int>(b);
+        } else if (isNumber(a) && isNumber(b)) {
+            result = toFloat(a) < toFloat(b);
+        } else if (std::holds_alternative<std::string>(a) && std::holds_alternative<std::string>(b)) {
+            result = std::get<std::string>(a) < std::get<std::string>(b);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Integer arithmetic wraps like the VM and generated code
+    int wrap(long long value) {
+        return static_cast<int>(static_cast<unsigned int>(value));
+    }
+}
+
+bool ConstantFolder::isTruthy(const Value& value) {
+    if (std::holds_alternative<bool>(value)) return std::get<bool>(value);
+    if (std::holds_alternative<int>(value)) return std::get<int>(value) != 0;
+    if (std::holds_alternative<float>(value)) return std::get<float>(value) != 0.0f;
+    return !std::get<std::string>(value).empty();
+}
+
+bool ConstantFolder::evaluateBinary(TokenType op, const Value& left, const Value& right, Value& result) {
+    bool bothInts = std::holds_alternative<int>(left) && std::holds_alternative<int>(right);
+    bool bothNumbers = isNumber(left) && isNumber(right);
+    bool flag = false;
+
+    switch (op) {
+        case TokenType::PLUS:
+            if (bothInts) {
+                result = wrap(static_cast<long long>(std::get<int>(left)) + std::get<int>(right));
+            } else if (bothNumbers) {
+                result = toFloat(left) + toFloat(right);
+            } else if (std::holds_alternative<std::string>(left) || std::holds_alternative<std::string>(right)) {
+                result = toString(left) + toString(right);
+            } else {
+                return false;
+            }
+            return true;
+        case TokenType::MINUS:
+            if (bothInts) {
+                result = wrap(static_cast<long long>(std::get<int>(left)) - std::get<int>(right));
+            } else if (bothNumbers) {
+                result = toFloat(left) - toFloat(right);
+            } else {
+                return false;
+            }
+            return true;
+        case TokenType::MULTIPLY:
+            if (bothInts) {
+                result = wrap(static_cast<long long>(std::get<int>(left)) * std::get<int>(right));
+            } else if (bothNumbers) {
+                result = toFloat(left) * toFloat(right);
+            } else {
+                return false;
+            }
+            return true;
+        case TokenType::DIVIDE:
+            // Division by zero is a runtime error and must stay one
+            if (!bothNumbers || toFloat(right) == 0.0f) return false;
+            result = toFloat(left) / toFloat(right);
+            return true;
+        case TokenType::MODULO:
+            if (!bothInts || std::get<int>(right) == 0) return false;
+            // INT_MIN % -1 overflows in C++; the result is 0
+            result = std::get<int>(right) == -1 ? 0 : std::get<int>(left) % std::get<int>(right);
+            return true;
+        case TokenType::EQUAL:
+            result = isEqual(left, right);
+            return true;
+        case TokenType::NOT_EQUAL:
+            result = !isEqual(left, right);
+            return true;
+        case TokenType::LESS:
+            if (!less(left, right, flag)) return false;
+            result = flag;
+            return true;
+        case TokenType::GREATER:
+            if (!less(right, left, flag)) return false;
+            result = flag;
+            return true;
+        case TokenType::LESS_EQUAL:
+            if (!less(left, right, flag)) return false;
+            result = flag || isEqual(left, right);
+            return true;
+        case TokenType::GREATER_EQUAL:
+            if (!less(right, left, flag)) return false;
+            result = flag || isEqual(left, right);
+            return true;
+        case TokenType::AND:
+            result = isTruthy(left) && isTruthy(right);
+            return true;
+        case TokenType::OR:
+            result = isTruthy(left) || isTruthy(right);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool ConstantFolder::evaluateUnary(TokenType op, const Value& operand, Value& result) {
+    switch (op) {
+        case TokenType::MINUS:
+            if (std::holds_alternative<int>(operand)) {
+                result = wrap(-static_cast<long long>(std::get<int>(operand)));
+            } else if (std::holds_alternative<float>(operand)) {
+                result = -std::get<float>(operand);
+            } else {
+                return false;
+            }
+            return true;
+        case TokenType::NOT:
+            result = !isTruthy(operand);
+            return true;
+        default:
+            return false;
+    }
+}
+
+size_t ConstantFolder::countNodes(const ExprPtr& expr) {
+    if (!expr) return 0;
+    switch (expr->getType()) {
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            return 1 + countNodes(binary->left) + countNodes(binary->right);
+        }
+        case ExprType::UNARY:
+            return 1 + countNodes(std::static_pointer_cast<UnaryExpr>(expr)->right);
+        case ExprType::CALL: {
+            size_t count = 1;
+            for (const auto& argument : std::static_pointer_cast<CallExpr>(expr)->arguments) {
+                count += countNodes(argument);
+            }
+            return count;
+        }
+        case ExprType::ASSIGNMENT:
+            return 1 + countNodes(std::static_pointer_cast<AssignmentExpr>(expr)->value);
+        default:
+            return 1;
+    }
+}
+
+// Finds the variables that are declared once and never assigned; only
+// those can be replaced by their initializer
+void ConstantFolder::collect(const StmtPtr& stmt) {
+    if (!stmt) return;
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            collect(std::static_pointer_cast<ExpressionStmt>(stmt)->expression);
+            break;
+        case StmtType::PRINT:
+            for (const auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                collect(expr);
+            }
+            break;
+        case StmtType::VARIABLE_DECL: {
+            auto decl = std::static_pointer_cast<VariableDeclStmt>(stmt);
+            declarations[std::string(decl->name.lexeme)]++;
+            collect(decl->initializer);
+            break;
+        }
+        case StmtType::BLOCK:
+            for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                collect(inner);
+            }
+            break;
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            collect(ifStmt->condition);
+            collect(ifStmt->thenBranch);
+            collect(ifStmt->elseBranch);
+            break;
+        }
+        case StmtType::WHILE: {
+            auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+            collect(whileStmt->condition);
+            collect(whileStmt->body);
+            break;
+        }
+        case StmtType::FUNCTION_DECL:
+            collect(std::static_pointer_cast<FunctionDeclStmt>(stmt)->body);
+            break;
+        case StmtType::RETURN:
+            collect(std::static_pointer_cast<ReturnStmt>(stmt)->value);
+            break;
+    }
+}
+
+void ConstantFolder::collect(const ExprPtr& expr) {
+    if (!expr) return;
+    switch (expr->getType()) {
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            collect(binary->left);
+            collect(binary->right);
+            break;
+        }
+        case ExprType::UNARY:
+            collect(std::static_pointer_cast<UnaryExpr>(expr)->right);
+            break;
+        case ExprType::CALL:
+            for (const auto& argument : std::static_pointer_cast<CallExpr>(expr)->arguments) {
+                collect(argument);
+            }
+            break;
+        case ExprType::ASSIGNMENT: {
+            auto assignment = std::static_pointer_cast<AssignmentExpr>(expr);
+            assigned.insert(std::string(assignment->name.lexeme));
+            collect(assignment->value);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+const Value* ConstantFolder::lookup(const std::string& name) const {
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+        auto it = scope->find(name);
+        if (it != scope->end()) {
+            return it->second;
+        }
+    }
+    return nullptr;
+}
+
+void ConstantFolder::replace(ExprPtr& expr, const Value& value) {
+    stats.foldedExpressions++;
+    stats.nodesEliminated += countNodes(expr) - 1;
+    expr = std::make_shared<LiteralExpr>(value);
+}
+
+void ConstantFolder::foldExpr(ExprPtr& expr) {
+    if (!expr) return;
+    switch (expr->getType()) {
+        case ExprType::VARIABLE: {
+            const Value* value = lookup(std::string(std::static_pointer_cast<VariableExpr>(expr)->name.lexeme));
+            if (value) {
+                stats.propagatedConstants++;
+                expr = std::make_shared<LiteralExpr>(*value);
+            }
+            break;
+        }
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            foldExpr(binary->left);
+            foldExpr(binary->right);
+            if (binary->left->getType() != ExprType::LITERAL || binary->right->getType() != ExprType::LITERAL) {
+                break;
+            }
+            Value result;
+            if (evaluateBinary(binary->op.type,
+                               std::static_pointer_cast<LiteralExpr>(binary->left)->value,
+                               std::static_pointer_cast<LiteralExpr>(binary->right)->value, result)) {
+                replace(expr, result);
+            }
+            break;
+        }
+        case ExprType::UNARY: {
+            auto unary = std::static_pointer_cast<UnaryExpr>(expr);
+            foldExpr(unary->right);
+            if (unary->right->getType() != ExprType::LITERAL) {
+                break;
+            }
+            Value result;
+            if (evaluateUnary(unary->op.type, std::static_pointer_cast<LiteralExpr>(unary->right)->value, result)) {
+                replace(expr, result);
+            }
+            break;
+        }
+        case ExprType::CALL:
+            for (auto& argument : std::static_pointer_cast<CallExpr>(expr)->arguments) {
+                foldExpr(argument);
+            }
+            break;
+        case ExprType::ASSIGNMENT:
+            foldExpr(std::static_pointer_cast<AssignmentExpr>(expr)->value);
+            break;
+        default:
+            break;
+    }
+}
+
+void ConstantFolder::foldStatements(const std::vector<StmtPtr>& statements) {
+    for (const auto& stmt : statements) {
+        foldStmt(stmt);
+    }
+}
+
+void ConstantFolder::foldStmt(const StmtPtr& stmt) {
+    if (!stmt) return;
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            foldExpr(std::static_pointer_cast<ExpressionStmt>(stmt)->expression);
+            break;
+        case StmtType::PRINT:
+            for (auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                foldExpr(expr);
+            }
+            break;
+        case StmtType::VARIABLE_DECL: {
+            auto decl = std::static_pointer_cast<VariableDeclStmt>(stmt);
+            foldExpr(decl->initializer);
+            std::string name(decl->name.lexeme);
+            bool constant = decl->initializer && decl->initializer->getType() == ExprType::LITERAL &&
+                            declarations[name] == 1 && !assigned.count(name);
+            // The declaration stays; a non-constant one hides outer constants
+            scopes.back()[name] = constant ? &std::static_pointer_cast<LiteralExpr>(decl->initializer)->value
+                                           : nullptr;
+            break;
+        }
+        case StmtType::BLOCK:
+            scopes.emplace_back();
+            foldStatements(std::static_pointer_cast<BlockStmt>(stmt)->statements);
+            scopes.pop_back();
+            break;
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            foldExpr(ifStmt->condition);
+            foldStmt(ifStmt->thenBranch);
+            foldStmt(ifStmt->elseBranch);
+            break;
+        }
+        case StmtType::WHILE: {
+            auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+            foldExpr(whileStmt->condition);
+            foldStmt(whileStmt->body);
+            break;
+        }
+        case StmtType::FUNCTION_DECL: {
+            // Functions run later against the global environment, so
+            // top-level constants are not visible in their bodies
+            auto function = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+            auto outer = std::move(scopes);
+            scopes.clear();
+            scopes.emplace_back();
+            for (const auto& param : function->parameters) {
+                scopes.back()[std::string(param.first.lexeme)] = nullptr;
+            }
+            foldStmt(function->body);
+            scopes = std::move(outer);
+            break;
+        }
+        case StmtType::RETURN:
+            foldExpr(std::static_pointer_cast<ReturnStmt>(stmt)->value);
+            break;
+    }
+}
+
+size_t ConstantFolder::run(const ProgramPtr& program) {
+    stats = Stats();
+    assigned.clear();
+    declarations.clear();
+    scopes.clear();
+
+    for (const auto& stmt : program->statements) {
+        collect(stmt);
+    }
+
+    scopes.emplace_back();
+    foldStatements(program->statements);
+    scopes.clear();
+    return stats.nodesEliminated;
+}
+
+std::string ConstantFolder::report() const {
+    std::ostringstream out;
+    out << "Constant folding: " << stats.foldedExpressions << " expressions folded, "
+        << stats.propagatedConstants << " constants propagated, "
+        << stats.nodesEliminated << " nodes eliminated";
+    return out.str();
+}
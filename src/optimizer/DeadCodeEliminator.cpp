@@ -0,0 +1,261 @@
+#include "DeadCodeEliminator.h"
+#include "ConstantFolder.h"
+#include <sstream>
+
+size_t DeadCodeEliminator::countNodes(const StmtPtr& stmt) {
+    if (!stmt) return 0;
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            return 1 + ConstantFolder::countNodes(std::static_pointer_cast<ExpressionStmt>(stmt)->expression);
+        case StmtType::PRINT: {
+            size_t count = 1;
+            for (const auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                count += ConstantFolder::countNodes(expr);
+            }
+            return count;
+        }
+        case StmtType::VARIABLE_DECL:
+            return 1 + ConstantFolder::countNodes(std::static_pointer_cast<VariableDeclStmt>(stmt)->initializer);
+        case StmtType::BLOCK: {
+            size_t count = 1;
+            for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                count += countNodes(inner);
+            }
+            return count;
+        }
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            return 1 + ConstantFolder::countNodes(ifStmt->condition) + countNodes(ifStmt->thenBranch) +
+                   countNodes(ifStmt->elseBranch);
+        }
+        case StmtType::WHILE: {
+            auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+            return 1 + ConstantFolder::countNodes(whileStmt->condition) + countNodes(whileStmt->body);
+        }
+        case StmtType::FUNCTION_DECL:
+            return 1 + countNodes(std::static_pointer_cast<FunctionDeclStmt>(stmt)->body);
+        case StmtType::RETURN:
+            return 1 + ConstantFolder::countNodes(std::static_pointer_cast<ReturnStmt>(stmt)->value);
+    }
+    return 1;
+}
+
+// A return on every path through the statement
+bool DeadCodeEliminator::alwaysReturns(const StmtPtr& stmt) {
+    if (!stmt) return false;
+    switch (stmt->getType()) {
+        case StmtType::RETURN:
+            return true;
+        case StmtType::BLOCK:
+            for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                if (alwaysReturns(inner)) return true;
+            }
+            return false;
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            return alwaysReturns(ifStmt->thenBranch) && alwaysReturns(ifStmt->elseBranch);
+        }
+        default:
+            return false;
+    }
+}
+
+void DeadCodeEliminator::collect(const StmtPtr& stmt) {
+    if (!stmt) return;
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            collect(std::static_pointer_cast<ExpressionStmt>(stmt)->expression, true);
+            break;
+        case StmtType::PRINT:
+            for (const auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                collect(expr, false);
+            }
+            break;
+        case StmtType::VARIABLE_DECL:
+            collect(std::static_pointer_cast<VariableDeclStmt>(stmt)->initializer, false);
+            break;
+        case StmtType::BLOCK:
+            for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                collect(inner);
+            }
+            break;
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            collect(ifStmt->condition, false);
+            collect(ifStmt->thenBranch);
+            collect(ifStmt->elseBranch);
+            break;
+        }
+        case StmtType::WHILE: {
+            auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+            collect(whileStmt->condition, false);
+            collect(whileStmt->body);
+            break;
+        }
+        case StmtType::FUNCTION_DECL:
+            collect(std::static_pointer_cast<FunctionDeclStmt>(stmt)->body);
+            break;
+        case StmtType::RETURN:
+            collect(std::static_pointer_cast<ReturnStmt>(stmt)->value, false);
+            break;
+    }
+}
+
+void DeadCodeEliminator::collect(const ExprPtr& expr, bool statementLevel) {
+    if (!expr) return;
+    switch (expr->getType()) {
+        case ExprType::VARIABLE:
+            reads.insert(std::string(std::static_pointer_cast<VariableExpr>(expr)->name.lexeme));
+            break;
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            collect(binary->left, false);
+            collect(binary->right, false);
+            break;
+        }
+        case ExprType::UNARY:
+            collect(std::static_pointer_cast<UnaryExpr>(expr)->right, false);
+            break;
+        case ExprType::CALL: {
+            // Calls look the callee up like any other variable
+            auto call = std::static_pointer_cast<CallExpr>(expr);
+            reads.insert(std::string(call->callee.lexeme));
+            for (const auto& argument : call->arguments) {
+                collect(argument, false);
+            }
+            break;
+        }
+        case ExprType::ASSIGNMENT: {
+            auto assignment = std::static_pointer_cast<AssignmentExpr>(expr);
+            if (!statementLevel) {
+                nestedAssignments.insert(std::string(assignment->name.lexeme));
+            }
+            collect(assignment->value, false);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+bool DeadCodeEliminator::isDeadStore(const std::string& name) const {
+    return removeDeadStores && !reads.count(name) && !nestedAssignments.count(name);
+}
+
+// The replacement for a statement; nullptr when it can be dropped
+StmtPtr DeadCodeEliminator::eliminate(const StmtPtr& stmt) {
+    if (!stmt) return nullptr;
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION: {
+            ExprPtr expr = std::static_pointer_cast<ExpressionStmt>(stmt)->expression;
+            if (expr->getType() == ExprType::ASSIGNMENT) {
+                auto assignment = std::static_pointer_cast<AssignmentExpr>(expr);
+                if (!isDeadStore(std::string(assignment->name.lexeme))) return stmt;
+                // The value is still computed for its side effects and errors
+                stats.deadStores++;
+                expr = assignment->value;
+                if (expr->getType() != ExprType::LITERAL) {
+                    return std::make_shared<ExpressionStmt>(expr);
+                }
+            }
+            return expr->getType() == ExprType::LITERAL ? nullptr : stmt;
+        }
+        case StmtType::VARIABLE_DECL: {
+            auto decl = std::static_pointer_cast<VariableDeclStmt>(stmt);
+            if (!isDeadStore(std::string(decl->name.lexeme))) return stmt;
+            stats.deadStores++;
+            if (decl->initializer && decl->initializer->getType() != ExprType::LITERAL) {
+                return std::make_shared<ExpressionStmt>(decl->initializer);
+            }
+            return nullptr;
+        }
+        case StmtType::BLOCK:
+            eliminateStatements(std::static_pointer_cast<BlockStmt>(stmt)->statements);
+            return stmt;
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            if (ifStmt->condition->getType() == ExprType::LITERAL) {
+                stats.constantBranches++;
+                bool taken = ConstantFolder::isTruthy(std::static_pointer_cast<LiteralExpr>(ifStmt->condition)->value);
+                return eliminate(taken ? ifStmt->thenBranch : ifStmt->elseBranch);
+            }
+            ifStmt->thenBranch = eliminateBranch(ifStmt->thenBranch);
+            ifStmt->elseBranch = eliminate(ifStmt->elseBranch);
+            return stmt;
+        }
+        case StmtType::WHILE: {
+            auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+            if (whileStmt->condition->getType() == ExprType::LITERAL &&
+                !ConstantFolder::isTruthy(std::static_pointer_cast<LiteralExpr>(whileStmt->condition)->value)) {
+                stats.constantBranches++;
+                return nullptr;
+            }
+            whileStmt->body = eliminateBranch(whileStmt->body);
+            return stmt;
+        }
+        case StmtType::FUNCTION_DECL: {
+            auto function = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+            functionDepth++;
+            function->body = eliminateBranch(function->body);
+            functionDepth--;
+            return stmt;
+        }
+        default:
+            return stmt;
+    }
+}
+
+// Statements that must stay in place (if/while bodies) become empty blocks
+StmtPtr DeadCodeEliminator::eliminateBranch(const StmtPtr& stmt) {
+    StmtPtr result = eliminate(stmt);
+    return result ? result : std::make_shared<BlockStmt>(std::vector<StmtPtr>());
+}
+
+void DeadCodeEliminator::eliminateStatements(std::vector<StmtPtr>& statements) {
+    std::vector<StmtPtr> kept;
+    for (size_t i = 0; i < statements.size(); i++) {
+        StmtPtr stmt = eliminate(statements[i]);
+        if (!stmt) continue;
+        if (stmt->getType() == StmtType::BLOCK && std::static_pointer_cast<BlockStmt>(stmt)->statements.empty()) {
+            continue;
+        }
+        kept.push_back(stmt);
+
+        if (functionDepth > 0 && alwaysReturns(stmt)) {
+            stats.unreachableStatements += statements.size() - i - 1;
+            break;
+        }
+    }
+    statements = std::move(kept);
+}
+
+size_t DeadCodeEliminator::run(const ProgramPtr& program) {
+    stats = Stats();
+    functionDepth = 0;
+    reads.clear();
+    nestedAssignments.clear();
+
+    size_t before = 0;
+    for (const auto& stmt : program->statements) {
+        before += countNodes(stmt);
+        collect(stmt);
+    }
+
+    eliminateStatements(program->statements);
+
+    size_t after = 0;
+    for (const auto& stmt : program->statements) {
+        after += countNodes(stmt);
+    }
+    stats.nodesEliminated = before - after;
+    return stats.nodesEliminated;
+}
+
+std::string DeadCodeEliminator::report() const {
+    std::ostringstream out;
+    out << "Dead code: " << stats.unreachableStatements << " unreachable statements, "
+        << stats.constantBranches << " constant branches, "
+        << stats.deadStores << " dead stores removed, "
+        << stats.nodesEliminated << " nodes eliminated";
+    return out.str();
+}
@@ -0,0 +1,390 @@
+#include "InductionVariables.h"
+#include <climits>
+#include <sstream>
+
+namespace {
+    using Kind = ValueKinds::Kind;
+
+    int lineOf(const ExprPtr& expr) {
+        switch (expr->getType()) {
+            case ExprType::VARIABLE: return std::static_pointer_cast<VariableExpr>(expr)->name.line();
+            case ExprType::BINARY: return std::static_pointer_cast<BinaryExpr>(expr)->op.line();
+            case ExprType::UNARY: return std::static_pointer_cast<UnaryExpr>(expr)->op.line();
+            case ExprType::CALL: return std::static_pointer_cast<CallExpr>(expr)->callee.line();
+            case ExprType::ASSIGNMENT: return std::static_pointer_cast<AssignmentExpr>(expr)->name.line();
+            default: return 0;
+        }
+    }
+
+    bool isIntLiteral(const ExprPtr& expr, int& value) {
+        if (expr->getType() != ExprType::LITERAL) return false;
+        const Value& literal = std::static_pointer_cast<LiteralExpr>(expr)->value;
+        if (!std::holds_alternative<int>(literal)) return false;
+        value = std::get<int>(literal);
+        return true;
+    }
+
+    bool isVariable(const ExprPtr& expr, const std::string& name) {
+        return expr->getType() == ExprType::VARIABLE &&
+               std::static_pointer_cast<VariableExpr>(expr)->name.lexeme == name;
+    }
+
+    // Integer arithmetic wraps in both engines
+    int wrappingMultiply(int a, int b) {
+        return static_cast<int>(static_cast<unsigned>(a) * static_cast<unsigned>(b));
+    }
+
+    int wrappingNegate(int a) {
+        return static_cast<int>(0u - static_cast<unsigned>(a));
+    }
+
+    Token makeToken(TokenType type, const std::string& lexeme, int line) {
+        return Token(type, lexeme, line, 0);
+    }
+}
+
+bool InductionVariables::isDeclared(const std::string& name) const {
+    for (const auto& scope : scopes) {
+        if (scope.count(name)) return true;
+    }
+    return false;
+}
+
+bool InductionVariables::isInvariant(const ExprPtr& expr, const std::unordered_set<std::string>& defined) const {
+    switch (expr->getType()) {
+        case ExprType::LITERAL:
+            return true;
+        case ExprType::VARIABLE: {
+            std::string name(std::static_pointer_cast<VariableExpr>(expr)->name.lexeme);
+            return !defined.count(name) && isDeclared(name);
+        }
+        case ExprType::UNARY:
+            return isInvariant(std::static_pointer_cast<UnaryExpr>(expr)->right, defined);
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            return isInvariant(binary->left, defined) && isInvariant(binary->right, defined);
+        }
+        default:
+            return false;
+    }
+}
+
+std::vector<InductionVariables::Induction> InductionVariables::findInductions(
+        const std::shared_ptr<WhileStmt>& loop) {
+    std::vector<Induction> inductions;
+    if (loop->body->getType() != StmtType::BLOCK) return inductions;
+    const auto& statements = std::static_pointer_cast<BlockStmt>(loop->body)->statements;
+
+    for (size_t index = 0; index < statements.size(); index++) {
+        if (statements[index]->getType() != StmtType::EXPRESSION) continue;
+        ExprPtr expr = std::static_pointer_cast<ExpressionStmt>(statements[index])->expression;
+        if (expr->getType() != ExprType::ASSIGNMENT) continue;
+        auto assignment = std::static_pointer_cast<AssignmentExpr>(expr);
+        std::string name(assignment->name.lexeme);
+        if (assignment->value->getType() != ExprType::BINARY) continue;
+
+        // i = i + c, i = c + i or i = i - c
+        auto update = std::static_pointer_cast<BinaryExpr>(assignment->value);
+        int step;
+        bool matched = update->op.type == TokenType::PLUS &&
+                       ((isVariable(update->left, name) && isIntLiteral(update->right, step)) ||
+                        (isVariable(update->right, name) && isIntLiteral(update->left, step)));
+        if (!matched && update->op.type == TokenType::MINUS && isVariable(update->left, name) &&
+            isIntLiteral(update->right, step)) {
+            step = wrappingNegate(step);
+            matched = true;
+        }
+        if (!matched || !isDeclared(name) ||
+            kinds.kindOf(std::make_shared<VariableExpr>(assignment->name)) != Kind::INT) {
+            continue;
+        }
+
+        // Nothing else in the loop may change it, directly or through a call
+        std::vector<StmtPtr> others;
+        for (size_t other = 0; other < statements.size(); other++) {
+            if (other != index) others.push_back(statements[other]);
+        }
+        std::unordered_set<std::string> writes;
+        if (!effects.collectWrites(loop->condition, writes) ||
+            !effects.collectWrites(std::make_shared<BlockStmt>(others), writes) ||
+            writes.count(name)) {
+            continue;
+        }
+        inductions.push_back({name, step, index, {}});
+    }
+    return inductions;
+}
+
+void InductionVariables::reduce(ExprPtr& expr, std::vector<Induction>& inductions, LoopInfo& info) {
+    if (!expr) return;
+    switch (expr->getType()) {
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            if (binary->op.type == TokenType::MULTIPLY) {
+                int factor;
+                ExprPtr variable;
+                if (isIntLiteral(binary->right, factor)) variable = binary->left;
+                else if (isIntLiteral(binary->left, factor)) variable = binary->right;
+
+                for (auto& induction : inductions) {
+                    if (!variable || !isVariable(variable, induction.name)) continue;
+                    std::string& name = induction.derived[factor];
+                    if (name.empty()) {
+                        name = "$iv" + std::to_string(nextTemporary++);
+                        kinds.set(name, Kind::INT);
+                    }
+                    expr = std::make_shared<VariableExpr>(
+                        makeToken(TokenType::IDENTIFIER, name, binary->op.line()));
+                    info.reduced++;
+                    stats.multiplicationsReduced++;
+                    return;
+                }
+            }
+            reduce(binary->left, inductions, info);
+            reduce(binary->right, inductions, info);
+            break;
+        }
+        case ExprType::UNARY:
+            reduce(std::static_pointer_cast<UnaryExpr>(expr)->right, inductions, info);
+            break;
+        case ExprType::CALL:
+            for (auto& argument : std::static_pointer_cast<CallExpr>(expr)->arguments) {
+                reduce(argument, inductions, info);
+            }
+            break;
+        case ExprType::ASSIGNMENT:
+            reduce(std::static_pointer_cast<AssignmentExpr>(expr)->value, inductions, info);
+            break;
+        default:
+            break;
+    }
+}
+
+void InductionVariables::reduceInStmt(const StmtPtr& stmt, std::vector<Induction>& inductions, LoopInfo& info) {
+    if (!stmt) return;
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            reduce(std::static_pointer_cast<ExpressionStmt>(stmt)->expression, inductions, info);
+            break;
+        case StmtType::PRINT:
+            for (auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                reduce(expr, inductions, info);
+            }
+            break;
+        case StmtType::VARIABLE_DECL:
+            reduce(std::static_pointer_cast<VariableDeclStmt>(stmt)->initializer, inductions, info);
+            break;
+        case StmtType::BLOCK:
+            for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                reduceInStmt(inner, inductions, info);
+            }
+            break;
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            reduce(ifStmt->condition, inductions, info);
+            reduceInStmt(ifStmt->thenBranch, inductions, info);
+            reduceInStmt(ifStmt->elseBranch, inductions, info);
+            break;
+        }
+        case StmtType::WHILE: {
+            auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+            reduce(whileStmt->condition, inductions, info);
+            reduceInStmt(whileStmt->body, inductions, info);
+            break;
+        }
+        case StmtType::RETURN:
+            reduce(std::static_pointer_cast<ReturnStmt>(stmt)->value, inductions, info);
+            break;
+        default:
+            break;
+    }
+}
+
+void InductionVariables::normalizeExitTest(const std::shared_ptr<WhileStmt>& loop,
+                                           const std::vector<Induction>& inductions,
+                                           const std::unordered_set<std::string>& defined, LoopInfo& info) {
+    if (loop->condition->getType() != ExprType::BINARY || !kinds.cannotTrap(loop->condition)) return;
+    auto test = std::static_pointer_cast<BinaryExpr>(loop->condition);
+    TokenType op = test->op.type;
+    if (op != TokenType::LESS && op != TokenType::LESS_EQUAL &&
+        op != TokenType::GREATER && op != TokenType::GREATER_EQUAL) {
+        return;
+    }
+
+    auto inductionOf = [&](const ExprPtr& expr) -> const Induction* {
+        for (const auto& induction : inductions) {
+            if (isVariable(expr, induction.name)) return &induction;
+        }
+        return nullptr;
+    };
+
+    // bound < i becomes i > bound; neither side can fail, so the order
+    // they are evaluated in does not matter
+    const Induction* counter = inductionOf(test->left);
+    if (!counter && inductionOf(test->right) && isInvariant(test->left, defined)) {
+        counter = inductionOf(test->right);
+        std::swap(test->left, test->right);
+        switch (op) {
+            case TokenType::LESS: test->op = makeToken(TokenType::GREATER, ">", test->op.line()); break;
+            case TokenType::LESS_EQUAL: test->op = makeToken(TokenType::GREATER_EQUAL, ">=", test->op.line()); break;
+            case TokenType::GREATER: test->op = makeToken(TokenType::LESS, "<", test->op.line()); break;
+            default: test->op = makeToken(TokenType::LESS_EQUAL, "<=", test->op.line()); break;
+        }
+        info.normalized = true;
+    }
+    if (!counter || !isInvariant(test->right, defined)) return;
+
+    // Inclusive bounds become exclusive when the limit is a constant that
+    // can be moved by one without wrapping
+    int bound;
+    if (isIntLiteral(test->right, bound)) {
+        if (test->op.type == TokenType::LESS_EQUAL && bound != INT_MAX) {
+            test->op = makeToken(TokenType::LESS, "<", test->op.line());
+            test->right = std::make_shared<LiteralExpr>(bound + 1);
+            info.normalized = true;
+        } else if (test->op.type == TokenType::GREATER_EQUAL && bound != INT_MIN) {
+            test->op = makeToken(TokenType::GREATER, ">", test->op.line());
+            test->right = std::make_shared<LiteralExpr>(bound - 1);
+            info.normalized = true;
+        }
+    }
+    if (kinds.kindOf(test->right) == Kind::INT &&
+        ((test->op.type == TokenType::LESS && counter->step > 0) ||
+         (test->op.type == TokenType::GREATER && counter->step < 0))) {
+        info.counter = counter->name;
+        info.step = counter->step;
+        info.bound = test->right;
+        stats.countedLoops++;
+    }
+}
+
+// Returns the declarations to place before the loop
+std::vector<StmtPtr> InductionVariables::processLoop(const std::shared_ptr<WhileStmt>& loop) {
+    process(loop->body);
+
+    LoopInfo info{lineOf(loop->condition), {}, "", 0, nullptr, 0, false};
+    std::vector<StmtPtr> preheader;
+    std::unordered_set<std::string> defined;
+    bool opaque = !effects.collectWrites(loop->condition, defined) ||
+                  !effects.collectWrites(loop->body, defined);
+
+    std::vector<Induction> inductions;
+    if (!opaque) inductions = findInductions(loop);
+    for (const auto& induction : inductions) {
+        info.inductionVariables.push_back(induction.name);
+    }
+    stats.inductionVariables += inductions.size();
+
+    if (!inductions.empty()) {
+        reduce(loop->condition, inductions, info);
+        reduceInStmt(loop->body, inductions, info);
+
+        // Each $iv starts at i * k and moves by step * k right after i does
+        auto& statements = std::static_pointer_cast<BlockStmt>(loop->body)->statements;
+        std::vector<StmtPtr> result;
+        for (size_t index = 0; index < statements.size(); index++) {
+            result.push_back(statements[index]);
+            for (const auto& induction : inductions) {
+                if (induction.update != index) continue;
+                for (const auto& [factor, name] : induction.derived) {
+                    Token token = makeToken(TokenType::IDENTIFIER, name, info.line);
+                    preheader.push_back(std::make_shared<VariableDeclStmt>(token, std::make_shared<BinaryExpr>(
+                        std::make_shared<VariableExpr>(makeToken(TokenType::IDENTIFIER, induction.name, info.line)),
+                        makeToken(TokenType::MULTIPLY, "*", info.line),
+                        std::make_shared<LiteralExpr>(factor))));
+                    result.push_back(std::make_shared<ExpressionStmt>(std::make_shared<AssignmentExpr>(
+                        token, std::make_shared<BinaryExpr>(
+                            std::make_shared<VariableExpr>(token), makeToken(TokenType::PLUS, "+", info.line),
+                            std::make_shared<LiteralExpr>(wrappingMultiply(induction.step, factor))))));
+                }
+            }
+        }
+        statements = std::move(result);
+
+        normalizeExitTest(loop, inductions, defined, info);
+        if (info.normalized) stats.exitTestsNormalized++;
+    }
+
+    stats.loops++;
+    loops.push_back(std::move(info));
+    return preheader;
+}
+
+void InductionVariables::process(StmtPtr& stmt) {
+    if (!stmt) return;
+    switch (stmt->getType()) {
+        case StmtType::VARIABLE_DECL:
+            scopes.back().insert(std::string(std::static_pointer_cast<VariableDeclStmt>(stmt)->name.lexeme));
+            break;
+        case StmtType::BLOCK:
+            scopes.emplace_back();
+            processStatements(std::static_pointer_cast<BlockStmt>(stmt)->statements);
+            scopes.pop_back();
+            break;
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            process(ifStmt->thenBranch);
+            process(ifStmt->elseBranch);
+            break;
+        }
+        case StmtType::WHILE: {
+            std::vector<StmtPtr> preheader = processLoop(std::static_pointer_cast<WhileStmt>(stmt));
+            if (!preheader.empty()) {
+                preheader.push_back(stmt);
+                stmt = std::make_shared<BlockStmt>(preheader);
+            }
+            break;
+        }
+        case StmtType::FUNCTION_DECL: {
+            auto function = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+            auto outer = std::move(scopes);
+            scopes.clear();
+            scopes.emplace_back();
+            for (const auto& param : function->parameters) {
+                scopes.back().insert(std::string(param.first.lexeme));
+            }
+            process(function->body);
+            scopes = std::move(outer);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void InductionVariables::processStatements(std::vector<StmtPtr>& statements) {
+    std::vector<StmtPtr> result;
+    for (auto& stmt : statements) {
+        if (stmt->getType() == StmtType::WHILE) {
+            for (auto& decl : processLoop(std::static_pointer_cast<WhileStmt>(stmt))) {
+                scopes.back().insert(std::string(std::static_pointer_cast<VariableDeclStmt>(decl)->name.lexeme));
+                result.push_back(decl);
+            }
+        } else {
+            process(stmt);
+        }
+        result.push_back(stmt);
+    }
+    statements = std::move(result);
+}
+
+size_t InductionVariables::run(const ProgramPtr& program) {
+    stats = Stats();
+    loops.clear();
+    effects.analyze(program);
+    kinds.infer(program);
+
+    scopes.clear();
+    scopes.emplace_back();
+    processStatements(program->statements);
+    scopes.clear();
+    return stats.multiplicationsReduced;
+}
+
+std::string InductionVariables::report() const {
+    std::ostringstream out;
+    out << "Induction variables: " << stats.inductionVariables << " found in " << stats.loops << " loops, "
+        << stats.multiplicationsReduced << " multiplications reduced, " << stats.exitTestsNormalized
+        << " exit tests normalized, " << stats.countedLoops << " counted loops";
+    return out.str();
+}
@@ -0,0 +1,702 @@
+#include "Inliner.h"
+#include "DeadCodeEliminator.h"
+#include <sstream>
+
+namespace {
+    // Names a function body declares and uses, and where it returns
+    struct BodyShape {
+        std::unordered_set<std::string> declared;
+        std::unordered_set<std::string> used;
+        size_t returns = 0;
+        bool nestedFunction = false;
+    };
+
+    void scan(const ExprPtr& expr, BodyShape& shape) {
+        if (!expr) return;
+        switch (expr->getType()) {
+            case ExprType::VARIABLE:
+                shape.used.insert(std::string(std::static_pointer_cast<VariableExpr>(expr)->name.lexeme));
+                break;
+            case ExprType::BINARY: {
+                auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+                scan(binary->left, shape);
+                scan(binary->right, shape);
+                break;
+            }
+            case ExprType::UNARY:
+                scan(std::static_pointer_cast<UnaryExpr>(expr)->right, shape);
+                break;
+            case ExprType::CALL: {
+                auto call = std::static_pointer_cast<CallExpr>(expr);
+                shape.used.insert(std::string(call->callee.lexeme));
+                for (const auto& argument : call->arguments) {
+                    scan(argument, shape);
+                }
+                break;
+            }
+            case ExprType::ASSIGNMENT: {
+                auto assignment = std::static_pointer_cast<AssignmentExpr>(expr);
+                shape.used.insert(std::string(assignment->name.lexeme));
+                scan(assignment->value, shape);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void scan(const StmtPtr& stmt, BodyShape& shape) {
+        if (!stmt) return;
+        switch (stmt->getType()) {
+            case StmtType::EXPRESSION:
+                scan(std::static_pointer_cast<ExpressionStmt>(stmt)->expression, shape);
+                break;
+            case StmtType::PRINT:
+                for (const auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                    scan(expr, shape);
+                }
+                break;
+            case StmtType::VARIABLE_DECL: {
+                auto decl = std::static_pointer_cast<VariableDeclStmt>(stmt);
+                shape.declared.insert(std::string(decl->name.lexeme));
+                scan(decl->initializer, shape);
+                break;
+            }
+            case StmtType::BLOCK:
+                for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                    scan(inner, shape);
+                }
+                break;
+            case StmtType::IF: {
+                auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+                scan(ifStmt->condition, shape);
+                scan(ifStmt->thenBranch, shape);
+                scan(ifStmt->elseBranch, shape);
+                break;
+            }
+            case StmtType::WHILE: {
+                auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+                scan(whileStmt->condition, shape);
+                scan(whileStmt->body, shape);
+                break;
+            }
+            case StmtType::FUNCTION_DECL:
+                shape.nestedFunction = true;
+                break;
+            case StmtType::RETURN:
+                shape.returns++;
+                scan(std::static_pointer_cast<ReturnStmt>(stmt)->value, shape);
+                break;
+        }
+    }
+
+    bool hasCallOrStore(const ExprPtr& expr) {
+        switch (expr->getType()) {
+            case ExprType::CALL:
+            case ExprType::ASSIGNMENT:
+                return true;
+            case ExprType::BINARY: {
+                auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+                return hasCallOrStore(binary->left) || hasCallOrStore(binary->right);
+            }
+            case ExprType::UNARY:
+                return hasCallOrStore(std::static_pointer_cast<UnaryExpr>(expr)->right);
+            default:
+                return false;
+        }
+    }
+
+    bool isSimple(const ExprPtr& expr) {
+        return expr->getType() == ExprType::LITERAL || expr->getType() == ExprType::VARIABLE;
+    }
+
+    // Every name a variable or parameter takes anywhere in the program
+    void collectVariableNames(const StmtPtr& stmt, std::unordered_set<std::string>& names) {
+        BodyShape shape;
+        scan(stmt, shape);
+        names.insert(shape.declared.begin(), shape.declared.end());
+        if (!stmt) return;
+        switch (stmt->getType()) {
+            case StmtType::EXPRESSION:
+            case StmtType::PRINT:
+            case StmtType::VARIABLE_DECL:
+            case StmtType::RETURN:
+                break;
+            case StmtType::BLOCK:
+                for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                    collectVariableNames(inner, names);
+                }
+                break;
+            case StmtType::IF: {
+                auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+                collectVariableNames(ifStmt->thenBranch, names);
+                collectVariableNames(ifStmt->elseBranch, names);
+                break;
+            }
+            case StmtType::WHILE:
+                collectVariableNames(std::static_pointer_cast<WhileStmt>(stmt)->body, names);
+                break;
+            case StmtType::FUNCTION_DECL: {
+                auto function = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+                for (const auto& param : function->parameters) {
+                    names.insert(std::string(param.first.lexeme));
+                }
+                collectVariableNames(function->body, names);
+                break;
+            }
+        }
+    }
+
+    // Names assigned anywhere
+    void collectAssigned(const ExprPtr& expr, std::unordered_set<std::string>& names) {
+        if (!expr) return;
+        switch (expr->getType()) {
+            case ExprType::BINARY: {
+                auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+                collectAssigned(binary->left, names);
+                collectAssigned(binary->right, names);
+                break;
+            }
+            case ExprType::UNARY:
+                collectAssigned(std::static_pointer_cast<UnaryExpr>(expr)->right, names);
+                break;
+            case ExprType::CALL:
+                for (const auto& argument : std::static_pointer_cast<CallExpr>(expr)->arguments) {
+                    collectAssigned(argument, names);
+                }
+                break;
+            case ExprType::ASSIGNMENT: {
+                auto assignment = std::static_pointer_cast<AssignmentExpr>(expr);
+                names.insert(std::string(assignment->name.lexeme));
+                collectAssigned(assignment->value, names);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void collectAssigned(const StmtPtr& stmt, std::unordered_set<std::string>& names) {
+        if (!stmt) return;
+        switch (stmt->getType()) {
+            case StmtType::EXPRESSION:
+                collectAssigned(std::static_pointer_cast<ExpressionStmt>(stmt)->expression, names);
+                break;
+            case StmtType::PRINT:
+                for (const auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                    collectAssigned(expr, names);
+                }
+                break;
+            case StmtType::VARIABLE_DECL:
+                collectAssigned(std::static_pointer_cast<VariableDeclStmt>(stmt)->initializer, names);
+                break;
+            case StmtType::BLOCK:
+                for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                    collectAssigned(inner, names);
+                }
+                break;
+            case StmtType::IF: {
+                auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+                collectAssigned(ifStmt->condition, names);
+                collectAssigned(ifStmt->thenBranch, names);
+                collectAssigned(ifStmt->elseBranch, names);
+                break;
+            }
+            case StmtType::WHILE: {
+                auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+                collectAssigned(whileStmt->condition, names);
+                collectAssigned(whileStmt->body, names);
+                break;
+            }
+            case StmtType::FUNCTION_DECL:
+                collectAssigned(std::static_pointer_cast<FunctionDeclStmt>(stmt)->body, names);
+                break;
+            case StmtType::RETURN:
+                collectAssigned(std::static_pointer_cast<ReturnStmt>(stmt)->value, names);
+                break;
+        }
+    }
+}
+
+ExprPtr Inliner::clone(const ExprPtr& expr, const std::unordered_map<std::string, std::string>& renames,
+                       const std::unordered_map<std::string, ExprPtr>& values) {
+    if (!expr) return nullptr;
+    auto rename = [&](Token token) {
+        auto it = renames.find(std::string(token.lexeme));
+        if (it != renames.end()) token = Token(token.type, it->second, token.line(), token.column());
+        return token;
+    };
+
+    switch (expr->getType()) {
+        case ExprType::LITERAL:
+            return std::make_shared<LiteralExpr>(std::static_pointer_cast<LiteralExpr>(expr)->value);
+        case ExprType::VARIABLE: {
+            const Token& name = std::static_pointer_cast<VariableExpr>(expr)->name;
+            auto it = values.find(std::string(name.lexeme));
+            if (it != values.end()) return clone(it->second, {});
+            return std::make_shared<VariableExpr>(rename(name));
+        }
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            auto copy = std::make_shared<BinaryExpr>(clone(binary->left, renames, values), binary->op,
+                                                     clone(binary->right, renames, values));
+            copy->site = binary->site;
+            copy->profiledType = binary->profiledType;
+            return copy;
+        }
+        case ExprType::UNARY: {
+            auto unary = std::static_pointer_cast<UnaryExpr>(expr);
+            return std::make_shared<UnaryExpr>(unary->op, clone(unary->right, renames, values));
+        }
+        case ExprType::CALL: {
+            auto call = std::static_pointer_cast<CallExpr>(expr);
+            std::vector<ExprPtr> arguments;
+            for (const auto& argument : call->arguments) {
+                arguments.push_back(clone(argument, renames, values));
+            }
+            auto copy = std::make_shared<CallExpr>(rename(call->callee), arguments);
+            copy->site = call->site;
+            copy->hot = call->hot;
+            return copy;
+        }
+        case ExprType::ASSIGNMENT: {
+            auto assignment = std::static_pointer_cast<AssignmentExpr>(expr);
+            return std::make_shared<AssignmentExpr>(rename(assignment->name),
+                                                    clone(assignment->value, renames, values));
+        }
+    }
+    return nullptr;
+}
+
+StmtPtr Inliner::clone(const StmtPtr& stmt, const std::unordered_map<std::string, std::string>& renames) {
+    if (!stmt) return nullptr;
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            return std::make_shared<ExpressionStmt>(
+                clone(std::static_pointer_cast<ExpressionStmt>(stmt)->expression, renames));
+        case StmtType::PRINT: {
+            std::vector<ExprPtr> expressions;
+            for (const auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                expressions.push_back(clone(expr, renames));
+            }
+            return std::make_shared<PrintStmt>(expressions);
+        }
+        case StmtType::VARIABLE_DECL: {
+            auto decl = std::static_pointer_cast<VariableDeclStmt>(stmt);
+            Token name = decl->name;
+            auto it = renames.find(std::string(name.lexeme));
+            if (it != renames.end()) name = Token(name.type, it->second, name.line(), name.column());
+            return std::make_shared<VariableDeclStmt>(name, clone(decl->initializer, renames));
+        }
+        case StmtType::BLOCK: {
+            std::vector<StmtPtr> statements;
+            for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                statements.push_back(clone(inner, renames));
+            }
+            return std::make_shared<BlockStmt>(statements);
+        }
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            auto copy = std::make_shared<IfStmt>(clone(ifStmt->condition, renames),
+                                                 clone(ifStmt->thenBranch, renames), clone(ifStmt->elseBranch, renames));
+            copy->site = ifStmt->site;
+            return copy;
+        }
+        case StmtType::WHILE: {
+            auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+            auto copy = std::make_shared<WhileStmt>(clone(whileStmt->condition, renames),
+                                                    clone(whileStmt->body, renames));
+            copy->site = whileStmt->site;
+            return copy;
+        }
+        case StmtType::FUNCTION_DECL: {
+            auto function = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+            auto copy = std::make_shared<FunctionDeclStmt>(function->name, function->parameters,
+                                                           function->returnType, clone(function->body, renames));
+            copy->site = function->site;
+            return copy;
+        }
+        case StmtType::RETURN: {
+            auto ret = std::static_pointer_cast<ReturnStmt>(stmt);
+            return std::make_shared<ReturnStmt>(ret->keyword, clone(ret->value, renames));
+        }
+    }
+    return nullptr;
+}
+
+void Inliner::collectCandidates(const ProgramPtr& program) {
+    // Only functions whose name always means the same function qualify
+    std::unordered_map<std::string, int> declarations;
+    std::unordered_set<std::string> variables;
+    for (const auto& stmt : program->statements) {
+        if (stmt->getType() == StmtType::FUNCTION_DECL) {
+            declarations[std::string(std::static_pointer_cast<FunctionDeclStmt>(stmt)->name.lexeme)]++;
+        }
+        collectVariableNames(stmt, variables);
+        collectAssigned(stmt, variables);
+    }
+
+    for (const auto& [name, count] : declarations) {
+        Candidate& candidate = candidates[name];
+        candidate.size = 0;
+        candidate.expression = false;
+        if (count > 1) {
+            candidate.rejection = "declared more than once";
+        } else if (variables.count(name)) {
+            candidate.rejection = "name is also used as a variable";
+        } else if (effects.find(name) && effects.find(name)->recursive) {
+            candidate.rejection = "recursive";
+        }
+    }
+}
+
+// The candidate for a call that can be inlined, or nullptr with the reason
+const Inliner::Candidate* Inliner::check(const CallExpr& call, bool expression, std::string& reason) const {
+    auto it = candidates.find(std::string(call.callee.lexeme));
+    if (it == candidates.end()) return nullptr;
+    const Candidate& candidate = it->second;
+
+    if (!candidate.rejection.empty()) {
+        reason = candidate.rejection;
+    } else if (!declaredFunctions.count(std::string(call.callee.lexeme))) {
+        reason = "declared after the call";
+    } else if (call.arguments.size() != candidate.function->parameters.size()) {
+        reason = "argument count does not match";
+    } else if (candidate.size > limitFor(call)) {
+        reason = "over budget (" + std::to_string(candidate.size) + " > " + std::to_string(limitFor(call)) + ")";
+    } else if (expression && !candidate.expression) {
+        reason = "not in statement position";
+    } else {
+        for (size_t i = 1; i < scopes.size(); i++) {
+            if (scopes[i].count(std::string(call.callee.lexeme))) {
+                reason = "redeclared at the call site";
+                return nullptr;
+            }
+        }
+        for (const auto& name : candidate.free) {
+            for (size_t i = 1; i < scopes.size(); i++) {
+                if (scopes[i].count(name)) {
+                    reason = "'" + name + "' is shadowed at the call site";
+                    return nullptr;
+                }
+            }
+        }
+        if (expression) {
+            for (const auto& argument : call.arguments) {
+                if (!isSimple(argument)) {
+                    reason = "not in statement position";
+                    return nullptr;
+                }
+            }
+        }
+        return &candidate;
+    }
+    return nullptr;
+}
+
+void Inliner::decide(const CallExpr& call, const Candidate* candidate, bool inlined, const std::string& reason) {
+    auto it = candidates.find(std::string(call.callee.lexeme));
+    size_t size = candidate ? candidate->size : (it != candidates.end() ? it->second.size : 0);
+    decisions.push_back({call.callee.line(), std::string(call.callee.lexeme), inlined, reason, size});
+    stats.sites++;
+    if (inlined) stats.inlined++;
+    if (inlined && call.hot) stats.hot++;
+}
+
+// Substitutes expression-bodied functions; other candidate calls that are
+// not the statement's first call are recorded as not inlined
+void Inliner::substitute(ExprPtr& expr) {
+    if (!expr) return;
+    switch (expr->getType()) {
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            substitute(binary->left);
+            substitute(binary->right);
+            break;
+        }
+        case ExprType::UNARY:
+            substitute(std::static_pointer_cast<UnaryExpr>(expr)->right);
+            break;
+        case ExprType::ASSIGNMENT:
+            substitute(std::static_pointer_cast<AssignmentExpr>(expr)->value);
+            break;
+        case ExprType::CALL: {
+            auto call = std::static_pointer_cast<CallExpr>(expr);
+            for (auto& argument : call->arguments) {
+                substitute(argument);
+            }
+            if (!candidates.count(std::string(call->callee.lexeme))) break;
+
+            std::string reason;
+            const Candidate* candidate = check(*call, true, reason);
+            if (candidate) {
+                std::unordered_map<std::string, ExprPtr> values;
+                for (size_t i = 0; i < call->arguments.size(); i++) {
+                    values[std::string(candidate->function->parameters[i].first.lexeme)] = call->arguments[i];
+                }
+                decide(*call, candidate, true, "substituted");
+                expr = clone(candidate->returnValue, {}, values);
+            } else if (&expr != currentRoot) {
+                decide(*call, nullptr, false, reason);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// The call a statement evaluates before anything else with side effects
+ExprPtr* Inliner::firstCall(ExprPtr& expr) {
+    if (!expr) return nullptr;
+    switch (expr->getType()) {
+        case ExprType::CALL: {
+            auto call = std::static_pointer_cast<CallExpr>(expr);
+            if (candidates.count(std::string(call->callee.lexeme))) return &expr;
+            return call->arguments.empty() ? nullptr : firstCall(call->arguments[0]);
+        }
+        case ExprType::ASSIGNMENT:
+            return firstCall(std::static_pointer_cast<AssignmentExpr>(expr)->value);
+        case ExprType::BINARY:
+            return firstCall(std::static_pointer_cast<BinaryExpr>(expr)->left);
+        case ExprType::UNARY:
+            return firstCall(std::static_pointer_cast<UnaryExpr>(expr)->right);
+        default:
+            return nullptr;
+    }
+}
+
+// Expands the body in front of the statement; the call becomes the
+// renamed return value (nullptr when the whole statement goes away)
+bool Inliner::inlineAt(ExprPtr& slot, bool wholeStatement, std::vector<StmtPtr>& out) {
+    auto call = std::static_pointer_cast<CallExpr>(slot);
+    std::string reason;
+    const Candidate* candidate = check(*call, false, reason);
+    if (!candidate) {
+        decide(*call, nullptr, false, reason);
+        return false;
+    }
+    if (!candidate->returnValue && !wholeStatement) {
+        decide(*call, candidate, false, "no return value");
+        return false;
+    }
+
+    std::string prefix = "$inl" + std::to_string(nextSite++) + "_";
+    std::unordered_map<std::string, std::string> renames;
+    for (const auto& name : candidate->locals) {
+        renames[name] = prefix + name;
+    }
+
+    // Arguments are evaluated in order into the renamed parameters
+    const auto& parameters = candidate->function->parameters;
+    for (size_t i = 0; i < parameters.size(); i++) {
+        const Token& parameter = parameters[i].first;
+        const std::string& name = renames[std::string(parameter.lexeme)];
+        out.push_back(std::make_shared<VariableDeclStmt>(Token(parameter.type, name, parameter.line(), parameter.column()),
+                                                         call->arguments[i]));
+        scopes.back().insert(name);
+    }
+
+    const auto& body = std::static_pointer_cast<BlockStmt>(candidate->function->body)->statements;
+    for (const auto& stmt : body) {
+        if (stmt->getType() == StmtType::RETURN) break;
+        out.push_back(clone(stmt, renames));
+        if (stmt->getType() == StmtType::VARIABLE_DECL) {
+            scopes.back().insert(renames[std::string(std::static_pointer_cast<VariableDeclStmt>(stmt)->name.lexeme)]);
+        }
+    }
+
+    decide(*call, candidate, true, "expanded");
+    slot = candidate->returnValue ? clone(candidate->returnValue, renames) : nullptr;
+    return true;
+}
+
+void Inliner::expandSlot(StmtPtr& stmt) {
+    if (!stmt) return;
+    std::vector<StmtPtr> statements;
+    expand(stmt, statements);
+    if (statements.size() == 1) {
+        stmt = statements[0];
+    } else {
+        stmt = std::make_shared<BlockStmt>(statements);
+    }
+}
+
+void Inliner::expandStatements(std::vector<StmtPtr>& statements) {
+    std::vector<StmtPtr> result;
+    for (const auto& stmt : statements) {
+        expand(stmt, result);
+    }
+    statements = std::move(result);
+}
+
+void Inliner::expand(const StmtPtr& stmt, std::vector<StmtPtr>& out) {
+    switch (stmt->getType()) {
+        case StmtType::BLOCK:
+            scopes.emplace_back();
+            expandStatements(std::static_pointer_cast<BlockStmt>(stmt)->statements);
+            scopes.pop_back();
+            out.push_back(stmt);
+            return;
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            substitute(ifStmt->condition);
+            expandSlot(ifStmt->thenBranch);
+            expandSlot(ifStmt->elseBranch);
+            out.push_back(stmt);
+            return;
+        }
+        case StmtType::WHILE: {
+            auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+            substitute(whileStmt->condition);
+            expandSlot(whileStmt->body);
+            out.push_back(stmt);
+            return;
+        }
+        case StmtType::FUNCTION_DECL: {
+            auto function = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+            bool topLevel = scopes.size() == 1;
+            if (!topLevel) {
+                // A nested function hides a top-level one of the same name
+                scopes.back().insert(std::string(function->name.lexeme));
+            }
+            auto outer = std::move(scopes);
+            scopes = {outer.front(), {}};
+            for (const auto& param : function->parameters) {
+                scopes.back().insert(std::string(param.first.lexeme));
+            }
+            expandSlot(function->body);
+            scopes = std::move(outer);
+            out.push_back(stmt);
+
+            // Callers after this point can inline the (already optimized) body
+            auto it = candidates.find(std::string(function->name.lexeme));
+            if (!topLevel || it == candidates.end()) return;
+            Candidate& candidate = it->second;
+            candidate.function = function;
+            candidate.size = DeadCodeEliminator::countNodes(function->body);
+            declaredFunctions.insert(std::string(function->name.lexeme));
+            if (!candidate.rejection.empty()) return;
+
+            auto block = std::dynamic_pointer_cast<BlockStmt>(function->body);
+            BodyShape shape;
+            scan(function->body, shape);
+            bool endsWithReturn = block && !block->statements.empty() &&
+                                  block->statements.back()->getType() == StmtType::RETURN;
+            if (!block) {
+                candidate.rejection = "body is not a block";
+            } else if (shape.nestedFunction) {
+                candidate.rejection = "declares a function";
+            } else if (shape.returns > (endsWithReturn ? 1u : 0u)) {
+                candidate.rejection = "returns before the end";
+            }
+            if (!candidate.rejection.empty()) return;
+
+            candidate.returnValue = endsWithReturn
+                ? std::static_pointer_cast<ReturnStmt>(block->statements.back())->value : nullptr;
+            candidate.expression = block->statements.size() == 1 && candidate.returnValue &&
+                                   !hasCallOrStore(candidate.returnValue);
+            candidate.locals = shape.declared;
+            for (const auto& param : function->parameters) {
+                candidate.locals.insert(std::string(param.first.lexeme));
+            }
+            for (const auto& name : shape.used) {
+                if (!candidate.locals.count(name)) candidate.free.insert(name);
+            }
+            return;
+        }
+        default:
+            break;
+    }
+
+    // Simple statements: the first call may be expanded in front of them
+    ExprPtr* root = nullptr;
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            root = &std::static_pointer_cast<ExpressionStmt>(stmt)->expression;
+            break;
+        case StmtType::PRINT: {
+            auto& expressions = std::static_pointer_cast<PrintStmt>(stmt)->expressions;
+            root = expressions.empty() ? nullptr : &expressions[0];
+            break;
+        }
+        case StmtType::VARIABLE_DECL:
+            root = &std::static_pointer_cast<VariableDeclStmt>(stmt)->initializer;
+            break;
+        case StmtType::RETURN:
+            root = &std::static_pointer_cast<ReturnStmt>(stmt)->value;
+            break;
+        default:
+            break;
+    }
+
+    ExprPtr* call = root ? firstCall(*root) : nullptr;
+    currentRoot = call;
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            substitute(std::static_pointer_cast<ExpressionStmt>(stmt)->expression);
+            break;
+        case StmtType::PRINT:
+            for (auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                substitute(expr);
+            }
+            break;
+        case StmtType::VARIABLE_DECL:
+            substitute(std::static_pointer_cast<VariableDeclStmt>(stmt)->initializer);
+            break;
+        case StmtType::RETURN:
+            substitute(std::static_pointer_cast<ReturnStmt>(stmt)->value);
+            break;
+        default:
+            break;
+    }
+    currentRoot = nullptr;
+
+    bool keep = true;
+    if (call && *call && (*call)->getType() == ExprType::CALL) {
+        bool wholeStatement = call == root && stmt->getType() == StmtType::EXPRESSION;
+        if (inlineAt(*call, wholeStatement, out) && !*call) {
+            keep = false;
+        }
+    }
+
+    if (stmt->getType() == StmtType::VARIABLE_DECL) {
+        scopes.back().insert(std::string(std::static_pointer_cast<VariableDeclStmt>(stmt)->name.lexeme));
+    }
+    if (keep) {
+        out.push_back(stmt);
+    }
+}
+
+size_t Inliner::run(const ProgramPtr& program) {
+    stats = Stats();
+    candidates.clear();
+    declaredFunctions.clear();
+    decisions.clear();
+    nextSite = 0;
+    currentRoot = nullptr;
+
+    effects.analyze(program);
+    collectCandidates(program);
+
+    scopes.clear();
+    scopes.emplace_back();
+    expandStatements(program->statements);
+    scopes.clear();
+    return stats.inlined;
+}
+
+std::string Inliner::report(bool verbose) const {
+    std::ostringstream out;
+    out << "Inlining: " << stats.inlined << " of " << stats.sites << " call sites inlined";
+    if (stats.hot > 0) {
+        out << " (" << stats.hot << " hot in the profile)";
+    }
+    if (verbose) {
+        for (const auto& decision : decisions) {
+            out << "\n  line " << decision.line << ": " << decision.callee << " (" << decision.size << " nodes) "
+                << (decision.inlined ? "inlined, " : "not inlined: ") << decision.reason;
+        }
+    }
+    return out.str();
+}
@@ -0,0 +1,304 @@
+#include "LoopInvariantMotion.h"
+#include <sstream>
+
+namespace {
+    int lineOf(const ExprPtr& expr) {
+        switch (expr->getType()) {
+            case ExprType::VARIABLE: return std::static_pointer_cast<VariableExpr>(expr)->name.line();
+            case ExprType::BINARY: return std::static_pointer_cast<BinaryExpr>(expr)->op.line();
+            case ExprType::UNARY: return std::static_pointer_cast<UnaryExpr>(expr)->op.line();
+            case ExprType::CALL: return std::static_pointer_cast<CallExpr>(expr)->callee.line();
+            case ExprType::ASSIGNMENT: return std::static_pointer_cast<AssignmentExpr>(expr)->name.line();
+            default: return 0;
+        }
+    }
+
+    bool containsCall(const ExprPtr& expr) {
+        switch (expr->getType()) {
+            case ExprType::CALL:
+                return true;
+            case ExprType::BINARY: {
+                auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+                return containsCall(binary->left) || containsCall(binary->right);
+            }
+            case ExprType::UNARY:
+                return containsCall(std::static_pointer_cast<UnaryExpr>(expr)->right);
+            default:
+                return false;
+        }
+    }
+}
+
+std::string LoopInvariantMotion::key(const ExprPtr& expr) {
+    std::ostringstream out;
+    switch (expr->getType()) {
+        case ExprType::LITERAL: {
+            const Value& value = std::static_pointer_cast<LiteralExpr>(expr)->value;
+            if (std::holds_alternative<int>(value)) out << "i" << std::get<int>(value);
+            else if (std::holds_alternative<float>(value)) out << "f" << std::hexfloat << std::get<float>(value);
+            else if (std::holds_alternative<bool>(value)) out << "b" << std::get<bool>(value);
+            else out << "s" << std::get<std::string>(value).size() << ":" << std::get<std::string>(value);
+            break;
+        }
+        case ExprType::VARIABLE:
+            out << "v" << std::static_pointer_cast<VariableExpr>(expr)->name.lexeme;
+            break;
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            out << "(" << key(binary->left) << " " << static_cast<int>(binary->op.type) << " "
+                << key(binary->right) << ")";
+            break;
+        }
+        case ExprType::UNARY: {
+            auto unary = std::static_pointer_cast<UnaryExpr>(expr);
+            out << "(" << static_cast<int>(unary->op.type) << " " << key(unary->right) << ")";
+            break;
+        }
+        case ExprType::CALL: {
+            auto call = std::static_pointer_cast<CallExpr>(expr);
+            out << call->callee.lexeme << "(";
+            for (const auto& argument : call->arguments) {
+                out << key(argument) << ",";
+            }
+            out << ")";
+            break;
+        }
+        case ExprType::ASSIGNMENT: {
+            auto assignment = std::static_pointer_cast<AssignmentExpr>(expr);
+            out << "(" << assignment->name.lexeme << " = " << key(assignment->value) << ")";
+            break;
+        }
+    }
+    return out.str();
+}
+
+bool LoopInvariantMotion::isDeclared(const std::string& name) const {
+    for (const auto& scope : scopes) {
+        if (scope.count(name)) return true;
+    }
+    return false;
+}
+
+bool LoopInvariantMotion::isInvariant(const ExprPtr& expr, const LoopInfo& loop) const {
+    switch (expr->getType()) {
+        case ExprType::LITERAL:
+            return true;
+        case ExprType::VARIABLE: {
+            std::string name(std::static_pointer_cast<VariableExpr>(expr)->name.lexeme);
+            return !loop.defined.count(name) && isDeclared(name);
+        }
+        case ExprType::UNARY:
+            return isInvariant(std::static_pointer_cast<UnaryExpr>(expr)->right, loop);
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            return isInvariant(binary->left, loop) && isInvariant(binary->right, loop);
+        }
+        case ExprType::CALL: {
+            // A pure call depends on its arguments and the globals it reads
+            auto call = std::static_pointer_cast<CallExpr>(expr);
+            if (!effects.isPure(std::string(call->callee.lexeme))) return false;
+            if (const SideEffects::Summary* summary = effects.find(std::string(call->callee.lexeme))) {
+                for (const auto& name : summary->reads) {
+                    if (loop.defined.count(name)) return false;
+                }
+            }
+            for (const auto& argument : call->arguments) {
+                if (!isInvariant(argument, loop)) return false;
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+void LoopInvariantMotion::hoist(ExprPtr& expr, Hoisting& state, bool alwaysEvaluated) {
+    if (!expr) return;
+    ExprType type = expr->getType();
+    if (type != ExprType::LITERAL && type != ExprType::VARIABLE && isInvariant(expr, *state.loop) &&
+        (alwaysEvaluated || kinds.cannotTrap(expr))) {
+        int line = lineOf(expr);
+        std::string exprKey = key(expr);
+        auto it = state.temporaries.find(exprKey);
+        std::string name;
+        if (it != state.temporaries.end()) {
+            name = it->second;
+        } else {
+            name = "$licm" + std::to_string(nextTemporary++);
+            state.temporaries[exprKey] = name;
+            kinds.set(name, kinds.kindOf(expr));
+            state.preheader.push_back(std::make_shared<VariableDeclStmt>(
+                Token(TokenType::IDENTIFIER, name, line, 0), expr));
+            state.loop->hoisted++;
+            stats.expressionsHoisted++;
+            if (containsCall(expr)) stats.callsHoisted++;
+        }
+        expr = std::make_shared<VariableExpr>(Token(TokenType::IDENTIFIER, name, line, 0));
+        return;
+    }
+
+    // The operands of and/or are always both evaluated
+    switch (type) {
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            hoist(binary->left, state, alwaysEvaluated);
+            hoist(binary->right, state, alwaysEvaluated);
+            break;
+        }
+        case ExprType::UNARY:
+            hoist(std::static_pointer_cast<UnaryExpr>(expr)->right, state, alwaysEvaluated);
+            break;
+        case ExprType::CALL:
+            for (auto& argument : std::static_pointer_cast<CallExpr>(expr)->arguments) {
+                hoist(argument, state, alwaysEvaluated);
+            }
+            break;
+        case ExprType::ASSIGNMENT:
+            hoist(std::static_pointer_cast<AssignmentExpr>(expr)->value, state, alwaysEvaluated);
+            break;
+        default:
+            break;
+    }
+}
+
+void LoopInvariantMotion::hoistInStmt(const StmtPtr& stmt, Hoisting& state) {
+    if (!stmt) return;
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            hoist(std::static_pointer_cast<ExpressionStmt>(stmt)->expression, state, false);
+            break;
+        case StmtType::PRINT:
+            for (auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                hoist(expr, state, false);
+            }
+            break;
+        case StmtType::VARIABLE_DECL:
+            hoist(std::static_pointer_cast<VariableDeclStmt>(stmt)->initializer, state, false);
+            break;
+        case StmtType::BLOCK:
+            for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                hoistInStmt(inner, state);
+            }
+            break;
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            hoist(ifStmt->condition, state, false);
+            hoistInStmt(ifStmt->thenBranch, state);
+            hoistInStmt(ifStmt->elseBranch, state);
+            break;
+        }
+        case StmtType::WHILE: {
+            auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+            hoist(whileStmt->condition, state, false);
+            hoistInStmt(whileStmt->body, state);
+            break;
+        }
+        case StmtType::RETURN:
+            hoist(std::static_pointer_cast<ReturnStmt>(stmt)->value, state, false);
+            break;
+        default:
+            break;
+    }
+}
+
+// Returns the preheader declarations to place before the loop
+std::vector<StmtPtr> LoopInvariantMotion::processLoop(const std::shared_ptr<WhileStmt>& loop) {
+    // Inner loops first, so their invariants can move further out
+    process(loop->body);
+
+    LoopInfo info{lineOf(loop->condition), {}, false, 0};
+    info.opaque = !effects.collectWrites(loop->condition, info.defined) ||
+                  !effects.collectWrites(loop->body, info.defined);
+
+    Hoisting state{&info, {}, {}};
+    if (!info.opaque) {
+        // The condition runs before the first iteration, so anything
+        // invariant there is evaluated at the same point as before
+        hoist(loop->condition, state, true);
+        hoistInStmt(loop->body, state);
+    }
+
+    stats.loops++;
+    loops.push_back(std::move(info));
+    return std::move(state.preheader);
+}
+
+void LoopInvariantMotion::process(StmtPtr& stmt) {
+    if (!stmt) return;
+    switch (stmt->getType()) {
+        case StmtType::VARIABLE_DECL:
+            scopes.back().insert(std::string(std::static_pointer_cast<VariableDeclStmt>(stmt)->name.lexeme));
+            break;
+        case StmtType::BLOCK:
+            scopes.emplace_back();
+            processStatements(std::static_pointer_cast<BlockStmt>(stmt)->statements);
+            scopes.pop_back();
+            break;
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            process(ifStmt->thenBranch);
+            process(ifStmt->elseBranch);
+            break;
+        }
+        case StmtType::WHILE: {
+            // A loop in a single-statement position gets a block for its preheader
+            std::vector<StmtPtr> preheader = processLoop(std::static_pointer_cast<WhileStmt>(stmt));
+            if (!preheader.empty()) {
+                preheader.push_back(stmt);
+                stmt = std::make_shared<BlockStmt>(preheader);
+            }
+            break;
+        }
+        case StmtType::FUNCTION_DECL: {
+            // Function bodies only see their parameters and locals
+            auto function = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+            auto outer = std::move(scopes);
+            scopes.clear();
+            scopes.emplace_back();
+            for (const auto& param : function->parameters) {
+                scopes.back().insert(std::string(param.first.lexeme));
+            }
+            process(function->body);
+            scopes = std::move(outer);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void LoopInvariantMotion::processStatements(std::vector<StmtPtr>& statements) {
+    std::vector<StmtPtr> result;
+    for (auto& stmt : statements) {
+        if (stmt->getType() == StmtType::WHILE) {
+            for (auto& decl : processLoop(std::static_pointer_cast<WhileStmt>(stmt))) {
+                scopes.back().insert(std::string(std::static_pointer_cast<VariableDeclStmt>(decl)->name.lexeme));
+                result.push_back(decl);
+            }
+        } else {
+            process(stmt);
+        }
+        result.push_back(stmt);
+    }
+    statements = std::move(result);
+}
+
+size_t LoopInvariantMotion::run(const ProgramPtr& program) {
+    stats = Stats();
+    loops.clear();
+    effects.analyze(program);
+    kinds.infer(program);
+
+    scopes.clear();
+    scopes.emplace_back();
+    processStatements(program->statements);
+    scopes.clear();
+    return stats.expressionsHoisted;
+}
+
+std::string LoopInvariantMotion::report() const {
+    std::ostringstream out;
+    out << "Loop-invariant code motion: " << stats.loops << " loops, "
+        << stats.expressionsHoisted << " expressions hoisted (" << stats.callsHoisted << " calls)";
+    return out.str();
+}
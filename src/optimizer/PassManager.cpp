@@ -0,0 +1,98 @@
+#include "PassManager.h"
+#include "../parser/ASTPrinter.h"
+#include "../ir/IRPrinter.h"
+#include "../core/Config.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+PassManager::PassManager(int level) : level(std::max(0, std::min(level, MAX_LEVEL))) {}
+
+void PassManager::add(const std::string& name, int level, AstPass pass, Report report) {
+    passes.push_back({name, level, std::move(pass), nullptr, std::move(report)});
+}
+
+void PassManager::add(const std::string& name, int level, IrPass pass, Report report) {
+    passes.push_back({name, level, nullptr, std::move(pass), std::move(report)});
+}
+
+bool PassManager::isRegistered(const std::string& name) const {
+    return std::any_of(passes.begin(), passes.end(), [&name](const Pass& pass) { return pass.name == name; });
+}
+
+bool PassManager::shouldPrint(const std::string& name) const {
+    return printAfter == "all" || printAfter == name;
+}
+
+void PassManager::record(const Pass& pass, double milliseconds, size_t changes) {
+    stats.push_back({pass.name, milliseconds, changes});
+}
+
+void PassManager::run(const ProgramPtr& program) {
+    for (const Pass& pass : passes) {
+        if (!pass.runAst || pass.level > level) continue;
+
+        auto start = std::chrono::steady_clock::now();
+        size_t changes = pass.runAst(program);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        record(pass, elapsed.count(), changes);
+
+        if (shouldPrint(pass.name)) {
+            std::cout << "*** AST after " << pass.name << " ***" << std::endl;
+            std::cout << ASTPrinter::print(program);
+        }
+    }
+}
+
+void PassManager::run(IRModule& module) {
+    for (const Pass& pass : passes) {
+        if (!pass.runIr || pass.level > level) continue;
+
+        auto start = std::chrono::steady_clock::now();
+        size_t changes = pass.runIr(module);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        record(pass, elapsed.count(), changes);
+
+        if (shouldPrint(pass.name)) {
+            std::cout << "*** IR after " << pass.name << " ***" << std::endl;
+            std::cout << IRPrinter::print(module);
+        }
+    }
+}
+
+std::string PassManager::report() const {
+    std::ostringstream out;
+    for (const PassStats& ran : stats) {
+        for (const Pass& pass : passes) {
+            if (pass.name == ran.name && pass.report) {
+                out << pass.report() << "\n";
+                break;
+            }
+        }
+    }
+
+    double total = 0;
+    out << "Pass timings (-O" << level << "):\n";
+    for (const PassStats& ran : stats) {
+        out << "  " << std::left << std::setw(12) << ran.name << std::right << std::fixed
+            << std::setprecision(3) << std::setw(9) << ran.milliseconds << " ms  "
+            << ran.changes << " changes\n";
+        total += ran.milliseconds;
+    }
+    out << "  " << std::left << std::setw(12) << "total" << std::right << std::fixed
+        << std::setprecision(3) << std::setw(9) << total << " ms\n";
+    return out.str();
+}
+
+int PassManager::configuredLevel() {
+    std::string value = Config::get("optimize", "true");
+    if (value == "false") return 0;
+    int configured = Config::getInt("optimize", 2);
+    return std::max(0, std::min(configured, MAX_LEVEL));
+}
+
+size_t PassManager::inlineBudget(int level) {
+    return static_cast<size_t>(std::max(0, Config::getInt("inline_budget", level >= 3 ? 120 : 40)));
+}
@@ -0,0 +1,202 @@
+#include "Profile.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    const char* const HEADER = "simplelang-profile";
+
+    void numberExpr(const ExprPtr& expr, unsigned& next);
+
+    void numberStmt(const StmtPtr& stmt, unsigned& next) {
+        if (!stmt) return;
+        switch (stmt->getType()) {
+            case StmtType::EXPRESSION:
+                numberExpr(std::static_pointer_cast<ExpressionStmt>(stmt)->expression, next);
+                break;
+            case StmtType::PRINT:
+                for (const auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                    numberExpr(expr, next);
+                }
+                break;
+            case StmtType::VARIABLE_DECL:
+                numberExpr(std::static_pointer_cast<VariableDeclStmt>(stmt)->initializer, next);
+                break;
+            case StmtType::BLOCK:
+                for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                    numberStmt(inner, next);
+                }
+                break;
+            case StmtType::IF: {
+                auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+                ifStmt->site = next++;
+                numberExpr(ifStmt->condition, next);
+                numberStmt(ifStmt->thenBranch, next);
+                numberStmt(ifStmt->elseBranch, next);
+                break;
+            }
+            case StmtType::WHILE: {
+                auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+                whileStmt->site = next++;
+                numberExpr(whileStmt->condition, next);
+                numberStmt(whileStmt->body, next);
+                break;
+            }
+            case StmtType::FUNCTION_DECL: {
+                auto function = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+                function->site = next++;
+                numberStmt(function->body, next);
+                break;
+            }
+            case StmtType::RETURN:
+                numberExpr(std::static_pointer_cast<ReturnStmt>(stmt)->value, next);
+                break;
+        }
+    }
+
+    void numberExpr(const ExprPtr& expr, unsigned& next) {
+        if (!expr) return;
+        switch (expr->getType()) {
+            case ExprType::BINARY: {
+                auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+                binary->site = next++;
+                numberExpr(binary->left, next);
+                numberExpr(binary->right, next);
+                break;
+            }
+            case ExprType::UNARY:
+                numberExpr(std::static_pointer_cast<UnaryExpr>(expr)->right, next);
+                break;
+            case ExprType::CALL: {
+                auto call = std::static_pointer_cast<CallExpr>(expr);
+                call->site = next++;
+                for (const auto& argument : call->arguments) {
+                    numberExpr(argument, next);
+                }
+                break;
+            }
+            case ExprType::ASSIGNMENT:
+                numberExpr(std::static_pointer_cast<AssignmentExpr>(expr)->value, next);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+size_t Profile::number(const ProgramPtr& program) {
+    unsigned next = 1;
+    for (const auto& stmt : program->statements) {
+        numberStmt(stmt, next);
+    }
+    return next - 1;
+}
+
+void Profile::recordBranch(unsigned site, bool taken) {
+    Branch& branch = branches[site];
+    if (taken) branch.taken++;
+    else branch.notTaken++;
+}
+
+void Profile::recordOperands(unsigned site, const std::string& left, const std::string& right) {
+    operands[site][left + " " + right]++;
+}
+
+void Profile::recordCall(unsigned site, unsigned target) {
+    Call& call = calls[site];
+    call.count++;
+    call.targets[target]++;
+}
+
+const Profile::Branch* Profile::getBranch(unsigned site) const {
+    auto it = branches.find(site);
+    return it == branches.end() ? nullptr : &it->second;
+}
+
+const Profile::Call* Profile::getCall(unsigned site) const {
+    auto it = calls.find(site);
+    return it == calls.end() ? nullptr : &it->second;
+}
+
+std::string Profile::dominantOperands(unsigned site, double share) const {
+    auto it = operands.find(site);
+    if (it == operands.end()) return "";
+
+    uint64_t total = 0;
+    const std::pair<const std::string, uint64_t>* best = nullptr;
+    for (const auto& entry : it->second) {
+        total += entry.second;
+        if (!best || entry.second > best->second) best = &entry;
+    }
+    return best && best->second >= share * static_cast<double>(total) ? best->first : "";
+}
+
+uint64_t Profile::hottestCall() const {
+    uint64_t hottest = 0;
+    for (const auto& entry : calls) {
+        hottest = std::max(hottest, entry.second.count);
+    }
+    return hottest;
+}
+
+bool Profile::save(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file << HEADER << " " << sites << "\n";
+    for (const auto& entry : branches) {
+        file << "branch " << entry.first << " " << entry.second.taken << " " << entry.second.notTaken << "\n";
+    }
+    for (const auto& site : operands) {
+        for (const auto& entry : site.second) {
+            file << "operands " << site.first << " " << entry.first << " " << entry.second << "\n";
+        }
+    }
+    for (const auto& site : calls) {
+        for (const auto& target : site.second.targets) {
+            file << "call " << site.first << " " << target.first << " " << target.second << "\n";
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+bool Profile::load(const std::string& filename) {
+    std::ifstream file(filename);
+    std::string header;
+    size_t count = 0;
+    if (!file.is_open() || !(file >> header >> count) || header != HEADER) {
+        return false;
+    }
+
+    *this = Profile();
+    sites = count;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string kind;
+        unsigned site = 0;
+        if (!(fields >> kind)) continue;
+        if (kind == "branch") {
+            Branch branch;
+            if (!(fields >> site >> branch.taken >> branch.notTaken)) return false;
+            branches[site] = branch;
+        } else if (kind == "operands") {
+            std::string left, right;
+            uint64_t evaluations = 0;
+            if (!(fields >> site >> left >> right >> evaluations)) return false;
+            operands[site][left + " " + right] = evaluations;
+        } else if (kind == "call") {
+            unsigned target = 0;
+            uint64_t reached = 0;
+            if (!(fields >> site >> target >> reached)) return false;
+            calls[site].count += reached;
+            calls[site].targets[target] = reached;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,158 @@
+#include "ProfileGuided.h"
+#include <sstream>
+
+namespace {
+    TokenType typeNamed(const std::string& name) {
+        if (name == "int") return TokenType::INT_TYPE;
+        if (name == "float") return TokenType::FLOAT_TYPE;
+        if (name == "bool") return TokenType::BOOL_TYPE;
+        if (name == "string") return TokenType::STRING_TYPE;
+        return TokenType::ERROR;
+    }
+
+    // Only the truth of a condition matters, so `!!c` may become `c`
+    ExprPtr negate(const ExprPtr& condition) {
+        if (condition->getType() == ExprType::UNARY) {
+            auto unary = std::static_pointer_cast<UnaryExpr>(condition);
+            if (unary->op.type == TokenType::NOT) return unary->right;
+        }
+        return std::make_shared<UnaryExpr>(Token(TokenType::NOT, "!", 0, 0), condition);
+    }
+}
+
+void ProfileGuided::layout(IfStmt& ifStmt) {
+    const Profile::Branch* branch = profile.getBranch(ifStmt.site);
+    if (!ifStmt.elseBranch || !ifStmt.condition || !branch) return;
+    if (branch->taken + branch->notTaken < MIN_SAMPLES || branch->notTaken <= branch->taken) return;
+
+    ifStmt.condition = negate(ifStmt.condition);
+    std::swap(ifStmt.thenBranch, ifStmt.elseBranch);
+    stats.branchesInverted++;
+}
+
+void ProfileGuided::specialize(BinaryExpr& binary) {
+    std::string types = profile.dominantOperands(binary.site, TYPE_SHARE);
+    size_t space = types.find(' ');
+    if (space == std::string::npos || types.substr(0, space) != types.substr(space + 1)) return;
+
+    TokenType type = typeNamed(types.substr(0, space));
+    if (type != TokenType::ERROR) {
+        binary.profiledType = type;
+        stats.operationsTyped++;
+    }
+}
+
+void ProfileGuided::markHot(CallExpr& call) {
+    const Profile::Call* profiled = profile.getCall(call.site);
+    auto function = functions.find(std::string(call.callee.lexeme));
+    if (!profiled || function == functions.end()) return;
+    if (profiled->count < MIN_SAMPLES || profiled->count < HOT_CALL_SHARE * static_cast<double>(hottest)) return;
+
+    auto target = profiled->targets.find(function->second);
+    if (target != profiled->targets.end() &&
+        target->second >= TARGET_SHARE * static_cast<double>(profiled->count)) {
+        call.hot = true;
+        stats.hotCalls++;
+    }
+}
+
+void ProfileGuided::visit(const ExprPtr& expr) {
+    if (!expr) return;
+    switch (expr->getType()) {
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            specialize(*binary);
+            visit(binary->left);
+            visit(binary->right);
+            break;
+        }
+        case ExprType::UNARY:
+            visit(std::static_pointer_cast<UnaryExpr>(expr)->right);
+            break;
+        case ExprType::CALL: {
+            auto call = std::static_pointer_cast<CallExpr>(expr);
+            markHot(*call);
+            for (const auto& argument : call->arguments) {
+                visit(argument);
+            }
+            break;
+        }
+        case ExprType::ASSIGNMENT:
+            visit(std::static_pointer_cast<AssignmentExpr>(expr)->value);
+            break;
+        default:
+            break;
+    }
+}
+
+void ProfileGuided::visit(const StmtPtr& stmt) {
+    if (!stmt) return;
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            visit(std::static_pointer_cast<ExpressionStmt>(stmt)->expression);
+            break;
+        case StmtType::PRINT:
+            for (const auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                visit(expr);
+            }
+            break;
+        case StmtType::VARIABLE_DECL:
+            visit(std::static_pointer_cast<VariableDeclStmt>(stmt)->initializer);
+            break;
+        case StmtType::BLOCK:
+            for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                visit(inner);
+            }
+            break;
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            visit(ifStmt->condition);
+            visit(ifStmt->thenBranch);
+            visit(ifStmt->elseBranch);
+            layout(*ifStmt);
+            break;
+        }
+        case StmtType::WHILE: {
+            auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+            visit(whileStmt->condition);
+            visit(whileStmt->body);
+            break;
+        }
+        case StmtType::FUNCTION_DECL:
+            visit(std::static_pointer_cast<FunctionDeclStmt>(stmt)->body);
+            break;
+        case StmtType::RETURN:
+            visit(std::static_pointer_cast<ReturnStmt>(stmt)->value);
+            break;
+    }
+}
+
+size_t ProfileGuided::run(const ProgramPtr& program) {
+    stats = Stats();
+    functions.clear();
+    hottest = profile.hottestCall();
+
+    // A name declared twice at the top level has no single target
+    std::unordered_map<std::string, size_t> declarations;
+    for (const auto& stmt : program->statements) {
+        if (stmt->getType() != StmtType::FUNCTION_DECL) continue;
+        auto function = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+        if (declarations[std::string(function->name.lexeme)]++ == 0) {
+            functions[std::string(function->name.lexeme)] = function->site;
+        } else {
+            functions.erase(std::string(function->name.lexeme));
+        }
+    }
+
+    for (const auto& stmt : program->statements) {
+        visit(stmt);
+    }
+    return stats.branchesInverted + stats.operationsTyped + stats.hotCalls;
+}
+
+std::string ProfileGuided::report() const {
+    std::ostringstream out;
+    out << "Profile: " << stats.branchesInverted << " branches inverted, " << stats.operationsTyped
+        << " operations typed, " << stats.hotCalls << " hot call sites";
+    return out.str();
+}
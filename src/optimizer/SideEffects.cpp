@@ -0,0 +1,259 @@
+#include "SideEffects.h"
+
+namespace {
+    // Everything a piece of code does directly, without following calls.
+    // While `scopes` is not empty (a function body), names declared in it
+    // are resolved as the code runs and only the other ones are recorded
+    // in reads and writes
+    struct DirectEffects {
+        std::unordered_set<std::string> declared;
+        std::unordered_set<std::string> reads;
+        std::unordered_set<std::string> writes;
+        std::unordered_set<std::string> calls;
+        std::vector<std::unordered_set<std::string>> scopes;
+
+        bool isLocal(const std::string& name) const {
+            for (const auto& scope : scopes) {
+                if (scope.count(name)) return true;
+            }
+            return false;
+        }
+
+        void declare(const std::string& name) {
+            declared.insert(name);
+            if (!scopes.empty()) scopes.back().insert(name);
+        }
+    };
+
+    void walk(const ExprPtr& expr, DirectEffects& effects);
+
+    void walk(const StmtPtr& stmt, DirectEffects& effects) {
+        if (!stmt) return;
+        switch (stmt->getType()) {
+            case StmtType::EXPRESSION:
+                walk(std::static_pointer_cast<ExpressionStmt>(stmt)->expression, effects);
+                break;
+            case StmtType::PRINT:
+                effects.calls.insert("print");
+                for (const auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                    walk(expr, effects);
+                }
+                break;
+            case StmtType::VARIABLE_DECL: {
+                auto decl = std::static_pointer_cast<VariableDeclStmt>(stmt);
+                walk(decl->initializer, effects);
+                effects.declare(std::string(decl->name.lexeme));
+                break;
+            }
+            case StmtType::BLOCK: {
+                bool scoped = !effects.scopes.empty();
+                if (scoped) effects.scopes.emplace_back();
+                for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                    walk(inner, effects);
+                }
+                if (scoped) effects.scopes.pop_back();
+                break;
+            }
+            case StmtType::IF: {
+                auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+                walk(ifStmt->condition, effects);
+                walk(ifStmt->thenBranch, effects);
+                walk(ifStmt->elseBranch, effects);
+                break;
+            }
+            case StmtType::WHILE: {
+                auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+                walk(whileStmt->condition, effects);
+                walk(whileStmt->body, effects);
+                break;
+            }
+            case StmtType::FUNCTION_DECL:
+                // Defining a function binds its name
+                effects.declare(std::string(std::static_pointer_cast<FunctionDeclStmt>(stmt)->name.lexeme));
+                break;
+            case StmtType::RETURN:
+                walk(std::static_pointer_cast<ReturnStmt>(stmt)->value, effects);
+                break;
+        }
+    }
+
+    void walk(const ExprPtr& expr, DirectEffects& effects) {
+        if (!expr) return;
+        switch (expr->getType()) {
+            case ExprType::VARIABLE: {
+                std::string name(std::static_pointer_cast<VariableExpr>(expr)->name.lexeme);
+                if (!effects.isLocal(name)) effects.reads.insert(name);
+                break;
+            }
+            case ExprType::BINARY: {
+                auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+                walk(binary->left, effects);
+                walk(binary->right, effects);
+                break;
+            }
+            case ExprType::UNARY:
+                walk(std::static_pointer_cast<UnaryExpr>(expr)->right, effects);
+                break;
+            case ExprType::CALL: {
+                auto call = std::static_pointer_cast<CallExpr>(expr);
+                effects.calls.insert(std::string(call->callee.lexeme));
+                for (const auto& argument : call->arguments) {
+                    walk(argument, effects);
+                }
+                break;
+            }
+            case ExprType::ASSIGNMENT: {
+                auto assignment = std::static_pointer_cast<AssignmentExpr>(expr);
+                walk(assignment->value, effects);
+                std::string name(assignment->name.lexeme);
+                if (!effects.isLocal(name)) effects.writes.insert(name);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void collectFunctions(const StmtPtr& stmt, std::vector<const FunctionDeclStmt*>& functions) {
+        if (!stmt) return;
+        switch (stmt->getType()) {
+            case StmtType::FUNCTION_DECL:
+                functions.push_back(static_cast<const FunctionDeclStmt*>(stmt.get()));
+                break;
+            case StmtType::BLOCK:
+                for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                    collectFunctions(inner, functions);
+                }
+                break;
+            case StmtType::IF: {
+                auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+                collectFunctions(ifStmt->thenBranch, functions);
+                collectFunctions(ifStmt->elseBranch, functions);
+                break;
+            }
+            case StmtType::WHILE:
+                collectFunctions(std::static_pointer_cast<WhileStmt>(stmt)->body, functions);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+bool SideEffects::isPureNative(const std::string& name) {
+    return name == "toString" || name == "toInt" || name == "toFloat" ||
+           name == "length" || name == "substring" || name == "concat";
+}
+
+bool SideEffects::isIONative(const std::string& name) {
+    return name == "print" || name == "input";
+}
+
+void SideEffects::summarize(const FunctionDeclStmt& function) {
+    // A name is local only after its declaration and inside its block, so
+    // a global read before a `let` of the same name, or outside the block
+    // declaring it, still counts
+    DirectEffects effects;
+    effects.scopes.emplace_back();
+    for (const auto& param : function.parameters) {
+        effects.declare(std::string(param.first.lexeme));
+    }
+    walk(function.body, effects);
+
+    // A function declared twice gets the union of both bodies
+    Summary& summary = functions[std::string(function.name.lexeme)];
+    summary.reads.insert(effects.reads.begin(), effects.reads.end());
+    summary.writes.insert(effects.writes.begin(), effects.writes.end());
+    callGraph[std::string(function.name.lexeme)].insert(effects.calls.begin(), effects.calls.end());
+}
+
+void SideEffects::analyze(const ProgramPtr& program) {
+    functions.clear();
+    callGraph.clear();
+
+    std::vector<const FunctionDeclStmt*> declarations;
+    for (const auto& stmt : program->statements) {
+        collectFunctions(stmt, declarations);
+    }
+    for (const FunctionDeclStmt* function : declarations) {
+        summarize(*function);
+    }
+
+    // Fold callee effects into callers until nothing changes
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& [name, summary] : functions) {
+            for (const auto& callee : callGraph[name]) {
+                auto it = functions.find(callee);
+                if (it == functions.end()) {
+                    bool io = summary.io || isIONative(callee);
+                    bool unknown = summary.unknownCalls || (!isIONative(callee) && !isPureNative(callee));
+                    changed |= io != summary.io || unknown != summary.unknownCalls;
+                    summary.io = io;
+                    summary.unknownCalls = unknown;
+                    continue;
+                }
+                const Summary& other = it->second;
+                if (&other == &summary) continue;
+                size_t before = summary.reads.size() + summary.writes.size();
+                summary.reads.insert(other.reads.begin(), other.reads.end());
+                summary.writes.insert(other.writes.begin(), other.writes.end());
+                bool io = summary.io || other.io;
+                bool unknown = summary.unknownCalls || other.unknownCalls;
+                changed |= before != summary.reads.size() + summary.writes.size() ||
+                           io != summary.io || unknown != summary.unknownCalls;
+                summary.io = io;
+                summary.unknownCalls = unknown;
+            }
+        }
+    }
+
+    // Recursion through other functions: the function reaches itself
+    for (auto& [name, summary] : functions) {
+        std::unordered_set<std::string> visited;
+        std::vector<std::string> stack(callGraph[name].begin(), callGraph[name].end());
+        while (!stack.empty() && !summary.recursive) {
+            std::string callee = stack.back();
+            stack.pop_back();
+            if (callee == name) {
+                summary.recursive = true;
+            } else if (functions.count(callee) && visited.insert(callee).second) {
+                stack.insert(stack.end(), callGraph[callee].begin(), callGraph[callee].end());
+            }
+        }
+    }
+}
+
+const SideEffects::Summary* SideEffects::find(const std::string& function) const {
+    auto it = functions.find(function);
+    return it == functions.end() ? nullptr : &it->second;
+}
+
+bool SideEffects::isPure(const std::string& function) const {
+    if (isPureNative(function)) return true;
+    const Summary* summary = find(function);
+    return summary && !summary->io && !summary->unknownCalls && summary->writes.empty();
+}
+
+bool SideEffects::collectWrites(const StmtPtr& stmt, std::unordered_set<std::string>& writes) const {
+    DirectEffects effects;
+    walk(stmt, effects);
+    writes.insert(effects.declared.begin(), effects.declared.end());
+    writes.insert(effects.writes.begin(), effects.writes.end());
+
+    for (const auto& callee : effects.calls) {
+        const Summary* summary = find(callee);
+        if (summary) {
+            if (summary->unknownCalls) return false;
+            writes.insert(summary->writes.begin(), summary->writes.end());
+        } else if (!isIONative(callee) && !isPureNative(callee)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SideEffects::collectWrites(const ExprPtr& expr, std::unordered_set<std::string>& writes) const {
+    return collectWrites(std::make_shared<ExpressionStmt>(expr), writes);
+}
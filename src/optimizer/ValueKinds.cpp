@@ -0,0 +1,253 @@
+#include "ValueKinds.h"
+#include <vector>
+
+namespace {
+    using Kind = ValueKinds::Kind;
+
+    bool isNumeric(Kind kind) {
+        return ValueKinds::isNumeric(kind);
+    }
+
+    Kind join(Kind a, Kind b) {
+        if (a == Kind::NONE) return b;
+        if (b == Kind::NONE || a == b) return a;
+        if (isNumeric(a) && isNumeric(b)) return Kind::NUMBER;
+        return Kind::UNKNOWN;
+    }
+
+    // int op int stays int; a float on either side makes a float
+    Kind arithmetic(Kind left, Kind right) {
+        if (left == Kind::INT && right == Kind::INT) return Kind::INT;
+        if (left == Kind::FLOAT || right == Kind::FLOAT) return Kind::FLOAT;
+        return Kind::NUMBER;
+    }
+
+    bool isNonZeroLiteral(const ExprPtr& expr, bool intOnly) {
+        if (expr->getType() != ExprType::LITERAL) return false;
+        const Value& value = std::static_pointer_cast<LiteralExpr>(expr)->value;
+        if (std::holds_alternative<int>(value)) return std::get<int>(value) != 0;
+        return !intOnly && std::holds_alternative<float>(value) && std::get<float>(value) != 0.0f;
+    }
+
+    int lineOf(const ExprPtr& expr) {
+        switch (expr->getType()) {
+            case ExprType::VARIABLE: return std::static_pointer_cast<VariableExpr>(expr)->name.line();
+            case ExprType::BINARY: return std::static_pointer_cast<BinaryExpr>(expr)->op.line();
+            case ExprType::UNARY: return std::static_pointer_cast<UnaryExpr>(expr)->op.line();
+            case ExprType::CALL: return std::static_pointer_cast<CallExpr>(expr)->callee.line();
+            case ExprType::ASSIGNMENT: return std::static_pointer_cast<AssignmentExpr>(expr)->name.line();
+            default: return 0;
+        }
+    }
+
+    bool containsCall(const ExprPtr& expr) {
+        switch (expr->getType()) {
+            case ExprType::CALL:
+                return true;
+            case ExprType::BINARY: {
+                auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+                return containsCall(binary->left) || containsCall(binary->right);
+            }
+            case ExprType::UNARY:
+                return containsCall(std::static_pointer_cast<UnaryExpr>(expr)->right);
+            default:
+                return false;
+        }
+    }
+
+    // Every definition of a variable, by name
+    void collectDefinitions(const StmtPtr& stmt, std::vector<std::pair<std::string, ExprPtr>>& definitions,
+                            std::unordered_map<std::string, Kind>& kinds);
+
+    void collectDefinitions(const ExprPtr& expr, std::vector<std::pair<std::string, ExprPtr>>& definitions) {
+        if (!expr) return;
+        switch (expr->getType()) {
+            case ExprType::BINARY: {
+                auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+                collectDefinitions(binary->left, definitions);
+                collectDefinitions(binary->right, definitions);
+                break;
+            }
+            case ExprType::UNARY:
+                collectDefinitions(std::static_pointer_cast<UnaryExpr>(expr)->right, definitions);
+                break;
+            case ExprType::CALL:
+                for (const auto& argument : std::static_pointer_cast<CallExpr>(expr)->arguments) {
+                    collectDefinitions(argument, definitions);
+                }
+                break;
+            case ExprType::ASSIGNMENT: {
+                auto assignment = std::static_pointer_cast<AssignmentExpr>(expr);
+                definitions.push_back({std::string(assignment->name.lexeme), assignment->value});
+                collectDefinitions(assignment->value, definitions);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void collectDefinitions(const StmtPtr& stmt, std::vector<std::pair<std::string, ExprPtr>>& definitions,
+                            std::unordered_map<std::string, Kind>& kinds) {
+        if (!stmt) return;
+        switch (stmt->getType()) {
+            case StmtType::EXPRESSION:
+                collectDefinitions(std::static_pointer_cast<ExpressionStmt>(stmt)->expression, definitions);
+                break;
+            case StmtType::PRINT:
+                for (const auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                    collectDefinitions(expr, definitions);
+                }
+                break;
+            case StmtType::VARIABLE_DECL: {
+                auto decl = std::static_pointer_cast<VariableDeclStmt>(stmt);
+                if (decl->initializer) {
+                    definitions.push_back({std::string(decl->name.lexeme), decl->initializer});
+                    collectDefinitions(decl->initializer, definitions);
+                } else {
+                    kinds[std::string(decl->name.lexeme)] = Kind::UNKNOWN;   // Starts out null
+                }
+                break;
+            }
+            case StmtType::BLOCK:
+                for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                    collectDefinitions(inner, definitions, kinds);
+                }
+                break;
+            case StmtType::IF: {
+                auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+                collectDefinitions(ifStmt->condition, definitions);
+                collectDefinitions(ifStmt->thenBranch, definitions, kinds);
+                collectDefinitions(ifStmt->elseBranch, definitions, kinds);
+                break;
+            }
+            case StmtType::WHILE: {
+                auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+                collectDefinitions(whileStmt->condition, definitions);
+                collectDefinitions(whileStmt->body, definitions, kinds);
+                break;
+            }
+            case StmtType::FUNCTION_DECL: {
+                // Arguments can be anything
+                auto function = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+                kinds[std::string(function->name.lexeme)] = Kind::UNKNOWN;
+                for (const auto& param : function->parameters) {
+                    kinds[std::string(param.first.lexeme)] = Kind::UNKNOWN;
+                }
+                collectDefinitions(function->body, definitions, kinds);
+                break;
+            }
+            case StmtType::RETURN:
+                collectDefinitions(std::static_pointer_cast<ReturnStmt>(stmt)->value, definitions);
+                break;
+        }
+    }
+}
+
+bool ValueKinds::isNumeric(Kind kind) {
+    return kind == Kind::INT || kind == Kind::FLOAT || kind == Kind::NUMBER;
+}
+
+void ValueKinds::infer(const ProgramPtr& program) {
+    kinds.clear();
+    std::vector<std::pair<std::string, ExprPtr>> definitions;
+    for (const auto& stmt : program->statements) {
+        collectDefinitions(stmt, definitions, kinds);
+    }
+
+    // Optimistic fixpoint: a variable has a kind once every definition agrees
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto& [name, value] : definitions) {
+            Kind& kind = kinds[name];
+            Kind joined = join(kind, kindOf(value));
+            if (joined != kind) {
+                kind = joined;
+                changed = true;
+            }
+        }
+    }
+}
+
+// A failed operation yields null, so anything that can fail is UNKNOWN
+ValueKinds::Kind ValueKinds::kindOf(const ExprPtr& expr) const {
+    switch (expr->getType()) {
+        case ExprType::LITERAL: {
+            const Value& value = std::static_pointer_cast<LiteralExpr>(expr)->value;
+            if (std::holds_alternative<int>(value)) return Kind::INT;
+            if (std::holds_alternative<float>(value)) return Kind::FLOAT;
+            if (std::holds_alternative<bool>(value)) return Kind::BOOL;
+            return Kind::STRING;
+        }
+        case ExprType::VARIABLE: {
+            auto it = kinds.find(std::string(std::static_pointer_cast<VariableExpr>(expr)->name.lexeme));
+            return it == kinds.end() ? Kind::NONE : it->second;
+        }
+        case ExprType::ASSIGNMENT:
+            return kindOf(std::static_pointer_cast<AssignmentExpr>(expr)->value);
+        case ExprType::UNARY: {
+            auto unary = std::static_pointer_cast<UnaryExpr>(expr);
+            if (unary->op.type == TokenType::NOT) return Kind::BOOL;
+            Kind operand = kindOf(unary->right);
+            return isNumeric(operand) || operand == Kind::NONE ? operand : Kind::UNKNOWN;
+        }
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            TokenType op = binary->op.type;
+            if (op == TokenType::EQUAL || op == TokenType::NOT_EQUAL || op == TokenType::AND || op == TokenType::OR) {
+                return Kind::BOOL;
+            }
+            Kind left = kindOf(binary->left);
+            Kind right = kindOf(binary->right);
+            if (op == TokenType::PLUS && (left == Kind::STRING || right == Kind::STRING)) {
+                return Kind::STRING;
+            }
+            if (left == Kind::NONE || right == Kind::NONE) {
+                return Kind::NONE;
+            }
+            switch (op) {
+                case TokenType::PLUS:
+                case TokenType::MINUS:
+                case TokenType::MULTIPLY:
+                    return isNumeric(left) && isNumeric(right) ? arithmetic(left, right) : Kind::UNKNOWN;
+                case TokenType::DIVIDE:
+                    return isNumeric(left) && isNumeric(right) && isNonZeroLiteral(binary->right, false)
+                               ? Kind::FLOAT : Kind::UNKNOWN;
+                case TokenType::MODULO:
+                    return left == Kind::INT && right == Kind::INT && isNonZeroLiteral(binary->right, true)
+                               ? Kind::INT : Kind::UNKNOWN;
+                case TokenType::LESS:
+                case TokenType::GREATER:
+                case TokenType::LESS_EQUAL:
+                case TokenType::GREATER_EQUAL:
+                    return (isNumeric(left) && isNumeric(right)) || (left == Kind::STRING && right == Kind::STRING)
+                               ? Kind::BOOL : Kind::UNKNOWN;
+                default:
+                    return Kind::UNKNOWN;
+            }
+        }
+        default:
+            return Kind::UNKNOWN;
+    }
+}
+
+bool ValueKinds::cannotTrap(const ExprPtr& expr) const {
+    switch (expr->getType()) {
+        case ExprType::LITERAL:
+        case ExprType::VARIABLE:
+            return true;
+        case ExprType::UNARY: {
+            auto unary = std::static_pointer_cast<UnaryExpr>(expr);
+            return cannotTrap(unary->right) && (unary->op.type == TokenType::NOT || isNumeric(kindOf(unary->right)));
+        }
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            Kind kind = kindOf(expr);
+            return cannotTrap(binary->left) && cannotTrap(binary->right) &&
+                   kind != Kind::UNKNOWN && kind != Kind::NONE;
+        }
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,159 @@
+#include "ASTPrinter.h"
+#include "../core/Numbers.h"
+
+namespace {
+    std::string literalText(const Value& value) {
+        if (std::holds_alternative<int>(value)) return Numbers::toString(std::get<int>(value));
+        if (std::holds_alternative<float>(value)) return Numbers::toString(std::get<float>(value));
+        if (std::holds_alternative<bool>(value)) return std::get<bool>(value) ? "true" : "false";
+        return "\"" + std::get<std::string>(value) + "\"";
+    }
+
+    std::string typeText(TokenType type) {
+        switch (type) {
+            case TokenType::INT_TYPE: return "int";
+            case TokenType::FLOAT_TYPE: return "float";
+            case TokenType::BOOL_TYPE: return "bool";
+            case TokenType::STRING_TYPE: return "string";
+            default: return "void";
+        }
+    }
+
+    // Binary expressions already carry their parentheses
+    std::string conditionText(const ExprPtr& condition) {
+        std::string text = ASTPrinter::print(condition);
+        return condition && condition->getType() == ExprType::BINARY ? text : "(" + text + ")";
+    }
+}
+
+std::string ASTPrinter::print(const ExprPtr& expr) {
+    if (!expr) {
+        return "";
+    }
+    switch (expr->getType()) {
+        case ExprType::LITERAL:
+            return literalText(std::static_pointer_cast<LiteralExpr>(expr)->value);
+        case ExprType::VARIABLE:
+            return std::string(std::static_pointer_cast<VariableExpr>(expr)->name.lexeme);
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            return "(" + print(binary->left) + " " + std::string(binary->op.lexeme) + " " + print(binary->right) + ")";
+        }
+        case ExprType::UNARY: {
+            auto unary = std::static_pointer_cast<UnaryExpr>(expr);
+            return "(" + std::string(unary->op.lexeme) + print(unary->right) + ")";
+        }
+        case ExprType::CALL: {
+            auto call = std::static_pointer_cast<CallExpr>(expr);
+            std::string text = std::string(call->callee.lexeme) + "(";
+            for (size_t i = 0; i < call->arguments.size(); i++) {
+                text += (i > 0 ? ", " : "") + print(call->arguments[i]);
+            }
+            return text + ")";
+        }
+        case ExprType::ASSIGNMENT: {
+            auto assignment = std::static_pointer_cast<AssignmentExpr>(expr);
+            return std::string(assignment->name.lexeme) + " = " + print(assignment->value);
+        }
+    }
+    return "";
+}
+
+// `{`, the statements one level deeper, and the closing `}` at `depth`;
+// a branch that is not a block prints as a block of one statement
+void ASTPrinter::printBranch(const StmtPtr& stmt, int depth, std::string& out) {
+    out += "{\n";
+    if (stmt && stmt->getType() == StmtType::BLOCK) {
+        for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+            printStatement(inner, depth + 1, out);
+        }
+    } else {
+        printStatement(stmt, depth + 1, out);
+    }
+    out += std::string(depth * 2, ' ') + "}";
+}
+
+void ASTPrinter::printStatement(const StmtPtr& stmt, int depth, std::string& out) {
+    if (!stmt) {
+        return;
+    }
+    std::string indent(depth * 2, ' ');
+    out += indent;
+
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            out += print(std::static_pointer_cast<ExpressionStmt>(stmt)->expression) + ";\n";
+            break;
+        case StmtType::PRINT: {
+            auto printStmt = std::static_pointer_cast<PrintStmt>(stmt);
+            out += "print(";
+            for (size_t i = 0; i < printStmt->expressions.size(); i++) {
+                out += (i > 0 ? ", " : "") + print(printStmt->expressions[i]);
+            }
+            out += ");\n";
+            break;
+        }
+        case StmtType::VARIABLE_DECL: {
+            auto decl = std::static_pointer_cast<VariableDeclStmt>(stmt);
+            out += "let " + std::string(decl->name.lexeme);
+            if (decl->initializer) {
+                out += " = " + print(decl->initializer);
+            }
+            out += ";\n";
+            break;
+        }
+        case StmtType::BLOCK:
+            printBranch(stmt, depth, out);
+            out += "\n";
+            break;
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            out += "if " + conditionText(ifStmt->condition) + " then ";
+            printBranch(ifStmt->thenBranch, depth, out);
+            if (ifStmt->elseBranch) {
+                out += " else ";
+                printBranch(ifStmt->elseBranch, depth, out);
+            }
+            out += " end;\n";
+            break;
+        }
+        case StmtType::WHILE: {
+            auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+            out += "while " + conditionText(whileStmt->condition) + " do ";
+            printBranch(whileStmt->body, depth, out);
+            out += " end;\n";
+            break;
+        }
+        case StmtType::FUNCTION_DECL: {
+            auto function = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+            out += "function " + std::string(function->name.lexeme) + "(";
+            for (size_t i = 0; i < function->parameters.size(); i++) {
+                out += (i > 0 ? ", " : "") + std::string(function->parameters[i].first.lexeme) + ": " +
+                       typeText(function->parameters[i].second);
+            }
+            out += "): " + typeText(function->returnType) + " ";
+            printBranch(function->body, depth, out);
+            out += "\n";
+            break;
+        }
+        case StmtType::RETURN: {
+            auto returnStmt = std::static_pointer_cast<ReturnStmt>(stmt);
+            out += returnStmt->value ? "return " + print(returnStmt->value) + ";\n" : "return;\n";
+            break;
+        }
+    }
+}
+
+std::string ASTPrinter::print(const StmtPtr& stmt) {
+    std::string out;
+    printStatement(stmt, 0, out);
+    return out;
+}
+
+std::string ASTPrinter::print(const ProgramPtr& program) {
+    std::string out;
+    for (const auto& stmt : program->statements) {
+        printStatement(stmt, 0, out);
+    }
+    return out;
+}
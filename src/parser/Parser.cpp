@@ -1,17 +1,24 @@
 #include "Parser.h"
+#include <algorithm>
 #include <memory>
 
-Parser::Parser(Lexer& lexer) : lexer(lexer), current(lexer.nextToken()) {
-    previous = current;
+Parser::Parser(Lexer& lexer) : Parser(lexer.tokenize()) {}
+
+Parser::Parser(TokenBuffer tokens) : tokens(std::move(tokens)), position(0), previousIndex(0) {}
+
+TokenType Parser::peekNext() const {
+    return tokens.type(std::min(position + 1, tokens.size() - 1));
 }
 
 void Parser::advance() {
-    previous = current;
-    current = lexer.nextToken();
+    previousIndex = position;
+    if (position + 1 < tokens.size()) {
+        position++;
+    }
 }
 
 bool Parser::check(TokenType type) const {
-    return current.type == type;
+    return tokens.type(position) == type;
 }
 
 bool Parser::match(TokenType type) {
@@ -27,22 +34,21 @@ bool Parser::consume(TokenType type, const std::string& message) {
         advance();
         return true;
     }
-    reportError(current, message);
+    reportError(current(), message);
     return false;
 }
 
 Token Parser::consume(TokenType type) {
     if (check(type)) {
-        Token token = current;
         advance();
-        return token;
+        return previous();
     }
-    reportError(current, "Expected " + std::to_string(static_cast<int>(type)));
-    return Token(TokenType::ERROR, "", 0, current.line, current.column);
+    reportError(current(), "Expected " + std::to_string(static_cast<int>(type)));
+    return Token(TokenType::ERROR, tokens.getSource(), tokens.offset(position), 0);
 }
 
 void Parser::reportError(const Token& token, const std::string& message) {
-    errors.push_back(Error(ErrorType::SYNTAX, message, token.line, token.column, "Parser"));
+    errors.push_back(Error(ErrorType::SYNTAX, message, token.line(), token.column(), "Parser"));
 }
 
 ProgramPtr Parser::parse() {
@@ -53,34 +59,45 @@ ProgramPtr Parser::parseProgram() {
     std::vector<StmtPtr> statements;
     
     while (!check(TokenType::END_OF_FILE)) {
+        size_t start = position;
         try {
             StmtPtr stmt = parseStatement();
             if (stmt) {
                 statements.push_back(stmt);
+            } else {
+                synchronize(start);
             }
         } catch (...) {
-            // Synchronize on statement boundaries
-            while (!check(TokenType::END_OF_FILE) && 
-                   !check(TokenType::SEMICOLON) &&
-                   !check(TokenType::LET) &&
-                   !check(TokenType::IF) &&
-                   !check(TokenType::WHILE) &&
-                   !check(TokenType::FUNCTION) &&
-                   !check(TokenType::PRINT)) {
-                advance();
-            }
-            
-            if (check(TokenType::SEMICOLON)) {
-                advance();
-            }
+            synchronize(start);
         }
     }
     
     return std::make_shared<Program>(statements);
 }
 
+void Parser::synchronize(size_t start) {
+    // A statement that failed on its first token still consumes it, so
+    // the loops calling parseStatement() always move on
+    bool moved = position != start;
+    while (!check(TokenType::END_OF_FILE) && !check(TokenType::SEMICOLON)) {
+        if (moved && (check(TokenType::LET) || check(TokenType::IF) || check(TokenType::WHILE) ||
+                      check(TokenType::FUNCTION) || check(TokenType::RETURN) || check(TokenType::RIGHT_BRACE))) {
+            return;
+        }
+        advance();
+        moved = true;
+    }
+    
+    if (check(TokenType::SEMICOLON)) {
+        advance();
+    }
+}
+
 StmtPtr Parser::parseStatement() {
-    if (match(TokenType::LET)) {
+    if (check(TokenType::LEFT_BRACE)) {
+        // A block groups several statements, e.g. a loop body between 'do' and 'end'
+        return parseBlock();
+    } else if (match(TokenType::LET)) {
         return parseVariableDeclaration();
     } else if (match(TokenType::IF)) {
         return parseIfStatement();
@@ -91,16 +108,15 @@ StmtPtr Parser::parseStatement() {
     } else if (match(TokenType::RETURN)) {
         return parseReturnStatement();
     } else if (check(TokenType::IDENTIFIER) && peekNext() == TokenType::LEFT_PAREN) {
+        // Calls, print(...) among them
         return parseExpressionStatement();
-    } else if (check(TokenType::PRINT)) {
-        return parsePrintStatement();
     } else {
         return parseExpressionStatement();
     }
 }
 
 StmtPtr Parser::parsePrintStatement() {
-    Token printToken = previous;
+    Token printToken = previous();
     
     if (!consume(TokenType::LEFT_PAREN, "Expected '(' after 'print'")) {
         return nullptr;
@@ -132,16 +148,16 @@ StmtPtr Parser::parseVariableDeclaration() {
     if (!consume(TokenType::IDENTIFIER, "Expected variable name")) {
         return nullptr;
     }
-    Token name = previous;
+    Token name = previous();
     
     if (!match(TokenType::ASSIGN)) {
-        reportError(current, "Expected '=' in variable declaration");
+        reportError(current(), "Expected '=' in variable declaration");
         return nullptr;
     }
     
     ExprPtr initializer = parseExpression();
     if (!initializer) {
-        reportError(current, "Expected expression in variable declaration");
+        reportError(current(), "Expected expression in variable declaration");
         return nullptr;
     }
     
@@ -159,7 +175,7 @@ StmtPtr Parser::parseIfStatement() {
     
     ExprPtr condition = parseExpression();
     if (!condition) {
-        reportError(current, "Expected condition expression");
+        reportError(current(), "Expected condition expression");
         return nullptr;
     }
     
@@ -173,7 +189,7 @@ StmtPtr Parser::parseIfStatement() {
     
     StmtPtr thenBranch = parseStatement();
     if (!thenBranch) {
-        reportError(current, "Expected statement after 'then'");
+        reportError(current(), "Expected statement after 'then'");
         return nullptr;
     }
     
@@ -181,7 +197,7 @@ StmtPtr Parser::parseIfStatement() {
     if (match(TokenType::ELSE)) {
         elseBranch = parseStatement();
         if (!elseBranch) {
-            reportError(current, "Expected statement after 'else'");
+            reportError(current(), "Expected statement after 'else'");
             return nullptr;
         }
     }
@@ -204,7 +220,7 @@ StmtPtr Parser::parseWhileStatement() {
     
     ExprPtr condition = parseExpression();
     if (!condition) {
-        reportError(current, "Expected condition expression");
+        reportError(current(), "Expected condition expression");
         return nullptr;
     }
     
@@ -218,7 +234,7 @@ StmtPtr Parser::parseWhileStatement() {
     
     StmtPtr body = parseStatement();
     if (!body) {
-        reportError(current, "Expected statement after 'do'");
+        reportError(current(), "Expected statement after 'do'");
         return nullptr;
     }
     
@@ -241,9 +257,12 @@ StmtPtr Parser::parseBlock() {
     std::vector<StmtPtr> statements;
     
     while (!check(TokenType::RIGHT_BRACE) && !check(TokenType::END_OF_FILE)) {
+        size_t start = position;
         StmtPtr stmt = parseStatement();
         if (stmt) {
             statements.push_back(stmt);
+        } else {
+            synchronize(start);
         }
     }
     
@@ -258,7 +277,7 @@ StmtPtr Parser::parseFunctionDeclaration() {
     if (!consume(TokenType::IDENTIFIER, "Expected function name")) {
         return nullptr;
     }
-    Token name = previous;
+    Token name = previous();
     
     if (!consume(TokenType::LEFT_PAREN, "Expected '(' after function name")) {
         return nullptr;
@@ -271,7 +290,7 @@ StmtPtr Parser::parseFunctionDeclaration() {
             if (!consume(TokenType::IDENTIFIER, "Expected parameter name")) {
                 return nullptr;
             }
-            Token paramName = previous;
+            Token paramName = previous();
             
             if (!consume(TokenType::COLON, "Expected ':' after parameter name")) {
                 return nullptr;
@@ -283,7 +302,7 @@ StmtPtr Parser::parseFunctionDeclaration() {
             else if (match(TokenType::BOOL_TYPE)) paramType = TokenType::BOOL_TYPE;
             else if (match(TokenType::STRING_TYPE)) paramType = TokenType::STRING_TYPE;
             else {
-                reportError(current, "Expected type after ':'");
+                reportError(current(), "Expected type after ':'");
                 return nullptr;
             }
             
@@ -303,14 +322,14 @@ StmtPtr Parser::parseFunctionDeclaration() {
         else if (match(TokenType::STRING_TYPE)) returnType = TokenType::STRING_TYPE;
         else if (match(TokenType::VOID_TYPE)) returnType = TokenType::VOID_TYPE;
         else {
-            reportError(current, "Expected return type after ':'");
+            reportError(current(), "Expected return type after ':'");
             return nullptr;
         }
     }
     
     StmtPtr body = parseBlock();
     if (!body) {
-        reportError(current, "Expected function body");
+        reportError(current(), "Expected function body");
         return nullptr;
     }
     
@@ -318,7 +337,7 @@ StmtPtr Parser::parseFunctionDeclaration() {
 }
 
 StmtPtr Parser::parseReturnStatement() {
-    Token keyword = previous;
+    Token keyword = previous();
     
     ExprPtr value = nullptr;
     if (!check(TokenType::SEMICOLON)) {
@@ -335,7 +354,7 @@ StmtPtr Parser::parseReturnStatement() {
 StmtPtr Parser::parseExpressionStatement() {
     ExprPtr expr = parseExpression();
     if (!expr) {
-        reportError(current, "Expected expression");
+        reportError(current(), "Expected expression");
         return nullptr;
     }
     
@@ -360,7 +379,7 @@ ExprPtr Parser::parseAssignment() {
                 return std::make_shared<AssignmentExpr>(varExpr->name, value);
             }
         } else {
-            reportError(previous, "Invalid assignment target");
+            reportError(previous(), "Invalid assignment target");
         }
     }
     
@@ -371,7 +390,7 @@ ExprPtr Parser::parseEquality() {
     ExprPtr expr = parseComparison();
     
     while (match(TokenType::EQUAL) || match(TokenType::NOT_EQUAL)) {
-        Token op = previous;
+        Token op = previous();
         ExprPtr right = parseComparison();
         if (right) {
             expr = std::make_shared<BinaryExpr>(expr, op, right);
@@ -386,7 +405,7 @@ ExprPtr Parser::parseComparison() {
     
     while (match(TokenType::LESS) || match(TokenType::LESS_EQUAL) || 
            match(TokenType::GREATER) || match(TokenType::GREATER_EQUAL)) {
-        Token op = previous;
+        Token op = previous();
         ExprPtr right = parseTerm();
         if (right) {
             expr = std::make_shared<BinaryExpr>(expr, op, right);
@@ -400,7 +419,7 @@ ExprPtr Parser::parseTerm() {
     ExprPtr expr = parseFactor();
     
     while (match(TokenType::PLUS) || match(TokenType::MINUS)) {
-        Token op = previous;
+        Token op = previous();
         ExprPtr right = parseFactor();
         if (right) {
             expr = std::make_shared<BinaryExpr>(expr, op, right);
@@ -414,7 +433,7 @@ ExprPtr Parser::parseFactor() {
     ExprPtr expr = parseUnary();
     
     while (match(TokenType::MULTIPLY) || match(TokenType::DIVIDE) || match(TokenType::MODULO)) {
-        Token op = previous;
+        Token op = previous();
         ExprPtr right = parseUnary();
         if (right) {
             expr = std::make_shared<BinaryExpr>(expr, op, right);
@@ -426,7 +445,7 @@ ExprPtr Parser::parseFactor() {
 
 ExprPtr Parser::parseUnary() {
     if (match(TokenType::MINUS) || match(TokenType::NOT)) {
-        Token op = previous;
+        Token op = previous();
         ExprPtr right = parseUnary();
         if (right) {
             return std::make_shared<UnaryExpr>(op, right);
@@ -452,19 +471,19 @@ ExprPtr Parser::parseCall() {
 
 ExprPtr Parser::parsePrimary() {
     if (match(TokenType::INT_LITERAL)) {
-        return std::make_shared<LiteralExpr>(previous.value);
+        return std::make_shared<LiteralExpr>(*tokens.literal(previousIndex));
     }
     if (match(TokenType::FLOAT_LITERAL)) {
-        return std::make_shared<LiteralExpr>(previous.value);
+        return std::make_shared<LiteralExpr>(*tokens.literal(previousIndex));
     }
     if (match(TokenType::BOOL_LITERAL)) {
-        return std::make_shared<LiteralExpr>(previous.value);
+        return std::make_shared<LiteralExpr>(*tokens.literal(previousIndex));
     }
     if (match(TokenType::STRING_LITERAL)) {
-        return std::make_shared<LiteralExpr>(previous.value);
+        return std::make_shared<LiteralExpr>(*tokens.literal(previousIndex));
     }
     if (match(TokenType::IDENTIFIER)) {
-        return std::make_shared<VariableExpr>(previous);
+        return std::make_shared<VariableExpr>(previous());
     }
     if (match(TokenType::LEFT_PAREN)) {
         ExprPtr expr = parseExpression();
@@ -474,7 +493,7 @@ ExprPtr Parser::parsePrimary() {
         return expr;
     }
     
-    reportError(current, "Expected expression");
+    reportError(current(), "Expected expression");
     return nullptr;
 }
 
@@ -484,7 +503,7 @@ ExprPtr Parser::finishCall(ExprPtr callee) {
     if (!check(TokenType::RIGHT_PAREN)) {
         do {
             if (arguments.size() >= 255) {
-                reportError(current, "Cannot have more than 255 arguments");
+                reportError(current(), "Cannot have more than 255 arguments");
             }
             ExprPtr arg = parseExpression();
             if (arg) {
@@ -501,6 +520,6 @@ ExprPtr Parser::finishCall(ExprPtr callee) {
         return std::make_shared<CallExpr>(varExpr->name, arguments);
     }
     
-    reportError(previous, "Expected function name");
+    reportError(previous(), "Expected function name");
     return callee;
 }
\ No newline at end of file
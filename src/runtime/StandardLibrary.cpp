@@ -1,4 +1,5 @@
 #include "StandardLibrary.h"
+#include "../core/Numbers.h"
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -91,7 +92,11 @@ Value StandardLibrary::toInt(const std::vector<Value>& args) {
             return std::get<bool>(arg) ? 1 : 0;
         }
         if (std::holds_alternative<std::string>(arg)) {
-            return std::stoi(std::get<std::string>(arg));
+            int value;
+            if (Numbers::parse(std::get<std::string>(arg), value)) {
+                return value;
+            }
+            throw std::runtime_error("Cannot convert to integer");
         }
     } catch (...) {
         throw std::runtime_error("Cannot convert to integer");
@@ -118,7 +123,11 @@ Value StandardLibrary::toFloat(const std::vector<Value>& args) {
             return std::get<bool>(arg) ? 1.0f : 0.0f;
         }
         if (std::holds_alternative<std::string>(arg)) {
-            return std::stof(std::get<std::string>(arg));
+            float value;
+            if (Numbers::parse(std::get<std::string>(arg), value)) {
+                return value;
+            }
+            throw std::runtime_error("Cannot convert to float");
         }
     } catch (...) {
         throw std::runtime_error("Cannot convert to float");
@@ -0,0 +1,262 @@
+#include "EscapeAnalysis.h"
+#include <algorithm>
+#include <set>
+#include <sstream>
+
+namespace {
+    // Names a statement declares in the frame it runs in; branches that are
+    // not blocks run in the same frame
+    void collectNames(const StmtPtr& stmt, std::unordered_set<std::string>& names) {
+        if (!stmt) return;
+        switch (stmt->getType()) {
+            case StmtType::VARIABLE_DECL:
+                names.insert(std::string(std::static_pointer_cast<VariableDeclStmt>(stmt)->name.lexeme));
+                break;
+            case StmtType::FUNCTION_DECL:
+                names.insert(std::string(std::static_pointer_cast<FunctionDeclStmt>(stmt)->name.lexeme));
+                break;
+            case StmtType::IF: {
+                auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+                collectNames(ifStmt->thenBranch, names);
+                collectNames(ifStmt->elseBranch, names);
+                break;
+            }
+            case StmtType::WHILE:
+                collectNames(std::static_pointer_cast<WhileStmt>(stmt)->body, names);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void EscapeAnalysis::pushScope(const void* owner, const std::vector<StmtPtr>& statements) {
+    Scope scope{owner, {}, {}};
+    for (const auto& stmt : statements) {
+        collectNames(stmt, scope.names);
+    }
+    scopes.push_back(std::move(scope));
+    if (owner) frames.insert(owner);
+}
+
+// Innermost scope that has declared the name so far, -1 if none
+int EscapeAnalysis::resolve(const std::string& name) const {
+    for (int i = static_cast<int>(scopes.size()) - 1; i >= 0; i--) {
+        if (scopes[i].declared.count(name)) return i;
+    }
+    return -1;
+}
+
+void EscapeAnalysis::use(const std::string& name, bool asValue) {
+    int index = resolve(name);
+    // A function reached through an upvalue is called from wherever the
+    // function using it ends up, so it has to outlive its frame as well
+    bool captured = !active.empty() && index != 0 && index < static_cast<int>(active.back().frame);
+    if (asValue || captured) {
+        if (index >= 0) {
+            const FunctionDeclStmt* function = scopes[index].declared.at(name);
+            if (function) functions[function].escapes = true;
+        } else {
+            // Not declared yet, so it could be any function of that name
+            for (const FunctionDeclStmt* function : byName[name]) {
+                functions[function].escapes = true;
+            }
+        }
+    }
+    if (active.empty() || index >= static_cast<int>(active.back().frame)) {
+        return;
+    }
+
+    // A declaration that runs later in a frame between here and the one
+    // the name resolves to would be found first at call time
+    size_t innermost = active.back().frame;
+    for (size_t s = index < 1 ? 1 : index + 1; s < innermost; s++) {
+        if (!scopes[s].names.count(name)) continue;
+        for (const auto& function : active) {
+            if (function.frame > s) functions[function.function].capturesFrame = true;
+        }
+    }
+
+    // Every function between the use and the declaration needs the upvalue
+    if (index > 0) {
+        for (const auto& function : active) {
+            if (function.frame <= static_cast<size_t>(index)) continue;
+            auto& upvalues = functions[function.function].upvalues;
+            if (std::find(upvalues.begin(), upvalues.end(), name) == upvalues.end()) {
+                upvalues.push_back(name);
+            }
+            captures.push_back({function.function, scopes[index].owner, name});
+        }
+    }
+}
+
+void EscapeAnalysis::walk(const StmtPtr& stmt) {
+    if (!stmt) return;
+    switch (stmt->getType()) {
+        case StmtType::EXPRESSION:
+            walk(std::static_pointer_cast<ExpressionStmt>(stmt)->expression);
+            break;
+        case StmtType::PRINT:
+            for (const auto& expr : std::static_pointer_cast<PrintStmt>(stmt)->expressions) {
+                walk(expr);
+            }
+            break;
+        case StmtType::VARIABLE_DECL: {
+            // The initializer runs before the name is defined
+            auto decl = std::static_pointer_cast<VariableDeclStmt>(stmt);
+            walk(decl->initializer);
+            scopes.back().declared[std::string(decl->name.lexeme)] = nullptr;
+            break;
+        }
+        case StmtType::BLOCK: {
+            auto block = std::static_pointer_cast<BlockStmt>(stmt);
+            pushScope(block.get(), block->statements);
+            for (const auto& inner : block->statements) {
+                walk(inner);
+            }
+            scopes.pop_back();
+            break;
+        }
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            walk(ifStmt->condition);
+            walk(ifStmt->thenBranch);
+            walk(ifStmt->elseBranch);
+            break;
+        }
+        case StmtType::WHILE: {
+            auto whileStmt = std::static_pointer_cast<WhileStmt>(stmt);
+            walk(whileStmt->condition);
+            walk(whileStmt->body);
+            break;
+        }
+        case StmtType::FUNCTION_DECL: {
+            auto function = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+            scopes.back().declared[std::string(function->name.lexeme)] = function.get();
+            functions[function.get()];
+            byName[std::string(function->name.lexeme)].push_back(function.get());
+
+            Chain& chain = chains[function.get()];
+            for (size_t s = 1; s < scopes.size(); s++) {
+                chain.frames.push_back(scopes[s].owner);
+            }
+            for (const auto& outer : active) {
+                chain.enclosing.push_back(outer.function);
+            }
+
+            // The body runs in the call frame, next to the parameters
+            auto body = std::dynamic_pointer_cast<BlockStmt>(function->body);
+            pushScope(function.get(), body ? body->statements : std::vector<StmtPtr>{});
+            for (const auto& param : function->parameters) {
+                scopes.back().names.insert(std::string(param.first.lexeme));
+                scopes.back().declared[std::string(param.first.lexeme)] = nullptr;
+            }
+            active.push_back({function.get(), scopes.size() - 1});
+            if (body) {
+                for (const auto& inner : body->statements) {
+                    walk(inner);
+                }
+            } else {
+                walk(function->body);
+            }
+            active.pop_back();
+            scopes.pop_back();
+            break;
+        }
+        case StmtType::RETURN:
+            walk(std::static_pointer_cast<ReturnStmt>(stmt)->value);
+            break;
+    }
+}
+
+void EscapeAnalysis::walk(const ExprPtr& expr) {
+    if (!expr) return;
+    switch (expr->getType()) {
+        case ExprType::VARIABLE:
+            use(std::string(std::static_pointer_cast<VariableExpr>(expr)->name.lexeme), true);
+            break;
+        case ExprType::BINARY: {
+            auto binary = std::static_pointer_cast<BinaryExpr>(expr);
+            walk(binary->left);
+            walk(binary->right);
+            break;
+        }
+        case ExprType::UNARY:
+            walk(std::static_pointer_cast<UnaryExpr>(expr)->right);
+            break;
+        case ExprType::CALL: {
+            auto call = std::static_pointer_cast<CallExpr>(expr);
+            use(std::string(call->callee.lexeme), false);
+            for (const auto& argument : call->arguments) {
+                walk(argument);
+            }
+            break;
+        }
+        case ExprType::ASSIGNMENT: {
+            auto assignment = std::static_pointer_cast<AssignmentExpr>(expr);
+            walk(assignment->value);
+            use(std::string(assignment->name.lexeme), false);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void EscapeAnalysis::analyze(const ProgramPtr& program) {
+    scopes.clear();
+    active.clear();
+    functions.clear();
+    chains.clear();
+    byName.clear();
+    captures.clear();
+    frames.clear();
+    heapFrames.clear();
+    stats = Stats();
+
+    pushScope(nullptr, program->statements);
+    for (const auto& stmt : program->statements) {
+        walk(stmt);
+    }
+    scopes.clear();
+
+    // An escaping function that captures its frame whole keeps the chain
+    // around it alive, including the frames of the functions it is in
+    for (auto& [function, info] : functions) {
+        if (!info.escapes || !info.capturesFrame) continue;
+        const Chain& chain = chains[function];
+        info.pinned = true;
+        heapFrames.insert(chain.frames.begin(), chain.frames.end());
+        for (const FunctionDeclStmt* outer : chain.enclosing) {
+            functions[outer].pinned = true;
+        }
+    }
+
+    std::set<std::pair<const void*, std::string>> boxed;
+    for (const auto& capture : captures) {
+        const FunctionInfo& info = functions[capture.function];
+        if (info.escapes && !info.pinned) boxed.insert({capture.owner, capture.name});
+    }
+
+    stats.functions = functions.size();
+    for (const auto& [function, info] : functions) {
+        if (info.escapes) stats.escaping++;
+        if (info.pinned) stats.pinned++;
+    }
+    stats.boxedVariables = boxed.size();
+    stats.heapFrames = heapFrames.size();
+    stats.stackFrames = frames.size() - heapFrames.size();
+}
+
+const EscapeAnalysis::FunctionInfo* EscapeAnalysis::find(const FunctionDeclStmt* function) const {
+    auto it = functions.find(function);
+    return it == functions.end() ? nullptr : &it->second;
+}
+
+std::string EscapeAnalysis::report() const {
+    std::ostringstream out;
+    out << "Escape analysis: " << stats.escaping << " of " << stats.functions << " functions escape ("
+        << stats.pinned << " pinned), " << stats.boxedVariables << " variables boxed, "
+        << stats.stackFrames << " stack frames, " << stats.heapFrames << " heap frames";
+    return out.str();
+}
@@ -17,72 +17,72 @@ void SemanticAnalyzer::exitScope() {
 }
 
 void SemanticAnalyzer::declareVariable(const Token& name, TokenType type, bool initialized) {
-    auto symbol = std::make_shared<Symbol>(name.lexeme, SymbolType::VARIABLE, 
+    auto symbol = std::make_shared<Symbol>(std::string(name.lexeme), SymbolType::VARIABLE, 
                                           type, currentScope->getScopeLevel(), initialized);
     if (!currentScope->insert(symbol)) {
-        reportError(name, "Variable '" + name.lexeme + "' already declared in this scope");
+        reportError(name, "Variable '" + std::string(name.lexeme) + "' already declared in this scope");
     }
 }
 
 void SemanticAnalyzer::defineVariable(const Token& name) {
-    auto symbol = currentScope->lookup(name.lexeme);
+    auto symbol = currentScope->lookup(std::string(name.lexeme));
     if (symbol) {
         symbol->isInitialized = true;
     }
 }
 
 void SemanticAnalyzer::reportError(const Token& token, const std::string& message) {
-    errors.push_back(Error(ErrorType::SEMANTIC, message, token.line, token.column, "SemanticAnalyzer"));
+    errors.push_back(Error(ErrorType::SEMANTIC, message, token.line(), token.column(), "SemanticAnalyzer"));
 }
 
 // Expression visitors
 Value SemanticAnalyzer::visitLiteralExpr(const LiteralExpr& expr) {
-    return nullptr;
+    return Value();
 }
 
 Value SemanticAnalyzer::visitVariableExpr(const VariableExpr& expr) {
-    auto symbol = currentScope->lookup(expr.name.lexeme);
+    auto symbol = currentScope->lookup(std::string(expr.name.lexeme));
     if (!symbol) {
-        reportError(expr.name, "Undefined variable '" + expr.name.lexeme + "'");
+        reportError(expr.name, "Undefined variable '" + std::string(expr.name.lexeme) + "'");
     } else if (!symbol->isInitialized) {
-        reportError(expr.name, "Variable '" + expr.name.lexeme + "' used before initialization");
+        reportError(expr.name, "Variable '" + std::string(expr.name.lexeme) + "' used before initialization");
     }
-    return nullptr;
+    return Value();
 }
 
 Value SemanticAnalyzer::visitBinaryExpr(const BinaryExpr& expr) {
     expr.left->accept(*this);
     expr.right->accept(*this);
-    return nullptr;
+    return Value();
 }
 
 Value SemanticAnalyzer::visitUnaryExpr(const UnaryExpr& expr) {
     expr.right->accept(*this);
-    return nullptr;
+    return Value();
 }
 
 Value SemanticAnalyzer::visitCallExpr(const CallExpr& expr) {
-    auto symbol = currentScope->lookup(expr.callee.lexeme);
+    auto symbol = currentScope->lookup(std::string(expr.callee.lexeme));
     if (!symbol || symbol->type != SymbolType::FUNCTION) {
-        reportError(expr.callee, "Undefined function '" + expr.callee.lexeme + "'");
+        reportError(expr.callee, "Undefined function '" + std::string(expr.callee.lexeme) + "'");
     }
     
     for (auto& arg : expr.arguments) {
         arg->accept(*this);
     }
-    return nullptr;
+    return Value();
 }
 
 Value SemanticAnalyzer::visitAssignmentExpr(const AssignmentExpr& expr) {
-    auto symbol = currentScope->lookup(expr.name.lexeme);
+    auto symbol = currentScope->lookup(std::string(expr.name.lexeme));
     if (!symbol) {
-        reportError(expr.name, "Cannot assign to undefined variable '" + expr.name.lexeme + "'");
+        reportError(expr.name, "Cannot assign to undefined variable '" + std::string(expr.name.lexeme) + "'");
     } else if (symbol->isConstant) {
-        reportError(expr.name, "Cannot assign to constant '" + expr.name.lexeme + "'");
+        reportError(expr.name, "Cannot assign to constant '" + std::string(expr.name.lexeme) + "'");
     }
     
     expr.value->accept(*this);
-    return nullptr;
+    return Value();
 }
 
 // Statement visitors
@@ -1,208 +1,428 @@
 #include "TypeChecker.h"
 #include <iostream>
 
-TypeChecker::TypeChecker() 
-    : currentScope(std::make_shared<SymbolTable>()), currentReturnType(TokenType::VOID_TYPE), inFunction(false) {}
-
-TokenType TypeChecker::getExpressionType(const ExprPtr& expr) {
-    // This would be implemented to return the type of an expression
-    // For now, return a placeholder
-    return TokenType::INT_TYPE;
-}
-
-bool TypeChecker::checkType(TokenType expected, TokenType actual, const Token& token) {
-    if (expected != actual) {
-        reportError(token, "Type mismatch. Expected " + 
-            std::to_string(static_cast<int>(expected)) + 
-            ", got " + std::to_string(static_cast<int>(actual)));
-        return false;
+namespace {
+    // A function that can reach the end of its body returns null
+    bool alwaysReturns(const StmtPtr& stmt) {
+        if (!stmt) return false;
+        switch (stmt->getType()) {
+            case StmtType::RETURN:
+                return true;
+            case StmtType::BLOCK:
+                for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                    if (alwaysReturns(inner)) return true;
+                }
+                return false;
+            case StmtType::IF: {
+                auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+                return alwaysReturns(ifStmt->thenBranch) && alwaysReturns(ifStmt->elseBranch);
+            }
+            default:
+                return false;
+        }
     }
-    return true;
 }
 
-bool TypeChecker::isNumericType(TokenType type) {
-    return type == TokenType::INT_TYPE || type == TokenType::FLOAT_TYPE;
-}
+TypeChecker::TypeChecker()
+    : currentScope(std::make_shared<SymbolTable>()), currentReturnType(TokenType::VOID_TYPE), inFunction(false),
+      currentFunction(nullptr), functionScopeLevel(0), currentType(DYNAMIC), changed(false) {}
 
-bool TypeChecker::isBooleanType(TokenType type) {
-    return type == TokenType::BOOL_TYPE;
+TokenType TypeChecker::getExpressionType(const ExprPtr& expr) {
+    expr->accept(*this);
+    expr->staticType = currentType;
+    return currentType;
 }
 
-bool TypeChecker::isStringType(TokenType type) {
-    return type == TokenType::STRING_TYPE;
+bool TypeChecker::isNumericType(TokenType type) {
+    return type == TokenType::INT_TYPE || type == TokenType::FLOAT_TYPE;
 }
 
 bool TypeChecker::typesCompatible(TokenType t1, TokenType t2) {
     if (t1 == t2) return true;
-    
+
     // Allow implicit int to float conversion
     if ((t1 == TokenType::INT_TYPE && t2 == TokenType::FLOAT_TYPE) ||
         (t1 == TokenType::FLOAT_TYPE && t2 == TokenType::INT_TYPE)) {
         return true;
     }
-    
+
     return false;
 }
 
-TokenType TypeChecker::getBinaryResultType(TokenType left, TokenType right, TokenType op) {
+// Mirrors the runtime: int op int stays int, a float makes a float, `+`
+// with a string concatenates, `/` always gives a float and `%` needs ints.
+// Returns false when the operation fails for every value of these types.
+bool TypeChecker::getBinaryResultType(TokenType left, TokenType right, TokenType op, TokenType& result) {
+    result = DYNAMIC;
+
+    // Equality and logical operators accept anything
+    if (op == TokenType::EQUAL || op == TokenType::NOT_EQUAL ||
+        op == TokenType::AND || op == TokenType::OR) {
+        result = TokenType::BOOL_TYPE;
+        return true;
+    }
+
+    if (op == TokenType::PLUS && (left == TokenType::STRING_TYPE || right == TokenType::STRING_TYPE)) {
+        result = TokenType::STRING_TYPE;
+        return true;
+    }
+
+    // Comparisons produce a bool whenever they succeed
+    if (op == TokenType::LESS || op == TokenType::LESS_EQUAL ||
+        op == TokenType::GREATER || op == TokenType::GREATER_EQUAL) {
+        result = TokenType::BOOL_TYPE;
+        if (left == DYNAMIC || right == DYNAMIC) return true;
+        return (isNumericType(left) && isNumericType(right)) ||
+               (left == TokenType::STRING_TYPE && right == TokenType::STRING_TYPE);
+    }
+
     // Arithmetic operators
-    if (op == TokenType::PLUS || op == TokenType::MINUS || 
-        op == TokenType::MULTIPLY || op == TokenType::DIVIDE || 
-        op == TokenType::MODULO) {
-        
-        if (left == TokenType::INT_TYPE && right == TokenType::INT_TYPE) {
-            return TokenType::INT_TYPE;
+    if ((left != DYNAMIC && !isNumericType(left)) || (right != DYNAMIC && !isNumericType(right))) {
+        return op == TokenType::PLUS && (left == DYNAMIC || right == DYNAMIC);
+    }
+    if (op == TokenType::MODULO) {
+        if (left == TokenType::FLOAT_TYPE || right == TokenType::FLOAT_TYPE) return false;
+        result = TokenType::INT_TYPE;
+        return true;
+    }
+    if (op == TokenType::DIVIDE) {
+        result = TokenType::FLOAT_TYPE;
+        return true;
+    }
+    // An unknown operand of `+` may still be a string
+    if (left == TokenType::INT_TYPE && right == TokenType::INT_TYPE) {
+        result = TokenType::INT_TYPE;
+    } else if ((left == TokenType::FLOAT_TYPE || right == TokenType::FLOAT_TYPE) &&
+               (op != TokenType::PLUS || (left != DYNAMIC && right != DYNAMIC))) {
+        result = TokenType::FLOAT_TYPE;
+    }
+    return true;
+}
+
+std::string TypeChecker::typeName(TokenType type) {
+    switch (type) {
+        case TokenType::INT_TYPE: return "int";
+        case TokenType::FLOAT_TYPE: return "float";
+        case TokenType::BOOL_TYPE: return "bool";
+        case TokenType::STRING_TYPE: return "string";
+        case TokenType::VOID_TYPE: return "void";
+        default: return "dynamic";
+    }
+}
+
+void TypeChecker::reportError(const Token& token, const std::string& message) {
+    errors.push_back(Error(ErrorType::SEMANTIC, message, token.line(), token.column(), "TypeChecker"));
+}
+
+// Counts declarations by name and finds every function, including nested ones
+void TypeChecker::collectDeclarations(const StmtPtr& stmt) {
+    if (!stmt) return;
+    switch (stmt->getType()) {
+        case StmtType::VARIABLE_DECL:
+            declarationCounts[std::string(std::static_pointer_cast<VariableDeclStmt>(stmt)->name.lexeme)]++;
+            break;
+        case StmtType::BLOCK:
+            for (const auto& inner : std::static_pointer_cast<BlockStmt>(stmt)->statements) {
+                collectDeclarations(inner);
+            }
+            break;
+        case StmtType::IF: {
+            auto ifStmt = std::static_pointer_cast<IfStmt>(stmt);
+            collectDeclarations(ifStmt->thenBranch);
+            collectDeclarations(ifStmt->elseBranch);
+            break;
         }
-        if ((left == TokenType::INT_TYPE || left == TokenType::FLOAT_TYPE) &&
-            (right == TokenType::INT_TYPE || right == TokenType::FLOAT_TYPE)) {
-            return TokenType::FLOAT_TYPE;
+        case StmtType::WHILE:
+            collectDeclarations(std::static_pointer_cast<WhileStmt>(stmt)->body);
+            break;
+        case StmtType::FUNCTION_DECL: {
+            auto function = std::static_pointer_cast<FunctionDeclStmt>(stmt);
+            declarationCounts[std::string(function->name.lexeme)]++;
+            functions[std::string(function->name.lexeme)] = {function.get(), true};
+            for (const auto& param : function->parameters) {
+                declarationCounts[std::string(param.first.lexeme)]++;
+            }
+            collectDeclarations(function->body);
+            break;
         }
+        default:
+            break;
     }
-    
-    // Comparison operators
-    if (op == TokenType::EQUAL || op == TokenType::NOT_EQUAL ||
-        op == TokenType::LESS || op == TokenType::LESS_EQUAL ||
-        op == TokenType::GREATER || op == TokenType::GREATER_EQUAL) {
-        return TokenType::BOOL_TYPE;
+}
+
+void TypeChecker::checkStatement(const StmtPtr& stmt) {
+    stmt->accept(*this);
+    if (stmt->getType() == StmtType::VARIABLE_DECL) {
+        auto decl = std::static_pointer_cast<VariableDeclStmt>(stmt);
+        auto it = bindings.find(&decl->name);
+        decl->staticType = it == bindings.end() ? DYNAMIC : it->second;
     }
-    
-    // Logical operators
-    if (op == TokenType::AND || op == TokenType::OR) {
-        if (left == TokenType::BOOL_TYPE && right == TokenType::BOOL_TYPE) {
-            return TokenType::BOOL_TYPE;
-        }
+}
+
+void TypeChecker::declare(const Token& name, SymbolType kind, TokenType type) {
+    auto symbol = std::make_shared<Symbol>(std::string(name.lexeme), kind, type, currentScope->getScopeLevel(), true);
+    symbol->declaration = &name;
+    if (!currentScope->insert(symbol)) {
+        // Redeclared in the same scope: the name holds whatever was assigned last
+        markDynamic(std::string(name.lexeme));
     }
-    
-    return TokenType::ERROR;
 }
 
-void TypeChecker::reportError(const Token& token, const std::string& message) {
-    errors.push_back(Error(ErrorType::SEMANTIC, message, token.line, token.column, "TypeChecker"));
+void TypeChecker::refine(const Token* declaration, TokenType type) {
+    auto it = bindings.find(declaration);
+    if (it == bindings.end()) {
+        bindings[declaration] = type;
+    } else if (it->second != type && it->second != DYNAMIC) {
+        it->second = DYNAMIC;
+        changed = true;
+    }
+}
+
+void TypeChecker::markDynamic(const std::string& name) {
+    changed |= dynamicNames.insert(name).second;
+}
+
+void TypeChecker::markReturnsDynamic(const std::string& function) {
+    auto it = functions.find(function);
+    if (it != functions.end() && it->second.returnsDeclared) {
+        it->second.returnsDeclared = false;
+        changed = true;
+    }
+}
+
+// The declaration a name refers to, or null when that is only known at
+// runtime: a function looks up its free variables when it is called, and
+// by then another declaration of the same name may be visible
+std::shared_ptr<Symbol> TypeChecker::resolve(const std::string& name) {
+    if (dynamicNames.count(name)) return nullptr;
+    auto symbol = currentScope->lookup(name);
+    if (!symbol || !symbol->declaration) return nullptr;
+    if (inFunction && symbol->scopeLevel < functionScopeLevel && declarationCounts[name] != 1) {
+        return nullptr;
+    }
+    return symbol;
+}
+
+TokenType TypeChecker::getReturnType(const std::string& function) const {
+    auto it = functions.find(function);
+    auto count = declarationCounts.find(function);
+    if (it == functions.end() || !it->second.returnsDeclared ||
+        count == declarationCounts.end() || count->second != 1) {
+        return DYNAMIC;
+    }
+    TokenType type = it->second.declaration->returnType;
+    return type == TokenType::VOID_TYPE ? DYNAMIC : type;
 }
 
 // Expression visitors
 Value TypeChecker::visitLiteralExpr(const LiteralExpr& expr) {
     // Literals have inherent types based on their value
-    return nullptr;
+    if (std::holds_alternative<int>(expr.value)) currentType = TokenType::INT_TYPE;
+    else if (std::holds_alternative<float>(expr.value)) currentType = TokenType::FLOAT_TYPE;
+    else if (std::holds_alternative<bool>(expr.value)) currentType = TokenType::BOOL_TYPE;
+    else currentType = TokenType::STRING_TYPE;
+    return Value();
 }
 
 Value TypeChecker::visitVariableExpr(const VariableExpr& expr) {
-    auto symbol = currentScope->lookup(expr.name.lexeme);
-    if (!symbol) {
-        reportError(expr.name, "Undefined variable '" + expr.name.lexeme + "'");
-        return nullptr;
+    // Undefined names are reported by the SemanticAnalyzer
+    currentType = DYNAMIC;
+    auto symbol = resolve(std::string(expr.name.lexeme));
+    if (symbol && symbol->type != SymbolType::FUNCTION) {
+        auto it = bindings.find(symbol->declaration);
+        if (it != bindings.end()) currentType = it->second;
     }
-    return nullptr;
+    return Value();
 }
 
 Value TypeChecker::visitBinaryExpr(const BinaryExpr& expr) {
-    expr.left->accept(*this);
-    expr.right->accept(*this);
-    return nullptr;
+    TokenType left = getExpressionType(expr.left);
+    TokenType right = getExpressionType(expr.right);
+    if (!getBinaryResultType(left, right, expr.op.type, currentType)) {
+        reportError(expr.op, "Operator '" + std::string(expr.op.lexeme) + "' cannot be applied to " +
+                    typeName(left) + " and " + typeName(right));
+        currentType = DYNAMIC;
+    }
+    return Value();
 }
 
 Value TypeChecker::visitUnaryExpr(const UnaryExpr& expr) {
-    expr.right->accept(*this);
-    return nullptr;
+    TokenType operand = getExpressionType(expr.right);
+    if (expr.op.type == TokenType::NOT) {
+        currentType = TokenType::BOOL_TYPE;
+    } else if (operand == DYNAMIC || isNumericType(operand)) {
+        currentType = operand;
+    } else {
+        reportError(expr.op, "Operator '" + std::string(expr.op.lexeme) + "' cannot be applied to " + typeName(operand));
+        currentType = DYNAMIC;
+    }
+    return Value();
 }
 
 Value TypeChecker::visitCallExpr(const CallExpr& expr) {
+    std::vector<TokenType> argumentTypes;
     for (auto& arg : expr.arguments) {
-        arg->accept(*this);
+        argumentTypes.push_back(getExpressionType(arg));
+    }
+
+    // Natives and functions declared more than once are not checked
+    std::string name(expr.callee.lexeme);
+    auto it = functions.find(name);
+    if (it == functions.end() || declarationCounts[name] != 1 || dynamicNames.count(name)) {
+        currentType = DYNAMIC;
+        return Value();
     }
-    return nullptr;
+
+    const FunctionDeclStmt& function = *it->second.declaration;
+    if (argumentTypes.size() != function.parameters.size()) {
+        reportError(expr.callee, "Function '" + name + "' expects " + std::to_string(function.parameters.size()) +
+                    " arguments but got " + std::to_string(argumentTypes.size()));
+    } else {
+        for (size_t i = 0; i < argumentTypes.size(); i++) {
+            TokenType expected = function.parameters[i].second;
+            if (argumentTypes[i] != DYNAMIC && !typesCompatible(expected, argumentTypes[i])) {
+                reportError(expr.callee, "Argument " + std::to_string(i + 1) + " of '" + name + "' must be " +
+                            typeName(expected) + ", got " + typeName(argumentTypes[i]));
+            }
+            refine(&function.parameters[i].first, argumentTypes[i]);
+        }
+    }
+
+    currentType = getReturnType(name);
+    return Value();
 }
 
 Value TypeChecker::visitAssignmentExpr(const AssignmentExpr& expr) {
-    expr.value->accept(*this);
-    return nullptr;
+    currentType = getExpressionType(expr.value);
+    auto symbol = resolve(std::string(expr.name.lexeme));
+    if (symbol && symbol->type != SymbolType::FUNCTION) {
+        refine(symbol->declaration, currentType);
+    } else {
+        markDynamic(std::string(expr.name.lexeme));
+    }
+    return Value();
 }
 
 // Statement visitors
 void TypeChecker::visitPrintStmt(const PrintStmt& stmt) {
     for (auto& expr : stmt.expressions) {
-        expr->accept(*this);
+        getExpressionType(expr);
     }
 }
 
 void TypeChecker::visitVariableDeclStmt(const VariableDeclStmt& stmt) {
-    if (stmt.initializer) {
-        stmt.initializer->accept(*this);
-    }
+    // Without an initializer the binding starts out null
+    TokenType type = stmt.initializer ? getExpressionType(stmt.initializer) : DYNAMIC;
+    declare(stmt.name, SymbolType::VARIABLE, type);
+    refine(&stmt.name, type);
 }
 
 void TypeChecker::visitExpressionStmt(const ExpressionStmt& stmt) {
     if (stmt.expression) {
-        stmt.expression->accept(*this);
+        getExpressionType(stmt.expression);
     }
 }
 
 void TypeChecker::visitBlockStmt(const BlockStmt& stmt) {
     auto oldScope = currentScope;
     currentScope = std::make_shared<SymbolTable>(oldScope->getScopeLevel() + 1, oldScope);
-    
+
     for (auto& stmtPtr : stmt.statements) {
-        stmtPtr->accept(*this);
+        checkStatement(stmtPtr);
     }
-    
+
     currentScope = oldScope;
 }
 
 void TypeChecker::visitIfStmt(const IfStmt& stmt) {
     if (stmt.condition) {
-        stmt.condition->accept(*this);
+        getExpressionType(stmt.condition);
     }
     if (stmt.thenBranch) {
-        stmt.thenBranch->accept(*this);
+        checkStatement(stmt.thenBranch);
     }
     if (stmt.elseBranch) {
-        stmt.elseBranch->accept(*this);
+        checkStatement(stmt.elseBranch);
     }
 }
 
 void TypeChecker::visitWhileStmt(const WhileStmt& stmt) {
     if (stmt.condition) {
-        stmt.condition->accept(*this);
+        getExpressionType(stmt.condition);
     }
     if (stmt.body) {
-        stmt.body->accept(*this);
+        checkStatement(stmt.body);
     }
 }
 
 void TypeChecker::visitFunctionDeclStmt(const FunctionDeclStmt& stmt) {
+    declare(stmt.name, SymbolType::FUNCTION, stmt.returnType);
+
     bool oldInFunction = inFunction;
     TokenType oldReturnType = currentReturnType;
-    
+    const FunctionDeclStmt* oldFunction = currentFunction;
+    int oldScopeLevel = functionScopeLevel;
+
     inFunction = true;
     currentReturnType = stmt.returnType;
-    
+    currentFunction = &stmt;
+
     auto oldScope = currentScope;
     currentScope = std::make_shared<SymbolTable>(oldScope->getScopeLevel() + 1, oldScope);
-    
+    functionScopeLevel = currentScope->getScopeLevel();
+
     // Add parameters to scope
     for (auto& [paramName, paramType] : stmt.parameters) {
-        auto symbol = std::make_shared<Symbol>(paramName.lexeme, SymbolType::PARAMETER, 
-                                               paramType, currentScope->getScopeLevel(), true);
-        currentScope->insert(symbol);
+        declare(paramName, SymbolType::PARAMETER, paramType);
+        refine(&paramName, paramType);
     }
-    
+
     if (stmt.body) {
-        stmt.body->accept(*this);
+        checkStatement(stmt.body);
+        if (!alwaysReturns(stmt.body)) {
+            markReturnsDynamic(std::string(stmt.name.lexeme));
+        }
     }
-    
+
     currentScope = oldScope;
     inFunction = oldInFunction;
     currentReturnType = oldReturnType;
+    currentFunction = oldFunction;
+    functionScopeLevel = oldScopeLevel;
 }
 
 void TypeChecker::visitReturnStmt(const ReturnStmt& stmt) {
-    if (stmt.value) {
-        stmt.value->accept(*this);
+    TokenType type = stmt.value ? getExpressionType(stmt.value) : DYNAMIC;
+    if (!inFunction) {
+        return;
+    }
+
+    if (type != DYNAMIC && currentReturnType != TokenType::VOID_TYPE && !typesCompatible(currentReturnType, type)) {
+        reportError(stmt.keyword, "Function '" + std::string(currentFunction->name.lexeme) + "' returns " +
+                    typeName(currentReturnType) + ", got " + typeName(type));
+    }
+    if (type != currentReturnType) {
+        markReturnsDynamic(std::string(currentFunction->name.lexeme));
     }
 }
 
 void TypeChecker::check(const ProgramPtr& program) {
+    bindings.clear();
+    functions.clear();
+    declarationCounts.clear();
+    dynamicNames.clear();
     for (auto& stmt : program->statements) {
-        stmt->accept(*this);
+        collectDeclarations(stmt);
     }
-}
\ No newline at end of file
+
+    // Bindings only ever widen to DYNAMIC, so this settles; the last round
+    // leaves the annotations and errors
+    do {
+        changed = false;
+        errors.clear();
+        currentScope = std::make_shared<SymbolTable>();
+        for (auto& stmt : program->statements) {
+            checkStatement(stmt);
+        }
+    } while (changed);
+}
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <cstdio>
+#include <memory>
+#include "../include/lexer/Lexer.h"
+#include "../include/parser/Parser.h"
+#include "../include/compiler/CBackend.h"
+#include "../include/compiler/NativeModule.h"
+
+// Generate C for a source string; returns false on parse or backend errors
+bool generateC(const std::string& source, std::string& code) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto program = parser.parse();
+
+    if (parser.hasErrors()) {
+        return false;
+    }
+
+    CBackend backend;
+    code = backend.generate(program);
+    return !backend.hasErrors();
+}
+
+// Build a standalone executable and capture what it prints; `prefix` is
+// shell run before it, such as a ulimit
+bool runExecutable(const std::string& code, std::string& output, const std::string& prefix = "") {
+    std::string path = "/tmp/simplelang_cbackend_test";
+    std::string message;
+    if (!NativeModule::buildExecutable(code, path, message)) {
+        return false;
+    }
+
+    FILE* pipe = popen((prefix + path).c_str(), "r");
+    if (!pipe) {
+        return false;
+    }
+    char buffer[256];
+    while (fgets(buffer, sizeof buffer, pipe)) {
+        output += buffer;
+    }
+    pclose(pipe);
+    std::remove(path.c_str());
+    return true;
+}
+
+void testCBackend() {
+    std::cout << "Running C Backend Tests...\n";
+    std::cout << "==========================\n";
+
+    int passed = 0;
+    int total = 0;
+
+    std::string fibonacci =
+        "function fib(n: int): int { if (n < 2) then return n; else return fib(n - 1) + fib(n - 2); end; }\n"
+        "function half(x: float): float { return x / 2; }\n"
+        "print(fib(20), half(5.0), \"n=\" + 3);";
+
+    // Test 1: Typed functions become plain C functions
+    {
+        total++;
+        std::string code;
+        if (generateC(fibonacci, code) &&
+            code.find("static int f_fib(int v_n)") != std::string::npos &&
+            code.find("static float f_half(float v_x)") != std::string::npos) {
+            std::cout << "Test 1: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 1: FAILED - Code: " << code << "\n";
+        }
+    }
+
+    // Test 2: Programs that change a variable's type are rejected
+    {
+        total++;
+        std::string code;
+        if (!generateC("let x = 1; x = 2.5; print(x);", code)) {
+            std::cout << "Test 2: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 2: FAILED - Dynamic typing was accepted\n";
+        }
+    }
+
+    if (!NativeModule::isSupported()) {
+        std::cout << "Tests 3-5: SKIPPED - No native toolchain\n";
+    } else {
+        // Test 3: Compiled output matches the interpreter's formatting
+        {
+            total++;
+            std::string code, output;
+            if (generateC(fibonacci, code) && runExecutable(code, output) &&
+                output == "6765 2.5 n=3\n") {
+                std::cout << "Test 3: PASSED\n";
+                passed++;
+            } else {
+                std::cout << "Test 3: FAILED - Output: " << output << "\n";
+            }
+        }
+
+        // Test 4: Runtime errors in a loaded module come back to the host
+        {
+            total++;
+            std::string code, message;
+            NativeModule module;
+            if (generateC("print(\"before\"); let z = 0; let m = 5 % z; print(m);", code) &&
+                module.load(code, message) && !module.run(message) &&
+                message == "Modulo by zero" && module.printed() == 7) {
+                std::cout << "Test 4: PASSED\n";
+                passed++;
+            } else {
+                std::cout << "Test 4: FAILED - Message: " << message << "\n";
+            }
+        }
+
+        // Test 5: Concatenation temporaries are freed, so string loops run in bounded memory
+        {
+            total++;
+            std::string code, output;
+            std::string loop =
+                "let s = \"\"; let i = 0;\n"
+                "while (i < 1000000) do { s = \"item \" + i + \" of a long string\"; i = i + 1; } end;\n"
+                "print(i);";
+            if (generateC(loop, code) && runExecutable(code, output, "ulimit -v 65536; ") &&
+                output == "1000000\n") {
+                std::cout << "Test 5: PASSED\n";
+                passed++;
+            } else {
+                std::cout << "Test 5: FAILED - Output: " << output << "\n";
+            }
+        }
+    }
+
+    std::cout << "\nC Backend Tests Complete!\n";
+    std::cout << "Passed: " << passed << "/" << total << " tests\n";
+}
+
+int main() {
+    testCBackend();
+    return 0;
+}
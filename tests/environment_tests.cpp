@@ -0,0 +1,81 @@
+#include <iostream>
+#include <memory>
+#include "../include/interpreter/Environment.h"
+
+// A function value closing over `closure`, as the interpreter builds one
+static FunctionObject makeFunction(std::shared_ptr<Environment> closure) {
+    FunctionObject func;
+    func.returnType = TokenType::VOID_TYPE;
+    func.closure = std::move(closure);
+    return func;
+}
+
+void testEnvironment() {
+    std::cout << "Running Environment Tests...\n";
+    std::cout << "============================\n";
+
+    int passed = 0;
+    int total = 0;
+
+    // Test 1: A recursive function stored in its own frame does not keep the frame alive
+    {
+        total++;
+        auto frame = std::make_shared<Environment>();
+        frame->define("f", makeFunction(frame));
+        std::weak_ptr<Environment> alive = frame;
+        frame.reset();
+        if (alive.expired()) {
+            std::cout << "Test 1: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 1: FAILED - The frame owns itself\n";
+        }
+    }
+
+    // Test 2: A copy read out of the frame owns it and can still find itself
+    {
+        total++;
+        auto frame = std::make_shared<Environment>();
+        frame->define("f", makeFunction(frame));
+        std::weak_ptr<Environment> alive = frame;
+        Value escaped = frame->get("f");
+        frame.reset();
+
+        bool resolves = false;
+        if (!alive.expired()) {
+            const FunctionObject& func = std::get<FunctionObject>(escaped);
+            Value self = func.closure->get("f");
+            resolves = std::get<FunctionObject>(self).closure == func.closure;
+        }
+        escaped = nullptr;
+        if (resolves && alive.expired()) {
+            std::cout << "Test 2: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 2: FAILED - Escaped copy lost its frame or leaked it\n";
+        }
+    }
+
+    // Test 3: Frames on the C++ stack are borrowed and stay as they are
+    {
+        total++;
+        Environment frame;
+        std::shared_ptr<Environment> borrowed(std::shared_ptr<Environment>(), &frame);
+        frame.define("f", makeFunction(borrowed));
+        Value func = frame.get("f");
+        if (std::get<FunctionObject>(func).closure.get() == &frame) {
+            std::cout << "Test 3: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 3: FAILED - Borrowed closure was dropped\n";
+        }
+    }
+
+    std::cout << "\nEnvironment Tests Complete!\n";
+    std::cout << "Passed: " << passed << "/" << total << " tests\n";
+}
+
+int main() {
+    testEnvironment();
+    return 0;
+}
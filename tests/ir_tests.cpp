@@ -0,0 +1,266 @@
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include "../include/lexer/Lexer.h"
+#include "../include/parser/Parser.h"
+#include "../include/compiler/CodeGenerator.h"
+#include "../include/ir/IRBuilder.h"
+#include "../include/ir/IRVerifier.h"
+#include "../include/ir/IRPrinter.h"
+#include "../include/ir/IRLowering.h"
+#include "../include/ir/RangeAnalysis.h"
+#include "../include/ir/ValueNumbering.h"
+#include "../include/interpreter/VM.h"
+
+// Parse and build the IR for a source string
+std::unique_ptr<IRModule> buildIR(const std::string& source, ProgramPtr& program) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    program = parser.parse();
+
+    if (parser.hasErrors()) {
+        return nullptr;
+    }
+
+    IRBuilder builder;
+    auto module = builder.build(program);
+    return builder.hasErrors() ? nullptr : std::move(module);
+}
+
+// Run bytecode on the VM and capture what it prints
+std::string runChunk(const BytecodeWriter& chunk) {
+    std::streambuf* oldCoutBuffer = std::cout.rdbuf();
+    std::stringstream buffer;
+    std::cout.rdbuf(buffer.rdbuf());
+
+    VM vm;
+    vm.run(chunk);
+
+    std::cout.rdbuf(oldCoutBuffer);
+    return buffer.str();
+}
+
+void testIR() {
+    std::cout << "Running IR Tests...\n";
+    std::cout << "===================\n";
+
+    int passed = 0;
+    int total = 0;
+
+    std::string fibonacci =
+        "let a = 1; let b = 2; let i = 0;\n"
+        "while (i < 10) do { let t = a; a = b; b = t + b; i = i + 1; } end;\n"
+        "if (a > 50) then { print(\"big\", a); } else { print(\"small\", a); } end;\n"
+        "print(a, b, i);";
+
+    // Test 1: Loop-carried variables become phis in the loop header
+    {
+        total++;
+        ProgramPtr program;
+        auto module = buildIR(fibonacci, program);
+        size_t phis = 0;
+        if (module) {
+            for (const auto& instruction : module->main()->blocks[1]->instructions) {
+                if (instruction->op == IROp::PHI) phis++;
+            }
+        }
+        if (phis == 3) {
+            std::cout << "Test 1: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 1: FAILED - Header phis: " << phis << "\n";
+        }
+    }
+
+    // Test 2: The verifier accepts built IR and the printer shows the phis
+    {
+        total++;
+        ProgramPtr program;
+        auto module = buildIR(fibonacci, program);
+        IRVerifier verifier;
+        if (module && verifier.verify(*module) &&
+            IRPrinter::print(*module).find("phi [") != std::string::npos) {
+            std::cout << "Test 2: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 2: FAILED - IR did not verify\n";
+        }
+    }
+
+    // Test 3: Lowered IR behaves like the direct bytecode
+    {
+        total++;
+        ProgramPtr program;
+        auto module = buildIR(fibonacci, program);
+        std::string expected, output;
+        if (module) {
+            CodeGenerator generator;
+            expected = runChunk(generator.generate(program));
+
+            IRLowering lowering;
+            output = runChunk(lowering.lower(*module));
+        }
+        if (!output.empty() && output == expected && output == "big 144\n144 233 10\n") {
+            std::cout << "Test 3: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 3: FAILED - Output: " << output << "\n";
+        }
+    }
+
+    // Test 4: The verifier rejects a phi that lost an operand
+    {
+        total++;
+        ProgramPtr program;
+        auto module = buildIR(fibonacci, program);
+        IRVerifier verifier;
+        if (module) {
+            module->main()->blocks[1]->instructions.front()->operands.pop_back();
+        }
+        if (module && !verifier.verify(*module)) {
+            std::cout << "Test 4: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 4: FAILED - Broken IR verified\n";
+        }
+    }
+
+    // Test 5: Top-level variables used by functions stay in memory
+    {
+        total++;
+        ProgramPtr program;
+        auto module = buildIR("let g = 5; function f(): int { return g; } print(f());", program);
+        std::string text = module ? IRPrinter::print(*module) : "";
+        if (text.find("store_global g") != std::string::npos &&
+            text.find("load_global g") != std::string::npos) {
+            std::cout << "Test 5: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 5: FAILED - IR: " << text << "\n";
+        }
+    }
+
+    // Test 6: Loop bounds prove divisors non-zero and counters free of overflow
+    {
+        total++;
+        ProgramPtr program;
+        auto module = buildIR(
+            "let i = 1; let s = 0;\n"
+            "while (i < 100) do { s = s + 100 % i; i = i + 1; } end;\n"
+            "print(s, 700 / i);", program);
+        RangeAnalysis ranges;
+        std::string output;
+        bool marked = false;
+        if (module) {
+            ranges.analyze(*module);
+            IRLowering lowering;
+            BytecodeWriter chunk = lowering.lower(*module, &ranges);
+            for (size_t offset = 0; offset < chunk.getCode().size(); offset++) {
+                marked = marked || chunk.isUnchecked(offset);
+            }
+            output = runChunk(chunk);
+        }
+        const RangeAnalysis::Stats& stats = ranges.getStats();
+        // The sum widens to any int, so only the mod and the counter are safe
+        if (module && marked && output == "1701 7.0\n" && stats.divisions == 2 &&
+            stats.nonZeroDivisors == 2 && stats.intOperations == 3 && stats.noOverflow == 2) {
+            std::cout << "Test 6: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 6: FAILED - " << ranges.report() << ", output: " << output << "\n";
+        }
+    }
+
+    // Test 7: Divisors that can reach zero and sums that can wrap stay checked
+    {
+        total++;
+        ProgramPtr program;
+        auto module = buildIR(
+            "let k = 3; let big = 2147483000;\n"
+            "while (k > -3) do { k = k - 1; if (k != 0) then { print(12 % k); } end; print(k * 2); } end;\n"
+            "print(12 % k, big + 1000, big + 600);", program);
+        RangeAnalysis ranges;
+        if (module) ranges.analyze(*module);
+        const RangeAnalysis::Stats& stats = ranges.getStats();
+        // k can be zero inside the loop (a range has no holes) but is -3 after it;
+        // of the int operations (including the negation in `-3`) only `big + 1000` can overflow
+        if (module && stats.divisions == 2 && stats.nonZeroDivisors == 1 &&
+            stats.intOperations == 7 && stats.noOverflow == 6) {
+            std::cout << "Test 7: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 7: FAILED - " << ranges.report() << "\n";
+        }
+    }
+
+    // Test 8: Repeated arithmetic and loads are computed once, across blocks too
+    {
+        total++;
+        ProgramPtr program;
+        std::string source =
+            "let a = 6; let b = 7; let g = 2;\n"
+            "function h(): int { return g; }\n"
+            "let x = a * b + g; let y = b * a + g;\n"
+            "if (a < b) then { print(a * b, b > a, g); } end;\n"
+            "print(x, y);";
+        auto module = buildIR(source, program);
+        ValueNumbering numbering;
+        size_t before = 0;
+        size_t after = 0;
+        std::string output;
+        if (module) {
+            for (const auto& block : module->main()->blocks) before += block->instructions.size();
+            numbering.run(*module);
+            for (const auto& block : module->main()->blocks) after += block->instructions.size();
+            IRVerifier verifier;
+            if (verifier.verify(*module)) {
+                IRLowering lowering;
+                output = runChunk(lowering.lower(*module));
+            }
+        }
+        const ValueNumbering::Stats& stats = numbering.getStats();
+        // `b > a` is keyed as `a < b`; g is reused only within a block, and
+        // `+ g` stays because g could hold anything
+        if (module && output == "42 true 2\n44 44\n" && after + stats.eliminated + stats.constants == before &&
+            stats.byOp.count(IROp::MUL) && stats.byOp.at(IROp::MUL) == 2 &&
+            stats.byOp.count(IROp::GT) && stats.byOp.at(IROp::GT) == 1 &&
+            stats.byOp.count(IROp::LOAD_GLOBAL) && stats.byOp.at(IROp::LOAD_GLOBAL) == 1 &&
+            !stats.byOp.count(IROp::ADD)) {
+            std::cout << "Test 8: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 8: FAILED - " << numbering.report() << ", output: " << output << "\n";
+        }
+    }
+
+    // Test 9: Calls are reused only when the callee is pure, and values that may fail are kept
+    {
+        total++;
+        ProgramPtr program;
+        auto module = buildIR(
+            "function sq(n: int): int { return n * n; }\n"
+            "function show(n: int): int { print(n); return n; }\n"
+            "function half(n: int): int { return n / 2; }\n"
+            "let s = \"x\";\n"
+            "print(sq(3) + sq(3), show(1) + show(1), half(4), half(4), s - 1, s - 1);", program);
+        ValueNumbering numbering;
+        if (module) numbering.run(*module);
+        const ValueNumbering::Stats& stats = numbering.getStats();
+        if (module && numbering.isPureFunction("sq") && numbering.isPureFunction("half") &&
+            !numbering.isPureFunction("show") && stats.byOp.count(IROp::CALL) &&
+            stats.byOp.at(IROp::CALL) == 2 && !stats.byOp.count(IROp::SUB)) {
+            std::cout << "Test 9: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 9: FAILED - " << numbering.report() << "\n";
+        }
+    }
+
+    std::cout << "\nIR Tests Complete!\n";
+    std::cout << "Passed: " << passed << "/" << total << " tests\n";
+}
+
+int main() {
+    testIR();
+    return 0;
+}
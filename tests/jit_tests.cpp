@@ -0,0 +1,240 @@
+#include <iostream>
+#include <cstdio>
+#include <sstream>
+#include <memory>
+#include "../include/lexer/Lexer.h"
+#include "../include/parser/Parser.h"
+#include "../include/compiler/CodeGenerator.h"
+#include "../include/compiler/Jit.h"
+#include "../include/interpreter/VM.h"
+#include "../include/core/Config.h"
+#include "../include/core/Utils.h"
+#include <unistd.h>
+
+// Compile source to bytecode and run it on the VM, with or without the JIT
+bool runBytecode(const std::string& source, bool jit, std::string& output, bool& runtimeErrors,
+                 size_t* traceCount = nullptr) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto program = parser.parse();
+
+    if (parser.hasErrors()) {
+        return false;
+    }
+
+    CodeGenerator generator;
+    BytecodeWriter chunk = generator.generate(program);
+    if (!generator.isExecutable()) {
+        return false;
+    }
+
+    Config::set("jit", jit ? "true" : "false");
+
+    std::streambuf* oldCoutBuffer = std::cout.rdbuf();
+    std::stringstream buffer;
+    std::cout.rdbuf(buffer.rdbuf());
+
+    VM vm;
+    vm.run(chunk);
+
+    std::cout.rdbuf(oldCoutBuffer);
+    output = buffer.str();
+    runtimeErrors = vm.hasErrors();
+    if (traceCount) {
+        *traceCount = vm.getTraceCount();
+    }
+    return true;
+}
+
+void testJit() {
+    std::cout << "Running JIT Tests...\n";
+    std::cout << "====================\n";
+
+    int passed = 0;
+    int total = 0;
+
+    struct Case {
+        std::string source;
+        std::string expected;
+        bool expectErrors;
+    };
+
+    std::vector<Case> cases = {
+        // Test 1: Integer loop runs entirely in native code; int arithmetic wraps
+        {"let i = 0; while (i < 1000) do i = i + 3; end; print(i, i % 7, -i);"
+         "let m = -2147483647 - 1; let d = -1; print(m % d, m - 1, m * d, -m);",
+         "1002 1 -1002\n0 2147483647 -2147483648 -2147483648\n", false},
+        // Test 2: Comparisons and booleans
+        {"let a = 4; let b = 9; print(a < b, a >= b, a == 4, !(a != 4));",
+         "true false true true\n", false},
+        // Test 3: Division and strings exit to the VM
+        {"let x = 7; let y = x / 2; print(y); print(\"n=\" + x);",
+         "3.5\nn=7\n", false},
+        // Test 4: Modulo by zero leaves native code and reports the error
+        {"let m = 5 % 0; print(m);",
+         "null\n", true}
+    };
+
+    for (size_t i = 0; i < cases.size(); i++) {
+        total++;
+        std::string name = "Test " + std::to_string(i + 1);
+
+        std::string vmOutput, jitOutput;
+        bool vmErrors = false, jitErrors = false;
+
+        if (!runBytecode(cases[i].source, false, vmOutput, vmErrors) ||
+            !runBytecode(cases[i].source, true, jitOutput, jitErrors)) {
+            std::cout << name << ": FAILED - Could not compile to bytecode\n";
+            continue;
+        }
+
+        if (jitOutput == cases[i].expected && jitOutput == vmOutput &&
+            jitErrors == cases[i].expectErrors && jitErrors == vmErrors) {
+            std::cout << name << ": PASSED\n";
+            passed++;
+        } else {
+            std::cout << name << ": FAILED - Output: " << jitOutput << "\n";
+        }
+    }
+
+    // Test 5: Native code is actually produced on supported hosts
+    {
+        total++;
+        Lexer lexer("let i = 0; while (i < 10) do i = i + 1; end;");
+        Parser parser(lexer);
+        auto program = parser.parse();
+
+        CodeGenerator generator;
+        BytecodeWriter chunk = generator.generate(program);
+
+        JitCompiler compiler;
+        std::unique_ptr<JitFunction> function = compiler.compile(chunk);
+
+        if (!JitCompiler::isSupported() || (function && function->getMemory().getSize() > 0)) {
+            std::cout << "Test 5: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 5: FAILED - No native code generated\n";
+        }
+    }
+
+    // Tests 6-7: Hot loops are traced and leave through side exits
+    std::string countdown;
+    for (int i = 1; i <= 20; i++) {
+        countdown += "i = " + std::to_string(i) + "\n";
+    }
+    std::vector<Case> traced = {
+        {"let i = 0; let x = 0.5; while (i < 100) do x = x + (i = i + 1) / 4; end; print(x, i);",
+         "1263.0 100\n", false},
+        {"let i = 0; while (i < 20) do print(\"i =\", i = i + 1); end;",
+         countdown, false}
+    };
+
+    for (size_t i = 0; i < traced.size(); i++) {
+        total++;
+        std::string name = "Test " + std::to_string(i + 6);
+
+        std::string vmOutput, jitOutput;
+        bool vmErrors = false, jitErrors = false;
+        size_t traces = 0;
+
+        if (!runBytecode(traced[i].source, false, vmOutput, vmErrors) ||
+            !runBytecode(traced[i].source, true, jitOutput, jitErrors, &traces)) {
+            std::cout << name << ": FAILED - Could not compile to bytecode\n";
+            continue;
+        }
+
+        bool compiled = traces > 0 || !JitCompiler::isSupported();
+        if (jitOutput == traced[i].expected && jitOutput == vmOutput && !jitErrors && compiled) {
+            std::cout << name << ": PASSED\n";
+            passed++;
+        } else {
+            std::cout << name << ": FAILED - Traces: " << traces << ", Output: " << jitOutput << "\n";
+        }
+    }
+
+    // Test 8: Generated code is named in the perf map with its script line
+    {
+        total++;
+        Config::set("perf", "true");
+        Config::set("script", "count.sl");
+        Lexer lexer("let i = 0;\nwhile (i < 10) do i = i + 1; end;");
+        Parser parser(lexer);
+        auto program = parser.parse();
+
+        CodeGenerator generator;
+        BytecodeWriter chunk = generator.generate(program);
+
+        JitCompiler compiler;
+        std::unique_ptr<JitFunction> function = compiler.compile(chunk);
+
+        std::string map;
+        if (function) {
+            map = Utils::readFile("/tmp/perf-" + std::to_string(getpid()) + ".map");
+        }
+        if (!JitCompiler::isSupported() ||
+            (chunk.getLine(0) == 1 && map.find("simplelang:main (count.sl:1)") != std::string::npos)) {
+            std::cout << "Test 8: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 8: FAILED - Map: " << map << "\n";
+        }
+        Config::set("perf", "false");
+        std::remove(("/tmp/perf-" + std::to_string(getpid()) + ".map").c_str());
+        std::remove(("/tmp/jit-" + std::to_string(getpid()) + ".dump").c_str());
+    }
+
+    // Test 9: A load of a mixed-type slot runs natively on its profiled type behind a tag guard
+    {
+        total++;
+        auto speculate = [](TokenType profiled, std::string& output) {
+            Lexer lexer("let x = true; let i = 0; while (i < 3) do { x = i; i = i + 1; } end; let y = x + 1; print(y);");
+            Parser parser(lexer);
+            auto program = parser.parse();
+            if (parser.hasErrors() || program->statements.size() < 4) return uint32_t(0);
+            auto sum = std::static_pointer_cast<VariableDeclStmt>(program->statements[3]);
+            std::static_pointer_cast<BinaryExpr>(sum->initializer)->profiledType = profiled;
+
+            CodeGenerator generator;
+            BytecodeWriter chunk = generator.generate(program);
+            JitCompiler compiler;
+            std::unique_ptr<JitFunction> function = compiler.compile(chunk);
+            if (!function) return uint32_t(0);
+
+            std::vector<int64_t> slots(chunk.slotCount(), 0);
+            std::vector<uint8_t> tags(chunk.slotCount(), static_cast<uint8_t>(JitType::UNDEF));
+            std::vector<int64_t> stack(function->getMaxStackDepth(), 0);
+            std::streambuf* oldCoutBuffer = std::cout.rdbuf();
+            std::stringstream buffer;
+            std::cout.rdbuf(buffer.rdbuf());
+            uint32_t result = function->invoke(slots.data(), tags.data(), stack.data());
+            std::cout.rdbuf(oldCoutBuffer);
+            output = buffer.str();
+            return result;
+        };
+
+        std::string asInt, asBool, unprofiled;
+        uint32_t intResult = speculate(TokenType::INT_TYPE, asInt);
+        uint32_t boolResult = speculate(TokenType::BOOL_TYPE, asBool);
+        uint32_t plainResult = speculate(TokenType::ERROR, unprofiled);
+        if (!JitCompiler::isSupported() ||
+            (intResult == JitFunction::COMPLETED && asInt == "3\n" &&
+             boolResult != JitFunction::COMPLETED && asBool.empty() &&
+             plainResult != JitFunction::COMPLETED)) {
+            std::cout << "Test 9: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 9: FAILED - Output: " << asInt << "\n";
+        }
+    }
+
+    Config::set("jit", "false");
+
+    std::cout << "\nJIT Tests Complete!\n";
+    std::cout << "Passed: " << passed << "/" << total << " tests\n";
+}
+
+int main() {
+    testJit();
+    return 0;
+}
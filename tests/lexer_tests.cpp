@@ -1,8 +1,17 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 #include <string>
 #include "../include/lexer/Lexer.h"
 #include "../include/lexer/Token.h"
+#include "../include/lexer/Scan.h"
+#include "../include/lexer/Keywords.h"
+#include "../include/lexer/ParallelLexer.h"
+#include "../include/lexer/IncrementalLexer.h"
+#include "../include/core/Numbers.h"
 
 void testLexer() {
     std::cout << "Running Lexer Tests...\n";
@@ -87,7 +96,310 @@ void testLexer() {
         
         std::cout << "Test 5: " << (tokens.size() == 10 ? "PASSED" : "FAILED") << "\n\n";
     }
-    
+
+    // Test 6: Lexemes are views into the source and outlive the lexer
+    {
+        auto source = SourceBuffer::fromString("let s = \"hi\" + 42 * 2.5; let b = true;");
+        std::vector<Token> tokens;
+        {
+            Lexer lexer(source);
+            Token token;
+            do {
+                token = lexer.nextToken();
+                tokens.push_back(token);
+            } while (token.type != TokenType::END_OF_FILE);
+        }
+
+        bool inSource = true;
+        for (const auto& token : tokens) {
+            if (!token.lexeme.empty() && (token.text != source ||
+                token.lexeme.data() < source->data() || token.lexeme.data() >= source->data() + source->size())) {
+                inSource = false;
+            }
+        }
+
+        bool decoded = std::get<std::string>(tokens[3].literal()) == "hi" &&
+                       std::get<int>(tokens[5].literal()) == 42 &&
+                       std::get<float>(tokens[7].literal()) == 2.5f &&
+                       std::get<bool>(tokens[12].literal());
+        std::cout << "Tokens: " << tokens.size() << ", source shared by " << source.use_count() - 1 << "\n";
+        std::cout << "Test 6: " << (inSource && decoded && tokens[3].lexeme == "\"hi\"" ? "PASSED" : "FAILED") << "\n\n";
+    }
+
+    // Test 7: Every scanner implementation the CPU has gives the same tokens and positions
+    {
+        std::string source;
+        for (int i = 0; i < 40; i++) {
+            source += std::string(i % 37, ' ') + "let a_very_long_identifier_name_" + std::to_string(i) +
+                      std::string(i % 5, '\t') + "= \"str\ning " + std::string(i, 'x') + "\" + 12.5;" +
+                      std::string(i % 3, '\n') + "# comment " + std::string(i * 2, '#') + "\r\n";
+        }
+
+        std::string original = Scan::isa();
+        std::vector<std::string> results;
+        for (const char* isa : {"scalar", "sse2", "avx2"}) {
+            if (!Scan::use(isa)) continue;
+            Lexer lexer(source);
+            std::string result;
+            Token token;
+            do {
+                token = lexer.nextToken();
+                result += token.toString() + "\n";
+            } while (token.type != TokenType::END_OF_FILE);
+            results.push_back(result);
+        }
+        Scan::use(original);
+
+        bool same = results.size() >= 1;
+        for (const auto& result : results) {
+            same = same && result == results[0];
+        }
+        std::string end = "END_OF_FILE '' at " + std::to_string(std::count(source.begin(), source.end(), '\n') + 1) + ":1\n";
+        std::cout << "Scanner: " << original << ", " << results.size() << " implementations compared\n";
+        std::cout << "Test 7: " << (same && results[0].find(end) != std::string::npos ? "PASSED" : "FAILED") << "\n\n";
+    }
+
+    // Test 8: The keyword table is a perfect hash; near misses stay identifiers
+    {
+        static_assert(Keywords::lookup("function") == TokenType::FUNCTION, "keywords are found at compile time");
+        const char* keywords[] = {"let", "if", "else", "while", "for", "function", "return", "end", "then",
+                                  "do", "int", "float", "bool", "string", "void", "true", "false"};
+        const char* identifiers[] = {"lets", "If", "el", "whilst", "fore", "functions", "_end", "thee",
+                                     "d", "integer", "floats", "boolean", "strings", "voids", "tru", "f", "print"};
+        bool correct = Keywords::isPerfect();
+        for (const char* word : keywords) {
+            Lexer lexer(word);
+            correct = correct && Keywords::isKeyword(word) && lexer.nextToken().type != TokenType::IDENTIFIER;
+        }
+        for (const char* word : identifiers) {
+            Lexer lexer(word);
+            correct = correct && !Keywords::isKeyword(word) && lexer.nextToken().type == TokenType::IDENTIFIER;
+        }
+        std::cout << "Test 8: " << (correct ? "PASSED" : "FAILED") << "\n\n";
+    }
+
+    // Test 9: Files are mapped and lexed in place; empty files are read
+    {
+        std::string path = "/tmp/simplelang_lexer_test.sl";
+        std::string emptyPath = "/tmp/simplelang_lexer_empty.sl";
+        std::ofstream(path) << "let x = 1;\n# done\nx";
+        std::ofstream(emptyPath).close();
+
+        auto file = SourceBuffer::open(path);
+        auto empty = SourceBuffer::open(emptyPath);
+        std::vector<Token> tokens;
+        {
+            Lexer lexer(file);
+            Token token;
+            do {
+                token = lexer.nextToken();
+                tokens.push_back(token);
+            } while (token.type != TokenType::END_OF_FILE);
+        }
+        Lexer emptyLexer(empty);
+
+        bool missing = false;
+        try {
+            SourceBuffer::open("/tmp/simplelang_no_such_file.sl");
+        } catch (const std::runtime_error&) {
+            missing = true;
+        }
+        std::remove(path.c_str());
+        std::remove(emptyPath.c_str());
+
+        std::cout << "Mapped: " << (file->isMapped() ? "yes" : "no") << ", " << tokens.size() << " tokens\n";
+        std::cout << "Test 9: " << (tokens.size() == 7 && tokens[5].lexeme == "x" && tokens[5].line() == 3 &&
+                                    tokens[5].lexeme.data() == file->data() + file->size() - 1 &&
+                                    empty->size() == 0 && emptyLexer.nextToken().type == TokenType::END_OF_FILE &&
+                                    missing ? "PASSED" : "FAILED") << "\n\n";
+    }
+
+    // Test 10: tokenize() gives the same stream as nextToken(), with literals decoded once
+    {
+        std::string source = "let total = 12 + 3.5 * count; # note\nif ok then print(\"a\\nb\", true) end @";
+        Lexer streaming(source);
+        Lexer batch(source);
+        TokenBuffer tokens = batch.tokenize();
+
+        bool same = true;
+        size_t count = 0;
+        Token token;
+        do {
+            token = streaming.nextToken();
+            Token stored = tokens.token(count);
+            same = same && count < tokens.size() && stored.type == token.type && stored.lexeme == token.lexeme &&
+                   stored.line() == token.line() && stored.column() == token.column();
+            count++;
+        } while (token.type != TokenType::END_OF_FILE);
+
+        bool literals = std::get<int>(*tokens.literal(3)) == 12 && std::get<float>(*tokens.literal(5)) == 3.5f &&
+                        std::get<std::string>(*tokens.literal(14)) == "a\\nb" && !tokens.literal(1);
+        std::cout << "Tokens: " << tokens.size() << ", error: " << tokens.lexeme(tokens.size() - 2) << "\n";
+        std::cout << "Test 10: " << (same && count == tokens.size() && literals &&
+                                     tokens.type(tokens.size() - 2) == TokenType::ERROR ? "PASSED" : "FAILED") << "\n\n";
+    }
+
+    // Test 11: Lexing in slices on threads gives the sequential token stream
+    {
+        std::string source;
+        for (int i = 0; i < 200; i++) {
+            source += "let s" + std::to_string(i) + " = \"first\n# not a comment\nlast\" # say \"hi\n" +
+                      "x = x + " + std::to_string(i) + " * 2.5; @\n";
+        }
+        source += "print(\"unterminated\n";
+        auto text = SourceBuffer::fromString(source);
+        Lexer lexer(text);
+        TokenBuffer expected = lexer.tokenize();
+        TokenBuffer tokens = ParallelLexer::tokenize(text, 4, 64);
+        std::vector<size_t> points = ParallelLexer::splitPoints(*text, 4);
+
+        bool same = tokens.size() == expected.size();
+        for (size_t i = 0; same && i < tokens.size(); i++) {
+            const Literal* literal = tokens.literal(i);
+            const Literal* expectedLiteral = expected.literal(i);
+            same = tokens.type(i) == expected.type(i) && tokens.lexeme(i) == expected.lexeme(i) &&
+                   tokens.line(i) == expected.line(i) && tokens.column(i) == expected.column(i) &&
+                   (literal ? expectedLiteral && *literal == *expectedLiteral : !expectedLiteral);
+        }
+        bool safe = points.size() == 3;
+        for (size_t point : points) {
+            // Never inside the string, whose second and third lines start with '#' and "last"
+            safe = safe && source[point - 1] == '\n' &&
+                   (source.compare(point, 4, "let ") == 0 || source.compare(point, 4, "x = ") == 0);
+        }
+        std::cout << "Tokens: " << tokens.size() << ", cuts: " << points.size() << "\n";
+        std::cout << "Test 11: " << (same && safe ? "PASSED" : "FAILED") << "\n\n";
+    }
+
+    // Test 12: Numbers are parsed whole and floats print in their shortest round-trip form
+    {
+        int i = 7;
+        float f = 0;
+        bool parsed = Numbers::parse("-42", i) && i == -42 && Numbers::parse("2.5", f) && f == 2.5f &&
+                      !Numbers::parse("12abc", i) && !Numbers::parse("1 2", i) && !Numbers::parse(" ", i) &&
+                      !Numbers::parse("+-1", i) && !Numbers::parse("99999999999", i) && i == -42 &&
+                      Numbers::parse(" +7\t", i) && i == 7 && Numbers::parse("\t-0.5 ", f) && f == -0.5f;
+
+        bool printed = Numbers::toString(0.1f) == "0.1" && Numbers::toString(7.0f) == "7.0" &&
+                       Numbers::toString(-2.5f) == "-2.5" && Numbers::toString(1e20f) == "1e+20" &&
+                       Numbers::toString(-2147483647 - 1) == "-2147483648";
+        bool roundTrip = true;
+        for (float value = 1.0f / 3; value < 1e9f; value *= 7.3f) {
+            float back = 0;
+            roundTrip = roundTrip && Numbers::parse(Numbers::toString(value), back) && back == value;
+        }
+
+        Lexer lexer("let big = 99999999999;");
+        TokenBuffer tokens = lexer.tokenize();
+        std::cout << "0.1f: " << Numbers::toString(0.1f) << ", overflow: " << tokens.lexeme(3) << "\n";
+        std::cout << "Test 12: " << (parsed && printed && roundTrip && tokens.type(3) == TokenType::ERROR ?
+                                     "PASSED" : "FAILED") << "\n\n";
+    }
+
+    // Test 13: Incremental edits leave the same tokens as lexing the edited text, relexing little
+    {
+        std::string document;
+        for (int i = 0; i < 2000; i++) {
+            document += "let v" + std::to_string(i) + " = " + std::to_string(i) + " + 2.5; # \"c\"\n";
+        }
+        IncrementalLexer incremental(document);
+
+        const char* pieces[] = {"=", "\"", "#", "\n", " ", "x", "1", ".", "5", "@", "let", "\"a\nb\"", ""};
+        unsigned seed = 7;
+        auto random = [&seed](size_t bound) {
+            seed = seed * 1103515245 + 12345;
+            return bound ? (seed >> 8) % bound : 0;
+        };
+        bool same = true;
+        for (int round = 0; round < 300 && same; round++) {
+            size_t size = incremental.getText().size();
+            size_t offset = random(size + 1);
+            size_t length = std::min<size_t>(random(4), size - offset);
+            incremental.edit(offset, length, pieces[random(13)]);
+
+            Lexer lexer(std::string(incremental.getText()));
+            TokenBuffer expected = lexer.tokenize();
+            const TokenBuffer& tokens = incremental.getTokens();
+            same = tokens.size() == expected.size();
+            for (size_t i = 0; same && i < tokens.size(); i++) {
+                const Literal* literal = tokens.literal(i);
+                const Literal* expectedLiteral = expected.literal(i);
+                same = tokens.type(i) == expected.type(i) && tokens.lexeme(i) == expected.lexeme(i) &&
+                       tokens.line(i) == expected.line(i) && tokens.column(i) == expected.column(i) &&
+                       (literal ? expectedLiteral && *literal == *expectedLiteral : !expectedLiteral);
+            }
+        }
+
+        // Typing inside one line of the document relexes a few tokens
+        size_t middle = incremental.getText().find("let v1000 ");
+        IncrementalLexer::Delta typed = incremental.edit(middle + 4, 0, "w");
+        std::cout << "Typing relexed " << typed.inserted << " of " << incremental.getTokens().size() << " tokens\n";
+        std::cout << "Test 13: " << (same && middle != std::string::npos && typed.inserted < 20 &&
+                                     incremental.getTokens().lexeme(typed.first + 1) == "wv1000" ?
+                                     "PASSED" : "FAILED") << "\n\n";
+    }
+
+    // Test 14: Lines and columns come from offsets, as counting every byte would give them
+    {
+        std::string source;
+        for (int i = 0; i < 300; i++) {
+            source += std::string(i % 41, ' ') + "x" + std::to_string(i) + " =\t\"a\n" + std::string(i % 70, 'b') +
+                      "\" @" + std::string(i % 3, '\n') + "# note\r\n";
+        }
+        auto text = SourceBuffer::fromString(source);
+        Lexer lexer(text);
+        TokenBuffer tokens = lexer.tokenize();
+
+        std::vector<SourceBuffer::Position> counted;
+        int line = 1, column = 1;
+        for (char c : source) {
+            counted.push_back({line, column});
+            if (c == '\n') {
+                line++;
+                column = 1;
+            } else {
+                column++;
+            }
+        }
+        counted.push_back({line, column});
+
+        bool same = true;
+        for (size_t i = 0; same && i < tokens.size(); i++) {
+            SourceBuffer::Position expected = counted[tokens.offset(i)];
+            Token token = tokens.token(i);
+            same = tokens.line(i) == expected.line && tokens.column(i) == expected.column &&
+                   token.line() == expected.line && token.column() == expected.column;
+        }
+
+        // Tokens made by later stages keep the position they are given
+        Token made(TokenType::IDENTIFIER, "renamed", 12, 5);
+        Token unplaced;
+        Lexer bad("let\n  @");
+        Token error = bad.nextToken();
+        error = bad.nextToken();
+        std::cout << "Lines: " << tokens.line(tokens.size() - 1) << ", error at " << error.line() << ":"
+                  << error.column() << "\n";
+        std::cout << "Test 14: " << (same && made.line() == 12 && made.column() == 5 && unplaced.line() == 1 &&
+                                     !unplaced.text && error.type == TokenType::ERROR && error.line() == 2 &&
+                                     error.column() == 3 ? "PASSED" : "FAILED") << "\n\n";
+    }
+
+    // Test 15: A literal out of range is an error token from nextToken() too, and lexing goes on
+    {
+        Lexer lexer("99999999999 1234567890 3.0");
+        Token overflow = lexer.nextToken();
+        Token fits = lexer.nextToken();
+        Token after = lexer.nextToken();
+        bool decoded = false;
+        try {
+            decoded = std::get<int>(fits.literal()) == 1234567890 && std::get<float>(after.literal()) == 3.0f;
+        } catch (const std::exception&) {
+        }
+        std::cout << "Overflow: " << overflow.lexeme << "\n";
+        std::cout << "Test 15: " << (overflow.type == TokenType::ERROR && overflow.lexeme == "Number literal out of range" &&
+                                     fits.type == TokenType::INT_LITERAL && decoded ? "PASSED" : "FAILED") << "\n\n";
+    }
+
     std::cout << "Lexer Tests Complete!\n";
 }
 
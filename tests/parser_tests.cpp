@@ -152,6 +152,38 @@ void testParser() {
         std::cout << "Test 8: " << (!parser.hasErrors() && program ? "PASSED" : "FAILED") << "\n\n";
     }
     
+    // Test 9: Blocks are statements, so loop and branch bodies can hold several
+    {
+        std::string source = "while (i < 10) do { print(i); i = i + 1; } end;\n"
+                             "if (i > 5) then { let a = 1; print(a); } else { } end;";
+        Lexer lexer(source);
+        Parser parser(lexer);
+
+        auto program = parser.parse();
+
+        bool blocks = !parser.hasErrors() && program->statements.size() == 2;
+        if (blocks) {
+            auto loop = std::static_pointer_cast<WhileStmt>(program->statements[0]);
+            auto branch = std::static_pointer_cast<IfStmt>(program->statements[1]);
+            blocks = loop->body->getType() == StmtType::BLOCK &&
+                     std::static_pointer_cast<BlockStmt>(loop->body)->statements.size() == 2 &&
+                     branch->elseBranch && branch->elseBranch->getType() == StmtType::BLOCK;
+        }
+        std::cout << "Test 9: " << (blocks ? "PASSED" : "FAILED") << "\n\n";
+    }
+
+    // Test 10: Syntax errors are reported and parsing goes on with the next statement
+    {
+        std::string source = "let a = ; ) } let b = 2; function f() { + ; let c = 3; } end let d = 4;";
+        Lexer lexer(source);
+        Parser parser(lexer);
+
+        auto program = parser.parse();
+
+        std::cout << "Errors: " << parser.getErrors().size() << ", statements: " << program->statements.size() << "\n";
+        std::cout << "Test 10: " << (parser.hasErrors() && program->statements.size() == 3 ? "PASSED" : "FAILED") << "\n\n";
+    }
+
     std::cout << "Parser Tests Complete!\n";
 }
 
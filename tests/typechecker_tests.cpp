@@ -0,0 +1,158 @@
+#include <iostream>
+#include "../include/lexer/Lexer.h"
+#include "../include/parser/Parser.h"
+#include "../include/semantic/TypeChecker.h"
+
+static ProgramPtr parseProgram(const std::string& source) {
+    Lexer lexer(source);
+    Parser parser(lexer);
+    auto program = parser.parse();
+    return parser.hasErrors() ? nullptr : program;
+}
+
+// Inferred type of the first top-level `let` of a name
+TokenType declaredType(const ProgramPtr& program, const std::string& name) {
+    for (const auto& stmt : program->statements) {
+        if (stmt->getType() != StmtType::VARIABLE_DECL) continue;
+        auto decl = std::static_pointer_cast<VariableDeclStmt>(stmt);
+        if (decl->name.lexeme == name) return decl->staticType;
+    }
+    return TokenType::END_OF_FILE;
+}
+
+void testTypeChecker() {
+    std::cout << "Running TypeChecker Tests...\n";
+    std::cout << "============================\n";
+
+    int passed = 0;
+    int total = 0;
+
+    // Test 1: Let bindings take the type of their initializer
+    {
+        total++;
+        auto program = parseProgram(
+            "let a = 1; let b = a * 2.5; let s = \"n=\" + a; let c = a < 3; let d = 7 / 7; let e = a % 2;");
+        TypeChecker checker;
+        if (program) checker.check(program);
+        if (program && !checker.hasErrors() &&
+            declaredType(program, "a") == TokenType::INT_TYPE &&
+            declaredType(program, "b") == TokenType::FLOAT_TYPE &&
+            declaredType(program, "s") == TokenType::STRING_TYPE &&
+            declaredType(program, "c") == TokenType::BOOL_TYPE &&
+            declaredType(program, "d") == TokenType::FLOAT_TYPE &&
+            declaredType(program, "e") == TokenType::INT_TYPE) {
+            std::cout << "Test 1: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 1: FAILED\n";
+        }
+    }
+
+    // Test 2: Assigning another type makes a binding dynamic, including earlier uses in a loop
+    {
+        total++;
+        auto program = parseProgram(
+            "let i = 0; let x = 1; let n = 4;\n"
+            "while (i < 3) do { print(x + 1); x = \"s\"; i = i + 1; } end;\n"
+            "n = 4.5;");
+        TypeChecker checker;
+        if (program) checker.check(program);
+        bool parsed = program && program->statements.size() >= 4 &&
+                      program->statements[3]->getType() == StmtType::WHILE;
+        auto loop = parsed ? std::static_pointer_cast<WhileStmt>(program->statements[3]) : nullptr;
+        auto body = loop && loop->body->getType() == StmtType::BLOCK ?
+                    std::static_pointer_cast<BlockStmt>(loop->body) : nullptr;
+        if (body && body->statements.empty()) body = nullptr;
+        ExprPtr printed;
+        if (body && body->statements[0]->getType() == StmtType::PRINT) {
+            printed = std::static_pointer_cast<PrintStmt>(body->statements[0])->expressions[0];
+        } else if (body) {
+            printed = std::static_pointer_cast<CallExpr>(
+                std::static_pointer_cast<ExpressionStmt>(body->statements[0])->expression)->arguments[0];
+        }
+        if (program && !checker.hasErrors() && printed && printed->staticType == TypeChecker::DYNAMIC &&
+            declaredType(program, "i") == TokenType::INT_TYPE &&
+            declaredType(program, "x") == TypeChecker::DYNAMIC &&
+            declaredType(program, "n") == TypeChecker::DYNAMIC &&
+            loop->condition->staticType == TokenType::BOOL_TYPE) {
+            std::cout << "Test 2: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 2: FAILED\n";
+        }
+    }
+
+    // Test 3: Calls have the return type only when every path returns it
+    {
+        total++;
+        auto program = parseProgram(
+            "function square(n: int): int { return n * n; }\n"
+            "function half(n: int): float { if (n > 0) then { return n / 2; } end; }\n"
+            "function widen(n: int): float { return n; }\n"
+            "let r = square(4); let h = half(3); let w = widen(2);");
+        TypeChecker checker;
+        if (program) checker.check(program);
+        if (program && !checker.hasErrors() &&
+            declaredType(program, "r") == TokenType::INT_TYPE &&
+            declaredType(program, "h") == TypeChecker::DYNAMIC &&
+            declaredType(program, "w") == TypeChecker::DYNAMIC &&
+            checker.getReturnType("square") == TokenType::INT_TYPE) {
+            std::cout << "Test 3: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 3: FAILED\n";
+        }
+    }
+
+    // Test 4: Operations that always fail are reported before execution
+    {
+        total++;
+        auto program = parseProgram(
+            "let a = \"s\" - 1; let b = -true; let c = 1 % 2.0; let d = \"x\" < 1;\n"
+            "function f(n: int): int { return \"x\"; }\n"
+            "f(\"y\"); f(1, 2);");
+        TypeChecker checker;
+        if (program) checker.check(program);
+        std::string messages;
+        for (const auto& error : checker.getErrors()) {
+            messages += error.message + "\n";
+        }
+        if (checker.getErrors().size() == 7 &&
+            messages.find("Operator '-' cannot be applied to string and int") != std::string::npos &&
+            messages.find("Argument 1 of 'f' must be int, got string") != std::string::npos &&
+            messages.find("Function 'f' returns int, got string") != std::string::npos &&
+            messages.find("expects 1 arguments but got 2") != std::string::npos) {
+            std::cout << "Test 4: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 4: FAILED - " << messages << "\n";
+        }
+    }
+
+    // Test 5: Parameters stay typed only while every call passes their type
+    {
+        total++;
+        auto program = parseProgram(
+            "function id(n: int): int { return n; }\n"
+            "function inc(n: float): float { return n + 1.0; }\n"
+            "let p = id(1); let q = inc(2);");
+        TypeChecker checker;
+        if (program) checker.check(program);
+        if (program && !checker.hasErrors() &&
+            declaredType(program, "p") == TokenType::INT_TYPE &&
+            declaredType(program, "q") == TypeChecker::DYNAMIC) {
+            std::cout << "Test 5: PASSED\n";
+            passed++;
+        } else {
+            std::cout << "Test 5: FAILED\n";
+        }
+    }
+
+    std::cout << "\nTypeChecker Tests Complete!\n";
+    std::cout << "Passed: " << passed << "/" << total << " tests\n";
+}
+
+int main() {
+    testTypeChecker();
+    return 0;
+}